@@ -3,10 +3,14 @@
 #include "czmoney/money/money.h"
 #include "czmoney/money/money_api.h"
 #include "czmoney/money/initmoney.h" // 包含 initmoney.h
+#include "ll/api/event/EventBus.h"
 #include "ll/api/Config.h"
 #include "ll/api/io/Logger.h"
 #include "ll/api/mod/RegisterHelper.h"
 #include <RemoteCallAPI.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <filesystem>
 #include <stdexcept>
 #include "event/EventTest.h"
@@ -50,6 +54,56 @@ bool MyMod::load() {
     return true; // 加载成功
 }
 
+// 根据配置创建新的数据库连接 (尚未连接)
+// 主连接在 enable 中创建；对账等后台工作线程也通过它获得各自独立的连接
+std::unique_ptr<db::IDatabaseConnection> MyMod::createDatabaseConnection(bool verbose) const {
+    return createDatabaseConnection(mConfig, verbose);
+}
+
+std::unique_ptr<db::IDatabaseConnection> MyMod::createDatabaseConnection(const Config& cfg, bool verbose) const {
+    auto& logger = getSelf().getLogger();
+    if (cfg.db_type == "mysql") {
+        if (verbose) {
+            logger.info("Using MySQL database: host={}, user={}, db={}, port={}",
+                        cfg.db_host, cfg.db_user, cfg.db_name, cfg.db_port);
+        }
+        // 创建 MySQLConnection 实例
+        return std::make_unique<db::MySQLConnection>(
+            cfg.db_host,
+            cfg.db_user,
+            cfg.db_password,
+            cfg.db_name,
+            cfg.db_port
+        );
+    } else if (cfg.db_type == "postgresql") {
+        if (verbose) {
+            logger.info("Using PostgreSQL database: host={}, user={}, db={}, port={}",
+                        cfg.db_pg_host, cfg.db_pg_user, cfg.db_pg_name, cfg.db_pg_port);
+        }
+        // 创建 PostgreSQLConnection 实例
+        return std::make_unique<db::PostgreSQLConnection>(
+            cfg.db_pg_host,
+            cfg.db_pg_user,
+            cfg.db_pg_password,
+            cfg.db_pg_name,
+            cfg.db_pg_port
+        );
+    } else if (cfg.db_type == "sqlite") {
+        // 获取插件数据目录的绝对路径
+        std::filesystem::path dataPath = getSelf().getDataDir();
+        // 拼接 SQLite 文件路径
+        std::filesystem::path sqlitePath = dataPath / cfg.db_sqlite_path;
+        // 确保目录存在
+        std::filesystem::create_directories(sqlitePath.parent_path());
+        if (verbose) {
+            logger.info("Using SQLite database at path: {}", sqlitePath.string());
+        }
+        // 创建 SQLiteConnection 实例
+        return std::make_unique<db::SQLiteConnection>(sqlitePath.string());
+    }
+    return nullptr;
+}
+
 // 插件启用时的逻辑
 bool MyMod::enable() {
     auto& logger = getSelf().getLogger();
@@ -57,42 +111,10 @@ bool MyMod::enable() {
 
         // --- 数据库连接 ---
         try {
-        const auto& cfg = getConfig();
-        logger.info("Selected database type: {}", cfg.db_type);
-        if (cfg.db_type == "mysql") {
-            logger.info("Using MySQL database: host={}, user={}, db={}, port={}",
-                        cfg.db_host, cfg.db_user, cfg.db_name, cfg.db_port);
-            // 创建 MySQLConnection 实例
-            mDbConnection = std::make_unique<db::MySQLConnection>(
-                cfg.db_host,
-                cfg.db_user,
-                cfg.db_password,
-                cfg.db_name,
-                cfg.db_port
-            );
-        } else if (cfg.db_type == "postgresql") {
-            logger.info("Using PostgreSQL database: host={}, user={}, db={}, port={}",
-                        cfg.db_pg_host, cfg.db_pg_user, cfg.db_pg_name, cfg.db_pg_port);
-            // 创建 PostgreSQLConnection 实例
-            mDbConnection = std::make_unique<db::PostgreSQLConnection>(
-                cfg.db_pg_host,
-                cfg.db_pg_user,
-                cfg.db_pg_password,
-                cfg.db_pg_name,
-                cfg.db_pg_port
-            );
-        } else if (cfg.db_type == "sqlite") {
-            // 获取插件数据目录的绝对路径
-            std::filesystem::path dataPath = getSelf().getDataDir();
-            // 拼接 SQLite 文件路径
-            std::filesystem::path sqlitePath = dataPath / cfg.db_sqlite_path;
-             // 确保目录存在
-            std::filesystem::create_directories(sqlitePath.parent_path());
-            logger.info("Using SQLite database at path: {}", sqlitePath.string());
-            // 创建 SQLiteConnection 实例
-            mDbConnection = std::make_unique<db::SQLiteConnection>(sqlitePath.string());
-        } else {
-            logger.error("Unsupported database type configured: {}", cfg.db_type);
+        logger.info("Selected database type: {}", getConfig().db_type);
+        mDbConnection = createDatabaseConnection(true);
+        if (!mDbConnection) {
+            logger.error("Unsupported database type configured: {}", getConfig().db_type);
             return false;
         }
 
@@ -100,12 +122,220 @@ bool MyMod::enable() {
         if (mDbConnection->connect()) {
             logger.info("Database connection successful!");
 
+            // --- 流水哈希链密钥 ---
+            // 启用哈希链但未配置密钥时生成一个并写回配置文件，之后的校验都依赖这个密钥
+            if (getConfig().ledgerChain.enabled && getConfig().ledgerChain.secret.empty()) {
+                getConfig().ledgerChain.secret = LedgerChain::generateSecret();
+                if (ll::config::saveConfig(getConfig(), mConfigPath)) {
+                    logger.warn("Generated a new ledger chain secret and saved it to the configuration file. Keep it safe.");
+                } else {
+                    logger.error("Generated a new ledger chain secret but failed to save the configuration file!");
+                }
+            }
+
             // --- 初始化 MoneyManager ---
             mMoneyManager = std::make_unique<MoneyManager>(*mDbConnection, getConfig());
             logger.info("Initializing money database table...");
             if (mMoneyManager->initializeTable()) {
                 logger.info("Money database table initialized successfully.");
 
+                // --- 建立账户存在性过滤器 ---
+                // 在注册任何事件监听器之前建立，之后创建的账户都会先加入过滤器；
+                // 共用的 MySQL / PostgreSQL 上其他服务器创建的账户不会加入，因此只在 SQLite 上默认启用
+                const auto& filterCfg = getConfig().accountFilter;
+                if (filterCfg.enabled || (filterCfg.enableOnSqlite && getConfig().db_type == "sqlite")) {
+                    mAccountFilter = std::make_unique<AccountFilter>(*mDbConnection, getConfig());
+                    if (!mAccountFilter->build()) {
+                        logger.error("Failed to build account filter, account lookups will always query the database.");
+                        mAccountFilter.reset();
+                    } else {
+                        mMoneyManager->setAccountFilter(mAccountFilter.get());
+                    }
+                }
+
+                // --- 启动后台任务调度器 ---
+                mScheduler = std::make_unique<scheduler::TaskScheduler>(getConfig().scheduler);
+                mScheduler->start();
+
+                // --- 建立流水理由全文索引 ---
+                // 在后台构建，完成前按理由查询使用 LIKE；失败时只影响按理由查询的速度
+                if (getConfig().db_reason_index) {
+                    mReasonIndex = std::make_unique<ReasonIndexBuilder>(
+                        *mDbConnection,
+                        *mScheduler,
+                        *mMoneyManager,
+                        [this]() { return createDatabaseConnection(false); }
+                    );
+                    mReasonIndex->start();
+                }
+
+                // --- 初始化资金流向计数器 ---
+                mFlowCounters = std::make_unique<FlowCounters>(*mDbConnection, getConfig());
+                if (!mFlowCounters->initializeTable()) {
+                    logger.error("Failed to initialize flow counter table, flow counters are disabled.");
+                    mFlowCounters.reset();
+                } else {
+                    mMoneyManager->setFlowCounters(mFlowCounters.get());
+                    mScheduler->schedulePeriodic(
+                        "flow-counters-flush",
+                        std::chrono::seconds(std::max(1, getConfig().flowCounters.flushIntervalSeconds)),
+                        [this]() {
+                            if (mFlowCounters) {
+                                mFlowCounters->flush();
+                            }
+                        },
+                        scheduler::TaskPriority::Low
+                    );
+                }
+
+                // --- 初始化活跃玩家统计 ---
+                mActiveUsers = std::make_unique<ActiveUserTracker>(*mDbConnection, getConfig());
+                if (!mActiveUsers->initializeTable()) {
+                    logger.error("Failed to initialize active user table, active user statistics are disabled.");
+                    mActiveUsers.reset();
+                } else {
+                    mMoneyManager->setActiveUserTracker(mActiveUsers.get());
+                    mScheduler->schedulePeriodic(
+                        "active-users-flush",
+                        std::chrono::seconds(std::max(1, getConfig().activeUsers.flushIntervalSeconds)),
+                        [this]() {
+                            if (mActiveUsers) {
+                                mActiveUsers->flush();
+                            }
+                        },
+                        scheduler::TaskPriority::Low
+                    );
+                }
+
+                // --- 初始化写操作限流器 ---
+                mRateLimiter = std::make_unique<RateLimiter>(getConfig().rateLimit);
+                mMoneyManager->setRateLimiter(mRateLimiter.get());
+
+                // --- 初始化定时/周期付款引擎 ---
+                mPaymentEngine = std::make_unique<ScheduledPaymentEngine>(*mDbConnection, *mMoneyManager, getConfig());
+                if (!mPaymentEngine->initializeTable()) {
+                    logger.error("Failed to initialize scheduled payment table, scheduled payments are disabled.");
+                    mPaymentEngine.reset();
+                } else if (getConfig().scheduledPayments.enabled) {
+                    // runImmediately: 启动后立即补跑停机期间到期的付款
+                    mScheduler->schedulePeriodic(
+                        "scheduled-payments",
+                        std::chrono::seconds(std::max(1, getConfig().scheduledPayments.checkIntervalSeconds)),
+                        [this]() { runScheduledPayments(); },
+                        scheduler::TaskPriority::Normal,
+                        true
+                    );
+                }
+
+                // --- 初始化批量利息/财富税处理器 ---
+                mBulkEngine = std::make_unique<BulkAdjustmentEngine>(*mDbConnection, getConfig());
+                if (!mBulkEngine->initializeTable()) {
+                    logger.error("Failed to initialize bulk adjustment table, bulk adjustments are disabled.");
+                    mBulkEngine.reset();
+                } else {
+                    mBulkEngine->setFlowCounters(mFlowCounters.get());
+                    if (mBulkEngine->hasPendingWork()) {
+                        scheduleBulkAdjustment(); // 继续上次中断的任务
+                    }
+                }
+
+                // --- 初始化余额快照引擎 ---
+                mSnapshots = std::make_unique<BalanceSnapshotEngine>(*mDbConnection, getConfig());
+                if (!mSnapshots->initializeTable()) {
+                    logger.error("Failed to initialize balance snapshot tables, balance snapshots are disabled.");
+                    mSnapshots.reset();
+                } else {
+                    if (mSnapshots->hasPendingWork()) {
+                        scheduleBalanceSnapshot(); // 继续上次中断的快照
+                    }
+                    if (getConfig().snapshots.enabled) {
+                        mScheduler->schedulePeriodic(
+                            "balance-snapshot",
+                            std::chrono::minutes(std::max(1, getConfig().snapshots.intervalMinutes)),
+                            [this]() { startBalanceSnapshot(false); },
+                            scheduler::TaskPriority::Low
+                        );
+                    }
+                }
+
+                // --- 初始化流水对账器 ---
+                mReconciler = std::make_unique<ReconciliationEngine>(
+                    *mDbConnection,
+                    *mScheduler,
+                    getConfig(),
+                    [this]() { return createDatabaseConnection(false); }
+                );
+
+                // --- 初始化财富分布统计 ---
+                mAnalytics = std::make_unique<WealthAnalyticsEngine>(
+                    *mDbConnection,
+                    getConfig(),
+                    getConfig().analytics.dumpFile.empty()
+                        ? std::filesystem::path()
+                        : getSelf().getDataDir() / getConfig().analytics.dumpFile,
+                    [this]() { return createDatabaseConnection(false); }
+                );
+                if (getConfig().analytics.enabled) {
+                    mScheduler->schedulePeriodic(
+                        "wealth-analytics",
+                        std::chrono::minutes(std::max(1, getConfig().analytics.intervalMinutes)),
+                        [this]() { startWealthAnalytics(); },
+                        scheduler::TaskPriority::Low
+                    );
+                }
+
+                // --- 初始化异常收入检测 ---
+                // MoneyManager 在每笔入账 (加款、设置余额增加、兑换所得) 提交后直接喂给检测器，
+                // 不依赖事件监听；检测在内存中完成，不访问数据库
+                mExploitDetector = std::make_unique<ExploitDetector>(getConfig().exploitDetection);
+                if (getConfig().exploitDetection.enabled) {
+                    mMoneyManager->setExploitDetector(mExploitDetector.get());
+                }
+
+                // --- 初始化流水哈希链校验器 ---
+                mLedgerVerifier = std::make_unique<LedgerVerifier>(
+                    *mDbConnection,
+                    *mScheduler,
+                    getConfig(),
+                    [this]() { return createDatabaseConnection(false); }
+                );
+
+                // --- 初始化流水导出/回放工具 ---
+                mReplayer = std::make_unique<WorkloadReplayer>(
+                    *mDbConnection,
+                    getConfig(),
+                    getSelf().getDataDir() / "replay",
+                    [this]() { return createReplayTargetConnection(); }
+                );
+
+                // --- 初始化经济数据备份/恢复 ---
+                mBackup = std::make_unique<EconomyBackup>(
+                    *mDbConnection,
+                    *mScheduler,
+                    getConfig(),
+                    getSelf().getDataDir() / "backup",
+                    [this]() { return createDatabaseConnection(false); }
+                );
+
+                // --- 初始化数据库迁移工具 ---
+                mMigrator = std::make_unique<BackendMigrator>(
+                    *mDbConnection,
+                    *mScheduler,
+                    getConfig(),
+                    getSelf().getDataDir() / "migration.snapshot",
+                    [this]() { return createDatabaseConnection(false); },
+                    [this]() { return createMigrationTargetConnection(); }
+                );
+
+                // --- 初始化表单异步加载器 ---
+                mFormLoader = std::make_unique<ui::FormLoader>(
+                    *mDbConnection,
+                    *mScheduler,
+                    getConfig(),
+                    [this]() { return createDatabaseConnection(false); }
+                );
+                mFormLoader->start();
+
                 // --- 初始化玩家经济监听器 ---
                 logger.info("Initializing player money event listener...");
                 czmoney::initMoney(); // 调用 initMoney 函数来注册事件监听器
@@ -202,6 +432,122 @@ bool MyMod::enable() {
                         }
                     )
                 );
+                RemoteCall::exportAs("czmoney", "exchangeBalance",
+                    std::function<double(std::string, std::string, std::string, double, std::string, std::string, std::string)>(
+                        [](std::string uuid, std::string fromCurrency, std::string toCurrency, double amount,
+                           std::string r1, std::string r2, std::string r3) -> double {
+                            double received = 0.0;
+                            auto result = ::czmoney::api::exchangeBalance(uuid, fromCurrency, toCurrency, amount, &received, r1, r2, r3);
+                            return result == ::czmoney::api::MoneyApiResult::Success ? received : 0.0;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "getExchangeRate",
+                    std::function<double(std::string, std::string)>(
+                        [](std::string fromCurrency, std::string toCurrency) -> double {
+                            return ::czmoney::api::getExchangeRate(fromCurrency, toCurrency).value_or(0.0);
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "placeHold",
+                    std::function<int64_t(std::string, std::string, double, std::string, std::string, std::string)>(
+                        [](std::string uuid, std::string currencyType, double amount,
+                           std::string r1, std::string r2, std::string r3) -> int64_t {
+                            int64_t holdId = 0;
+                            auto result = ::czmoney::api::placeHold(uuid, currencyType, amount, holdId, r1, r2, r3);
+                            return result == ::czmoney::api::MoneyApiResult::Success ? holdId : 0LL;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "captureHold",
+                    std::function<bool(int64_t, std::string, double, std::string, std::string, std::string)>(
+                        [](int64_t holdId, std::string receiver, double amount,
+                           std::string r1, std::string r2, std::string r3) -> bool {
+                            return ::czmoney::api::captureHold(holdId, receiver, amount, r1, r2, r3) == ::czmoney::api::MoneyApiResult::Success;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "releaseHold",
+                    std::function<bool(int64_t)>(
+                        [](int64_t holdId) -> bool {
+                            return ::czmoney::api::releaseHold(holdId) == ::czmoney::api::MoneyApiResult::Success;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "getHeldBalance",
+                    std::function<double(std::string, std::string)>(
+                        [](std::string uuid, std::string currencyType) -> double {
+                            return ::czmoney::api::getHeldBalance(uuid, currencyType);
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "createScheduledPayment",
+                    std::function<int64_t(std::string, std::string, std::string, double, int64_t, int64_t, int64_t, std::string, std::string, std::string)>(
+                        [](std::string payer, std::string payee, std::string currencyType, double amount,
+                           int64_t intervalSeconds, int64_t firstRunDelaySeconds, int64_t totalRuns,
+                           std::string r1, std::string r2, std::string r3) -> int64_t {
+                            int64_t scheduleId = 0;
+                            auto result = ::czmoney::api::createScheduledPayment(
+                                payer, payee, currencyType, amount, intervalSeconds, firstRunDelaySeconds, totalRuns, scheduleId, r1, r2, r3
+                            );
+                            return result == ::czmoney::api::MoneyApiResult::Success ? scheduleId : 0LL;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "cancelScheduledPayment",
+                    std::function<bool(int64_t)>(
+                        [](int64_t scheduleId) -> bool {
+                            return ::czmoney::api::cancelScheduledPayment(scheduleId) == ::czmoney::api::MoneyApiResult::Success;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "getSpendableBalance",
+                    std::function<double(std::string, std::string)>(
+                        [](std::string uuid, std::string currencyType) -> double {
+                            auto opt = ::czmoney::api::getSpendableBalance(uuid, currencyType);
+                            return opt.has_value() ? opt.value() : 0.0;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "getPlayerBalanceAt",
+                    std::function<double(std::string, std::string, std::string)>(
+                        [](std::string uuid, std::string currencyType, std::string timestamp) -> double {
+                            auto opt = ::czmoney::api::getPlayerBalanceAt(uuid, currencyType, timestamp);
+                            return opt.has_value() ? opt.value() : 0.0;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "getFlowCounters",
+                    std::function<std::unordered_map<std::string, std::vector<double>>(std::string)>(
+                        [](std::string currencyType) -> std::unordered_map<std::string, std::vector<double>> {
+                            // 按插件 (reason1) 汇总，值为 [流入, 流出, 次数]
+                            std::unordered_map<std::string, std::vector<double>> result;
+                            for (const auto& counter : ::czmoney::api::getFlowCounters(currencyType, false)) {
+                                auto& values = result[counter.reason1];
+                                if (values.empty()) {
+                                    values.assign(3, 0.0);
+                                }
+                                values[0] += static_cast<double>(counter.sumIn) / 100.0;
+                                values[1] += static_cast<double>(counter.sumOut) / 100.0;
+                                values[2] += static_cast<double>(counter.ops);
+                            }
+                            return result;
+                        }
+                    )
+                );
+                RemoteCall::exportAs("czmoney", "getActivePlayerCount",
+                    std::function<int64_t(std::string, int, std::string)>(
+                        [](std::string currencyType, int days, std::string reason1) -> int64_t {
+                            // reason1 为空时统计所有理由
+                            auto count = ::czmoney::api::getActivePlayerCount(
+                                currencyType,
+                                days,
+                                reason1.empty() ? std::nullopt : std::optional<std::string_view>(reason1)
+                            );
+                            return count.has_value() ? static_cast<int64_t>(count.value()) : -1LL;
+                        }
+                    )
+                );
                 logger.info("Script API functions registered.");
                 // --- 脚本 API 导出结束 ---
                 // --- 命令注册结束 ---
@@ -243,11 +589,78 @@ bool MyMod::disable() {
     auto& logger = getSelf().getLogger(); // 获取 Logger 实例
     logger.debug("Disabling..."); // 输出调试信息
 
+    // --- 停止对账工作线程 ---
+    // 必须在调度器 drain 之前：工作线程会向调度器提交复核任务
+    if (mReconciler) {
+        mReconciler->stop();
+    }
+    if (mLedgerVerifier) {
+        mLedgerVerifier->stop();
+    }
+    if (mAnalytics) {
+        mAnalytics->stop();
+    }
+    if (mReplayer) {
+        mReplayer->stop();
+    }
+    if (mBackup) {
+        mBackup->stop();
+    }
+    if (mMigrator) {
+        mMigrator->stop();
+    }
+    if (mFormLoader) {
+        mFormLoader->stop();
+    }
+    if (mReasonIndex) {
+        mReasonIndex->stop();
+    }
+
+    // --- 停止后台任务调度器 ---
+    // 在 MoneyManager 和数据库连接释放前执行完积压任务，避免丢失待刷新的数据
+    if (mScheduler) {
+        mScheduler->stop();
+        mScheduler->drain();
+        mScheduler.reset();
+        logger.info("Task scheduler stopped.");
+    }
+
+    // --- 保存资金流向计数 ---
+    // 调度器已停止，不会再有新的变动，最后写入一次
+    if (mFlowCounters && mDbConnection && mDbConnection->isConnected()) {
+        mFlowCounters->flush();
+    }
+    if (mActiveUsers && mDbConnection && mDbConnection->isConnected()) {
+        mActiveUsers->flush();
+    }
+
     // --- 重置 MoneyManager ---
     // 释放 MoneyManager 实例，确保在数据库连接关闭前或后都可以安全执行
     // 如果 MoneyManager 的析构函数依赖数据库连接，则应在断开连接前 reset
     // 如果不依赖，顺序可以随意
+    if (mMoneyManager) {
+        mMoneyManager->setExploitDetector(nullptr);
+    }
+    mExploitDetector.reset();
+    mFormLoader.reset();
+    mMigrator.reset();
+    mBackup.reset();
+    mReplayer.reset();
+    mLedgerVerifier.reset();
+    mAnalytics.reset();
+    mReconciler.reset();
+    mSnapshots.reset();
+    mBulkEngine.reset();
+    mPaymentEngine.reset();
+    if (mMoneyManager) {
+        mMoneyManager->setRateLimiter(nullptr);
+    }
+    mRateLimiter.reset();
+    mReasonIndex.reset();
     mMoneyManager.reset();
+    mFlowCounters.reset();
+    mActiveUsers.reset();
+    mAccountFilter.reset();
     logger.info("MoneyManager reset.");
     // --- MoneyManager 重置结束 ---
 
@@ -276,6 +689,337 @@ MoneyManager& MyMod::getMoneyManager() {
     return *mMoneyManager; // 返回 MoneyManager 的引用
 }
 
+// 实现 getScheduler 访问器
+scheduler::TaskScheduler& MyMod::getScheduler() {
+    if (!mScheduler) {
+        throw std::runtime_error("TaskScheduler is not initialized. Is the mod enabled?");
+    }
+    return *mScheduler;
+}
+
+// 实现 getRateLimiter 访问器
+RateLimiter& MyMod::getRateLimiter() {
+    if (!mRateLimiter) {
+        throw std::runtime_error("RateLimiter is not initialized. Is the mod enabled?");
+    }
+    return *mRateLimiter;
+}
+
+// 实现 getPaymentEngine 访问器
+ScheduledPaymentEngine& MyMod::getPaymentEngine() {
+    if (!mPaymentEngine) {
+        throw std::runtime_error("ScheduledPaymentEngine is not initialized. Is the mod enabled?");
+    }
+    return *mPaymentEngine;
+}
+
+// 实现 getBulkAdjustmentEngine 访问器
+BulkAdjustmentEngine& MyMod::getBulkAdjustmentEngine() {
+    if (!mBulkEngine) {
+        throw std::runtime_error("BulkAdjustmentEngine is not initialized. Is the mod enabled?");
+    }
+    return *mBulkEngine;
+}
+
+// 实现 getReconciler 访问器
+ReconciliationEngine& MyMod::getReconciler() {
+    if (!mReconciler) {
+        throw std::runtime_error("ReconciliationEngine is not initialized. Is the mod enabled?");
+    }
+    return *mReconciler;
+}
+
+// 实现 getLedgerVerifier 访问器
+LedgerVerifier& MyMod::getLedgerVerifier() {
+    if (!mLedgerVerifier) {
+        throw std::runtime_error("LedgerVerifier is not initialized. Is the mod enabled?");
+    }
+    return *mLedgerVerifier;
+}
+
+// 实现 getWealthAnalytics 访问器
+WealthAnalyticsEngine& MyMod::getWealthAnalytics() {
+    if (!mAnalytics) {
+        throw std::runtime_error("WealthAnalyticsEngine is not initialized. Is the mod enabled?");
+    }
+    return *mAnalytics;
+}
+
+// 实现 getExploitDetector 访问器
+ExploitDetector& MyMod::getExploitDetector() {
+    if (!mExploitDetector) {
+        throw std::runtime_error("ExploitDetector is not initialized. Is the mod enabled?");
+    }
+    return *mExploitDetector;
+}
+
+// 实现 getFlowCounters 访问器
+FlowCounters& MyMod::getFlowCounters() {
+    if (!mFlowCounters) {
+        throw std::runtime_error("FlowCounters is not initialized. Is the mod enabled?");
+    }
+    return *mFlowCounters;
+}
+
+// 实现 getActiveUsers 访问器
+ActiveUserTracker& MyMod::getActiveUsers() {
+    if (!mActiveUsers) {
+        throw std::runtime_error("ActiveUserTracker is not initialized. Is the mod enabled?");
+    }
+    return *mActiveUsers;
+}
+
+// 实现 getAccountFilter 访问器
+AccountFilter& MyMod::getAccountFilter() {
+    if (!mAccountFilter) {
+        throw std::runtime_error("AccountFilter is not initialized. Is the mod enabled?");
+    }
+    return *mAccountFilter;
+}
+
+// 实现 getReplayer 访问器
+WorkloadReplayer& MyMod::getReplayer() {
+    if (!mReplayer) {
+        throw std::runtime_error("WorkloadReplayer is not initialized. Is the mod enabled?");
+    }
+    return *mReplayer;
+}
+
+// 实现 getBackup 访问器
+EconomyBackup& MyMod::getBackup() {
+    if (!mBackup) {
+        throw std::runtime_error("EconomyBackup is not initialized. Is the mod enabled?");
+    }
+    return *mBackup;
+}
+
+// 实现 getMigrator 访问器
+BackendMigrator& MyMod::getMigrator() {
+    if (!mMigrator) {
+        throw std::runtime_error("BackendMigrator is not initialized. Is the mod enabled?");
+    }
+    return *mMigrator;
+}
+
+// 实现 getFormLoader 访问器
+ui::FormLoader& MyMod::getFormLoader() {
+    if (!mFormLoader) {
+        throw std::runtime_error("FormLoader is not initialized. Is the mod enabled?");
+    }
+    return *mFormLoader;
+}
+
+// 恢复会整体替换余额 (和流水)，内存中依赖它们的状态需要重建
+bool MyMod::restoreBackup(const std::string& fileName) {
+    if (!mBackup) {
+        return false;
+    }
+    // 替换提交后在服务器线程上调用
+    return mBackup->startRestore(fileName, [this]() {
+        if (mMoneyManager) {
+            mMoneyManager->reloadHolds();
+        }
+        if (mAccountFilter && !mAccountFilter->build()) {
+            getSelf().getLogger().error("Failed to rebuild account filter after restore, disabling it.");
+            if (mMoneyManager) {
+                mMoneyManager->setAccountFilter(nullptr);
+            }
+            mAccountFilter.reset();
+        }
+        // 旧快照中的余额已与恢复后的数据无关，下一次快照必须是全量的
+        if (mSnapshots) {
+            mSnapshots->requestFullSnapshot();
+        }
+    });
+}
+
+// 实现 getSnapshotEngine 访问器
+BalanceSnapshotEngine& MyMod::getSnapshotEngine() {
+    if (!mSnapshots) {
+        throw std::runtime_error("BalanceSnapshotEngine is not initialized. Is the mod enabled?");
+    }
+    return *mSnapshots;
+}
+
+// 每个任务只处理一个分块，仍有剩余时重新提交，让大批量调整分摊到多个 tick
+void MyMod::scheduleBulkAdjustment() {
+    if (!mScheduler || !mBulkEngine) {
+        return;
+    }
+    mScheduler->submit(
+        "bulk-adjustment",
+        [this]() {
+            if (!mBulkEngine) {
+                return;
+            }
+            if (mBulkEngine->runNextChunk()) {
+                if (mScheduler && mScheduler->isRunning()) {
+                    scheduleBulkAdjustment();
+                }
+                return;
+            }
+            // 批量调整只写汇总流水，之后的历史余额查询需要一个新的全量快照作为起点
+            auto job = mBulkEngine->getJobStatus();
+            if (job && job->status == "completed") {
+                startBalanceSnapshot(true);
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+// 与批量调整相同，每个任务只处理一个分块
+void MyMod::scheduleBalanceSnapshot() {
+    if (!mScheduler || !mSnapshots) {
+        return;
+    }
+    mScheduler->submit(
+        "balance-snapshot-chunk",
+        [this]() {
+            if (mSnapshots && mSnapshots->runNextChunk() && mScheduler && mScheduler->isRunning()) {
+                scheduleBalanceSnapshot();
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+void MyMod::startBalanceSnapshot(bool forceFull) {
+    if (!mSnapshots) {
+        return;
+    }
+    int64_t snapshotId = 0;
+    auto    result     = mSnapshots->startSnapshot(forceFull, snapshotId);
+    if (result == api::MoneyApiResult::Success) {
+        scheduleBalanceSnapshot();
+    } else if (forceFull && result == api::MoneyApiResult::JobInProgress) {
+        mSnapshots->requestFullSnapshot(); // 当前快照完成后的下一次快照改为全量
+    }
+}
+
+void MyMod::scheduleWealthAnalytics() {
+    if (!mScheduler || !mAnalytics) {
+        return;
+    }
+    mScheduler->submit(
+        "wealth-analytics-chunk",
+        [this]() {
+            if (mAnalytics && mAnalytics->runNextChunk() && mScheduler && mScheduler->isRunning()) {
+                scheduleWealthAnalytics();
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+bool MyMod::startWealthAnalytics() {
+    if (!mAnalytics || !mAnalytics->start()) {
+        return false;
+    }
+    scheduleWealthAnalytics();
+    return true;
+}
+
+bool MyMod::startReplayExport(const std::string& fileName) {
+    if (!mReplayer || !mReplayer->startExport(fileName)) {
+        return false;
+    }
+    scheduleReplayExport();
+    return true;
+}
+
+void MyMod::scheduleReplayExport() {
+    if (!mScheduler || !mReplayer) {
+        return;
+    }
+    mScheduler->submit(
+        "replay-export-chunk",
+        [this]() {
+            if (mReplayer && mReplayer->runNextExportChunk() && mScheduler && mScheduler->isRunning()) {
+                scheduleReplayExport();
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+// 只比较配置字符串时，"./data/x.db" 与 "data/x.db"、绝对路径或符号链接都能绕过检查，
+// 因此 SQLite 比较规范化后的绝对路径，MySQL / PostgreSQL 比较主机 (不区分大小写)、端口和库名
+bool MyMod::isProductionDatabase(const Config& target) const {
+    if (target.db_type != mConfig.db_type) {
+        return false;
+    }
+    auto sameHost = [](const std::string& a, const std::string& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    };
+    if (target.db_type == "sqlite") {
+        std::filesystem::path dataDir = getSelf().getDataDir();
+        std::error_code       ec1;
+        std::error_code       ec2;
+        auto targetPath     = std::filesystem::weakly_canonical(dataDir / target.db_sqlite_path, ec1);
+        auto productionPath = std::filesystem::weakly_canonical(dataDir / mConfig.db_sqlite_path, ec2);
+        if (ec1 || ec2) {
+            return true; // 无法确定时按相同处理
+        }
+        return targetPath == productionPath;
+    } else if (target.db_type == "mysql") {
+        return sameHost(target.db_host, mConfig.db_host) && target.db_port == mConfig.db_port
+            && target.db_name == mConfig.db_name;
+    } else if (target.db_type == "postgresql") {
+        return sameHost(target.db_pg_host, mConfig.db_pg_host) && target.db_pg_port == mConfig.db_pg_port
+            && target.db_pg_name == mConfig.db_pg_name;
+    }
+    return false;
+}
+
+// 回放目标库：沿用生产库的连接参数，只替换数据库类型和文件路径 / 库名
+std::unique_ptr<db::IDatabaseConnection> MyMod::createReplayTargetConnection() const {
+    const auto& replay = mConfig.replay;
+    Config      target = mConfig;
+    target.db_type        = replay.targetType;
+    target.db_sqlite_path = replay.sqlitePath;
+    target.db_name        = replay.databaseName;
+    target.db_pg_name     = replay.databaseName;
+
+    if (isProductionDatabase(target)) {
+        getSelf().getLogger().error("回放目标数据库与生产数据库相同，已拒绝回放。请修改配置 replay。");
+        return nullptr;
+    }
+    return createDatabaseConnection(target, false);
+}
+
+// 迁移目标库：与回放相同，沿用生产库的连接参数；库名为空时沿用目标类型原有的库名
+std::unique_ptr<db::IDatabaseConnection> MyMod::createMigrationTargetConnection() const {
+    const auto& migration = mConfig.migration;
+    Config      target    = mConfig;
+    target.db_type        = migration.targetType;
+    target.db_sqlite_path = migration.sqlitePath;
+    if (!migration.databaseName.empty()) {
+        target.db_name    = migration.databaseName;
+        target.db_pg_name = migration.databaseName;
+    }
+
+    if (isProductionDatabase(target)) {
+        getSelf().getLogger().error("迁移目标数据库与生产数据库相同，已拒绝迁移。请修改配置 migration。");
+        return nullptr;
+    }
+    return createDatabaseConnection(target, false);
+}
+
+// 每次只处理一批 (并受 tick 预算限制)，可能还有积压时作为新任务提交，由调度器按 tick 预算分摊
+void MyMod::runScheduledPayments() {
+    if (!mPaymentEngine) {
+        return;
+    }
+    bool hasMore = false;
+    mPaymentEngine->runDueBatch(ScheduledPaymentEngine::nowEpochSeconds(), hasMore);
+    if (hasMore && mScheduler && mScheduler->isRunning()) {
+        mScheduler->submit("scheduled-payments-continue", [this]() { runScheduledPayments(); });
+    }
+}
+
 
 } // namespace czmoney
 
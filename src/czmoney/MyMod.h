@@ -7,6 +7,24 @@
 #include "db/postgresql.h" // 包含 PostgreSQL 连接头文件
 #include "czmoney/config.h"
 #include "czmoney/money/money.h" // 包含 MoneyManager 头文件
+#include "czmoney/scheduler/TaskScheduler.h" // 包含后台任务调度器
+#include "czmoney/money/RateLimiter.h" // 包含写操作限流器
+#include "czmoney/money/ScheduledPayment.h" // 包含定时/周期付款引擎
+#include "czmoney/money/BulkAdjustment.h" // 包含批量利息/财富税处理器
+#include "czmoney/money/Reconciliation.h" // 包含流水对账器
+#include "czmoney/money/BalanceSnapshot.h" // 包含余额快照引擎
+#include "czmoney/money/LedgerChain.h" // 包含流水哈希链校验器
+#include "czmoney/money/WealthAnalytics.h" // 包含财富分布统计
+#include "czmoney/money/ExploitDetector.h" // 包含异常收入检测
+#include "czmoney/money/FlowCounters.h" // 包含资金流向计数器
+#include "czmoney/money/ActiveUsers.h" // 包含活跃玩家统计
+#include "czmoney/money/ReasonIndex.h" // 包含流水理由全文索引构建器
+#include "czmoney/money/WorkloadReplay.h" // 包含流水导出/回放工具
+#include "czmoney/money/AccountFilter.h" // 包含账户存在性过滤器
+#include "czmoney/money/EconomyBackup.h" // 包含经济数据备份/恢复
+#include "czmoney/money/BackendMigration.h" // 包含数据库迁移工具
+#include "czmoney/ui/FormLoader.h" // 包含表单异步加载器
+#include "ll/api/event/ListenerBase.h"
 #include <memory>      // 为了 std::unique_ptr
 #include <filesystem> // 为了 std::filesystem
 
@@ -42,6 +60,99 @@ public:
     /// @warning Throws if the manager is not initialized (mod not enabled).
     [[nodiscard]] MoneyManager& getMoneyManager();
 
+    /// @return A reference to the background task scheduler.
+    /// @warning Throws if the scheduler is not initialized (mod not enabled).
+    [[nodiscard]] scheduler::TaskScheduler& getScheduler();
+
+    /// @return A reference to the write rate limiter.
+    /// @warning Throws if the limiter is not initialized (mod not enabled).
+    [[nodiscard]] RateLimiter& getRateLimiter();
+
+    /// @return A reference to the scheduled payment engine.
+    /// @warning Throws if the engine is not initialized (mod not enabled).
+    [[nodiscard]] ScheduledPaymentEngine& getPaymentEngine();
+
+    /// @return A reference to the bulk interest / wealth-tax engine.
+    /// @warning Throws if the engine is not initialized (mod not enabled).
+    [[nodiscard]] BulkAdjustmentEngine& getBulkAdjustmentEngine();
+
+    /// Submits the next chunk of the running bulk adjustment job to the background scheduler.
+    void scheduleBulkAdjustment();
+
+    /// @return A reference to the ledger reconciliation engine.
+    /// @warning Throws if the engine is not initialized (mod not enabled).
+    [[nodiscard]] ReconciliationEngine& getReconciler();
+
+    /// @return A reference to the balance snapshot engine.
+    /// @warning Throws if the engine is not initialized (mod not enabled).
+    [[nodiscard]] BalanceSnapshotEngine& getSnapshotEngine();
+
+    /// Submits the next chunk of the running balance snapshot to the background scheduler.
+    void scheduleBalanceSnapshot();
+
+    /// @return A reference to the ledger hash chain verifier.
+    /// @warning Throws if the verifier is not initialized (mod not enabled).
+    [[nodiscard]] LedgerVerifier& getLedgerVerifier();
+
+    /// @return A reference to the wealth distribution analytics engine.
+    /// @warning Throws if the engine is not initialized (mod not enabled).
+    [[nodiscard]] WealthAnalyticsEngine& getWealthAnalytics();
+
+    /// Starts a wealth analytics pass and submits its chunks to the background scheduler.
+    /// @return False if a pass is already running or the engine is not initialized.
+    bool startWealthAnalytics();
+
+    /// @return A reference to the in-memory exploit detector.
+    /// @warning Throws if the detector is not initialized (mod not enabled).
+    [[nodiscard]] ExploitDetector& getExploitDetector();
+
+    /// @return A reference to the per-plugin / per-reason money flow counters.
+    /// @warning Throws if the counters are not initialized (mod not enabled).
+    [[nodiscard]] FlowCounters& getFlowCounters();
+
+    /// @return A reference to the daily active player tracker.
+    /// @warning Throws if the tracker is not initialized (mod not enabled).
+    [[nodiscard]] ActiveUserTracker& getActiveUsers();
+
+    /// @return A reference to the economy_log export / replay benchmark tool.
+    /// @warning Throws if the replayer is not initialized (mod not enabled).
+    [[nodiscard]] WorkloadReplayer& getReplayer();
+
+    /// @return A reference to the in-memory account existence filter.
+    /// @warning Throws if the filter is not initialized (mod not enabled or filter disabled).
+    [[nodiscard]] AccountFilter& getAccountFilter();
+
+    /// @return A reference to the economy backup / restore tool.
+    /// @warning Throws if the backup tool is not initialized (mod not enabled).
+    [[nodiscard]] EconomyBackup& getBackup();
+
+    /// Starts restoring balances, holds (and the economy log, if the backup contains it) from a backup file.
+    /// Once the restored tables are committed, reloads the hold cache, rebuilds the account filter
+    /// and requests a full balance snapshot.
+    /// @return False if the file is invalid or another job is running; progress is in getBackup().getReport().
+    bool restoreBackup(const std::string& fileName);
+
+    /// @return A reference to the online SQLite / MySQL / PostgreSQL migration tool.
+    /// @warning Throws if the migrator is not initialized (mod not enabled).
+    [[nodiscard]] BackendMigrator& getMigrator();
+
+    /// @return A reference to the loader that queries form data off the server thread.
+    /// @warning Throws if the form loader is not initialized (mod not enabled).
+    [[nodiscard]] ui::FormLoader& getFormLoader();
+
+    /// Starts exporting economy_log to a CSV file and submits its chunks to the background scheduler.
+    /// @return False if an export or replay is already running or the file cannot be created.
+    bool startReplayExport(const std::string& fileName);
+
+    /// @return A new, not yet connected database connection built from the current configuration,
+    ///         or nullptr if the configured database type is unsupported.
+    [[nodiscard]] std::unique_ptr<db::IDatabaseConnection> createDatabaseConnection(bool verbose = false) const;
+
+    /// @return A new, not yet connected database connection built from the given configuration,
+    ///         or nullptr if its database type is unsupported.
+    [[nodiscard]] std::unique_ptr<db::IDatabaseConnection>
+    createDatabaseConnection(const Config& cfg, bool verbose) const;
+
 
 
 
@@ -49,6 +160,31 @@ private:
     ll::mod::NativeMod& mSelf;
     std::unique_ptr<db::IDatabaseConnection> mDbConnection; // 使用接口类型的 unique_ptr
     std::unique_ptr<MoneyManager> mMoneyManager; // 经济管理器指针
+    std::unique_ptr<FlowCounters> mFlowCounters; // 资金流向计数器 (MoneyManager 持有其裸指针)
+    std::unique_ptr<ActiveUserTracker> mActiveUsers; // 活跃玩家统计 (MoneyManager 持有其裸指针)
+    std::unique_ptr<AccountFilter> mAccountFilter; // 账户存在性过滤器 (MoneyManager 持有其裸指针)
+    std::unique_ptr<scheduler::TaskScheduler> mScheduler; // 后台任务调度器
+    std::unique_ptr<RateLimiter> mRateLimiter; // 写操作限流器
+    std::unique_ptr<ReasonIndexBuilder> mReasonIndex; // 流水理由全文索引构建器
+    std::unique_ptr<ScheduledPaymentEngine> mPaymentEngine; // 定时/周期付款引擎
+    std::unique_ptr<BulkAdjustmentEngine> mBulkEngine; // 批量利息/财富税处理器
+    std::unique_ptr<ReconciliationEngine> mReconciler; // 流水对账器
+    std::unique_ptr<BalanceSnapshotEngine> mSnapshots; // 余额快照引擎
+    std::unique_ptr<LedgerVerifier> mLedgerVerifier; // 流水哈希链校验器
+    std::unique_ptr<WealthAnalyticsEngine> mAnalytics; // 财富分布统计
+    std::unique_ptr<ExploitDetector> mExploitDetector; // 异常收入检测
+    std::unique_ptr<WorkloadReplayer> mReplayer; // 流水导出/回放工具
+    std::unique_ptr<EconomyBackup> mBackup; // 经济数据备份/恢复
+    std::unique_ptr<BackendMigrator> mMigrator; // 数据库迁移工具
+    std::unique_ptr<ui::FormLoader> mFormLoader; // 表单异步加载器
+
+    void runScheduledPayments(); // 处理到期付款，批次已满时继续提交下一批
+    void startBalanceSnapshot(bool forceFull); // 开始生成快照 (已有快照在生成时继续处理)
+    void scheduleWealthAnalytics(); // 提交财富统计的下一个分块
+    void scheduleReplayExport(); // 提交流水导出的下一个分块
+    bool isProductionDatabase(const Config& target) const; // 目标配置是否指向生产数据库 (比较规范化路径 / 主机、端口和库名)
+    std::unique_ptr<db::IDatabaseConnection> createReplayTargetConnection() const; // 回放目标库连接 (与生产库相同时返回 nullptr)
+    std::unique_ptr<db::IDatabaseConnection> createMigrationTargetConnection() const; // 迁移目标库连接 (与生产库相同时返回 nullptr)
     Config mConfig; // 存储加载的配置
     std::filesystem::path mConfigPath; // 配置文件路径
 };
@@ -5,6 +5,7 @@
 #include "czmoney/money/money_api.h" // 包含 TransactionLogEntry 和 API 函数
 #include "czmoney/ui/Transfer.h"     // 包含 TransferForm
 #include "czmoney/ui/AdminMoneyListForm.h" // 包含 AdminMoneyListForm
+#include "czmoney/ui/AdminAccountBrowserForm.h" // 包含账户浏览表单
 #include "ll/api/command/CommandHandle.h"
 #include "ll/api/command/CommandRegistrar.h"
 #include "ll/api/command/EnumName.h"
@@ -17,6 +18,8 @@
 #include "mc/server/commands/CommandOutput.h"
 #include "mc/server/commands/CommandPermissionLevel.h"
 #include "mc/world/actor/player/Player.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <fmt/format.h>
 #include <limits>
@@ -297,7 +300,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                         case czmoney::api::MoneyApiResult::InsufficientBalance:
                         case czmoney::api::MoneyApiResult::UnknownError:
                         default:
-                            errorMessage = "未知错误。";
+                            errorMessage = czmoney::api::getResultMessage(result);
                             break;
                         }
                         output.error(fmt::format(
@@ -375,7 +378,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                 case czmoney::api::MoneyApiResult::InsufficientBalance:
                 case czmoney::api::MoneyApiResult::UnknownError:
                 default:
-                    errorMessage = "未知错误。";
+                    errorMessage = czmoney::api::getResultMessage(result);
                     break;
                 }
                 sendFeedback(
@@ -451,7 +454,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                         case czmoney::api::MoneyApiResult::InsufficientBalance:
                         case czmoney::api::MoneyApiResult::UnknownError:
                         default:
-                            errorMessage = "未知错误。";
+                            errorMessage = czmoney::api::getResultMessage(result);
                             break;
                         }
                         output.error(fmt::format(
@@ -540,7 +543,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                 case czmoney::api::MoneyApiResult::InsufficientBalance:
                 case czmoney::api::MoneyApiResult::UnknownError:
                 default:
-                    errorMessage = "未知错误。";
+                    errorMessage = czmoney::api::getResultMessage(result);
                     break;
                 }
                 sendFeedback(
@@ -633,7 +636,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                         break;
                     case czmoney::api::MoneyApiResult::UnknownError:
                     default:
-                        errorMessage = "未知错误。";
+                        errorMessage = czmoney::api::getResultMessage(result);
                         break;
                     }
                     output.error(fmt::format(
@@ -743,7 +746,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                     break;
                 case czmoney::api::MoneyApiResult::UnknownError:
                 default:
-                    errorMessage = "未知错误。";
+                    errorMessage = czmoney::api::getResultMessage(result);
                     break;
                 }
                 sendFeedback(
@@ -1063,7 +1066,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                         break;
                     case czmoney::api::MoneyApiResult::UnknownError:
                     default:
-                        errorMessage = "未知错误。";
+                        errorMessage = czmoney::api::getResultMessage(transferResult);
                         break;
                     }
                     sendFeedback(
@@ -1196,7 +1199,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
                         break;
                     case czmoney::api::MoneyApiResult::UnknownError:
                     default:
-                        errorMessage = "未知错误。";
+                        errorMessage = czmoney::api::getResultMessage(transferResult);
                         break;
                     }
                     sendFeedback(
@@ -1231,8 +1234,7 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
             // 目前，我们直接打开表单，表单内部会处理默认货币类型
 
             try {
-                czmoney::ui::RankForm form(*player); // 实例化排行榜表单
-                // 表单在构造函数中已经发送，这里不需要额外调用 sendTo
+                czmoney::ui::showRankForm(*player); // 数据就绪后由表单加载器发送
                 output.success("正在打开排行榜表单...");
             } catch (const std::exception& e) {
                 output.error(fmt::format("打开排行榜表单失败：{}", e.what()));
@@ -1267,6 +1269,1177 @@ void registerMoneyCommands(const std::vector<std::string>& aliases) {
             }
         });
 
+    // 10. money admin scheduler - 查看后台任务调度器积压情况
+    moneyCommand.overload()
+        .text("admin")
+        .text("scheduler")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto stats = MyMod::getInstance().getScheduler().getStats();
+                output.success(fmt::format(
+                    "后台任务积压：高 {} / 普通 {} / 低 {}，最老任务已等待 {:.1f}ms",
+                    stats.queuedHigh,
+                    stats.queuedNormal,
+                    stats.queuedLow,
+                    stats.oldestWaitMs
+                ));
+                output.success(fmt::format(
+                    "上个 tick：间隔 {:.1f}ms，预算 {:.2f}ms，已用 {:.2f}ms",
+                    stats.lastTickIntervalMs,
+                    stats.lastBudgetMs,
+                    stats.lastUsedMs
+                ));
+                output.success(fmt::format(
+                    "累计：执行 {} 个任务 (失败 {})，提升优先级 {} 次，{} / {} 个 tick 留有积压",
+                    stats.executedTotal,
+                    stats.failedTotal,
+                    stats.escalatedTotal,
+                    stats.ticksOverBudget,
+                    stats.ticksTotal
+                ));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取调度器状态失败：{}", e.what()));
+            }
+        });
+
+
+    // 11. money admin bulk start <percent> [threshold] [currencyType] - 开始批量利息/财富税
+    moneyCommand.overload<MoneyBulkStartArgs>()
+        .text("admin")
+        .text("bulk")
+        .text("start")
+        .required("percent")
+        .optional("threshold")
+        .optional("currencyType")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyBulkStartArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            std::string currencyType = getTargetCurrencyType(args.currencyType);
+            int64_t     jobId        = 0;
+            auto        result       = czmoney::api::startBulkAdjustment(
+                currencyType,
+                static_cast<double>(args.percent),
+                static_cast<double>(args.threshold),
+                jobId,
+                args.percent >= 0.0f ? "Interest" : "WealthTax"
+            );
+            switch (result) {
+            case czmoney::api::MoneyApiResult::Success:
+                output.success(fmt::format(
+                    "批量调整任务 #{} 已开始：{} 比例 {:.2f}%，起点 {:.2f}。使用 /money admin bulk status 查看进度。",
+                    jobId,
+                    currencyType,
+                    args.percent,
+                    args.threshold
+                ));
+                break;
+            case czmoney::api::MoneyApiResult::JobInProgress:
+                output.error("已有批量调整任务在运行，请等待完成或先取消。");
+                break;
+            case czmoney::api::MoneyApiResult::InvalidAmount:
+                output.error("比例必须在 -100 到 100 之间且不为 0，起点不能为负数。");
+                break;
+            case czmoney::api::MoneyApiResult::DatabaseError:
+                output.error("数据库错误，无法开始批量调整。");
+                break;
+            default:
+                output.error(fmt::format("无法开始批量调整 (货币类型 '{}' 是否已配置?)。", currencyType));
+                break;
+            }
+        });
+
+    // 12. money admin bulk status - 查看批量调整进度
+    moneyCommand.overload()
+        .text("admin")
+        .text("bulk")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto job = MyMod::getInstance().getBulkAdjustmentEngine().getJobStatus();
+                if (!job) {
+                    output.success("没有批量调整任务记录。");
+                    return;
+                }
+                int64_t percent = job->totalAccounts > 0
+                                    ? std::min<int64_t>(100, job->processedAccounts * 100 / job->totalAccounts)
+                                    : (job->status == "completed" ? 100 : 0);
+                output.success(fmt::format(
+                    "任务 #{} [{}]：{} 比例 {:.2f}%，进度 {}% ({}/{} 个账户)，总变动 {}",
+                    job->id,
+                    job->status,
+                    job->currencyType,
+                    static_cast<double>(job->rateBasisPoints) / 100.0,
+                    percent,
+                    job->processedAccounts,
+                    job->totalAccounts,
+                    czmoney::api::formatBalance(job->totalDelta)
+                ));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取批量调整状态失败：{}", e.what()));
+            }
+        });
+
+    // 13. money admin bulk cancel - 取消批量调整 (已处理的部分保留)
+    moneyCommand.overload()
+        .text("admin")
+        .text("bulk")
+        .text("cancel")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            if (czmoney::api::cancelBulkAdjustment() == czmoney::api::MoneyApiResult::Success) {
+                output.success("批量调整任务已取消，已处理的账户不会回滚。");
+            } else {
+                output.error("没有运行中的批量调整任务。");
+            }
+        });
+
+    // 14. money admin bulk resume - 出错暂停后继续处理
+    moneyCommand.overload()
+        .text("admin")
+        .text("bulk")
+        .text("resume")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                if (!MyMod::getInstance().getBulkAdjustmentEngine().hasPendingWork()) {
+                    output.error("没有运行中的批量调整任务。");
+                    return;
+                }
+                MyMod::getInstance().scheduleBulkAdjustment();
+                output.success("已重新提交批量调整任务。");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("继续批量调整失败：{}", e.what()));
+            }
+        });
+
+
+    // 15. money admin reconcile check|repair - 对账 (repair 会为不一致的账户追加修复流水)
+    for (const char* mode : {"check", "repair"}) {
+        bool repair = std::string(mode) == "repair";
+        moneyCommand.overload()
+            .text("admin")
+            .text("reconcile")
+            .text(mode)
+            .execute([repair](CommandOrigin const& origin, CommandOutput& output) {
+                if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                    output.error("您没有权限使用此命令。");
+                    return;
+                }
+                try {
+                    if (MyMod::getInstance().getReconciler().start(repair)) {
+                        output.success(fmt::format(
+                            "对账已开始 ({})。使用 /money admin reconcile status 查看进度。",
+                            repair ? "修复模式" : "只读模式"
+                        ));
+                    } else {
+                        output.error("已有对账在运行，或无法读取账户范围 (详见控制台日志)。");
+                    }
+                } catch (const std::exception& e) {
+                    output.error(fmt::format("开始对账失败：{}", e.what()));
+                }
+            });
+    }
+
+    // 16. money admin reconcile status - 查看对账进度与结果
+    moneyCommand.overload()
+        .text("admin")
+        .text("reconcile")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto report = MyMod::getInstance().getReconciler().getReport();
+                output.success(fmt::format(
+                    "对账{}：扫描 {} 个账户，不一致 {} 个，已修复 {} 个，出错分块 {} 个，耗时 {:.0f}ms",
+                    report.running ? "进行中" : (report.cancelled ? "已取消" : "已结束"),
+                    report.scannedAccounts,
+                    report.mismatches,
+                    report.repaired,
+                    report.errors,
+                    report.elapsedMs
+                ));
+                size_t shown = 0;
+                for (const auto& mismatch : report.samples) {
+                    if (++shown > 10) {
+                        output.success(fmt::format("... 其余 {} 条详见控制台日志", report.samples.size() - 10));
+                        break;
+                    }
+                    output.success(fmt::format(
+                        "- {} [{}] 余额 {} / 流水推算 {}{}",
+                        mismatch.uuid,
+                        mismatch.currencyType,
+                        czmoney::api::formatBalance(mismatch.actual),
+                        czmoney::api::formatBalance(mismatch.expected),
+                        mismatch.repaired ? " (已修复)" : ""
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取对账状态失败：{}", e.what()));
+            }
+        });
+
+    // 17. money admin reconcile cancel - 取消对账
+    moneyCommand.overload()
+        .text("admin")
+        .text("reconcile")
+        .text("cancel")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& reconciler = MyMod::getInstance().getReconciler();
+                if (!reconciler.isRunning()) {
+                    output.error("没有正在运行的对账。");
+                    return;
+                }
+                reconciler.stop();
+                output.success("对账已取消。");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("取消对账失败：{}", e.what()));
+            }
+        });
+
+    // 18. money admin snapshot take|full - 立即生成余额快照 (take 按配置决定全量或增量)
+    for (const char* mode : {"take", "full"}) {
+        bool forceFull = std::string(mode) == "full";
+        moneyCommand.overload()
+            .text("admin")
+            .text("snapshot")
+            .text(mode)
+            .execute([forceFull](CommandOrigin const& origin, CommandOutput& output) {
+                if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                    output.error("您没有权限使用此命令。");
+                    return;
+                }
+                try {
+                    int64_t snapshotId = 0;
+                    auto    result     = MyMod::getInstance().getSnapshotEngine().startSnapshot(forceFull, snapshotId);
+                    if (result == czmoney::api::MoneyApiResult::Success) {
+                        MyMod::getInstance().scheduleBalanceSnapshot();
+                        output.success(fmt::format(
+                            "余额快照 #{} 已开始生成。使用 /money admin snapshot status 查看进度。",
+                            snapshotId
+                        ));
+                    } else if (result == czmoney::api::MoneyApiResult::JobInProgress) {
+                        output.error("已有余额快照在生成，请等待完成。");
+                    } else {
+                        output.error("无法开始生成余额快照 (详见控制台日志)。");
+                    }
+                } catch (const std::exception& e) {
+                    output.error(fmt::format("生成余额快照失败：{}", e.what()));
+                }
+            });
+    }
+
+    // 19. money admin snapshot status - 查看最近一次快照
+    moneyCommand.overload()
+        .text("admin")
+        .text("snapshot")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto snapshot = MyMod::getInstance().getSnapshotEngine().getSnapshotStatus();
+                if (!snapshot) {
+                    output.success("没有余额快照记录。");
+                    return;
+                }
+                output.success(fmt::format(
+                    "快照 #{} [{} / {}]：已写入 {} 个账户，游标 id {}{}",
+                    snapshot->id,
+                    snapshot->kind,
+                    snapshot->status,
+                    snapshot->rowCount,
+                    snapshot->lastId,
+                    snapshot->completedAt.empty() ? "" : "，完成于 " + snapshot->completedAt
+                ));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取快照状态失败：{}", e.what()));
+            }
+        });
+
+    // 20. money admin balanceat <playerName> <time> [currencyType] - 查询玩家在某个时间点的余额
+    moneyCommand.overload<MoneyBalanceAtArgs>()
+        .text("admin")
+        .text("balanceat")
+        .required("playerName")
+        .required("time")
+        .optional("currencyType")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyBalanceAtArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            std::string currency      = getTargetCurrencyType(args.currencyType);
+            auto        playerInfoOpt = PlayerInfo::getInstance().fromName(args.playerName);
+            if (!playerInfoOpt.has_value()) {
+                output.error(fmt::format("未找到玩家 '{}'。", args.playerName));
+                return;
+            }
+            std::string uuid = playerInfoOpt->uuid.asString();
+            try {
+                auto startedAt = std::chrono::steady_clock::now();
+                auto balance   = MyMod::getInstance().getSnapshotEngine().getBalanceAt(uuid, currency, args.time);
+                double elapsedMs =
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt).count();
+                if (!balance) {
+                    output.error(fmt::format("没有足够的快照或流水来推算 {} 在 {} 的余额。", args.playerName, args.time));
+                    return;
+                }
+                output.success(fmt::format(
+                    "{} 在 {} 的 {} 余额：{}{}",
+                    args.playerName,
+                    args.time,
+                    currency,
+                    czmoney::api::formatBalance(balance->amount),
+                    balance->approximate ? " (近似值：区间内有批量调整或账户可能尚未创建)" : ""
+                ));
+                output.success(fmt::format(
+                    "起点：{}，重放流水 {} 条，耗时 {:.1f}ms",
+                    balance->snapshotId > 0 ? fmt::format("快照 #{}", balance->snapshotId) : std::string("流水"),
+                    balance->replayedRows,
+                    elapsedMs
+                ));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("查询历史余额失败：{}", e.what()));
+            }
+        });
+
+    // 21. money admin ledger verify - 并行校验流水哈希链
+    moneyCommand.overload()
+        .text("admin")
+        .text("ledger")
+        .text("verify")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                if (MyMod::getInstance().getLedgerVerifier().start()) {
+                    output.success("哈希链校验已开始。使用 /money admin ledger status 查看进度。");
+                } else {
+                    output.error("已有校验在运行，或流水表没有 chain_hash 列 (详见控制台日志)。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始哈希链校验失败：{}", e.what()));
+            }
+        });
+
+    // 22. money admin ledger status - 查看哈希链校验进度与结果
+    moneyCommand.overload()
+        .text("admin")
+        .text("ledger")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto report = MyMod::getInstance().getLedgerVerifier().getReport();
+                output.success(fmt::format(
+                    "哈希链校验{}：检查 {} 行 (链开始前的旧流水 {} 行)，断链 {} 处，出错分块 {} 个，耗时 {:.0f}ms",
+                    report.running ? "进行中" : (report.cancelled ? "已取消" : "已结束"),
+                    report.checkedRows,
+                    report.unsealedRows,
+                    report.brokenLinks,
+                    report.errors,
+                    report.elapsedMs
+                ));
+                if (report.firstBreak) {
+                    output.error(fmt::format(
+                        "最早的断链：流水 #{} ({})：{}",
+                        report.firstBreak->logId,
+                        report.firstBreak->currencyType,
+                        report.firstBreak->reason
+                    ));
+                }
+                size_t shown = 0;
+                for (const auto& brk : report.samples) {
+                    if (++shown > 10) {
+                        output.success(fmt::format("... 其余 {} 条详见控制台日志", report.samples.size() - 10));
+                        break;
+                    }
+                    output.success(fmt::format("- #{} [{}] {}", brk.logId, brk.currencyType, brk.reason));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取哈希链校验状态失败：{}", e.what()));
+            }
+        });
+
+    // 23. money admin ledger cancel - 取消哈希链校验
+    moneyCommand.overload()
+        .text("admin")
+        .text("ledger")
+        .text("cancel")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& verifier = MyMod::getInstance().getLedgerVerifier();
+                if (!verifier.isRunning()) {
+                    output.error("没有正在运行的哈希链校验。");
+                    return;
+                }
+                verifier.stop();
+                output.success("哈希链校验已取消。");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("取消哈希链校验失败：{}", e.what()));
+            }
+        });
+
+    // 24. money admin analytics run - 立即统计财富分布 (完成后写入 JSON 文件)
+    moneyCommand.overload()
+        .text("admin")
+        .text("analytics")
+        .text("run")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                if (MyMod::getInstance().startWealthAnalytics()) {
+                    output.success("财富分布统计已开始。使用 /money admin analytics show 查看结果。");
+                } else {
+                    output.error("已有统计在运行。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始财富分布统计失败：{}", e.what()));
+            }
+        });
+
+    // 25. money admin analytics show [currencyType] - 查看最近一次财富分布统计
+    moneyCommand.overload<MoneyAnalyticsArgs>()
+        .text("admin")
+        .text("analytics")
+        .text("show")
+        .optional("currencyType")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyAnalyticsArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& analytics = MyMod::getInstance().getWealthAnalytics();
+                auto  report    = analytics.getLastReport();
+                if (!report) {
+                    output.error(
+                        analytics.isRunning() ? "统计正在进行，请稍后再试。"
+                                              : "还没有统计结果，使用 /money admin analytics run 开始统计。"
+                    );
+                    return;
+                }
+                std::string filter = args.currencyType;
+                output.success(fmt::format(
+                    "财富分布 (统计于 {}，{} 个账户，耗时 {:.0f}ms){}",
+                    report->generatedAt,
+                    report->accountsScanned,
+                    report->elapsedMs,
+                    analytics.isRunning() ? "，新的统计进行中" : ""
+                ));
+                bool found = false;
+                for (const auto& stats : report->currencies) {
+                    if (!filter.empty() && stats.currencyType != filter) continue;
+                    found = true;
+                    output.success(fmt::format(
+                        "[{}] 账户 {} (零余额 {}，负余额 {})，总量 {}，平均 {}",
+                        stats.currencyType,
+                        stats.accounts,
+                        stats.zeroAccounts,
+                        stats.negativeAccounts,
+                        czmoney::api::formatBalance(stats.totalSupply),
+                        czmoney::api::formatBalance(stats.mean)
+                    ));
+                    output.success(fmt::format(
+                        "  基尼系数 {:.3f}，前 1% 持有 {:.1f}%，前 10% 持有 {:.1f}%",
+                        stats.gini,
+                        stats.top1Share * 100.0,
+                        stats.top10Share * 100.0
+                    ));
+                    std::string percentiles;
+                    for (const auto& [p, value] : stats.percentiles) {
+                        percentiles += fmt::format(
+                            "{}P{:g}={}",
+                            percentiles.empty() ? "" : "，",
+                            p,
+                            czmoney::api::formatBalance(value)
+                        );
+                    }
+                    if (!percentiles.empty()) {
+                        output.success("  " + percentiles);
+                    }
+                }
+                for (const auto& flow : report->dailyFlows) {
+                    if (!filter.empty() && flow.currencyType != filter) continue;
+                    output.success(fmt::format(
+                        "  {} [{}] 流入 {}，流出 {}，净变化 {} ({} 条流水)",
+                        flow.day,
+                        flow.currencyType,
+                        czmoney::api::formatBalance(flow.created),
+                        czmoney::api::formatBalance(flow.destroyed),
+                        czmoney::api::formatBalance(flow.created - flow.destroyed),
+                        flow.entries
+                    ));
+                }
+                if (!found && !filter.empty()) {
+                    output.error(fmt::format("统计结果中没有货币 '{}'。", filter));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取财富分布统计失败：{}", e.what()));
+            }
+        });
+
+    // 26. money admin alerts - 查看最近的异常收入告警
+    moneyCommand.overload()
+        .text("admin")
+        .text("alerts")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& detector = MyMod::getInstance().getExploitDetector();
+                auto  alerts   = detector.getRecentAlerts(10);
+                if (alerts.empty()) {
+                    output.success("没有异常收入告警。");
+                    return;
+                }
+                output.success(fmt::format("异常收入告警 (累计 {} 次，最近 {} 条)：", detector.getAlertCount(), alerts.size()));
+                auto now = std::chrono::system_clock::now();
+                for (const auto& alert : alerts) {
+                    auto ago = std::chrono::duration_cast<std::chrono::seconds>(now - alert.raisedAt).count();
+                    std::string subject = alert.kind == "player"
+                                            ? fmt::format("玩家 {}", alert.playerUuid)
+                                            : fmt::format("理由 '{}' / '{}'", alert.reason1, alert.reason2);
+                    output.success(fmt::format(
+                        "- {} 秒前 {} [{}]：窗口内 {} ({} 笔)，基线 {}，z = {:.1f}",
+                        ago,
+                        subject,
+                        alert.currencyType,
+                        czmoney::api::formatBalance(alert.windowAmount),
+                        alert.windowCount,
+                        czmoney::api::formatBalance(static_cast<int64_t>(alert.baseline)),
+                        alert.zScore
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取异常收入告警失败：{}", e.what()));
+            }
+        });
+
+    // 27. money admin flows plugin [currencyType] - 查看按插件统计的资金流向 (前 10 项)
+    moneyCommand.overload<MoneyAnalyticsArgs>()
+        .text("admin")
+        .text("flows")
+        .text("plugin")
+        .optional("currencyType")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyAnalyticsArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                std::string currencyType = args.currencyType;
+                auto counters = MyMod::getInstance().getFlowCounters().getCounters(currencyType, false);
+                if (counters.empty()) {
+                    output.success("没有资金流向记录。");
+                    return;
+                }
+                output.success(fmt::format(
+                    "资金流向 (按插件，共 {} 项，显示前 {} 项)：",
+                    counters.size(),
+                    std::min<size_t>(counters.size(), 10)
+                ));
+                for (size_t i = 0; i < counters.size() && i < 10; ++i) {
+                    const auto& counter = counters[i];
+                    output.success(fmt::format(
+                        "- [{}] 插件 {}：流入 {}，流出 {}，净变化 {} ({} 次)",
+                        counter.currencyType,
+                        counter.reason1.empty() ? "(空)" : counter.reason1,
+                        czmoney::api::formatBalance(counter.sumIn),
+                        czmoney::api::formatBalance(counter.sumOut),
+                        czmoney::api::formatBalance(counter.sumIn - counter.sumOut),
+                        counter.ops
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取资金流向失败：{}", e.what()));
+            }
+        });
+
+    // 28. money admin flows reason [currencyType] - 查看按理由统计的资金流向 (前 10 项)
+    moneyCommand.overload<MoneyAnalyticsArgs>()
+        .text("admin")
+        .text("flows")
+        .text("reason")
+        .optional("currencyType")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyAnalyticsArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                std::string currencyType = args.currencyType;
+                auto counters = MyMod::getInstance().getFlowCounters().getCounters(currencyType, true);
+                if (counters.empty()) {
+                    output.success("没有资金流向记录。");
+                    return;
+                }
+                output.success(fmt::format(
+                    "资金流向 (按理由，共 {} 项，显示前 {} 项)：",
+                    counters.size(),
+                    std::min<size_t>(counters.size(), 10)
+                ));
+                for (size_t i = 0; i < counters.size() && i < 10; ++i) {
+                    const auto& counter = counters[i];
+                    output.success(fmt::format(
+                        "- [{}] 理由 '{}' / '{}'：流入 {}，流出 {}，净变化 {} ({} 次)",
+                        counter.currencyType,
+                        counter.reason1, counter.reason2,
+                        czmoney::api::formatBalance(counter.sumIn),
+                        czmoney::api::formatBalance(counter.sumOut),
+                        czmoney::api::formatBalance(counter.sumIn - counter.sumOut),
+                        counter.ops
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取资金流向失败：{}", e.what()));
+            }
+        });
+
+    // 29. money admin active [days] [currencyType] - 查看最近几天的活跃玩家数 (HyperLogLog 估计)
+    moneyCommand.overload<MoneyActiveArgs>()
+        .text("admin")
+        .text("active")
+        .optional("days")
+        .optional("currencyType")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyActiveArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto&       tracker      = MyMod::getInstance().getActiveUsers();
+                int         days         = args.days > 0 ? std::min(args.days, 366) : 7;
+                std::string currencyType = args.currencyType;
+                auto        total        = tracker.countUnique(currencyType, days);
+                if (!total) {
+                    output.error("查询活跃玩家统计失败，请查看服务器日志。");
+                    return;
+                }
+                output.success(fmt::format(
+                    "最近 {} 天{}的活跃玩家约 {} 人 (估计值，误差约 1.6%)",
+                    days,
+                    currencyType.empty() ? "" : fmt::format(" [{}] ", currencyType),
+                    *total
+                ));
+                // 逐日数据只显示最近 7 天，避免刷屏
+                auto daily = tracker.countDaily(currencyType, std::min(days, 7));
+                for (const auto& [day, count] : daily) {
+                    output.success(fmt::format("  {}：{} 人", day, count));
+                }
+                auto reasons = tracker.countByReason(currencyType, days);
+                for (size_t i = 0; i < reasons.size() && i < 10; ++i) {
+                    output.success(fmt::format(
+                        "  - {}：{} 人",
+                        reasons[i].first.empty() ? "(空)" : reasons[i].first,
+                        reasons[i].second
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取活跃玩家统计失败：{}", e.what()));
+            }
+        });
+
+    // 30. money admin replay export <file> - 把 economy_log 导出为 CSV，供回放使用
+    moneyCommand.overload<MoneyReplayArgs>()
+        .text("admin")
+        .text("replay")
+        .text("export")
+        .required("file")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyReplayArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                if (MyMod::getInstance().startReplayExport(args.file)) {
+                    output.success(fmt::format("已开始导出流水到 replay/{}，使用 /money admin replay status 查看进度。", args.file));
+                } else {
+                    output.error("无法开始导出：已有导出或回放在运行，或文件名无效 (只能是文件名，不能包含路径)。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始导出失败：{}", e.what()));
+            }
+        });
+
+    // 31. money admin replay run <file> [speed] [overwrite] - 在回放目标数据库中重放导出的流水并统计性能
+    moneyCommand.overload<MoneyReplayArgs>()
+        .text("admin")
+        .text("replay")
+        .text("run")
+        .required("file")
+        .optional("speed")
+        .optional("overwrite")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyReplayArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                if (MyMod::getInstance().getReplayer().startReplay(args.file, static_cast<double>(args.speed), args.overwrite)) {
+                    output.success(fmt::format(
+                        "已开始回放 replay/{} (倍速: {})，使用 /money admin replay status 查看结果。",
+                        args.file,
+                        args.speed > 0.0f ? fmt::format("{:g}", args.speed) : "不等待"
+                    ));
+                } else {
+                    output.error("无法开始回放：已有导出或回放在运行，或文件不存在。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始回放失败：{}", e.what()));
+            }
+        });
+
+    // 32. money admin replay status - 查看导出 / 回放的进度与结果
+    moneyCommand.overload()
+        .text("admin")
+        .text("replay")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto report = MyMod::getInstance().getReplayer().getReport();
+                if (report.mode.empty()) {
+                    output.success("还没有运行过导出或回放。");
+                    return;
+                }
+                std::string state = report.running ? "进行中" : (report.cancelled ? "已取消" : "已结束");
+                if (!report.error.empty()) {
+                    output.error(fmt::format("{} {} 失败：{}", report.mode == "export" ? "导出" : "回放", report.file, report.error));
+                    return;
+                }
+                if (report.mode == "export") {
+                    output.success(fmt::format(
+                        "导出 {} {}：已写出 {} 行，耗时 {:.0f}ms",
+                        report.file,
+                        state,
+                        report.totalOps,
+                        report.elapsedMs
+                    ));
+                    return;
+                }
+                output.success(fmt::format(
+                    "回放 {} {} (目标 {})：{}/{} 条操作，跳过 {} 行，{} 个账户 (建立耗时 {:.0f}ms)",
+                    report.file,
+                    state,
+                    report.targetType.empty() ? "-" : report.targetType,
+                    report.replayedOps,
+                    report.totalOps,
+                    report.skippedRows,
+                    report.accounts,
+                    report.seedMs
+                ));
+                if (!report.running) {
+                    output.success(fmt::format(
+                        "吞吐量 {:.0f} ops/s，延迟 p50 {:.2f}ms / p95 {:.2f}ms / p99 {:.2f}ms / max {:.2f}ms，最大落后 {:.0f}ms",
+                        report.opsPerSecond,
+                        report.p50Ms,
+                        report.p95Ms,
+                        report.p99Ms,
+                        report.maxMs,
+                        report.maxLagMs
+                    ));
+                    output.success(fmt::format(
+                        "失败 {} 条，余额与流水不一致 {} 次，最终余额不一致账户 {} 个",
+                        report.failedOps,
+                        report.previousMismatches,
+                        report.finalMismatches
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取回放状态失败：{}", e.what()));
+            }
+        });
+
+    // 33. money admin replay cancel - 取消导出或回放
+    moneyCommand.overload()
+        .text("admin")
+        .text("replay")
+        .text("cancel")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& replayer = MyMod::getInstance().getReplayer();
+                if (!replayer.isRunning()) {
+                    output.error("没有正在运行的导出或回放。");
+                    return;
+                }
+                replayer.stop();
+                output.success("已取消。");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("取消失败：{}", e.what()));
+            }
+        });
+
+    // 34. money admin accountfilter - 查看账户存在性过滤器的误判率与命中情况
+    moneyCommand.overload()
+        .text("admin")
+        .text("accountfilter")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto stats = MyMod::getInstance().getAccountFilter().getStats();
+                output.success(fmt::format(
+                    "账户过滤器：{} 个账户 / 容量 {}，{} 层，占用 {} KB",
+                    stats.entries,
+                    stats.capacity,
+                    stats.layers,
+                    stats.memoryBytes / 1024
+                ));
+                output.success(fmt::format(
+                    "查询 {} 次，直接判定不存在 {} 次，误判 {} 次",
+                    stats.lookups,
+                    stats.definitelyAbsent,
+                    stats.falsePositives
+                ));
+                output.success(fmt::format(
+                    "误判率：预计 {:.4f}%，实测 {:.4f}%",
+                    stats.estimatedFpr * 100.0,
+                    stats.observedFpr * 100.0
+                ));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取账户过滤器统计失败：{}", e.what()));
+            }
+        });
+
+    // 35. money admin backup create <file> [withLog] - 在后台把余额 (和流水) 备份为二进制文件
+    moneyCommand.overload<MoneyBackupArgs>()
+        .text("admin")
+        .text("backup")
+        .text("create")
+        .required("file")
+        .optional("withLog")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyBackupArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                if (MyMod::getInstance().getBackup().startBackup(args.file, args.withLog)) {
+                    output.success(fmt::format(
+                        "已开始备份到 backup/{} (包含流水: {})，使用 /money admin backup status 查看进度。",
+                        args.file,
+                        args.withLog ? "是" : "否"
+                    ));
+                } else {
+                    output.error("无法开始备份：已有备份在运行、文件名无效 (只能是文件名，不能包含路径) 或无法建立快照。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始备份失败：{}", e.what()));
+            }
+        });
+
+    // 36. money admin backup status - 查看备份 / 恢复的进度与结果
+    moneyCommand.overload()
+        .text("admin")
+        .text("backup")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto report = MyMod::getInstance().getBackup().getReport();
+                if (report.mode.empty()) {
+                    output.success("还没有运行过备份或恢复。");
+                    return;
+                }
+                std::string action = report.mode == "backup" ? "备份" : "恢复";
+                if (!report.error.empty()) {
+                    output.error(fmt::format("{} {} 失败：{}", action, report.file, report.error));
+                    return;
+                }
+                std::string state = report.running ? "进行中" : (report.cancelled ? "已取消" : "已完成");
+                output.success(fmt::format(
+                    "{} {} {} (来源 {})：{} 个账户，{} 条冻结，{} 条流水，耗时 {:.0f}ms",
+                    action,
+                    report.file,
+                    state,
+                    report.sourceType.empty() ? "-" : report.sourceType,
+                    report.balanceRows,
+                    report.holdRows,
+                    report.includesLog ? std::to_string(report.logRows) : "未包含",
+                    report.elapsedMs
+                ));
+                if (report.mode == "backup" && !report.running && !report.cancelled && report.fileBytes > 0) {
+                    output.success(fmt::format(
+                        "文件大小 {} KB (原始数据约 {} KB，压缩比 {:.1f}x)",
+                        report.fileBytes / 1024,
+                        report.rawBytes / 1024,
+                        static_cast<double>(report.rawBytes) / static_cast<double>(report.fileBytes)
+                    ));
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取备份状态失败：{}", e.what()));
+            }
+        });
+
+    // 37. money admin backup cancel - 取消正在运行的备份
+    moneyCommand.overload()
+        .text("admin")
+        .text("backup")
+        .text("cancel")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& backup = MyMod::getInstance().getBackup();
+                if (!backup.isRunning()) {
+                    output.error("没有正在运行的备份。");
+                    return;
+                }
+                backup.stop();
+                output.success("已取消。");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("取消失败：{}", e.what()));
+            }
+        });
+
+    // 38. money admin backup restore <file> - 在后台用备份文件替换当前的余额、冻结 (和流水)
+    moneyCommand.overload<MoneyBackupArgs>()
+        .text("admin")
+        .text("backup")
+        .text("restore")
+        .required("file")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, MoneyBackupArgs const& args, ::Command const&) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& mod = MyMod::getInstance();
+                if (mod.getBackup().isRunning()) {
+                    output.error("有备份正在运行，请等待完成或取消后再恢复。");
+                    return;
+                }
+                if (!mod.restoreBackup(args.file)) {
+                    output.error("无法开始恢复，数据库未被修改：文件不存在或文件名无效。");
+                    return;
+                }
+                output.success(fmt::format(
+                    "已开始从 backup/{} 恢复 (校验文件后逐块写入，最后一次性替换)，使用 /money admin backup status 查看进度。",
+                    args.file
+                ));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("恢复失败：{}", e.what()));
+            }
+        });
+
+    // 39. money admin migrate start - 在后台把全部表复制到配置 migration 指定的数据库 (目标库必须为空)
+    moneyCommand.overload()
+        .text("admin")
+        .text("migrate")
+        .text("start")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& migrator = MyMod::getInstance().getMigrator();
+                if (migrator.start()) {
+                    output.success("已开始全量复制，使用 /money admin migrate status 查看进度。");
+                } else {
+                    output.error("已有迁移任务在运行。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始迁移失败：{}", e.what()));
+            }
+        });
+
+    // 40. money admin migrate catchup - 复制全量复制之后的写入并校验 (应先停止经济写入)
+    moneyCommand.overload()
+        .text("admin")
+        .text("migrate")
+        .text("catchup")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& migrator = MyMod::getInstance().getMigrator();
+                if (!migrator.isCopied()) {
+                    output.error("尚未完成全量复制，请先执行 /money admin migrate start。");
+                    return;
+                }
+                if (migrator.catchUp()) {
+                    output.success("已开始追赶与校验，使用 /money admin migrate status 查看结果。");
+                } else {
+                    output.error("已有迁移任务在运行。");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("开始追赶失败：{}", e.what()));
+            }
+        });
+
+    // 41. money admin migrate status - 查看迁移的进度与各表的校验结果
+    moneyCommand.overload()
+        .text("admin")
+        .text("migrate")
+        .text("status")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto report = MyMod::getInstance().getMigrator().getReport();
+                if (report.phase.empty()) {
+                    output.success("还没有运行过迁移。");
+                    return;
+                }
+                std::string phase = report.phase == "copy" ? "全量复制" : "追赶与校验";
+                if (!report.error.empty()) {
+                    output.error(fmt::format("{} ({} -> {}) 失败：{}", phase, report.sourceType, report.targetType, report.error));
+                    return;
+                }
+                std::string state = report.running ? fmt::format("进行中 ({})", report.currentTable)
+                                                   : (report.cancelled ? "已取消" : "已完成");
+                output.success(fmt::format(
+                    "{} ({} -> {}) {}，已完成 {} 轮追赶，耗时 {:.0f}ms",
+                    phase,
+                    report.sourceType,
+                    report.targetType,
+                    state,
+                    report.passes,
+                    report.elapsedMs
+                ));
+                for (const auto& table : report.tables) {
+                    if (!table.verified) {
+                        output.success(fmt::format("  {}: 写入 {} 行", table.table, table.copiedRows));
+                        continue;
+                    }
+                    bool matched = table.sourceRows == table.targetRows && table.sourceChecksum == table.targetChecksum;
+                    output.success(fmt::format(
+                        "  {}: 写入 {} 行，源库 {} 行 / 目标库 {} 行，{}",
+                        table.table,
+                        table.copiedRows,
+                        table.sourceRows,
+                        table.targetRows,
+                        matched ? "一致" : "不一致"
+                    ));
+                }
+                if (report.phase == "catchup" && !report.running && !report.cancelled) {
+                    if (report.mismatches == 0) {
+                        output.success(fmt::format(
+                            "校验通过。把配置 database.type 改为 {} 并重启服务器即可完成切换。",
+                            report.targetType
+                        ));
+                    } else {
+                        output.error(fmt::format(
+                            "{} 个表不一致。请确认已停止经济写入后再执行一次 /money admin migrate catchup。",
+                            report.mismatches
+                        ));
+                    }
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("获取迁移状态失败：{}", e.what()));
+            }
+        });
+
+    // 42. money admin migrate cancel - 取消正在运行的迁移任务
+    moneyCommand.overload()
+        .text("admin")
+        .text("migrate")
+        .text("cancel")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            try {
+                auto& migrator = MyMod::getInstance().getMigrator();
+                if (!migrator.isRunning()) {
+                    output.error("没有正在运行的迁移任务。");
+                    return;
+                }
+                migrator.stop();
+                output.success("已取消。取消全量复制后需要清空目标库才能重新开始。");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("取消失败：{}", e.what()));
+            }
+        });
+
+    // 43. money admin accounts - 按余额 / 更新时间分页浏览某种货币的全部账户
+    moneyCommand.overload()
+        .text("admin")
+        .text("accounts")
+        .execute([](CommandOrigin const& origin, CommandOutput& output) {
+            if (origin.getPermissionsLevel() < CommandPermissionLevel::GameDirectors) {
+                output.error("您没有权限使用此命令。");
+                return;
+            }
+            if (origin.getOriginType() != CommandOriginType::Player) {
+                output.error("此命令只能由玩家执行。");
+                return;
+            }
+            Actor* actor = origin.getEntity();
+            if (!actor || !actor->isPlayer()) {
+                output.error("无法从命令源获取玩家实体。");
+                return;
+            }
+            Player* player = static_cast<Player*>(actor);
+
+            try {
+                czmoney::ui::showAdminAccountBrowserForm(*player);
+                output.success("正在打开账户浏览表单...");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("打开账户浏览表单失败：{}", e.what()));
+            }
+        });
 
 } // registerMoneyCommands function end
 
@@ -99,6 +99,43 @@ struct MoneyRankArgs {
     // int count = 10;
 };
 
+// 用于批量利息/财富税
+struct MoneyBulkStartArgs {
+    float                   percent;        // 调整比例 (百分比)，正数为利息，负数为财富税
+    float                   threshold;      // 起息点/起征点 (可选)
+    ll::command::SoftEnum<CurrencyTypeEnum> currencyType;   // 货币类型 (可选)
+};
+
+// 用于查询离线玩家在某个时间点的余额
+struct MoneyBalanceAtArgs {
+    std::string             playerName;     // 玩家名称
+    std::string             time;           // 时间点 (例如 "2025-01-01 12:00:00"，含空格时需加引号)
+    ll::command::SoftEnum<CurrencyTypeEnum> currencyType;   // 货币类型 (可选)
+};
+
+// 用于查看财富分布统计和资金流向 (不指定货币时显示全部货币)
+struct MoneyAnalyticsArgs {
+    ll::command::SoftEnum<CurrencyTypeEnum> currencyType; // 可选的货币类型
+};
+
+// 用于导出 / 回放流水 (基准测试)
+struct MoneyReplayArgs {
+    std::string             file;           // 文件名 (位于插件数据目录的 replay 目录下)
+    float                   speed = 0;      // 回放倍速 (可选)，1 为原始节奏，0 表示不等待
+    bool                    overwrite = false; // 目标库已有数据时是否清空后回放 (可选，默认拒绝)
+};
+
+// 用于备份 / 恢复经济数据
+struct MoneyBackupArgs {
+    std::string             file;           // 文件名 (位于插件数据目录的 backup 目录下)
+    bool                    withLog = true; // 是否同时备份流水 (可选，默认备份)
+};
+
+// 用于查看活跃玩家统计 (不指定货币时合并全部货币)
+struct MoneyActiveArgs {
+    int                     days = 0;       // 统计最近几天 (可选，默认 7)
+    ll::command::SoftEnum<CurrencyTypeEnum> currencyType;   // 货币类型 (可选)
+};
 
 
 // --- 命令注册函数声明 ---
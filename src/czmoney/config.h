@@ -18,6 +18,8 @@ struct CurrencyConfig {
     bool allowTransfer = true; // 默认为允许
     // 转账税率 (0.0 到 1.0 之间的小数，例如 0.05 表示 5%)
     double transferTaxRate = 0.0; // 默认为 0%
+    // 创建账户时是否写入一条开户流水 (从 0 变为初始余额)，默认不写
+    bool logAccountCreation = false;
 
     // LL::Config 需要一个序列化/反序列化函数
     template <typename Self>
@@ -26,6 +28,378 @@ struct CurrencyConfig {
         self(minimumBalance, "minimumBalance");
         self(allowTransfer, "allowTransfer"); 
         self(transferTaxRate, "transferTaxRate"); 
+        self(logAccountCreation, "logAccountCreation");
+    }
+};
+
+// 结构体：后台任务调度器设置
+struct SchedulerConfig {
+    // 每个 tick 允许后台任务占用的时间 (毫秒)
+    double tickBudgetMs = 5.0;
+    // 服务器卡顿时预算收缩的下限 (毫秒)
+    double minTickBudgetMs = 0.5;
+    // 任务等待超过多少个 tick 后提升一级优先级 (0 表示不提升)
+    int escalateAfterTicks = 200;
+    // 队列总长度超过该值时启用突发预算 (0 表示不启用)
+    int backlogThreshold = 500;
+    // 突发预算倍率
+    double burstBudgetMultiplier = 2.0;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(tickBudgetMs, "tickBudgetMs");
+        self(minTickBudgetMs, "minTickBudgetMs");
+        self(escalateAfterTicks, "escalateAfterTicks");
+        self(backlogThreshold, "backlogThreshold");
+        self(burstBudgetMultiplier, "burstBudgetMultiplier");
+    }
+};
+
+// 结构体：写操作限流设置 (令牌桶)
+struct RateLimitConfig {
+    // 是否启用限流
+    bool enabled = true;
+    // 单个玩家发起写操作 (如 /money pay) 的突发上限与每秒补充速率
+    double playerBurst     = 5.0;
+    double playerPerSecond = 1.0;
+    // 单个调用方 (按 API 的 reason1 区分) 的突发上限与每秒补充速率，所有写操作都会检查 (转账、兑换同时检查玩家)
+    double pluginBurst     = 200.0;
+    double pluginPerSecond = 50.0;
+    // 每个维度最多跟踪的键数量，超出后先清理空闲的桶，再淘汰最久未使用的桶
+    int maxTrackedKeys = 10000;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(playerBurst, "player", "burst");
+        self(playerPerSecond, "player", "perSecond");
+        self(pluginBurst, "plugin", "burst");
+        self(pluginPerSecond, "plugin", "perSecond");
+        self(maxTrackedKeys, "maxTrackedKeys");
+    }
+};
+
+// 结构体：定时/周期付款设置
+struct ScheduledPaymentConfig {
+    // 是否启用定时/周期付款
+    bool enabled = true;
+    // 检查到期付款的间隔 (秒)
+    int checkIntervalSeconds = 30;
+    // 每批 (一个事务) 最多处理的计划数量
+    int batchSize = 50;
+    // 是否补跑停机期间错过的付款，以及每个计划单次最多补跑的次数
+    bool catchUpMissedRuns = true;
+    int  maxCatchUpRuns    = 24;
+    // 余额不足时的重试延迟 (秒)
+    int retryDelaySeconds = 600;
+    // 连续失败达到该次数后暂停计划，0 表示从不暂停
+    int maxConsecutiveFailures = 3;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(checkIntervalSeconds, "checkIntervalSeconds");
+        self(batchSize, "batchSize");
+        self(catchUpMissedRuns, "catchUpMissedRuns");
+        self(maxCatchUpRuns, "maxCatchUpRuns");
+        self(retryDelaySeconds, "retryDelaySeconds");
+        self(maxConsecutiveFailures, "maxConsecutiveFailures");
+    }
+};
+
+// 结构体：批量利息/财富税设置
+struct BulkAdjustmentConfig {
+    // 每个事务 (分块) 处理的账户行数
+    int chunkSize = 500;
+    // 每处理多少百分比进度输出一次日志 (0 表示只在开始和结束时输出)
+    int progressLogPercentStep = 10;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(chunkSize, "chunkSize");
+        self(progressLogPercentStep, "progressLogPercentStep");
+    }
+};
+
+// 结构体：流水对账设置
+struct ReconciliationConfig {
+    // 工作线程数量 (MySQL / PostgreSQL，每个线程一个独立连接；SQLite 始终在调度器中单路执行)
+    int workerThreads = 2;
+    // 每次读取的账户行数
+    int chunkSize = 500;
+    // 工作线程每处理一块后的暂停时间 (毫秒)，用于降低对数据库的压力
+    int chunkPauseMs = 10;
+    // 报告中最多保留的不一致账户明细数量
+    int maxReportedMismatches = 100;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(workerThreads, "workerThreads");
+        self(chunkSize, "chunkSize");
+        self(chunkPauseMs, "chunkPauseMs");
+        self(maxReportedMismatches, "maxReportedMismatches");
+    }
+};
+
+// 结构体：余额快照设置
+struct SnapshotConfig {
+    // 是否定期生成余额快照 (用于按时间点查询历史余额)
+    bool enabled = true;
+    // 生成快照的间隔 (分钟)
+    int intervalMinutes = 60;
+    // 每隔多少次生成一次全量快照，其余为只包含变动账户的增量快照 (1 表示总是全量)
+    int fullSnapshotEvery = 24;
+    // 每个事务 (分块) 处理的账户行数
+    int chunkSize = 1000;
+    // 保留的全量快照数量，更早的快照在新的全量快照完成后删除 (0 表示不清理)
+    int retainFullSnapshots = 7;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(intervalMinutes, "intervalMinutes");
+        self(fullSnapshotEvery, "fullSnapshotEvery");
+        self(chunkSize, "chunkSize");
+        self(retainFullSnapshots, "retainFullSnapshots");
+    }
+};
+
+// 结构体：流水哈希链设置
+struct LedgerChainConfig {
+    // 是否为新写入的流水计算链式哈希 (启用后 economy_log 会多出 chain_hash 列)
+    bool enabled = false;
+    // HMAC 密钥 (十六进制)，为空时在启用时自动生成并写回配置文件。更换密钥会使之前的哈希全部校验失败
+    std::string secret = "";
+    // 校验时的工作线程数量 (MySQL / PostgreSQL，每个线程一个独立连接；SQLite 始终在调度器中单路执行)
+    int verifyThreads = 4;
+    // 校验时每次读取的流水行数
+    int verifyChunkSize = 2000;
+    // 报告中最多保留的断链明细数量
+    int maxReportedBreaks = 50;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(secret, "secret");
+        self(verifyThreads, "verifyThreads");
+        self(verifyChunkSize, "verifyChunkSize");
+        self(maxReportedBreaks, "maxReportedBreaks");
+    }
+};
+
+// 结构体：财富分布统计设置
+struct AnalyticsConfig {
+    // 是否定期统计财富分布并写入 JSON 文件
+    bool enabled = true;
+    // 统计间隔 (分钟)
+    int intervalMinutes = 60;
+    // 每次读取的账户行数
+    int chunkSize = 2000;
+    // 分位数草图的相对误差 (例如 0.01 表示 1%)
+    double relativeAccuracy = 0.01;
+    // 需要输出的百分位
+    std::vector<double> percentiles = {10, 25, 50, 75, 90, 99};
+    // 汇总最近多少天 (包含今天) 的每日流水
+    int flowDays = 7;
+    // JSON 输出文件 (相对于插件数据目录)，为空表示不写入文件
+    std::string dumpFile = "analytics/wealth.json";
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(intervalMinutes, "intervalMinutes");
+        self(chunkSize, "chunkSize");
+        self(relativeAccuracy, "relativeAccuracy");
+        self(percentiles, "percentiles");
+        self(flowDays, "flowDays");
+        self(dumpFile, "dumpFile");
+    }
+};
+
+// 结构体：异常收入检测设置
+struct ExploitDetectionConfig {
+    // 是否启用异常收入检测 (只在内存中统计，不访问数据库)
+    bool enabled = true;
+    // 滑动窗口长度 (秒) 与窗口内的时间槽数量 (最多 60)，每个时间槽结束时更新一次基线
+    int windowSeconds  = 60;
+    int slotsPerWindow = 6;
+    // 窗口收入相对基线的 z 分数超过该值时告警
+    double zScoreThreshold = 4.0;
+    // 基线 (指数移动平均) 中新样本的权重
+    double baselineAlpha = 0.05;
+    // 按理由统计时，至少积累多少个窗口样本后才开始告警
+    int warmupWindows = 30;
+    // 窗口内收入低于该金额时不告警 (玩家 / 理由)
+    double playerMinAlertAmount = 10000.0;
+    double reasonMinAlertAmount = 100000.0;
+    // 同一个玩家或理由两次告警之间的最短间隔 (秒)
+    int alertCooldownSeconds = 300;
+    // 最多跟踪的键数量，超出后清理空闲的键
+    int maxTrackedKeys = 20000;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(windowSeconds, "windowSeconds");
+        self(slotsPerWindow, "slotsPerWindow");
+        self(zScoreThreshold, "zScoreThreshold");
+        self(baselineAlpha, "baselineAlpha");
+        self(warmupWindows, "warmupWindows");
+        self(playerMinAlertAmount, "player", "minAlertAmount");
+        self(reasonMinAlertAmount, "reason", "minAlertAmount");
+        self(alertCooldownSeconds, "alertCooldownSeconds");
+        self(maxTrackedKeys, "maxTrackedKeys");
+    }
+};
+
+// 结构体：资金流向计数设置
+struct FlowCounterConfig {
+    // 是否按插件 / 理由统计资金流入流出
+    bool enabled = true;
+    // 把计数写入数据库的间隔 (秒)
+    int flushIntervalSeconds = 60;
+    // 最多跟踪的 (货币, reason1, reason2) 组合数量，超出后新的理由归入 "<other>"
+    int maxTrackedReasons = 5000;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(flushIntervalSeconds, "flushIntervalSeconds");
+        self(maxTrackedReasons, "maxTrackedReasons");
+    }
+};
+
+// 结构体：账户存在性过滤器设置
+struct AccountFilterConfig {
+    // 是否在内存中维护账户布隆过滤器，查询不存在的账户时不访问数据库 (对所有数据库类型生效)
+    // 注意：多个服务器共用一个 MySQL / PostgreSQL 数据库时必须关闭，否则其他服务器创建的账户会被误判为不存在
+    bool enabled = false;
+    // 使用 SQLite 时自动启用 (数据库文件只属于本服务器)
+    bool enableOnSqlite = true;
+    // 目标误判率 (判定 "可能存在" 而实际不存在的比例)
+    double targetFalsePositiveRate = 0.01;
+    // 首层最小容量 (账户数)，实际容量为现有账户数的两倍与该值中的较大者
+    int minCapacity = 10000;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(enableOnSqlite, "enableOnSqlite");
+        self(targetFalsePositiveRate, "targetFalsePositiveRate");
+        self(minCapacity, "minCapacity");
+    }
+};
+
+// 结构体：活跃玩家统计设置
+struct ActiveUserConfig {
+    // 是否统计每日参与经济活动的不同玩家数 (HyperLogLog 估计，误差约 1.6%)
+    bool enabled = true;
+    // 把当天的统计写入数据库的间隔 (秒)
+    int flushIntervalSeconds = 300;
+    // 每天最多单独统计的 (货币, reason1) 数量，超出后新的理由归入 "<other>"
+    int maxTrackedReasons = 200;
+    // 保留每日统计的天数，0 表示永久保留
+    int retainDays = 400;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(flushIntervalSeconds, "flushIntervalSeconds");
+        self(maxTrackedReasons, "maxTrackedReasons");
+        self(retainDays, "retainDays");
+    }
+};
+
+// 结构体：流水回放 (基准测试) 设置
+struct ReplayConfig {
+    // 回放目标数据库类型 ("sqlite", "mysql", 或 "postgresql")
+    // 连接参数沿用 database 中对应类型的设置，只替换文件路径 / 库名，且不能与生产数据库相同
+    std::string targetType = "sqlite";
+    // SQLite 目标数据库文件路径 (相对插件数据目录)
+    std::string sqlitePath = "replay/replay.db";
+    // MySQL / PostgreSQL 目标库名 (需预先创建；回放会清空其中的余额和流水，已有数据时需在命令中加 overwrite 参数)
+    std::string databaseName = "czmoney_replay";
+    // 导出流水时每块读取的行数
+    int exportChunkSize = 2000;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(targetType, "targetType");
+        self(sqlitePath, "sqlitePath");
+        self(databaseName, "databaseName");
+        self(exportChunkSize, "exportChunkSize");
+    }
+};
+
+// 结构体：经济数据备份 / 恢复设置
+struct BackupConfig {
+    // 备份时每块读取的行数 (每块单独校验，也是解码时字典的作用范围)
+    int chunkSize = 5000;
+    // 恢复时每条 INSERT 语句插入的行数 (SQLite 还受 999 个参数的限制)
+    int restoreBatchRows = 500;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(chunkSize, "chunkSize");
+        self(restoreBatchRows, "restoreBatchRows");
+    }
+};
+
+// 结构体：数据库迁移设置
+struct MigrationConfig {
+    // 迁移目标数据库类型 ("sqlite", "mysql", 或 "postgresql")
+    // 连接参数沿用 database 中对应类型的设置，只替换文件路径 / 库名，且不能与生产数据库相同
+    std::string targetType = "mysql";
+    // SQLite 目标数据库文件路径 (相对插件数据目录)
+    std::string sqlitePath = "migration/czmoney.db";
+    // MySQL / PostgreSQL 目标库名 (需预先创建且为空)，为空时沿用 database 中对应类型的库名 (目标为另一种数据库时)
+    std::string databaseName = "";
+    // 每块从源库读取的行数 (也是追赶时游标回看的行数)
+    int chunkSize = 2000;
+    // 写入目标库时每条 INSERT 语句的行数 (SQLite 还受 999 个参数的限制)
+    int batchRows = 500;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(targetType, "targetType");
+        self(sqlitePath, "sqlitePath");
+        self(databaseName, "databaseName");
+        self(chunkSize, "chunkSize");
+        self(batchRows, "batchRows");
+    }
+};
+
+// 结构体：表单加载设置
+struct FormConfig {
+    // 是否异步查询表单数据 (余额列表、排行榜等)，关闭时在服务器线程上同步查询
+    // MySQL / PostgreSQL 在独立线程的连接上查询；SQLite 始终由调度器在服务器线程的主连接上查询
+    bool asyncLoading = true;
+    // 数据超过该时间 (毫秒) 仍未就绪时向玩家显示加载提示，0 表示不提示
+    int loadingHintMs = 200;
+    // 账户浏览表单 (money admin accounts) 每页显示的账户数量
+    int accountsPerPage = 10;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(asyncLoading, "asyncLoading");
+        self(loadingHintMs, "loadingHintMs");
+        self(accountsPerPage, "accountsPerPage");
+    }
+};
+
+// 结构体：货币兑换设置
+struct ExchangeConfig {
+    // 是否允许在同一玩家的两种货币之间兑换 (默认关闭，需要先配置汇率表)
+    bool enabled = false;
+    // 汇率表：源货币 -> (目标货币 -> 每 1 单位源货币兑换得到的目标货币数量)
+    // 只有列出的方向可以兑换 (反向需要单独配置)，兑换所得按分向下取整
+    // 示例：{"money": {"points": 0.1}} 表示 10 money 兑换 1 points
+    std::unordered_map<std::string, std::unordered_map<std::string, double>> rates;
+
+    template <typename Self>
+    void serialize(Self& self) {
+        self(enabled, "enabled");
+        self(rates, "rates");
     }
 };
 
@@ -53,6 +427,10 @@ struct Config {
     // --- SQLite 连接设置 (仅当 db_type 为 "sqlite" 时使用) ---
     std::string db_sqlite_path = "plugins/czmoney/czmoney.db"; // SQLite 数据库文件路径 (相对路径)
 
+    // 为流水的理由列创建全文索引 (SQLite FTS5 trigram / PostgreSQL pg_trgm / MySQL ngram FULLTEXT)，
+    // 按理由查询流水时不再全表扫描；每条流水的写入会略微变慢。已有流水的索引在后台建立，完成前仍使用全表扫描
+    bool db_reason_index = true;
+
     // 经济设置：按货币类型组织的配置
     // 键: 货币类型 (例如 "money", "points")
     // 值: 该货币类型的具体配置 (CurrencyConfig)
@@ -64,6 +442,57 @@ struct Config {
     // 命令别名设置
     std::vector<std::string> commandAliases = {"cm"}; 
 
+    // 后台任务调度器设置
+    SchedulerConfig scheduler;
+
+    // 写操作限流设置
+    RateLimitConfig rateLimit;
+
+    // 定时/周期付款设置
+    ScheduledPaymentConfig scheduledPayments;
+
+    // 批量利息/财富税设置
+    BulkAdjustmentConfig bulkAdjustment;
+
+    // 流水对账设置
+    ReconciliationConfig reconciliation;
+
+    // 余额快照设置
+    SnapshotConfig snapshots;
+
+    // 流水哈希链设置
+    LedgerChainConfig ledgerChain;
+
+    // 财富分布统计设置
+    AnalyticsConfig analytics;
+
+    // 异常收入检测设置
+    ExploitDetectionConfig exploitDetection;
+
+    // 资金流向计数设置
+    FlowCounterConfig flowCounters;
+
+    // 活跃玩家统计设置
+    ActiveUserConfig activeUsers;
+
+    // 流水回放设置
+    ReplayConfig replay;
+
+    // 账户存在性过滤器设置
+    AccountFilterConfig accountFilter;
+
+    // 经济数据备份设置
+    BackupConfig backup;
+
+    // 数据库迁移设置
+    MigrationConfig migration;
+
+    // 表单加载设置
+    FormConfig forms;
+
+    // 货币兑换设置
+    ExchangeConfig exchange;
+
 
     // LL::Config 需要一个序列化/反序列化函数
     template <typename Self>
@@ -84,9 +513,27 @@ struct Config {
         self(db_pg_name, "database", "postgresql", "databaseName");
         // SQLite 设置 (分组)
         self(db_sqlite_path, "database", "sqlite", "path");
+        self(db_reason_index, "database", "reasonSearchIndex");
         // 其他设置
         self(commandAliases, "command", "aliases");
         self(economy, "economy");
+        self(scheduler, "scheduler");
+        self(rateLimit, "rateLimit");
+        self(scheduledPayments, "scheduledPayments");
+        self(bulkAdjustment, "bulkAdjustment");
+        self(reconciliation, "reconciliation");
+        self(snapshots, "snapshots");
+        self(ledgerChain, "ledgerChain");
+        self(analytics, "analytics");
+        self(exploitDetection, "exploitDetection");
+        self(flowCounters, "flowCounters");
+        self(activeUsers, "activeUsers");
+        self(replay, "replay");
+        self(accountFilter, "accountFilter");
+        self(backup, "backup");
+        self(migration, "migration");
+        self(forms, "forms");
+        self(exchange, "exchange");
     }
 };
 
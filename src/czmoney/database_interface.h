@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional> // 提交后回调
+#include <new>     // std::nothrow_t
 #include <string>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 #include <variant> // 用于表示结果中不同的数据类型
 #include <optional> // 用于可选结果
@@ -9,10 +14,105 @@
 
 namespace db {
 
+// 数据库错误的分类，调用方据此决定重试、提示还是放弃
+enum class DbErrorCode {
+    Other,        // 其他错误 (SQL 语法错误、类型错误等)
+    Busy,         // 数据库忙 (SQLite 文件被锁、连接数已满、行锁无法立即获得)
+    Conflict,     // 冲突 (唯一键 / 约束冲突、死锁、序列化失败)
+    Timeout,      // 超时 (锁等待超时、语句执行超时或被中断)
+    Disconnected, // 未连接或连接已断开
+};
+
+/**
+ * @brief 获取错误分类的名称 (用于日志)
+ */
+inline const char* errorCodeName(DbErrorCode code) {
+    switch (code) {
+    case DbErrorCode::Busy:
+        return "busy";
+    case DbErrorCode::Conflict:
+        return "conflict";
+    case DbErrorCode::Timeout:
+        return "timeout";
+    case DbErrorCode::Disconnected:
+        return "disconnected";
+    default:
+        return "other";
+    }
+}
+
+// 结构化的数据库错误
+struct DbError {
+    DbErrorCode code = DbErrorCode::Other;
+    std::string message;
+};
+
 // 定义数据库操作可能抛出的通用异常类型
 class DatabaseException : public std::runtime_error {
 public:
-    using std::runtime_error::runtime_error; // 继承构造函数
+    explicit DatabaseException(const std::string& message, DbErrorCode code = DbErrorCode::Other)
+    : std::runtime_error(message),
+      mCode(code) {}
+
+    /**
+     * @brief 错误分类
+     */
+    [[nodiscard]] DbErrorCode code() const { return mCode; }
+
+private:
+    DbErrorCode mCode;
+};
+
+/**
+ * @brief 不抛异常的操作结果 (类似 C++23 的 std::expected<T, DbError>)
+ *
+ * 成功时保存值，失败时保存 DbError。try* 系列数据库操作返回该类型，
+ * 冲突、数据库忙等常见情况不再通过异常传递。
+ */
+template <typename T>
+class [[nodiscard]] DbExpected {
+public:
+    DbExpected(T value) : mStorage(std::in_place_index<0>, std::move(value)) {}
+    DbExpected(DbError error) : mStorage(std::in_place_index<1>, std::move(error)) {}
+
+    [[nodiscard]] bool has_value() const { return mStorage.index() == 0; }
+    explicit operator bool() const { return has_value(); }
+
+    T&       value() & { return std::get<0>(mStorage); }
+    const T& value() const& { return std::get<0>(mStorage); }
+    T&&      value() && { return std::get<0>(std::move(mStorage)); }
+
+    T&       operator*() & { return value(); }
+    const T& operator*() const& { return value(); }
+    T&&      operator*() && { return std::move(*this).value(); }
+    T*       operator->() { return &value(); }
+    const T* operator->() const { return &value(); }
+
+    template <typename U>
+    T value_or(U&& fallback) const& {
+        return has_value() ? value() : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    [[nodiscard]] const DbError& error() const { return std::get<1>(mStorage); }
+
+private:
+    std::variant<T, DbError> mStorage;
+};
+
+// 不带返回值的操作结果
+template <>
+class [[nodiscard]] DbExpected<void> {
+public:
+    DbExpected() = default;
+    DbExpected(DbError error) : mError(std::move(error)) {}
+
+    [[nodiscard]] bool has_value() const { return !mError.has_value(); }
+    explicit operator bool() const { return has_value(); }
+
+    [[nodiscard]] const DbError& error() const { return *mError; }
+
+private:
+    std::optional<DbError> mError;
 };
 
 // 定义查询结果的数据类型别名
@@ -21,6 +121,51 @@ using DbRow = std::vector<DbValue>;     // 单行结果
 using DbResult = std::vector<DbRow>;    // 多行结果集
 using DbParams = std::vector<DbValue>;  // 用于绑定预处理语句的参数列表
 
+class ColumnarResult; // 按列存储的查询结果，定义见 czmoney/db/columnar.h
+
+/**
+ * @brief 将结果中的单个值转换为 int64_t
+ *
+ * 不同后端返回的整数列类型不一致 (SQLite 为 int64_t，MySQL/PostgreSQL 的文本结果为 std::string)，
+ * 此函数统一处理这些情况。
+ * @param value 结果值
+ * @return std::optional<int64_t> 转换成功返回整数；NULL 或无法解析时返回 std::nullopt
+ */
+inline std::optional<int64_t> toInt64(const DbValue& value) {
+    if (std::holds_alternative<int64_t>(value)) {
+        return std::get<int64_t>(value);
+    }
+    if (std::holds_alternative<double>(value)) {
+        return static_cast<int64_t>(std::get<double>(value));
+    }
+    if (std::holds_alternative<std::string>(value)) {
+        try {
+            return std::stoll(std::get<std::string>(value));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief 将结果中的单个值转换为字符串
+ * @param value 结果值
+ * @return std::string 字符串表示，NULL 返回空字符串
+ */
+inline std::string toString(const DbValue& value) {
+    if (std::holds_alternative<std::string>(value)) {
+        return std::get<std::string>(value);
+    }
+    if (std::holds_alternative<int64_t>(value)) {
+        return std::to_string(std::get<int64_t>(value));
+    }
+    if (std::holds_alternative<double>(value)) {
+        return std::to_string(std::get<double>(value));
+    }
+    return {};
+}
+
 
 /**
  * @brief 数据库连接接口 (Interface)
@@ -93,6 +238,12 @@ public:
      */
     virtual void rollbackTransaction() = 0;
 
+    /**
+     * @brief 当前连接是否处于显式事务中。
+     * @return bool 已调用 beginTransaction 且尚未提交/回滚时返回 true。
+     */
+    virtual bool inTransaction() const = 0;
+
     // --- 预处理语句 (Prepared Statements) ---
     // 注意：这是一个简化的接口，实际实现可能更复杂。
     // 这里不显式返回句柄，而是假设实现类内部管理。
@@ -114,6 +265,221 @@ public:
      * @throws DatabaseException 执行过程中发生错误时抛出。
      */
     virtual DbResult queryPrepared(const std::string& sql, const DbParams& params) = 0;
+
+    /**
+     * @brief 执行一个带参数的查询，结果按列存储 (预处理方式)。
+     *
+     * 与 queryPrepared 相同，但结果直接写入 ColumnarResult：每列几个连续数组，文本共用一块缓冲区，
+     * 适合返回大量行的查询 (流水、排行榜等)。调用方需要包含 czmoney/db/columnar.h。
+     * @param sql 带占位符的 SQL 查询语句。
+     * @param params 按顺序绑定的参数列表 (可以为空)。
+     * @return ColumnarResult 查询结果；没有结果集的语句返回 0 列 0 行。
+     * @throws DatabaseException 执行过程中发生错误时抛出。
+     */
+    virtual ColumnarResult queryColumnar(const std::string& sql, const DbParams& params) = 0;
+
+    // --- 不抛异常的操作 ---
+    // 与对应的抛异常版本行为相同，错误通过返回值中的 DbError 报告 (包括未连接)。
+    // 抛异常的版本由这些函数实现，抛出的 DatabaseException::code() 与 DbError::code 一致。
+
+    /**
+     * @brief 执行不返回结果集的 SQL 语句 (可以包含多条语句)。
+     * @return DbExpected<int> 成功时为实现相关的状态值。
+     */
+    virtual DbExpected<int> tryExecute(const std::string& sql) = 0;
+
+    /**
+     * @brief 执行带参数的、不返回结果集的 SQL 语句 (预处理方式)。
+     * @return DbExpected<int> 成功时为受影响的行数。
+     */
+    virtual DbExpected<int> tryExecutePrepared(const std::string& sql, const DbParams& params) = 0;
+
+    /**
+     * @brief 执行带参数的查询，结果按列存储 (预处理方式)。调用方需要包含 czmoney/db/columnar.h。
+     */
+    virtual DbExpected<ColumnarResult> tryQueryColumnar(const std::string& sql, const DbParams& params) = 0;
+
+    virtual DbExpected<void> tryBeginTransaction()    = 0;
+    virtual DbExpected<void> tryCommitTransaction()   = 0;
+    virtual DbExpected<void> tryRollbackTransaction() = 0;
+
+    // --- 提交后回调 ---
+
+    /**
+     * @brief 注册一个在事务真正提交之后执行的回调 (发布 AfterEvent、更新内存统计等无法撤销的副作用)
+     *
+     * 不在事务中时立即执行。嵌套 ScopedTransaction (保存点) 的提交不会触发回调，
+     * 只有最外层 COMMIT 成功后才按注册顺序执行；事务回滚，或回调注册所在的保存点回滚时，回调被丢弃。
+     * 回调抛出的异常被忽略，回调需要自行记录日志。
+     */
+    void afterCommit(std::function<void()> callback) {
+        if (!inTransaction()) {
+            runCallback(callback);
+            return;
+        }
+        mAfterCommit.push_back(std::move(callback));
+    }
+
+    /**
+     * @brief 当前排队的提交后回调数量 (保存点开始时记录，回滚到保存点时丢弃之后注册的回调)
+     */
+    [[nodiscard]] size_t pendingAfterCommit() const { return mAfterCommit.size(); }
+
+    /**
+     * @brief 丢弃从第 mark 个开始注册的提交后回调
+     */
+    void discardAfterCommit(size_t mark = 0) {
+        if (mark < mAfterCommit.size()) {
+            mAfterCommit.erase(mAfterCommit.begin() + static_cast<std::ptrdiff_t>(mark), mAfterCommit.end());
+        }
+    }
+
+protected:
+    /**
+     * @brief 执行并清空提交后回调 (实现类在 COMMIT 成功后调用)
+     */
+    void runAfterCommit() {
+        // 回调中可能开始新的事务并注册新的回调，先取出当前队列
+        std::vector<std::function<void()>> callbacks = std::move(mAfterCommit);
+        mAfterCommit.clear();
+        for (auto& callback : callbacks) {
+            runCallback(callback);
+        }
+    }
+
+private:
+    std::vector<std::function<void()>> mAfterCommit;
+
+    static void runCallback(const std::function<void()>& callback) {
+        try {
+            callback();
+        } catch (...) {}
+    }
+};
+
+/**
+ * @brief 作用域事务 (RAII)
+ *
+ * 连接不在事务中时开始一个新事务；已在外层事务中时改用 SAVEPOINT，
+ * 使 rollback() 只撤销本作用域内的写入而不影响外层事务 (例如转账中的扣款/加款)。
+ * 析构时如果既未 commit 也未 rollback，则自动回滚。
+ * 通过 IDatabaseConnection::afterCommit 注册的回调只在最外层事务提交后执行。
+ * 使用 std::nothrow 构造时不抛异常：开始失败时 ok() 返回 false，提交使用 tryCommit()。
+ */
+class ScopedTransaction {
+public:
+    explicit ScopedTransaction(IDatabaseConnection& conn) : ScopedTransaction(conn, std::nothrow) {
+        if (mBeginError) {
+            throw DatabaseException(mBeginError->message, mBeginError->code);
+        }
+    }
+
+    ScopedTransaction(IDatabaseConnection& conn, const std::nothrow_t&)
+    : mConn(conn),
+      mNested(conn.inTransaction()),
+      mAfterCommitMark(conn.pendingAfterCommit()) {
+        DbExpected<void> begun;
+        if (mNested) {
+            static std::atomic<uint64_t> sSavepointCounter{0};
+            mSavepoint = "czmoney_sp_" + std::to_string(++sSavepointCounter);
+            DbExpected<int> savepoint = mConn.tryExecute("SAVEPOINT " + mSavepoint + ";");
+            if (!savepoint) {
+                begun = savepoint.error();
+            }
+        } else {
+            begun = mConn.tryBeginTransaction();
+        }
+        if (begun) {
+            mActive = true;
+        } else {
+            mBeginError = begun.error();
+        }
+    }
+
+    ~ScopedTransaction() {
+        if (mActive) {
+            (void)tryRollback();
+        }
+    }
+
+    /**
+     * @brief 事务是否已成功开始 (仅 std::nothrow 构造时可能为 false)
+     */
+    [[nodiscard]] bool ok() const { return !mBeginError.has_value(); }
+
+    /**
+     * @brief 开始事务失败的原因 (ok() 为 true 时不可调用)
+     */
+    [[nodiscard]] const DbError& error() const { return *mBeginError; }
+
+    /**
+     * @brief 提交，不抛异常 (嵌套时释放保存点)
+     */
+    DbExpected<void> tryCommit() {
+        if (!mActive) return {};
+        mActive = false;
+        if (mNested) {
+            DbExpected<int> released = mConn.tryExecute("RELEASE SAVEPOINT " + mSavepoint + ";");
+            if (!released) return released.error();
+            return {};
+        }
+        return mConn.tryCommitTransaction();
+    }
+
+    /**
+     * @brief 回滚本作用域内的写入，不抛异常
+     */
+    DbExpected<void> tryRollback() {
+        if (!mActive) return {};
+        mActive = false;
+        if (mNested) {
+            DbExpected<int> rolledBack = mConn.tryExecute("ROLLBACK TO SAVEPOINT " + mSavepoint + ";");
+            DbExpected<int> released   = mConn.tryExecute("RELEASE SAVEPOINT " + mSavepoint + ";");
+            mConn.discardAfterCommit(mAfterCommitMark); // 本作用域内注册的提交后回调不再执行
+            if (!rolledBack) return rolledBack.error();
+            if (!released) return released.error();
+            return {};
+        }
+        return mConn.tryRollbackTransaction();
+    }
+
+    ScopedTransaction(const ScopedTransaction&)            = delete;
+    ScopedTransaction& operator=(const ScopedTransaction&) = delete;
+
+    /**
+     * @brief 提交 (嵌套时释放保存点，由外层事务最终提交，提交后回调也在那时执行)
+     * @throws DatabaseException 提交失败时抛出
+     */
+    void commit() {
+        DbExpected<void> committed = tryCommit();
+        if (!committed) {
+            throw DatabaseException(committed.error().message, committed.error().code);
+        }
+    }
+
+    /**
+     * @brief 回滚本作用域内的写入
+     * @throws DatabaseException 回滚失败时抛出
+     */
+    void rollback() {
+        DbExpected<void> rolledBack = tryRollback();
+        if (!rolledBack) {
+            throw DatabaseException(rolledBack.error().message, rolledBack.error().code);
+        }
+    }
+
+    /**
+     * @brief 是否嵌套在外层事务中
+     */
+    [[nodiscard]] bool isNested() const { return mNested; }
+
+private:
+    IDatabaseConnection&   mConn;
+    bool                   mNested;
+    size_t                 mAfterCommitMark; // 开始时已排队的提交后回调数量
+    bool                   mActive = false;
+    std::string            mSavepoint;
+    std::optional<DbError> mBeginError;
 };
 
 } // namespace db
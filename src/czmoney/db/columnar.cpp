@@ -0,0 +1,162 @@
+#include "czmoney/db/columnar.h"
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace db {
+
+namespace {
+// 与 std::stoll / std::stod 一致：跳过前导空白和正号，只解析开头的数字部分
+template <typename T>
+std::optional<T> parseNumber(std::string_view text) {
+    size_t start = 0;
+    while (start < text.size() && std::isspace(static_cast<unsigned char>(text[start]))) {
+        ++start;
+    }
+    if (start < text.size() && text[start] == '+') {
+        ++start;
+    }
+    T value{};
+    auto [ptr, ec] = std::from_chars(text.data() + start, text.data() + text.size(), value);
+    if (ec != std::errc{}) {
+        return std::nullopt;
+    }
+    return value;
+}
+} // namespace
+
+ColumnarResult::ColumnarResult(size_t columnCount, size_t expectedRows, size_t expectedTextBytes)
+: mColumns(columnCount) {
+    if (expectedRows > 0) {
+        for (auto& column : mColumns) {
+            column.kinds.reserve(expectedRows);
+            column.values.reserve(expectedRows);
+            column.lengths.reserve(expectedRows);
+        }
+    }
+    if (expectedTextBytes > 0) {
+        mText.reserve(expectedTextBytes);
+    }
+}
+
+void ColumnarResult::append(size_t col, ColumnKind kind, int64_t value, uint32_t length) {
+    Column& column = mColumns[col];
+    column.kinds.push_back(kind);
+    column.values.push_back(value);
+    column.lengths.push_back(length);
+}
+
+void ColumnarResult::appendNull(size_t col) { append(col, ColumnKind::Null, 0, 0); }
+
+void ColumnarResult::appendInt64(size_t col, int64_t value) { append(col, ColumnKind::Int64, value, 0); }
+
+void ColumnarResult::appendDouble(size_t col, double value) {
+    append(col, ColumnKind::Double, std::bit_cast<int64_t>(value), 0);
+}
+
+void ColumnarResult::appendText(size_t col, const char* data, size_t length) {
+    char* target = appendTextSpace(col, length);
+    if (length > 0) {
+        std::memcpy(target, data, length);
+    }
+}
+
+char* ColumnarResult::appendTextSpace(size_t col, size_t length) {
+    if (length > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Text cell exceeds 4 GiB");
+    }
+    size_t offset = mText.size();
+    mText.resize(offset + length);
+    append(col, ColumnKind::Text, static_cast<int64_t>(offset), static_cast<uint32_t>(length));
+    return mText.data() + offset;
+}
+
+std::string_view ColumnarResult::getText(size_t row, size_t col) const {
+    const Column& column = mColumns[col];
+    if (column.kinds[row] != ColumnKind::Text) {
+        return {};
+    }
+    return std::string_view(mText).substr(static_cast<size_t>(column.values[row]), column.lengths[row]);
+}
+
+std::optional<int64_t> ColumnarResult::getInt64(size_t row, size_t col) const {
+    const Column& column = mColumns[col];
+    switch (column.kinds[row]) {
+    case ColumnKind::Int64:
+        return column.values[row];
+    case ColumnKind::Double: {
+        // 超出 int64_t 范围 (或 NaN) 的浮点数转换是未定义行为，按无法转换处理
+        double value = std::bit_cast<double>(column.values[row]);
+        if (!(value >= -0x1p63 && value < 0x1p63)) {
+            return std::nullopt;
+        }
+        return static_cast<int64_t>(value);
+    }
+    case ColumnKind::Text:
+        return parseNumber<int64_t>(getText(row, col));
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<double> ColumnarResult::getDouble(size_t row, size_t col) const {
+    const Column& column = mColumns[col];
+    switch (column.kinds[row]) {
+    case ColumnKind::Int64:
+        return static_cast<double>(column.values[row]);
+    case ColumnKind::Double:
+        return std::bit_cast<double>(column.values[row]);
+    case ColumnKind::Text:
+        return parseNumber<double>(getText(row, col));
+    default:
+        return std::nullopt;
+    }
+}
+
+std::string ColumnarResult::getString(size_t row, size_t col) const {
+    const Column& column = mColumns[col];
+    switch (column.kinds[row]) {
+    case ColumnKind::Int64:
+        return std::to_string(column.values[row]);
+    case ColumnKind::Double:
+        return std::to_string(std::bit_cast<double>(column.values[row]));
+    case ColumnKind::Text:
+        return std::string(getText(row, col));
+    default:
+        return {};
+    }
+}
+
+DbValue ColumnarResult::value(size_t row, size_t col) const {
+    const Column& column = mColumns[col];
+    switch (column.kinds[row]) {
+    case ColumnKind::Int64:
+        return column.values[row];
+    case ColumnKind::Double:
+        return std::bit_cast<double>(column.values[row]);
+    case ColumnKind::Text:
+        return std::string(getText(row, col));
+    default:
+        return nullptr;
+    }
+}
+
+DbResult ColumnarResult::toRows() const {
+    DbResult rows;
+    rows.reserve(mRowCount);
+    for (size_t row = 0; row < mRowCount; ++row) {
+        DbRow dbRow;
+        dbRow.reserve(mColumns.size());
+        for (size_t col = 0; col < mColumns.size(); ++col) {
+            dbRow.push_back(value(row, col));
+        }
+        rows.push_back(std::move(dbRow));
+    }
+    return rows;
+}
+
+} // namespace db
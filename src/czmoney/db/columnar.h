@@ -0,0 +1,118 @@
+#pragma once
+
+#include "czmoney/database_interface.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace db {
+
+// 单元格中实际保存的值类型
+enum class ColumnKind : uint8_t {
+    Null = 0,
+    Int64,
+    Double,
+    Text,
+};
+
+/**
+ * @brief 按列存储的查询结果
+ *
+ * DbResult 的每一行、每个字符串单元格都是单独的堆分配；ColumnarResult 每列只有三个连续数组
+ * (值类型、8 字节值、文本长度)，所有文本都写入同一块缓冲区，单元格只保存偏移量。
+ * 一次查询只需要少量几块内存，无论返回多少行。
+ * 同一列中的单元格类型可以不同 (SQLite 是动态类型)，读取时按单元格的实际类型转换。
+ * getText 返回的 string_view 指向内部缓冲区，只在结果对象存活且不再追加数据时有效。
+ */
+class ColumnarResult {
+public:
+    ColumnarResult() = default;
+
+    /**
+     * @brief 构造函数
+     * @param columnCount 列数
+     * @param expectedRows 预计行数 (用于预分配，未知时为 0)
+     * @param expectedTextBytes 预计文本总字节数 (用于预分配，未知时为 0)
+     */
+    explicit ColumnarResult(size_t columnCount, size_t expectedRows = 0, size_t expectedTextBytes = 0);
+
+    // --- 读取 ---
+
+    [[nodiscard]] size_t rowCount() const { return mRowCount; }
+    [[nodiscard]] size_t columnCount() const { return mColumns.size(); }
+    [[nodiscard]] bool   empty() const { return mRowCount == 0; }
+
+    [[nodiscard]] ColumnKind kind(size_t row, size_t col) const { return mColumns[col].kinds[row]; }
+    [[nodiscard]] bool       isNull(size_t row, size_t col) const { return kind(row, col) == ColumnKind::Null; }
+
+    /**
+     * @brief 读取整数 (文本会被解析，与 toInt64 规则相同)
+     * @return std::optional<int64_t> NULL 或无法解析时返回 std::nullopt
+     */
+    [[nodiscard]] std::optional<int64_t> getInt64(size_t row, size_t col) const;
+
+    /**
+     * @brief 读取浮点数 (整数与文本会被转换)
+     * @return std::optional<double> NULL 或无法解析时返回 std::nullopt
+     */
+    [[nodiscard]] std::optional<double> getDouble(size_t row, size_t col) const;
+
+    /**
+     * @brief 读取文本单元格，不复制
+     * @return std::string_view 非文本单元格返回空视图
+     */
+    [[nodiscard]] std::string_view getText(size_t row, size_t col) const;
+
+    /**
+     * @brief 读取字符串表示 (与 toString 规则相同，NULL 返回空字符串)
+     */
+    [[nodiscard]] std::string getString(size_t row, size_t col) const;
+
+    /**
+     * @brief 转换为 DbValue (兼容旧代码)
+     */
+    [[nodiscard]] DbValue value(size_t row, size_t col) const;
+
+    /**
+     * @brief 转换为按行存储的 DbResult (兼容旧代码)
+     */
+    [[nodiscard]] DbResult toRows() const;
+
+    /**
+     * @brief 文本缓冲区已使用的字节数
+     */
+    [[nodiscard]] size_t textBytes() const { return mText.size(); }
+
+    // --- 填充 (由数据库实现按行调用：为每一列追加一个值，然后 finishRow) ---
+
+    void appendNull(size_t col);
+    void appendInt64(size_t col, int64_t value);
+    void appendDouble(size_t col, double value);
+    void appendText(size_t col, const char* data, size_t length);
+
+    /**
+     * @brief 在文本缓冲区中为一个文本单元格预留空间，调用方直接写入 (避免经过临时缓冲区)
+     * @return char* 可写入 length 字节的指针，下一次追加前有效
+     */
+    char* appendTextSpace(size_t col, size_t length);
+
+    void finishRow() { ++mRowCount; }
+
+private:
+    struct Column {
+        std::vector<ColumnKind> kinds;
+        std::vector<int64_t>    values;  // 整数、浮点数的位模式或文本偏移量
+        std::vector<uint32_t>   lengths; // 文本长度 (其他类型为 0)
+    };
+
+    std::vector<Column> mColumns;
+    std::string         mText; // 本次查询所有文本的连续缓冲区
+    size_t              mRowCount = 0;
+
+    void append(size_t col, ColumnKind kind, int64_t value, uint32_t length);
+};
+
+} // namespace db
@@ -1,4 +1,5 @@
 #include "czmoney/db/mysql.h"
+#include <optional>
 #include <utility> // For std::move
 #include <variant> // For DbValue
 #include <vector>  // For DbResult, DbRow
@@ -12,6 +13,61 @@
 
 namespace db {
 
+// 按 MySQL 错误号对错误分类
+static DbError mysqlError(unsigned int errorNumber, const std::string& message, const char* detail) {
+    DbError error;
+    switch (errorNumber) {
+        case 1022: // ER_DUP_KEY
+        case 1062: // ER_DUP_ENTRY
+        case 1213: // ER_LOCK_DEADLOCK
+        case 1586: // ER_DUP_ENTRY_WITH_KEY_NAME
+            error.code = DbErrorCode::Conflict;
+            break;
+        case 1205: // ER_LOCK_WAIT_TIMEOUT
+        case 1317: // ER_QUERY_INTERRUPTED
+        case 3024: // ER_QUERY_TIMEOUT
+            error.code = DbErrorCode::Timeout;
+            break;
+        case 1040: // ER_CON_COUNT_ERROR
+            error.code = DbErrorCode::Busy;
+            break;
+        case 2006: // CR_SERVER_GONE_ERROR
+        case 2013: // CR_SERVER_LOST
+        case 2055: // CR_SERVER_LOST_EXTENDED
+            error.code = DbErrorCode::Disconnected;
+            break;
+        default:
+            break;
+    }
+    error.message = message + (detail ? ": " + std::string(detail) : "");
+    return error;
+}
+
+static DbError mysqlError(MYSQL* connection, const std::string& message) {
+    return mysqlError(mysql_errno(connection), message, mysql_error(connection));
+}
+
+static DbError mysqlError(MYSQL_STMT* stmt, const std::string& message) {
+    return mysqlError(mysql_stmt_errno(stmt), message, mysql_stmt_error(stmt));
+}
+
+static DbError notConnectedError() { return {DbErrorCode::Disconnected, "Not connected to MySQL database"}; }
+
+// 把不抛异常的结果转换为抛异常的接口
+template <typename T>
+static T unwrapOrThrow(DbExpected<T>&& result) {
+    if (!result) {
+        throw MySQLException(result.error());
+    }
+    return std::move(result).value();
+}
+
+static void unwrapOrThrow(DbExpected<void>&& result) {
+    if (!result) {
+        throw MySQLException(result.error());
+    }
+}
+
 // 构造函数实现
 MySQLConnection::MySQLConnection(
     const std::string& host,
@@ -127,16 +183,16 @@ bool MySQLConnection::isConnected() const {
 }
 
 // 执行 SQL 语句实现 (符合 IDatabaseConnection 接口)
-int MySQLConnection::execute(const std::string& sql) {
+int MySQLConnection::execute(const std::string& sql) { return unwrapOrThrow(tryExecute(sql)); }
+
+DbExpected<int> MySQLConnection::tryExecute(const std::string& sql) {
     if (!isConnected()) {
-        throw MySQLException("Not connected to database"); // 抛出异常
-        // return -1; // 或者返回错误码
+        return notConnectedError();
     }
 
     if (mysql_query(m_connection, sql.c_str())) {
         // 查询执行失败
-        throw MySQLException("mysql_query failed for SQL: " + sql, m_connection); // 抛出异常
-        // return mysql_errno(m_connection); // 返回 MySQL 错误码
+        return mysqlError(m_connection, "mysql_query failed for SQL: " + sql);
     }
 
     // 对于 INSERT, UPDATE, DELETE 等操作，可以返回影响的行数
@@ -214,46 +270,64 @@ std::string MySQLConnection::getDbType() const {
 
 // --- 事务管理实现 ---
 
-void MySQLConnection::beginTransaction() {
+void MySQLConnection::beginTransaction() { unwrapOrThrow(tryBeginTransaction()); }
+
+void MySQLConnection::commitTransaction() { unwrapOrThrow(tryCommitTransaction()); }
+
+void MySQLConnection::rollbackTransaction() { unwrapOrThrow(tryRollbackTransaction()); }
+
+DbExpected<void> MySQLConnection::tryBeginTransaction() {
     if (!isConnected()) {
-        throw MySQLException("Not connected to database");
+        return notConnectedError();
     }
     // 关闭自动提交以开始事务
     if (mysql_autocommit(m_connection, 0)) { // 0 = disable autocommit
-        throw MySQLException("Failed to disable autocommit (begin transaction)", m_connection);
+        return mysqlError(m_connection, "Failed to disable autocommit (begin transaction)");
     }
+    return {};
 }
 
-void MySQLConnection::commitTransaction() {
-     if (!isConnected()) {
+DbExpected<void> MySQLConnection::tryCommitTransaction() {
+    if (!isConnected()) {
         // 理论上不应在未连接时调用，但添加检查
-        throw MySQLException("Not connected to database");
+        return notConnectedError();
     }
     if (mysql_commit(m_connection)) {
-        // 提交失败，尝试回滚并抛出异常
-        mysql_rollback(m_connection); // 尝试回滚
-        throw MySQLException("Failed to commit transaction", m_connection);
-    }
-    // 提交成功后，重新启用自动提交 (可选，取决于应用逻辑)
+        // 提交失败，先记录错误再尝试回滚 (回滚会覆盖 mysql_errno)
+        DbError error = mysqlError(m_connection, "Failed to commit transaction");
+        mysql_rollback(m_connection);
+        mysql_autocommit(m_connection, 1);
+        discardAfterCommit();
+        return error;
+    }
+    runAfterCommit();
+    // 提交成功后，重新启用自动提交
     // 通常在事务结束后恢复自动提交是个好习惯
     if (mysql_autocommit(m_connection, 1)) { // 1 = enable autocommit
-        // 如果恢复自动提交失败，记录警告或抛出次要异常
-         throw MySQLException("Failed to re-enable autocommit after commit", m_connection);
+        return mysqlError(m_connection, "Failed to re-enable autocommit after commit");
     }
+    return {};
 }
 
-void MySQLConnection::rollbackTransaction() {
-     if (!isConnected()) {
-        throw MySQLException("Not connected to database");
+DbExpected<void> MySQLConnection::tryRollbackTransaction() {
+    discardAfterCommit();
+    if (!isConnected()) {
+        return notConnectedError();
     }
     if (mysql_rollback(m_connection)) {
         // 回滚失败通常是严重问题
-        throw MySQLException("Failed to rollback transaction", m_connection);
+        return mysqlError(m_connection, "Failed to rollback transaction");
     }
-     // 回滚后，重新启用自动提交 (可选)
+    // 回滚后，重新启用自动提交
     if (mysql_autocommit(m_connection, 1)) {
-         throw MySQLException("Failed to re-enable autocommit after rollback", m_connection);
+        return mysqlError(m_connection, "Failed to re-enable autocommit after rollback");
     }
+    return {};
+}
+
+bool MySQLConnection::inTransaction() const {
+    // beginTransaction 通过关闭自动提交开始事务，commit/rollback 后重新开启
+    return isConnected() && !(m_connection->server_status & SERVER_STATUS_AUTOCOMMIT);
 }
 
 
@@ -349,53 +423,66 @@ public:
 
 // --- 预处理语句实现 ---
 
-int MySQLConnection::executePrepared(const std::string& sql, const DbParams& params) {
-    if (!isConnected()) {
-        throw MySQLException("Not connected to MySQL database");
-    }
-
-    // 1. 初始化语句句柄
-    MYSQL_STMT* stmt = mysql_stmt_init(m_connection);
+// 准备、绑定参数并执行预处理语句，失败时返回错误而不抛异常
+static std::optional<DbError> prepareAndExecute(
+    MYSQL*              connection,
+    MySQLStatementGuard& stmtGuard,
+    MySQLBindGuard&      paramBinds,
+    const std::string&   sql,
+    const DbParams&      params
+) {
+    MYSQL_STMT* stmt = mysql_stmt_init(connection);
     if (!stmt) {
-        throw MySQLException("mysql_stmt_init failed", m_connection);
+        return mysqlError(connection, "mysql_stmt_init failed");
     }
-    MySQLStatementGuard stmtGuard(stmt); // RAII
+    stmtGuard.reset(stmt);
 
-    // 2. 准备语句
     if (mysql_stmt_prepare(stmt, sql.c_str(), static_cast<unsigned long>(sql.length()))) {
-        throw MySQLException("mysql_stmt_prepare failed for SQL: " + sql, stmt);
+        return mysqlError(stmt, "mysql_stmt_prepare failed for SQL: " + sql);
     }
 
-    // 检查参数数量 (可选但推荐)
     unsigned long expectedParams = mysql_stmt_param_count(stmt);
     if (expectedParams != params.size()) {
-         throw MySQLException("Parameter count mismatch: SQL expects " + std::to_string(expectedParams) +
-                              ", but " + std::to_string(params.size()) + " provided.", stmt);
+        return DbError{
+            DbErrorCode::Other,
+            "Parameter count mismatch: SQL expects " + std::to_string(expectedParams) + ", but "
+                + std::to_string(params.size()) + " provided."
+        };
     }
 
-    // 3. 绑定参数
-    MySQLBindGuard paramBinds;
     if (!params.empty()) {
         paramBinds.build(params);
         if (mysql_stmt_bind_param(stmt, paramBinds.get())) {
-            throw MySQLException("mysql_stmt_bind_param failed", stmt);
+            return mysqlError(stmt, "mysql_stmt_bind_param failed");
         }
     }
 
-    // 4. 执行语句
     if (mysql_stmt_execute(stmt)) {
-        throw MySQLException("mysql_stmt_execute failed", stmt);
+        return mysqlError(stmt, "mysql_stmt_execute failed");
     }
+    return std::nullopt;
+}
 
-    // 5. 获取受影响的行数
-    my_ulonglong affected_rows = mysql_stmt_affected_rows(stmt);
+int MySQLConnection::executePrepared(const std::string& sql, const DbParams& params) {
+    return unwrapOrThrow(tryExecutePrepared(sql, params));
+}
 
-    // stmtGuard 会自动调用 mysql_stmt_close
-    // 注意：返回类型是 int，可能无法完全表示 my_ulonglong
-    if (affected_rows > static_cast<my_ulonglong>(std::numeric_limits<int>::max())) {
-         // 可以记录警告或抛出异常，表示结果可能被截断
-         // 这里暂时截断
+DbExpected<int> MySQLConnection::tryExecutePrepared(const std::string& sql, const DbParams& params) {
+    if (!isConnected()) {
+        return notConnectedError();
+    }
+
+    MySQLStatementGuard stmtGuard; // RAII
+    MySQLBindGuard      paramBinds;
+    if (auto error = prepareAndExecute(m_connection, stmtGuard, paramBinds, sql, params)) {
+        return std::move(*error);
     }
+
+    // 获取受影响的行数
+    my_ulonglong affected_rows = mysql_stmt_affected_rows(stmtGuard.get());
+
+    // stmtGuard 会自动调用 mysql_stmt_close
+    // 注意：返回类型是 int，可能无法完全表示 my_ulonglong，这里暂时截断
     return static_cast<int>(affected_rows);
 }
 
@@ -571,4 +658,135 @@ DbResult MySQLConnection::queryPrepared(const std::string& sql, const DbParams&
 }
 
 
+ColumnarResult MySQLConnection::queryColumnar(const std::string& sql, const DbParams& params) {
+    return unwrapOrThrow(tryQueryColumnar(sql, params));
+}
+
+DbExpected<ColumnarResult> MySQLConnection::tryQueryColumnar(const std::string& sql, const DbParams& params) {
+    if (!isConnected()) {
+        return notConnectedError();
+    }
+
+    MySQLStatementGuard stmtGuard;
+    MySQLBindGuard      paramBinds;
+    if (auto error = prepareAndExecute(m_connection, stmtGuard, paramBinds, sql, params)) {
+        return std::move(*error);
+    }
+    MYSQL_STMT* stmt = stmtGuard.get();
+
+    MYSQL_RES* metaResult = mysql_stmt_result_metadata(stmt);
+    if (!metaResult) {
+        if (mysql_stmt_field_count(stmt) == 0) {
+            return ColumnarResult();
+        }
+        return mysqlError(stmt, "mysql_stmt_result_metadata failed");
+    }
+    std::unique_ptr<MYSQL_RES, decltype(&mysql_free_result)> metaGuard(metaResult, mysql_free_result);
+
+    unsigned int numFields = mysql_num_fields(metaResult);
+
+    // 结果绑定：整数列统一取为 BIGINT，浮点列取为 DOUBLE，其余 (字符串、DECIMAL、时间戳等) 由服务器转换为文本。
+    // 文本列使用固定大小的缓冲区，超出时用 mysql_stmt_fetch_column 直接读入结果的文本缓冲区。
+    constexpr unsigned long TEXT_BUFFER_SIZE = 256;
+    enum class MyColumn { Integer, Float, Text };
+    std::vector<MyColumn>      columnTypes(numFields, MyColumn::Text);
+    std::vector<MYSQL_BIND>    resultBinds(numFields);
+    std::vector<int64_t>       intBuffers(numFields);
+    std::vector<double>        doubleBuffers(numFields);
+    std::vector<char>          textBuffers(static_cast<size_t>(numFields) * TEXT_BUFFER_SIZE);
+    std::vector<unsigned long> lengths(numFields);
+    std::vector<char>          isNull(numFields);
+    std::vector<char>          error(numFields);
+
+    for (unsigned int i = 0; i < numFields; ++i) {
+        MYSQL_FIELD* field = mysql_fetch_field_direct(metaResult, i);
+        MYSQL_BIND&  bind  = resultBinds[i];
+        std::memset(&bind, 0, sizeof(MYSQL_BIND));
+
+        switch (field->type) {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_LONGLONG:
+                columnTypes[i]     = MyColumn::Integer;
+                bind.buffer_type   = MYSQL_TYPE_LONGLONG;
+                bind.buffer        = &intBuffers[i];
+                bind.buffer_length = sizeof(int64_t);
+                bind.is_unsigned   = (field->flags & UNSIGNED_FLAG) != 0;
+                break;
+            case MYSQL_TYPE_FLOAT:
+            case MYSQL_TYPE_DOUBLE:
+                columnTypes[i]     = MyColumn::Float;
+                bind.buffer_type   = MYSQL_TYPE_DOUBLE;
+                bind.buffer        = &doubleBuffers[i];
+                bind.buffer_length = sizeof(double);
+                break;
+            default:
+                bind.buffer_type   = MYSQL_TYPE_STRING;
+                bind.buffer        = textBuffers.data() + static_cast<size_t>(i) * TEXT_BUFFER_SIZE;
+                bind.buffer_length = TEXT_BUFFER_SIZE;
+                break;
+        }
+        bind.length  = &lengths[i];
+        bind.is_null = reinterpret_cast<bool*>(&isNull[i]);
+        bind.error   = reinterpret_cast<bool*>(&error[i]);
+    }
+
+    if (mysql_stmt_bind_result(stmt, resultBinds.data())) {
+        return mysqlError(stmt, "mysql_stmt_bind_result failed");
+    }
+    if (mysql_stmt_store_result(stmt)) {
+        return mysqlError(stmt, "mysql_stmt_store_result failed");
+    }
+
+    // 结果已全部拉到客户端，行数已知
+    ColumnarResult columnar(numFields, static_cast<size_t>(mysql_stmt_num_rows(stmt)));
+    while (true) {
+        int fetchRc = mysql_stmt_fetch(stmt);
+        if (fetchRc == MYSQL_NO_DATA) {
+            break;
+        }
+        if (fetchRc == 1) {
+            return mysqlError(stmt, "mysql_stmt_fetch failed");
+        }
+
+        for (unsigned int i = 0; i < numFields; ++i) {
+            if (isNull[i]) {
+                columnar.appendNull(i);
+                continue;
+            }
+            switch (columnTypes[i]) {
+                case MyColumn::Integer:
+                    columnar.appendInt64(i, intBuffers[i]);
+                    break;
+                case MyColumn::Float:
+                    columnar.appendDouble(i, doubleBuffers[i]);
+                    break;
+                default:
+                    if (lengths[i] <= TEXT_BUFFER_SIZE) {
+                        columnar.appendText(i, static_cast<const char*>(resultBinds[i].buffer), lengths[i]);
+                    } else {
+                        // 被截断的长文本：在结果缓冲区中预留完整长度，再读取整列
+                        MYSQL_BIND    fullBind;
+                        unsigned long fullLength = 0;
+                        std::memset(&fullBind, 0, sizeof(MYSQL_BIND));
+                        fullBind.buffer_type   = MYSQL_TYPE_STRING;
+                        fullBind.buffer        = columnar.appendTextSpace(i, lengths[i]);
+                        fullBind.buffer_length = lengths[i];
+                        fullBind.length        = &fullLength;
+                        if (mysql_stmt_fetch_column(stmt, &fullBind, i, 0)) {
+                            return mysqlError(stmt, "mysql_stmt_fetch_column failed");
+                        }
+                    }
+                    break;
+            }
+        }
+        columnar.finishRow();
+    }
+
+    return columnar;
+}
+
+
 } // namespace db
\ No newline at end of file
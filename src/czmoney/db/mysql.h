@@ -1,6 +1,7 @@
 #pragma once
 
 #include "czmoney/database_interface.h" // 包含数据库接口
+#include "czmoney/db/columnar.h" // 包含按列存储的查询结果
 #include <mysql.h>
 #include <string>
 #include <memory>
@@ -31,6 +32,12 @@ public:
      */
     explicit MySQLException(const std::string& message, MYSQL_STMT* stmt)
         : DatabaseException(message + ": " + std::string(mysql_stmt_error(stmt))) {}
+
+    /**
+     * @brief 构造函数 (由不抛异常的操作返回的错误转换)
+     * @param error 结构化的错误
+     */
+    explicit MySQLException(const DbError& error) : DatabaseException(error.message, error.code) {}
 };
 
 
@@ -131,10 +138,20 @@ public:
     void beginTransaction() override;
     void commitTransaction() override;
     void rollbackTransaction() override;
+    bool inTransaction() const override;
 
     // --- 预处理语句 ---
     int executePrepared(const std::string& sql, const DbParams& params) override;
     DbResult queryPrepared(const std::string& sql, const DbParams& params) override;
+    ColumnarResult queryColumnar(const std::string& sql, const DbParams& params) override;
+
+    // --- 不抛异常的操作 ---
+    DbExpected<int> tryExecute(const std::string& sql) override;
+    DbExpected<int> tryExecutePrepared(const std::string& sql, const DbParams& params) override;
+    DbExpected<ColumnarResult> tryQueryColumnar(const std::string& sql, const DbParams& params) override;
+    DbExpected<void> tryBeginTransaction() override;
+    DbExpected<void> tryCommitTransaction() override;
+    DbExpected<void> tryRollbackTransaction() override;
 
 private:
     std::string m_host;       // 数据库主机
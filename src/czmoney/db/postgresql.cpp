@@ -1,6 +1,8 @@
 #include "czmoney/db/postgresql.h"
 #include <algorithm> // For std::transform
+#include <cstdlib>   // For std::strtoll, std::strtod
 #include <sstream>   // For std::stringstream
+#include <string_view>
 #include <utility>   // For std::move
 #include <variant>   // For DbValue
 #include <vector>    // For DbResult, DbRow
@@ -8,6 +10,51 @@
 
 namespace db {
 
+// 按 SQLSTATE 对错误分类
+static DbError pgError(PGresult* result, PGconn* connection, const std::string& message) {
+    DbError error;
+    if (!connection || PQstatus(connection) != CONNECTION_OK) {
+        error.code = DbErrorCode::Disconnected;
+    } else if (result) {
+        const char*      state    = PQresultErrorField(result, PG_DIAG_SQLSTATE);
+        std::string_view sqlState = state ? state : "";
+        if (sqlState.starts_with("23") || sqlState == "40001" || sqlState == "40P01") {
+            error.code = DbErrorCode::Conflict; // 约束冲突、序列化失败、死锁
+        } else if (sqlState == "57014") {
+            error.code = DbErrorCode::Timeout; // statement_timeout 或被取消
+        } else if (sqlState == "55P03" || sqlState == "53300") {
+            error.code = DbErrorCode::Busy; // lock_not_available (NOWAIT)、连接数已满
+        } else if (sqlState.starts_with("08")) {
+            error.code = DbErrorCode::Disconnected;
+        }
+    }
+    if (result) {
+        error.message = message + ": " + PQresultErrorMessage(result);
+    } else if (connection) {
+        error.message = message + ": " + PQerrorMessage(connection);
+    } else {
+        error.message = message;
+    }
+    return error;
+}
+
+static DbError notConnectedError() { return {DbErrorCode::Disconnected, "Not connected to PostgreSQL database"}; }
+
+// 把不抛异常的结果转换为抛异常的接口
+template <typename T>
+static T unwrapOrThrow(DbExpected<T>&& result) {
+    if (!result) {
+        throw PostgreSQLException(result.error());
+    }
+    return std::move(result).value();
+}
+
+static void unwrapOrThrow(DbExpected<void>&& result) {
+    if (!result) {
+        throw PostgreSQLException(result.error());
+    }
+}
+
 // 构造函数实现
 PostgreSQLConnection::PostgreSQLConnection(
     const std::string& host,
@@ -130,14 +177,16 @@ void PostgreSQLConnection::checkResult(PGresult* result, ExecStatusType expected
 }
 
 // 执行 SQL 语句实现 (符合 IDatabaseConnection 接口)
-int PostgreSQLConnection::execute(const std::string& sql) {
+int PostgreSQLConnection::execute(const std::string& sql) { return unwrapOrThrow(tryExecute(sql)); }
+
+DbExpected<int> PostgreSQLConnection::tryExecute(const std::string& sql) {
     if (!isConnected()) {
-        throw PostgreSQLException("Not connected to PostgreSQL database");
+        return notConnectedError();
     }
 
     PGresult* result = PQexec(m_connection, sql.c_str());
     if (!result) {
-        throw PostgreSQLException("PQexec failed for SQL: " + sql, m_connection);
+        return pgError(nullptr, m_connection, "PQexec failed for SQL: " + sql);
     }
 
     // 使用 RAII 管理 PGresult
@@ -151,7 +200,7 @@ int PostgreSQLConnection::execute(const std::string& sql) {
         case PGRES_TUPLES_OK:   // 成功执行的查询 (SELECT)
             break;
         default:
-            throw PostgreSQLException("PostgreSQL command failed for SQL: " + sql, result);
+            return pgError(result, m_connection, "PostgreSQL command failed for SQL: " + sql);
     }
 
     // 对于 INSERT, UPDATE, DELETE 等操作，可以返回影响的行数
@@ -223,40 +272,43 @@ PGconn* PostgreSQLConnection::getPGconn() const {
 
 // --- 事务管理实现 ---
 
-void PostgreSQLConnection::beginTransaction() {
-    if (!isConnected()) {
-        throw PostgreSQLException("Not connected to database");
-    }
-    
-    PGresult* result = PQexec(m_connection, "BEGIN");
-    checkResult(result, PGRES_COMMAND_OK, "Failed to begin transaction");
-    PQclear(result);
+void PostgreSQLConnection::beginTransaction() { unwrapOrThrow(tryBeginTransaction()); }
+
+void PostgreSQLConnection::commitTransaction() { unwrapOrThrow(tryCommitTransaction()); }
+
+void PostgreSQLConnection::rollbackTransaction() { unwrapOrThrow(tryRollbackTransaction()); }
+
+DbExpected<void> PostgreSQLConnection::tryBeginTransaction() {
+    DbExpected<int> result = tryExecute("BEGIN");
+    if (!result) return DbError{result.error().code, "Failed to begin transaction: " + result.error().message};
+    return {};
 }
 
-void PostgreSQLConnection::commitTransaction() {
-    if (!isConnected()) {
-        throw PostgreSQLException("Not connected to database");
-    }
-    
-    PGresult* result = PQexec(m_connection, "COMMIT");
-    if (PQresultStatus(result) != PGRES_COMMAND_OK) {
-        PQclear(result);
+DbExpected<void> PostgreSQLConnection::tryCommitTransaction() {
+    DbExpected<int> result = tryExecute("COMMIT");
+    if (!result) {
         // 提交失败，尝试回滚
-        PGresult* rollbackResult = PQexec(m_connection, "ROLLBACK");
-        PQclear(rollbackResult); // 清理回滚结果
-        throw PostgreSQLException("Failed to commit transaction", result);
+        (void)tryExecute("ROLLBACK");
+        discardAfterCommit();
+        return DbError{result.error().code, "Failed to commit transaction: " + result.error().message};
     }
-    PQclear(result);
+    runAfterCommit();
+    return {};
 }
 
-void PostgreSQLConnection::rollbackTransaction() {
+DbExpected<void> PostgreSQLConnection::tryRollbackTransaction() {
+    discardAfterCommit();
+    DbExpected<int> result = tryExecute("ROLLBACK");
+    if (!result) return DbError{result.error().code, "Failed to rollback transaction: " + result.error().message};
+    return {};
+}
+
+bool PostgreSQLConnection::inTransaction() const {
     if (!isConnected()) {
-        throw PostgreSQLException("Not connected to database");
+        return false;
     }
-    
-    PGresult* result = PQexec(m_connection, "ROLLBACK");
-    checkResult(result, PGRES_COMMAND_OK, "Failed to rollback transaction");
-    PQclear(result);
+    PGTransactionStatusType status = PQtransactionStatus(m_connection);
+    return status == PQTRANS_INTRANS || status == PQTRANS_INERROR;
 }
 
 // 辅助函数：将 DbValue 转换为字符串
@@ -279,12 +331,8 @@ std::string PostgreSQLConnection::valueToString(const DbValue& value) {
 
 // --- 预处理语句实现 ---
 
-int PostgreSQLConnection::executePrepared(const std::string& sql, const DbParams& params) {
-    if (!isConnected()) {
-        throw PostgreSQLException("Not connected to PostgreSQL database");
-    }
-
-    // 准备参数
+// 辅助函数：以文本格式绑定参数并执行语句
+PGresult* PostgreSQLConnection::execParams(const std::string& sql, const DbParams& params) {
     std::vector<const char*> paramValues;
     std::vector<int> paramLengths;
     std::vector<int> paramFormats;
@@ -296,24 +344,18 @@ int PostgreSQLConnection::executePrepared(const std::string& sql, const DbParams
     stringParams.reserve(params.size());
 
     for (const auto& param : params) {
-        std::visit([&](auto&& arg) {
-            using T = std::decay_t<decltype(arg)>;
-            if constexpr (std::is_same_v<T, std::nullptr_t>) {
-                paramValues.push_back(nullptr);
-                paramLengths.push_back(0);
-                paramFormats.push_back(0); // 文本格式
-            } else {
-                // 转换为字符串
-                stringParams.push_back(valueToString(param));
-                paramValues.push_back(stringParams.back().c_str());
-                paramLengths.push_back(static_cast<int>(stringParams.back().length()));
-                paramFormats.push_back(0); // 文本格式
-            }
-        }, param);
+        if (std::holds_alternative<std::nullptr_t>(param)) {
+            paramValues.push_back(nullptr);
+            paramLengths.push_back(0);
+        } else {
+            stringParams.push_back(valueToString(param));
+            paramValues.push_back(stringParams.back().c_str());
+            paramLengths.push_back(static_cast<int>(stringParams.back().length()));
+        }
+        paramFormats.push_back(0); // 文本格式
     }
 
-    // 执行预处理语句
-    PGresult* result = PQexecParams(
+    return PQexecParams(
         m_connection,
         sql.c_str(),
         static_cast<int>(params.size()),
@@ -323,9 +365,20 @@ int PostgreSQLConnection::executePrepared(const std::string& sql, const DbParams
         paramFormats.data(),
         0 // 结果格式 (0 = 文本格式)
     );
+}
+
+int PostgreSQLConnection::executePrepared(const std::string& sql, const DbParams& params) {
+    return unwrapOrThrow(tryExecutePrepared(sql, params));
+}
+
+DbExpected<int> PostgreSQLConnection::tryExecutePrepared(const std::string& sql, const DbParams& params) {
+    if (!isConnected()) {
+        return notConnectedError();
+    }
 
+    PGresult* result = execParams(sql, params);
     if (!result) {
-        throw PostgreSQLException("PQexecParams failed", m_connection);
+        return pgError(nullptr, m_connection, "PQexecParams failed");
     }
 
     // 使用 RAII 管理 PGresult
@@ -333,12 +386,12 @@ int PostgreSQLConnection::executePrepared(const std::string& sql, const DbParams
 
     ExecStatusType status = PQresultStatus(result);
     if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
-        throw PostgreSQLException("PostgreSQL prepared statement execution failed", result);
+        return pgError(result, m_connection, "PostgreSQL prepared statement execution failed");
     }
 
     // 获取受影响的行数
-    char* affected = PQcmdTuples(result);
-    if (affected && strlen(affected) > 0) {
+    const char* affected = PQcmdTuples(result);
+    if (affected && affected[0] != '\0') {
         return std::atoi(affected);
     }
 
@@ -432,4 +485,88 @@ DbResult PostgreSQLConnection::queryPrepared(const std::string& sql, const DbPar
     return dbResult;
 }
 
+ColumnarResult PostgreSQLConnection::queryColumnar(const std::string& sql, const DbParams& params) {
+    return unwrapOrThrow(tryQueryColumnar(sql, params));
+}
+
+DbExpected<ColumnarResult> PostgreSQLConnection::tryQueryColumnar(const std::string& sql, const DbParams& params) {
+    if (!isConnected()) {
+        return notConnectedError();
+    }
+
+    PGresult* result = execParams(sql, params);
+    if (!result) {
+        return pgError(nullptr, m_connection, "PQexecParams failed");
+    }
+    std::unique_ptr<PGresult, decltype(&PQclear)> resultGuard(result, PQclear);
+
+    ExecStatusType status = PQresultStatus(result);
+    if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK) {
+        return pgError(result, m_connection, "PostgreSQL columnar query failed");
+    }
+    if (status == PGRES_COMMAND_OK) {
+        return ColumnarResult();
+    }
+
+    int numRows   = PQntuples(result);
+    int numFields = PQnfields(result);
+
+    // 按列的类型 OID 决定解析方式：整数、浮点数直接转换，其余 (NUMERIC、时间戳等) 保留文本
+    enum class PgColumn { Integer, Float, Text };
+    std::vector<PgColumn> columnTypes(numFields, PgColumn::Text);
+    for (int col = 0; col < numFields; ++col) {
+        switch (PQftype(result, col)) {
+            case 20: // int8
+            case 21: // int2
+            case 23: // int4
+            case 26: // oid
+                columnTypes[col] = PgColumn::Integer;
+                break;
+            case 700: // float4
+            case 701: // float8
+                columnTypes[col] = PgColumn::Float;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // 行数和文本总长度都已知，文本缓冲区一次分配到位
+    size_t textBytes = 0;
+    for (int col = 0; col < numFields; ++col) {
+        if (columnTypes[col] != PgColumn::Text) {
+            continue;
+        }
+        for (int row = 0; row < numRows; ++row) {
+            textBytes += static_cast<size_t>(PQgetlength(result, row, col));
+        }
+    }
+
+    ColumnarResult columnar(static_cast<size_t>(numFields), static_cast<size_t>(numRows), textBytes);
+    for (int row = 0; row < numRows; ++row) {
+        for (int col = 0; col < numFields; ++col) {
+            if (PQgetisnull(result, row, col)) {
+                columnar.appendNull(col);
+                continue;
+            }
+            const char* value = PQgetvalue(result, row, col);
+            switch (columnTypes[col]) {
+                case PgColumn::Integer:
+                    columnar.appendInt64(col, std::strtoll(value, nullptr, 10));
+                    break;
+                case PgColumn::Float:
+                    columnar.appendDouble(col, std::strtod(value, nullptr));
+                    break;
+                default:
+                    columnar.appendText(col, value, static_cast<size_t>(PQgetlength(result, row, col)));
+                    break;
+            }
+        }
+        columnar.finishRow();
+    }
+
+    return columnar;
+}
+
+
 } // namespace db
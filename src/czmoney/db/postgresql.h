@@ -2,6 +2,7 @@
 #pragma once
 
 #include "czmoney/database_interface.h" // 包含数据库接口
+#include "czmoney/db/columnar.h" // 包含按列存储的查询结果
 #include <libpq-fe.h> // PostgreSQL C API
 #include <string>
 #include <memory>
@@ -32,6 +33,12 @@ public:
      */
     explicit PostgreSQLException(const std::string& message, PGresult* result)
         : DatabaseException(message + ": " + std::string(PQresultErrorMessage(result))) {}
+
+    /**
+     * @brief 构造函数 (由不抛异常的操作返回的错误转换)
+     * @param error 结构化的错误
+     */
+    explicit PostgreSQLException(const DbError& error) : DatabaseException(error.message, error.code) {}
 };
 
 
@@ -132,10 +139,20 @@ public:
     void beginTransaction() override;
     void commitTransaction() override;
     void rollbackTransaction() override;
+    bool inTransaction() const override;
 
     // --- 预处理语句 ---
     int executePrepared(const std::string& sql, const DbParams& params) override;
     DbResult queryPrepared(const std::string& sql, const DbParams& params) override;
+    ColumnarResult queryColumnar(const std::string& sql, const DbParams& params) override;
+
+    // --- 不抛异常的操作 ---
+    DbExpected<int> tryExecute(const std::string& sql) override;
+    DbExpected<int> tryExecutePrepared(const std::string& sql, const DbParams& params) override;
+    DbExpected<ColumnarResult> tryQueryColumnar(const std::string& sql, const DbParams& params) override;
+    DbExpected<void> tryBeginTransaction() override;
+    DbExpected<void> tryCommitTransaction() override;
+    DbExpected<void> tryRollbackTransaction() override;
 
 private:
     std::string m_host;         // 数据库主机
@@ -160,6 +177,12 @@ private:
      * @return std::string 转换后的字符串表示
      */
     std::string valueToString(const DbValue& value);
+
+    /**
+     * @brief 辅助函数：以文本格式绑定参数并执行语句 (PQexecParams)
+     * @return PGresult* 执行结果，调用方负责 PQclear；连接失败时可能为 nullptr
+     */
+    PGresult* execParams(const std::string& sql, const DbParams& params);
 };
 
 } // namespace db
@@ -1,5 +1,6 @@
 #include "czmoney/db/sqlite.h"
 #include <filesystem> // For creating directories if needed
+#include <optional>
 #include <utility>    // For std::move
 #include <variant>    // For DbValue
 #include <vector>     // For DbResult and DbRow
@@ -53,6 +54,45 @@ public:
     }
 };
 
+// 按 SQLite 结果码对错误分类
+static DbError sqliteError(int rc, const std::string& message, sqlite3* db) {
+    DbError error;
+    switch (rc & 0xff) { // 扩展结果码的低 8 位是主结果码
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+            error.code = DbErrorCode::Busy;
+            break;
+        case SQLITE_CONSTRAINT:
+            error.code = DbErrorCode::Conflict;
+            break;
+        case SQLITE_INTERRUPT:
+            error.code = DbErrorCode::Timeout;
+            break;
+        default:
+            error.code = DbErrorCode::Other;
+            break;
+    }
+    error.message = db ? message + ": " + sqlite3_errmsg(db) : message;
+    return error;
+}
+
+static DbError notConnectedError() { return {DbErrorCode::Disconnected, "Not connected to SQLite database"}; }
+
+// 把不抛异常的结果转换为抛异常的接口
+template <typename T>
+static T unwrapOrThrow(DbExpected<T>&& result) {
+    if (!result) {
+        throw SQLiteException(result.error());
+    }
+    return std::move(result).value();
+}
+
+static void unwrapOrThrow(DbExpected<void>&& result) {
+    if (!result) {
+        throw SQLiteException(result.error());
+    }
+}
+
 // 构造函数实现
 SQLiteConnection::SQLiteConnection(const std::string& dbPath) :
     m_dbPath(dbPath),
@@ -152,10 +192,11 @@ bool SQLiteConnection::isConnected() const {
 }
 
 // 执行 SQL 语句实现 (简单版本，无结果集)
-int SQLiteConnection::execute(const std::string& sql) {
+int SQLiteConnection::execute(const std::string& sql) { return unwrapOrThrow(tryExecute(sql)); }
+
+DbExpected<int> SQLiteConnection::tryExecute(const std::string& sql) {
     if (!isConnected()) {
-        throw SQLiteException("Not connected to SQLite database");
-        // return SQLITE_ERROR; // 或者返回错误码
+        return notConnectedError();
     }
 
     char* errMsg = nullptr;
@@ -167,8 +208,7 @@ int SQLiteConnection::execute(const std::string& sql) {
             errorStr += " - Error: " + std::string(errMsg);
             sqlite3_free(errMsg); // 释放 SQLite 分配的错误消息内存
         }
-        throw SQLiteException(errorStr, m_db); // 抛出异常
-        // return rc; // 返回 SQLite 错误码
+        return sqliteError(rc, errorStr, m_db);
     }
 
     return rc; // 返回 SQLITE_OK
@@ -258,119 +298,129 @@ std::string SQLiteConnection::getDbType() const {
 
 // --- 事务管理实现 ---
 
-void SQLiteConnection::beginTransaction() {
-    // 使用 execute 执行 BEGIN TRANSACTION
-    // execute 内部会检查连接并抛出异常
-    execute("BEGIN TRANSACTION;");
+void SQLiteConnection::beginTransaction() { unwrapOrThrow(tryBeginTransaction()); }
+
+void SQLiteConnection::commitTransaction() { unwrapOrThrow(tryCommitTransaction()); }
+
+void SQLiteConnection::rollbackTransaction() { unwrapOrThrow(tryRollbackTransaction()); }
+
+DbExpected<void> SQLiteConnection::tryBeginTransaction() {
+    DbExpected<int> result = tryExecute("BEGIN TRANSACTION;");
+    if (!result) return result.error();
+    return {};
+}
+
+DbExpected<void> SQLiteConnection::tryCommitTransaction() {
+    DbExpected<int> result = tryExecute("COMMIT;");
+    if (!result) {
+        // 提交失败时事务可能仍然打开 (例如 SQLITE_BUSY)，回调留到调用方回滚时丢弃
+        if (!inTransaction()) discardAfterCommit();
+        return result.error();
+    }
+    runAfterCommit();
+    return {};
 }
 
-void SQLiteConnection::commitTransaction() {
-    // 使用 execute 执行 COMMIT
-    execute("COMMIT;");
+DbExpected<void> SQLiteConnection::tryRollbackTransaction() {
+    discardAfterCommit();
+    DbExpected<int> result = tryExecute("ROLLBACK;");
+    if (!result) return result.error();
+    return {};
 }
 
-void SQLiteConnection::rollbackTransaction() {
-    // 使用 execute 执行 ROLLBACK
-    execute("ROLLBACK;");
+bool SQLiteConnection::inTransaction() const {
+    // 自动提交模式被 BEGIN 关闭，COMMIT/ROLLBACK 后恢复
+    return m_db != nullptr && sqlite3_get_autocommit(m_db) == 0;
 }
 
 // --- 预处理语句辅助函数 (绑定参数) ---
-// 将 DbValue 绑定到 SQLite 语句的指定索引
-static void bindParameter(sqlite3_stmt* stmt, int index, const DbValue& value) {
-    int rc = SQLITE_OK;
-    std::visit([&](auto&& arg) {
+// 将 DbValue 绑定到 SQLite 语句的指定索引，返回 SQLite 结果码
+static int bindParameter(sqlite3_stmt* stmt, int index, const DbValue& value) {
+    return std::visit([&](auto&& arg) -> int {
         using T = std::decay_t<decltype(arg)>;
         if constexpr (std::is_same_v<T, std::nullptr_t>) {
-            rc = sqlite3_bind_null(stmt, index);
+            return sqlite3_bind_null(stmt, index);
         } else if constexpr (std::is_same_v<T, int64_t>) {
-            rc = sqlite3_bind_int64(stmt, index, arg);
+            return sqlite3_bind_int64(stmt, index, arg);
         } else if constexpr (std::is_same_v<T, double>) {
-            rc = sqlite3_bind_double(stmt, index, arg);
-        } else if constexpr (std::is_same_v<T, std::string>) {
-            // SQLITE_TRANSIENT: SQLite 复制字符串，更安全
-            rc = sqlite3_bind_text(stmt, index, arg.c_str(), -1, SQLITE_TRANSIENT);
+            return sqlite3_bind_double(stmt, index, arg);
         } else {
-            // 理论上不应发生，因为 DbValue 类型有限
-            throw SQLiteException("Unsupported parameter type encountered during binding", stmt);
+            // SQLITE_TRANSIENT: SQLite 复制字符串，更安全
+            return sqlite3_bind_text(stmt, index, arg.c_str(), static_cast<int>(arg.size()), SQLITE_TRANSIENT);
         }
     }, value);
-
-    if (rc != SQLITE_OK) {
-        throw SQLiteException("Failed to bind parameter at index " + std::to_string(index), stmt);
-    }
 }
 
-// --- 预处理语句实现 ---
-
-int SQLiteConnection::executePrepared(const std::string& sql, const DbParams& params) {
-    if (!isConnected()) {
-        throw SQLiteException("Not connected to SQLite database");
-    }
-
+// 准备语句并绑定全部参数，失败时返回错误
+static std::optional<DbError>
+prepareStatement(sqlite3* db, const std::string& sql, const DbParams& params, SQLiteStatementGuard& guard) {
     sqlite3_stmt* stmt = nullptr;
-    // 准备 SQL 语句
-    int rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, nullptr);
-    SQLiteStatementGuard stmtGuard(stmt); // RAII 管理
+    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+    guard.reset(stmt); // RAII 管理
 
     if (rc != SQLITE_OK) {
-        throw SQLiteException("sqlite3_prepare_v2 failed for SQL: " + sql, m_db);
+        return sqliteError(rc, "sqlite3_prepare_v2 failed for SQL: " + sql, db);
     }
 
     // 检查参数数量是否匹配占位符数量
     int expectedParams = sqlite3_bind_parameter_count(stmt);
     if (expectedParams != static_cast<int>(params.size())) {
-        throw SQLiteException("Parameter count mismatch: SQL expects " + std::to_string(expectedParams) +
-                              ", but " + std::to_string(params.size()) + " provided.", stmt);
+        return DbError{
+            DbErrorCode::Other,
+            "Parameter count mismatch: SQL expects " + std::to_string(expectedParams) + ", but "
+                + std::to_string(params.size()) + " provided."
+        };
     }
 
-
-    // 绑定所有参数
+    // 绑定所有参数 (索引从 1 开始)
     for (size_t i = 0; i < params.size(); ++i) {
-        bindParameter(stmt, static_cast<int>(i + 1), params[i]); // 索引从 1 开始
+        rc = bindParameter(stmt, static_cast<int>(i + 1), params[i]);
+        if (rc != SQLITE_OK) {
+            return sqliteError(rc, "Failed to bind parameter at index " + std::to_string(i + 1), db);
+        }
     }
+    return std::nullopt;
+}
 
-    // 执行语句
-    rc = sqlite3_step(stmt);
+// --- 预处理语句实现 ---
 
-    // 对于 execute (非 query)，期望的结果是 SQLITE_DONE
+int SQLiteConnection::executePrepared(const std::string& sql, const DbParams& params) {
+    return unwrapOrThrow(tryExecutePrepared(sql, params));
+}
+
+DbExpected<int> SQLiteConnection::tryExecutePrepared(const std::string& sql, const DbParams& params) {
+    if (!isConnected()) {
+        return notConnectedError();
+    }
+
+    SQLiteStatementGuard stmtGuard;
+    if (auto error = prepareStatement(m_db, sql, params, stmtGuard)) {
+        return std::move(*error);
+    }
+
+    // 执行语句，对于 execute (非 query)，期望的结果是 SQLITE_DONE
+    int rc = sqlite3_step(stmtGuard.get());
     if (rc != SQLITE_DONE) {
-        // 如果不是 DONE，则发生了错误
-        throw SQLiteException("sqlite3_step failed during prepared statement execution", stmt);
+        return sqliteError(rc, "sqlite3_step failed during prepared statement execution", m_db);
     }
 
     // 获取受影响的行数 (对于 INSERT, UPDATE, DELETE)
-    int changes = sqlite3_changes(m_db);
-
     // stmtGuard 会自动调用 sqlite3_finalize
-    return changes; // 返回受影响的行数
+    return sqlite3_changes(m_db);
 }
 
 
 DbResult SQLiteConnection::queryPrepared(const std::string& sql, const DbParams& params) {
-     if (!isConnected()) {
-        throw SQLiteException("Not connected to SQLite database");
-    }
-
-    sqlite3_stmt* stmt = nullptr;
-    // 准备 SQL 语句
-    int rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, nullptr);
-    SQLiteStatementGuard stmtGuard(stmt); // RAII 管理
-
-    if (rc != SQLITE_OK) {
-        throw SQLiteException("sqlite3_prepare_v2 failed for SQL: " + sql, m_db);
+    if (!isConnected()) {
+        throw SQLiteException(notConnectedError());
     }
 
-    // 检查参数数量
-    int expectedParams = sqlite3_bind_parameter_count(stmt);
-     if (expectedParams != static_cast<int>(params.size())) {
-        throw SQLiteException("Parameter count mismatch: SQL expects " + std::to_string(expectedParams) +
-                              ", but " + std::to_string(params.size()) + " provided.", stmt);
-    }
-
-    // 绑定所有参数
-    for (size_t i = 0; i < params.size(); ++i) {
-        bindParameter(stmt, static_cast<int>(i + 1), params[i]);
+    SQLiteStatementGuard stmtGuard;
+    if (auto error = prepareStatement(m_db, sql, params, stmtGuard)) {
+        throw SQLiteException(*error);
     }
+    sqlite3_stmt* stmt = stmtGuard.get();
+    int           rc   = SQLITE_OK;
 
     DbResult result; // 存储查询结果
 
@@ -418,4 +468,122 @@ DbResult SQLiteConnection::queryPrepared(const std::string& sql, const DbParams&
 }
 
 
+ColumnarResult SQLiteConnection::queryColumnar(const std::string& sql, const DbParams& params) {
+    return unwrapOrThrow(tryQueryColumnar(sql, params));
+}
+
+DbExpected<ColumnarResult> SQLiteConnection::tryQueryColumnar(const std::string& sql, const DbParams& params) {
+    if (!isConnected()) {
+        return notConnectedError();
+    }
+
+    SQLiteStatementGuard stmtGuard;
+    if (auto error = prepareStatement(m_db, sql, params, stmtGuard)) {
+        return std::move(*error);
+    }
+    sqlite3_stmt* stmt = stmtGuard.get();
+    int           rc   = SQLITE_OK;
+
+    // SQLite 事先不知道行数，各列数组按倍增方式增长
+    int            columnCount = sqlite3_column_count(stmt);
+    ColumnarResult result(static_cast<size_t>(columnCount));
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (int i = 0; i < columnCount; ++i) {
+            switch (sqlite3_column_type(stmt, i)) {
+                case SQLITE_INTEGER:
+                    result.appendInt64(i, sqlite3_column_int64(stmt, i));
+                    break;
+                case SQLITE_FLOAT:
+                    result.appendDouble(i, sqlite3_column_double(stmt, i));
+                    break;
+                case SQLITE_TEXT: {
+                    // 先取指针再取长度 (sqlite3_column_bytes 必须在类型转换之后调用)
+                    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, i));
+                    result.appendText(i, text, static_cast<size_t>(sqlite3_column_bytes(stmt, i)));
+                    break;
+                }
+                case SQLITE_BLOB: {
+                    const char* blob = static_cast<const char*>(sqlite3_column_blob(stmt, i));
+                    result.appendText(i, blob, static_cast<size_t>(sqlite3_column_bytes(stmt, i)));
+                    break;
+                }
+                default:
+                    result.appendNull(i);
+                    break;
+            }
+        }
+        result.finishRow();
+    }
+
+    if (rc != SQLITE_DONE) {
+        return sqliteError(rc, "sqlite3_step failed during columnar query execution", m_db);
+    }
+    return result;
+}
+
+
+// --- SQLiteSnapshot ---
+
+SQLiteSnapshot::SQLiteSnapshot(SQLiteConnection& source, std::filesystem::path path) : m_path(std::move(path)) {
+    std::error_code ec;
+    std::filesystem::remove(m_path, ec);
+    if (!source.getDB()) {
+        throw SQLiteException("Source database is not connected");
+    }
+    if (sqlite3_open(m_path.string().c_str(), &m_dest) != SQLITE_OK) {
+        SQLiteException error("Failed to create snapshot file " + m_path.string(), m_dest);
+        close();
+        throw error;
+    }
+    m_backup = sqlite3_backup_init(m_dest, "main", source.getDB(), "main");
+    if (!m_backup) {
+        SQLiteException error("Failed to start online backup", m_dest);
+        close();
+        throw error;
+    }
+}
+
+SQLiteSnapshot::~SQLiteSnapshot() { close(); }
+
+bool SQLiteSnapshot::step(int pages) {
+    if (m_done) {
+        return true;
+    }
+    if (!m_backup) {
+        throw SQLiteException("Online backup has already failed");
+    }
+    int rc = sqlite3_backup_step(m_backup, pages);
+    if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        return false; // 还有剩余的页，或源库暂时被锁定，下次继续
+    }
+    if (rc == SQLITE_DONE) {
+        rc = sqlite3_backup_finish(m_backup);
+        m_backup = nullptr;
+    }
+    if (rc != SQLITE_OK) {
+        SQLiteException error("Online backup step failed", m_dest);
+        close();
+        throw error;
+    }
+    m_done = true;
+    close();
+    return true;
+}
+
+void SQLiteSnapshot::close() {
+    if (m_backup) {
+        sqlite3_backup_finish(m_backup);
+        m_backup = nullptr;
+    }
+    if (m_dest) {
+        sqlite3_close(m_dest);
+        m_dest = nullptr;
+    }
+    if (!m_done) {
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+}
+
 } // namespace db
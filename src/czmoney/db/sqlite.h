@@ -1,6 +1,8 @@
 #pragma once
 
 #include "czmoney/database_interface.h" // 包含数据库接口
+#include "czmoney/db/columnar.h" // 包含按列存储的查询结果
+#include <filesystem>
 #include <sqlite3.h>
 #include <string>
 #include <stdexcept>
@@ -31,6 +33,12 @@ public:
      */
     explicit SQLiteException(const std::string& message, sqlite3_stmt* stmt)
         : DatabaseException(message + (stmt ? ": " + std::string(sqlite3_errmsg(sqlite3_db_handle(stmt))) : "")) {}
+
+    /**
+     * @brief 构造函数 (由不抛异常的操作返回的错误转换)
+     * @param error 结构化的错误
+     */
+    explicit SQLiteException(const DbError& error) : DatabaseException(error.message, error.code) {}
 };
 
 
@@ -117,10 +125,20 @@ public:
     void beginTransaction() override;
     void commitTransaction() override;
     void rollbackTransaction() override;
+    bool inTransaction() const override;
 
     // --- 预处理语句 ---
     int executePrepared(const std::string& sql, const DbParams& params) override;
     DbResult queryPrepared(const std::string& sql, const DbParams& params) override;
+    ColumnarResult queryColumnar(const std::string& sql, const DbParams& params) override;
+
+    // --- 不抛异常的操作 ---
+    DbExpected<int> tryExecute(const std::string& sql) override;
+    DbExpected<int> tryExecutePrepared(const std::string& sql, const DbParams& params) override;
+    DbExpected<ColumnarResult> tryQueryColumnar(const std::string& sql, const DbParams& params) override;
+    DbExpected<void> tryBeginTransaction() override;
+    DbExpected<void> tryCommitTransaction() override;
+    DbExpected<void> tryRollbackTransaction() override;
 
 private:
     std::string m_dbPath;     // 数据库文件路径
@@ -128,4 +146,48 @@ private:
     bool        m_connected;  // 标记当前是否已连接
 };
 
+
+/**
+ * @brief 用 SQLite 在线备份 API 把一个连接的数据库按页复制到快照文件
+ *
+ * 其他连接的读事务会让源连接的写入失败，因此后台任务应读取快照而不是直接打开生产数据库。
+ * 调用者在源连接所在的线程上分步调用 step()，两步之间源连接可以照常写入 (写入会同步到已复制的页)。
+ * 未完成的快照在析构时删除；完成后的快照文件由调用者负责删除。
+ */
+class SQLiteSnapshot {
+public:
+    /**
+     * @brief 构造函数：创建快照文件并开始在线备份
+     * @param source 源连接 (必须已连接)
+     * @param path 快照文件路径 (已存在时被覆盖)
+     * @throws SQLiteException 无法创建快照文件或开始备份时抛出
+     */
+    SQLiteSnapshot(SQLiteConnection& source, std::filesystem::path path);
+    ~SQLiteSnapshot();
+
+    SQLiteSnapshot(const SQLiteSnapshot&) = delete;
+    SQLiteSnapshot& operator=(const SQLiteSnapshot&) = delete;
+
+    /**
+     * @brief 复制下一批页
+     * @param pages 本次最多复制的页数
+     * @return bool 是否已全部复制完成 (完成后快照文件已关闭，可以由其他连接打开)
+     * @throws SQLiteException 复制失败时抛出
+     */
+    bool step(int pages);
+
+    /**
+     * @brief 快照文件路径
+     */
+    [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+    sqlite3*              m_dest = nullptr;   // 快照文件的连接
+    sqlite3_backup*       m_backup = nullptr; // 在线备份句柄
+    bool                  m_done = false;
+
+    void close();
+};
+
 } // namespace db
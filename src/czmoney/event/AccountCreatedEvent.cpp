@@ -0,0 +1,14 @@
+#include "czmoney/event/AccountCreatedEvent.h"
+#include <ll/api/event/Emitter.h>
+
+namespace czmoney::event {
+
+// --- AccountCreatedEvent Getters ---
+std::string const& AccountCreatedEvent::getPlayerUuid() const { return mPlayerUuid; }
+std::string const& AccountCreatedEvent::getCurrencyType() const { return mCurrencyType; }
+int64_t const&     AccountCreatedEvent::getInitialBalance() const { return mInitialBalance; }
+
+// --- Emitter for Event ---
+class AccountCreatedEventEmitter : public ll::event::Emitter<[](auto&&...) { return nullptr; }, AccountCreatedEvent> {};
+
+} // namespace czmoney::event
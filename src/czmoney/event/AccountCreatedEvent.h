@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <ll/api/event/Event.h>
+#include <string>
+
+
+namespace czmoney::event {
+
+/**
+ * @brief 账户创建事件 (不可取消)
+ *
+ * 玩家某种货币的账户第一次被创建时触发 (例如玩家首次进服)。
+ * 账户创建不经过 SetMoneyBeforeEvent / SetMoneyAfterEvent；
+ * 多个线程同时创建同一账户时，只有真正插入记录的一方会触发该事件。
+ */
+class AccountCreatedEvent final : public ll::event::Event {
+protected:
+    std::string const& mPlayerUuid;
+    std::string const& mCurrencyType;
+    int64_t const&     mInitialBalance; // 初始余额，整数形式 (实际金额 * 100)
+
+public:
+    constexpr explicit AccountCreatedEvent(
+        std::string const& playerUuid,
+        std::string const& currencyType,
+        int64_t const&     initialBalance
+    )
+    : mPlayerUuid(playerUuid),
+      mCurrencyType(currencyType),
+      mInitialBalance(initialBalance) {}
+
+public:
+    std::string const& getPlayerUuid() const;
+    std::string const& getCurrencyType() const;
+    int64_t const&     getInitialBalance() const;
+};
+
+} // namespace czmoney::event
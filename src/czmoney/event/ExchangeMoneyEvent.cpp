@@ -0,0 +1,23 @@
+#include "czmoney/event/ExchangeMoneyEvent.h"
+#include <ll/api/event/Emitter.h>
+
+namespace czmoney::event {
+
+// --- Emitter for Before Event ---
+class ExchangeMoneyBeforeEventEmitter : public ll::event::Emitter<[](auto&&...) { return nullptr; }, ExchangeMoneyBeforeEvent> {};
+
+
+// --- ExchangeMoneyAfterEvent Getters ---
+std::string const& ExchangeMoneyAfterEvent::getPlayerUuid() const { return mPlayerUuid; }
+std::string const& ExchangeMoneyAfterEvent::getFromCurrency() const { return mFromCurrency; }
+std::string const& ExchangeMoneyAfterEvent::getToCurrency() const { return mToCurrency; }
+int64_t const&     ExchangeMoneyAfterEvent::getAmountPaid() const { return mAmountPaid; }
+int64_t const&     ExchangeMoneyAfterEvent::getAmountReceived() const { return mAmountReceived; }
+std::string const& ExchangeMoneyAfterEvent::getReason1() const { return mReason1; }
+std::string const& ExchangeMoneyAfterEvent::getReason2() const { return mReason2; }
+std::string const& ExchangeMoneyAfterEvent::getReason3() const { return mReason3; }
+
+// --- Emitter for After Event ---
+class ExchangeMoneyAfterEventEmitter : public ll::event::Emitter<[](auto&&...) { return nullptr; }, ExchangeMoneyAfterEvent> {};
+
+} // namespace czmoney::event
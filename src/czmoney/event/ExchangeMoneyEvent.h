@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <ll/api/event/Cancellable.h>
+#include <ll/api/event/Event.h>
+#include <string>
+
+
+namespace czmoney::event {
+
+/**
+ * @brief 货币兑换前事件 (可取消)
+ *
+ * 在同一玩家的两种货币之间兑换之前触发 (只触发这一次，不再分别触发扣款/加款事件)。
+ * 监听器可以取消此事件以阻止兑换，也可以修改支付金额；兑换所得只读，事件返回后按汇率由支付金额重新计算。
+ */
+class ExchangeMoneyBeforeEvent final : public ll::event::Cancellable<ll::event::Event> {
+protected:
+    std::string&   mPlayerUuid;
+    std::string&   mFromCurrency;
+    std::string&   mToCurrency;
+    int64_t&       mAmountPaid;     // 扣除的源货币金额 (整数形式 * 100)
+    int64_t const& mAmountReceived; // 按原支付金额计算的兑换所得 (整数形式 * 100，只读)
+    std::string&   mReason1;
+    std::string&   mReason2;
+    std::string&   mReason3;
+
+public:
+    constexpr explicit ExchangeMoneyBeforeEvent(
+        std::string&   playerUuid,
+        std::string&   fromCurrency,
+        std::string&   toCurrency,
+        int64_t&       amountPaid,
+        int64_t const& amountReceived,
+        std::string&   reason1,
+        std::string&   reason2,
+        std::string&   reason3
+    )
+    : mPlayerUuid(playerUuid),
+      mFromCurrency(fromCurrency),
+      mToCurrency(toCurrency),
+      mAmountPaid(amountPaid),
+      mAmountReceived(amountReceived),
+      mReason1(reason1),
+      mReason2(reason2),
+      mReason3(reason3) {}
+
+public:
+    std::string&   getPlayerUuid() const { return mPlayerUuid; }
+    std::string&   getFromCurrency() const { return mFromCurrency; }
+    std::string&   getToCurrency() const { return mToCurrency; }
+    int64_t&       getAmountPaid() const { return mAmountPaid; }
+    int64_t const& getAmountReceived() const { return mAmountReceived; }
+    std::string&   getReason1() const { return mReason1; }
+    std::string&   getReason2() const { return mReason2; }
+    std::string&   getReason3() const { return mReason3; }
+};
+
+/**
+ * @brief 货币兑换后事件 (不可取消)
+ *
+ * 在扣款、加款和两条流水于同一事务中提交之后触发。
+ * 监听器只能读取事件信息，不能修改。
+ */
+class ExchangeMoneyAfterEvent final : public ll::event::Event {
+protected:
+    std::string const& mPlayerUuid;
+    std::string const& mFromCurrency;
+    std::string const& mToCurrency;
+    int64_t const&     mAmountPaid;     // 扣除的源货币金额 (整数形式 * 100)
+    int64_t const&     mAmountReceived; // 获得的目标货币金额 (整数形式 * 100)
+    std::string const& mReason1;
+    std::string const& mReason2;
+    std::string const& mReason3;
+
+public:
+    constexpr explicit ExchangeMoneyAfterEvent(
+        std::string const& playerUuid,
+        std::string const& fromCurrency,
+        std::string const& toCurrency,
+        int64_t const&     amountPaid,
+        int64_t const&     amountReceived,
+        std::string const& reason1,
+        std::string const& reason2,
+        std::string const& reason3
+    )
+    : mPlayerUuid(playerUuid),
+      mFromCurrency(fromCurrency),
+      mToCurrency(toCurrency),
+      mAmountPaid(amountPaid),
+      mAmountReceived(amountReceived),
+      mReason1(reason1),
+      mReason2(reason2),
+      mReason3(reason3) {}
+
+public:
+    std::string const& getPlayerUuid() const;
+    std::string const& getFromCurrency() const;
+    std::string const& getToCurrency() const;
+    int64_t const&     getAmountPaid() const;
+    int64_t const&     getAmountReceived() const;
+    std::string const& getReason1() const;
+    std::string const& getReason2() const;
+    std::string const& getReason3() const;
+};
+
+} // namespace czmoney::event
@@ -0,0 +1,20 @@
+#include "czmoney/event/ExploitAlertEvent.h"
+#include <ll/api/event/Emitter.h>
+
+namespace czmoney::event {
+
+// --- ExploitAlertEvent Getters ---
+std::string const& ExploitAlertEvent::getKind() const { return mKind; }
+std::string const& ExploitAlertEvent::getPlayerUuid() const { return mPlayerUuid; }
+std::string const& ExploitAlertEvent::getCurrencyType() const { return mCurrencyType; }
+std::string const& ExploitAlertEvent::getReason1() const { return mReason1; }
+std::string const& ExploitAlertEvent::getReason2() const { return mReason2; }
+int64_t const&     ExploitAlertEvent::getWindowAmount() const { return mWindowAmount; }
+int64_t const&     ExploitAlertEvent::getWindowCount() const { return mWindowCount; }
+double const&      ExploitAlertEvent::getBaseline() const { return mBaseline; }
+double const&      ExploitAlertEvent::getZScore() const { return mZScore; }
+
+// --- Emitter for Event ---
+class ExploitAlertEventEmitter : public ll::event::Emitter<[](auto&&...) { return nullptr; }, ExploitAlertEvent> {};
+
+} // namespace czmoney::event
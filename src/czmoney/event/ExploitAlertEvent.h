@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <ll/api/event/Event.h>
+#include <string>
+
+
+namespace czmoney::event {
+
+/**
+ * @brief 异常收入告警事件 (不可取消)
+ *
+ * 当某个玩家的收入速率，或某个理由 (reason1 + reason2) 的收入总量明显偏离其基线时触发。
+ * kind 为 "player" 时 playerUuid 有效；为 "reason" 时 reason1 / reason2 有效。
+ * 监听器只能读取事件信息，例如冻结账户或通知管理员。
+ */
+class ExploitAlertEvent final : public ll::event::Event {
+protected:
+    std::string const& mKind;
+    std::string const& mPlayerUuid;
+    std::string const& mCurrencyType;
+    std::string const& mReason1;
+    std::string const& mReason2;
+    int64_t const&     mWindowAmount; // 窗口内的收入总额，整数形式 (实际金额 * 100)
+    int64_t const&     mWindowCount;  // 窗口内的收入次数
+    double const&      mBaseline;     // 基线 (历史窗口收入的指数移动平均)，整数形式
+    double const&      mZScore;
+
+public:
+    constexpr explicit ExploitAlertEvent(
+        std::string const& kind,
+        std::string const& playerUuid,
+        std::string const& currencyType,
+        std::string const& reason1,
+        std::string const& reason2,
+        int64_t const&     windowAmount,
+        int64_t const&     windowCount,
+        double const&      baseline,
+        double const&      zScore
+    )
+    : mKind(kind),
+      mPlayerUuid(playerUuid),
+      mCurrencyType(currencyType),
+      mReason1(reason1),
+      mReason2(reason2),
+      mWindowAmount(windowAmount),
+      mWindowCount(windowCount),
+      mBaseline(baseline),
+      mZScore(zScore) {}
+
+public:
+    std::string const& getKind() const;
+    std::string const& getPlayerUuid() const;
+    std::string const& getCurrencyType() const;
+    std::string const& getReason1() const;
+    std::string const& getReason2() const;
+    int64_t const&     getWindowAmount() const;
+    int64_t const&     getWindowCount() const;
+    double const&      getBaseline() const;
+    double const&      getZScore() const;
+};
+
+} // namespace czmoney::event
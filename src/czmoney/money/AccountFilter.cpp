@@ -0,0 +1,213 @@
+#include "czmoney/money/AccountFilter.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/db/columnar.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace czmoney {
+
+namespace {
+constexpr int64_t BUILD_CHUNK_SIZE = 10000;
+constexpr double  TIGHTENING_RATIO = 0.5; // 每追加一层，该层的目标误判率减半，总误判率不超过首层的两倍
+} // namespace
+
+AccountFilter::AccountFilter(db::IDatabaseConnection& dbConn, const Config& config)
+: mDbConnection(dbConn),
+  mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+void AccountFilter::hashKey(std::string_view uuid, std::string_view currencyType, uint64_t& h1, uint64_t& h2) {
+    uint64_t hash = fnv1a(FNV_OFFSET_BASIS, uuid);
+    hash          = fnv1a(hash, "\xff"); // 分隔 uuid 与货币类型，避免拼接歧义
+    hash          = fnv1a(hash, currencyType);
+    h1   = mix64(hash);
+    h2   = mix64(h1 ^ 0x9e3779b97f4a7c15ULL) | 1; // 奇数步长，保证各个位置互不相同
+}
+
+AccountFilter::Layer AccountFilter::makeLayer(uint64_t capacity) const {
+    double fpr = std::clamp(mConfig.accountFilter.targetFalsePositiveRate, 1e-6, 0.5);
+    fpr *= std::pow(TIGHTENING_RATIO, static_cast<double>(mLayers.size()));
+    fpr = std::max(fpr, 1e-9);
+
+    // 最优位数 m = -n ln p / (ln 2)^2，哈希函数个数 k = (m / n) ln 2
+    const double ln2 = std::log(2.0);
+    Layer        layer;
+    layer.capacity  = std::max<uint64_t>(capacity, 1);
+    double bits     = std::ceil(-static_cast<double>(layer.capacity) * std::log(fpr) / (ln2 * ln2));
+    layer.bitCount  = std::max<uint64_t>(64, static_cast<uint64_t>(bits));
+    layer.bitCount  = (layer.bitCount + 63) / 64 * 64;
+    layer.hashCount = static_cast<uint32_t>(std::clamp(
+        std::lround(static_cast<double>(layer.bitCount) / static_cast<double>(layer.capacity) * ln2),
+        1L,
+        30L
+    ));
+    layer.bits.assign(layer.bitCount / 64, 0);
+    return layer;
+}
+
+bool AccountFilter::layerContains(const Layer& layer, uint64_t h1, uint64_t h2) {
+    for (uint32_t i = 0; i < layer.hashCount; ++i) {
+        uint64_t bit = (h1 + i * h2) % layer.bitCount;
+        if ((layer.bits[bit / 64] & (1ULL << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AccountFilter::addLocked(uint64_t h1, uint64_t h2) {
+    // 已经在某一层中 (或误判为存在) 时不再重复加入，避免无谓地消耗容量
+    for (const auto& layer : mLayers) {
+        if (layerContains(layer, h1, h2)) {
+            return;
+        }
+    }
+    if (mLayers.empty() || mLayers.back().entries >= mLayers.back().capacity) {
+        uint64_t capacity = mLayers.empty()
+                              ? static_cast<uint64_t>(std::max(1, mConfig.accountFilter.minCapacity))
+                              : mLayers.back().capacity * 2;
+        mLayers.push_back(makeLayer(capacity));
+        if (mReady) {
+            mLogger.info("账户过滤器已满，追加第 {} 层 (容量 {})。", mLayers.size(), capacity);
+        }
+    }
+    Layer& layer = mLayers.back();
+    for (uint32_t i = 0; i < layer.hashCount; ++i) {
+        uint64_t bit = (h1 + i * h2) % layer.bitCount;
+        layer.bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+    ++layer.entries;
+}
+
+bool AccountFilter::build() {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法建立账户过滤器：数据库未连接。");
+        return false;
+    }
+
+    std::string dbType = mDbConnection.getDbType();
+    std::string sql;
+    if (dbType == "postgresql") {
+        sql = "SELECT id, uuid, currency_type FROM player_balances WHERE id > $1 ORDER BY id LIMIT $2;";
+    } else {
+        sql = "SELECT id, uuid, currency_type FROM player_balances WHERE id > ? ORDER BY id LIMIT ?;";
+    }
+
+    try {
+        // 首层按现有账户数的两倍预留容量，启动后的新账户通常不需要追加新层
+        db::DbResult countResult = mDbConnection.query("SELECT COUNT(*) FROM player_balances;");
+        int64_t      existing    = countResult.empty() || countResult[0].empty() ? 0 : db::toInt64(countResult[0][0]).value_or(0);
+        uint64_t     capacity    = std::max<uint64_t>(
+            static_cast<uint64_t>(std::max(1, mConfig.accountFilter.minCapacity)),
+            static_cast<uint64_t>(std::max<int64_t>(existing, 0)) * 2
+        );
+
+        std::unique_lock lock(mMutex);
+        mReady = false;
+        mLayers.clear();
+        mLayers.push_back(makeLayer(capacity));
+
+        int64_t  cursor = 0;
+        uint64_t loaded = 0;
+        while (true) {
+            int64_t            previousCursor = cursor;
+            db::ColumnarResult rows           = mDbConnection.queryColumnar(sql, {cursor, BUILD_CHUNK_SIZE});
+            if (rows.columnCount() < 3) {
+                break;
+            }
+            for (size_t row = 0; row < rows.rowCount(); ++row) {
+                cursor = rows.getInt64(row, 0).value_or(cursor);
+                uint64_t h1, h2;
+                hashKey(rows.getText(row, 1), rows.getText(row, 2), h1, h2);
+                addLocked(h1, h2);
+                ++loaded;
+            }
+            if (rows.rowCount() < static_cast<size_t>(BUILD_CHUNK_SIZE) || cursor == previousCursor) {
+                break;
+            }
+        }
+        mReady = true;
+        lock.unlock();
+
+        AccountFilterStats stats = getStats();
+        mLogger.info(
+            "账户过滤器已建立：{} 个账户，{} 层，占用 {} KB，预计误判率 {:.4f}%。",
+            loaded,
+            stats.layers,
+            stats.memoryBytes / 1024,
+            stats.estimatedFpr * 100.0
+        );
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("建立账户过滤器时发生数据库错误: {}", e.what());
+    } catch (const std::exception& e) {
+        mLogger.error("建立账户过滤器时发生意外错误: {}", e.what());
+    }
+    std::unique_lock lock(mMutex);
+    mLayers.clear();
+    mReady = false;
+    return false;
+}
+
+void AccountFilter::add(const std::string& uuid, const std::string& currencyType) {
+    uint64_t h1, h2;
+    hashKey(uuid, currencyType, h1, h2);
+    std::unique_lock lock(mMutex);
+    if (mReady) {
+        addLocked(h1, h2);
+    }
+}
+
+bool AccountFilter::mightContain(const std::string& uuid, const std::string& currencyType) {
+    uint64_t h1, h2;
+    hashKey(uuid, currencyType, h1, h2);
+    std::shared_lock lock(mMutex);
+    if (!mReady) {
+        return true;
+    }
+    mLookups.fetch_add(1, std::memory_order_relaxed);
+    for (const auto& layer : mLayers) {
+        if (layerContains(layer, h1, h2)) {
+            return true;
+        }
+    }
+    mDefinitelyAbsent.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AccountFilter::recordFalsePositive() {
+    std::shared_lock lock(mMutex);
+    if (mReady) { // 未就绪时查询不经过过滤器，不算误判
+        mFalsePositives.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AccountFilterStats AccountFilter::getStats() const {
+    AccountFilterStats stats;
+    {
+        std::shared_lock lock(mMutex);
+        stats.ready        = mReady;
+        stats.layers       = mLayers.size();
+        double passProduct = 1.0; // 所有层都不误判的概率
+        for (const auto& layer : mLayers) {
+            stats.entries     += layer.entries;
+            stats.capacity    += layer.capacity;
+            stats.memoryBytes += layer.bits.size() * sizeof(uint64_t);
+            // 单层误判率 (1 - e^(-kn/m))^k
+            double k     = static_cast<double>(layer.hashCount);
+            double fill  = 1.0 - std::exp(-k * static_cast<double>(layer.entries) / static_cast<double>(layer.bitCount));
+            passProduct *= 1.0 - std::pow(fill, k);
+        }
+        stats.estimatedFpr = 1.0 - passProduct;
+    }
+    stats.lookups          = mLookups.load(std::memory_order_relaxed);
+    stats.definitelyAbsent = mDefinitelyAbsent.load(std::memory_order_relaxed);
+    stats.falsePositives   = mFalsePositives.load(std::memory_order_relaxed);
+    uint64_t negatives     = stats.falsePositives + stats.definitelyAbsent;
+    stats.observedFpr      = negatives == 0 ? 0.0 : static_cast<double>(stats.falsePositives) / static_cast<double>(negatives);
+    return stats;
+}
+
+} // namespace czmoney
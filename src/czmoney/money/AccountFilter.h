@@ -0,0 +1,107 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace czmoney {
+
+// 账户过滤器的运行统计
+struct AccountFilterStats {
+    bool     ready = false;          // 是否已从数据库建立 (未建立时所有查询都直接访问数据库)
+    uint64_t entries = 0;            // 已加入的 (uuid, 货币) 数量 (含重复加入)
+    uint64_t capacity = 0;           // 所有层的设计容量之和
+    size_t   layers = 0;             // 层数 (超出容量后追加新层)
+    size_t   memoryBytes = 0;        // 位数组占用的内存
+    double   estimatedFpr = 0;       // 按当前填充程度推算的误判率
+    uint64_t lookups = 0;            // 查询次数
+    uint64_t definitelyAbsent = 0;   // 判定为 "一定不存在" 而省去数据库查询的次数
+    uint64_t falsePositives = 0;     // 判定为 "可能存在" 但数据库中没有记录的次数
+    double   observedFpr = 0;        // falsePositives / (falsePositives + definitelyAbsent)
+};
+
+/**
+ * @brief 账户存在性过滤器 (可扩展的布隆过滤器)
+ *
+ * 启用时从 player_balances 加载所有 (uuid, 货币) 组合，之后每次创建账户前先加入过滤器。
+ * mightContain 返回 false 时账户一定不存在，调用方可以跳过数据库查询；返回 true 时仍需查询数据库确认。
+ * 超出设计容量后追加一层容量加倍的新位数组，误判率不会随玩家增长而失控。
+ * 布隆过滤器不支持删除，账户被删除后只会多出误判，不会漏判。
+ * 只在本服务器创建的账户会加入过滤器，默认只在 SQLite 上启用 (accountFilter.enableOnSqlite)，
+ * 多个服务器共用一个 MySQL / PostgreSQL 数据库时不能打开 accountFilter.enabled。
+ */
+class AccountFilter {
+public:
+    /**
+     * @brief 构造函数
+     * @param dbConn 数据库连接 (仅在 build 时使用)
+     * @param config 配置对象
+     */
+    AccountFilter(db::IDatabaseConnection& dbConn, const Config& config);
+
+    AccountFilter(const AccountFilter&) = delete;
+    AccountFilter& operator=(const AccountFilter&) = delete;
+
+    /**
+     * @brief 从 player_balances 建立过滤器 (按主键分块读取)
+     * @return bool 是否成功；失败时过滤器保持未就绪，所有查询都会访问数据库
+     */
+    bool build();
+
+    /**
+     * @brief 加入一个账户 (应在账户写入数据库之前调用，保证不会漏判)
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     */
+    void add(const std::string& uuid, const std::string& currencyType);
+
+    /**
+     * @brief 账户是否可能存在
+     * @return bool false 表示一定不存在；过滤器未就绪时总是返回 true
+     */
+    [[nodiscard]] bool mightContain(const std::string& uuid, const std::string& currencyType);
+
+    /**
+     * @brief 报告一次误判 (mightContain 返回 true 但数据库中没有该账户)
+     */
+    void recordFalsePositive();
+
+    /**
+     * @brief 获取运行统计
+     */
+    [[nodiscard]] AccountFilterStats getStats() const;
+
+private:
+    struct Layer {
+        std::vector<uint64_t> bits;
+        uint64_t              bitCount = 0;
+        uint32_t              hashCount = 0;
+        uint64_t              capacity = 0;
+        uint64_t              entries = 0;
+    };
+
+    db::IDatabaseConnection& mDbConnection;
+    const Config&            mConfig;
+    ll::io::Logger&          mLogger;
+
+    mutable std::shared_mutex mMutex; // 保护以下层数据
+    std::vector<Layer>        mLayers;
+    bool                      mReady = false;
+
+    std::atomic<uint64_t> mLookups{0};
+    std::atomic<uint64_t> mDefinitelyAbsent{0};
+    std::atomic<uint64_t> mFalsePositives{0};
+
+    Layer        makeLayer(uint64_t capacity) const;
+    void         addLocked(uint64_t h1, uint64_t h2);
+    static bool  layerContains(const Layer& layer, uint64_t h1, uint64_t h2);
+    static void  hashKey(std::string_view uuid, std::string_view currencyType, uint64_t& h1, uint64_t& h2);
+};
+
+} // namespace czmoney
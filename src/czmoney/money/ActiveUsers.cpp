@@ -0,0 +1,458 @@
+#include "czmoney/money/ActiveUsers.h"
+#include "czmoney/money/Helpers.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+namespace czmoney {
+
+namespace {
+constexpr int     MAX_QUERY_DAYS = 366;
+constexpr uint8_t MAX_RANK       = 64 - HyperLogLog::PRECISION + 1;
+
+// 序列化时每个字符保存 6 位
+constexpr char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+} // namespace
+
+// --- HyperLogLog ---
+
+void HyperLogLog::add(const std::string& value) {
+    uint64_t hash  = stableHash(value);
+    uint32_t index = static_cast<uint32_t>(hash >> (64 - PRECISION));
+    uint64_t rest  = hash << PRECISION;
+    uint8_t  rank  = rest == 0 ? MAX_RANK : static_cast<uint8_t>(std::countl_zero(rest) + 1);
+    if (rank > mRegisters[index]) {
+        mRegisters[index] = rank;
+    }
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    for (uint32_t i = 0; i < REGISTERS; ++i) {
+        mRegisters[i] = std::max(mRegisters[i], other.mRegisters[i]);
+    }
+}
+
+uint64_t HyperLogLog::estimate() const {
+    double   sum   = 0;
+    uint32_t zeros = 0;
+    for (uint8_t reg : mRegisters) {
+        sum += std::ldexp(1.0, -static_cast<int>(reg));
+        if (reg == 0) ++zeros;
+    }
+    const double m        = static_cast<double>(REGISTERS);
+    const double alpha    = 0.7213 / (1.0 + 1.079 / m);
+    double       estimate = alpha * m * m / sum;
+    // 小基数时使用线性计数修正
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return static_cast<uint64_t>(std::llround(estimate));
+}
+
+std::string HyperLogLog::serialize() const {
+    size_t nonZero = static_cast<size_t>(std::count_if(mRegisters.begin(), mRegisters.end(), [](uint8_t r) {
+        return r != 0;
+    }));
+    std::string text;
+    if (nonZero * 3 < REGISTERS) {
+        // 稀疏格式: 'S' + 每个非零寄存器 3 个字符 (下标高 6 位、低 6 位、值)
+        text.reserve(1 + nonZero * 3);
+        text.push_back('S');
+        for (uint32_t i = 0; i < REGISTERS; ++i) {
+            if (mRegisters[i] != 0) {
+                text.push_back(BASE64_CHARS[(i >> 6) & 0x3F]);
+                text.push_back(BASE64_CHARS[i & 0x3F]);
+                text.push_back(BASE64_CHARS[mRegisters[i] & 0x3F]);
+            }
+        }
+    } else {
+        // 密集格式: 'D' + 每个寄存器 1 个字符
+        text.reserve(1 + REGISTERS);
+        text.push_back('D');
+        for (uint8_t reg : mRegisters) {
+            text.push_back(BASE64_CHARS[reg & 0x3F]);
+        }
+    }
+    return text;
+}
+
+std::optional<HyperLogLog> HyperLogLog::deserialize(const std::string& text) {
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    HyperLogLog sketch;
+    if (text[0] == 'D') {
+        if (text.size() != 1 + REGISTERS) {
+            return std::nullopt;
+        }
+        for (uint32_t i = 0; i < REGISTERS; ++i) {
+            int value = base64Value(text[1 + i]);
+            if (value < 0 || value > MAX_RANK) {
+                return std::nullopt;
+            }
+            sketch.mRegisters[i] = static_cast<uint8_t>(value);
+        }
+        return sketch;
+    }
+    if (text[0] == 'S') {
+        if ((text.size() - 1) % 3 != 0) {
+            return std::nullopt;
+        }
+        for (size_t pos = 1; pos < text.size(); pos += 3) {
+            int high  = base64Value(text[pos]);
+            int low   = base64Value(text[pos + 1]);
+            int value = base64Value(text[pos + 2]);
+            if (high < 0 || low < 0 || value < 0 || value > MAX_RANK) {
+                return std::nullopt;
+            }
+            uint32_t index = (static_cast<uint32_t>(high) << 6) | static_cast<uint32_t>(low);
+            if (index >= REGISTERS) {
+                return std::nullopt;
+            }
+            sketch.mRegisters[index] = static_cast<uint8_t>(value);
+        }
+        return sketch;
+    }
+    return std::nullopt;
+}
+
+// --- ActiveUserTracker ---
+
+ActiveUserTracker::ActiveUserTracker(db::IDatabaseConnection& dbConn, const Config& config)
+: mDbConnection(dbConn),
+  mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+std::string ActiveUserTracker::dayString(int daysAgo) {
+    std::time_t now = std::time(nullptr);
+    std::tm     local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    // 以当天正午为基准向前推，避免夏令时切换当天出现重复或跳过的日期
+    local.tm_hour  = 12;
+    local.tm_min   = 0;
+    local.tm_sec   = 0;
+    local.tm_mday -= daysAgo;
+    local.tm_isdst = -1;
+    std::mktime(&local);
+
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    return buffer;
+}
+
+void ActiveUserTracker::refreshCurrentDayLocked(std::time_t now) {
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    mCurrentDay = buffer;
+
+    // 下一个本地午夜 (mktime 负责进位到下个月/年并处理夏令时)
+    local.tm_hour   = 0;
+    local.tm_min    = 0;
+    local.tm_sec    = 0;
+    local.tm_mday  += 1;
+    local.tm_isdst  = -1;
+    std::time_t end = std::mktime(&local);
+    mCurrentDayEnd  = end > now ? end : now + 60; // mktime 失败时一分钟后再试
+}
+
+bool ActiveUserTracker::initializeTable() {
+    std::string dbType = mDbConnection.getDbType();
+    std::string createSQL;
+
+    if (dbType == "mysql") {
+        createSQL = R"(
+            CREATE TABLE IF NOT EXISTS active_user_sketches (
+                day CHAR(10) NOT NULL,
+                currency_type VARCHAR(50) NOT NULL,
+                reason1 VARCHAR(255) NOT NULL DEFAULT '',
+                registers TEXT NOT NULL,
+                last_updated TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+                PRIMARY KEY (day, currency_type, reason1)
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )";
+    } else if (dbType == "sqlite") {
+        createSQL = R"(
+            CREATE TABLE IF NOT EXISTS active_user_sketches (
+                day TEXT NOT NULL,
+                currency_type TEXT NOT NULL,
+                reason1 TEXT NOT NULL DEFAULT '',
+                registers TEXT NOT NULL,
+                last_updated TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                PRIMARY KEY (day, currency_type, reason1)
+            ) WITHOUT ROWID;
+        )";
+    } else if (dbType == "postgresql") {
+        createSQL = R"(
+            CREATE TABLE IF NOT EXISTS active_user_sketches (
+                day CHAR(10) NOT NULL,
+                currency_type VARCHAR(50) NOT NULL,
+                reason1 VARCHAR(255) NOT NULL DEFAULT '',
+                registers TEXT NOT NULL,
+                last_updated TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                PRIMARY KEY (day, currency_type, reason1)
+            );
+        )";
+    } else {
+        mLogger.error("不支持的数据库类型 '{}'，无法创建 active_user_sketches 表。", dbType);
+        return false;
+    }
+
+    try {
+        mDbConnection.execute(createSQL);
+
+        // 重启后继续累加当天的草图
+        std::string  today = dayString();
+        db::DbResult rows  = mDbConnection.queryPrepared(
+            dbType == "postgresql" ? "SELECT currency_type, reason1, registers FROM active_user_sketches WHERE day = $1;"
+                                   : "SELECT currency_type, reason1, registers FROM active_user_sketches WHERE day = ?;",
+            {today}
+        );
+        std::lock_guard lock(mMutex);
+        mSketches.clear();
+        for (const auto& row : rows) {
+            if (row.size() != 3) continue;
+            auto sketch = HyperLogLog::deserialize(db::toString(row[2]));
+            if (!sketch) {
+                mLogger.warn("active_user_sketches 中 {} / {} 的草图格式无效，已忽略。", today, db::toString(row[0]));
+                continue;
+            }
+            mSketches[Key{today, db::toString(row[0]), db::toString(row[1])}] = Entry{*sketch, false};
+        }
+        mLogger.info("'active_user_sketches' 表初始化成功 (类型: {})，已加载当天 {} 个草图。", dbType, mSketches.size());
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建或加载 'active_user_sketches' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("创建或加载 'active_user_sketches' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+void ActiveUserTracker::record(const std::string& uuid, const std::string& currencyType, const std::string& reason1) {
+    if (!mConfig.activeUsers.enabled || uuid.empty()) {
+        return;
+    }
+    std::string reason = truncateReason(reason1);
+
+    std::lock_guard lock(mMutex);
+    // 每条记录都调用 localtime/mktime 开销不小，只在跨过午夜时重新计算日期
+    std::time_t now = std::time(nullptr);
+    if (now >= mCurrentDayEnd) {
+        refreshCurrentDayLocked(now);
+    }
+    const std::string& day = mCurrentDay;
+
+    Entry& total = mSketches[Key{day, currencyType, ALL_KEY}];
+    total.sketch.add(uuid);
+    total.dirty = true;
+
+    Key key{day, currencyType, reason};
+    if (!mSketches.contains(key)
+        && mSketches.size() >= static_cast<size_t>(std::max(1, mConfig.activeUsers.maxTrackedReasons))) {
+        std::get<2>(key) = OTHER_KEY;
+    }
+    Entry& perReason = mSketches[key];
+    perReason.sketch.add(uuid);
+    perReason.dirty = true;
+}
+
+size_t ActiveUserTracker::flush() {
+    std::vector<std::pair<Key, std::string>> dirty;
+    std::string                              today = dayString();
+    {
+        std::lock_guard lock(mMutex);
+        for (auto& [key, entry] : mSketches) {
+            if (entry.dirty) {
+                dirty.emplace_back(key, entry.sketch.serialize());
+                entry.dirty = false;
+            }
+        }
+    }
+
+    std::string dbType = mDbConnection.getDbType();
+    std::string sql;
+    if (dbType == "sqlite") {
+        sql = "INSERT OR REPLACE INTO active_user_sketches (day, currency_type, reason1, registers, last_updated) "
+              "VALUES (?, ?, ?, ?, CURRENT_TIMESTAMP);";
+    } else if (dbType == "mysql") {
+        sql = "INSERT INTO active_user_sketches (day, currency_type, reason1, registers) VALUES (?, ?, ?, ?) "
+              "ON DUPLICATE KEY UPDATE registers = VALUES(registers);";
+    } else if (dbType == "postgresql") {
+        sql = "INSERT INTO active_user_sketches (day, currency_type, reason1, registers) VALUES ($1, $2, $3, $4) "
+              "ON CONFLICT (day, currency_type, reason1) DO UPDATE SET registers = EXCLUDED.registers, "
+              "last_updated = CURRENT_TIMESTAMP;";
+    } else {
+        return 0;
+    }
+
+    try {
+        if (!dirty.empty()) {
+            db::ScopedTransaction transaction(mDbConnection);
+            for (const auto& [key, registers] : dirty) {
+                mDbConnection.executePrepared(sql, {std::get<0>(key), std::get<1>(key), std::get<2>(key), registers});
+            }
+            transaction.commit();
+            mLogger.debug("已保存 {} 个活跃玩家草图。", dirty.size());
+        }
+
+        // 前几天的草图已写入数据库，从内存中移除
+        std::lock_guard lock(mMutex);
+        std::erase_if(mSketches, [&](const auto& item) {
+            return std::get<0>(item.first) != today && !item.second.dirty;
+        });
+    } catch (const std::exception& e) {
+        mLogger.error("保存活跃玩家草图失败，将在下次重试: {}", e.what());
+        std::lock_guard lock(mMutex);
+        for (const auto& [key, registers] : dirty) {
+            auto it = mSketches.find(key);
+            if (it != mSketches.end()) {
+                it->second.dirty = true;
+            }
+        }
+        return 0;
+    }
+
+    // 每天清理一次超过保留天数的草图
+    if (mConfig.activeUsers.retainDays > 0 && mLastPurgeDay != today) {
+        try {
+            std::string cutoff = dayString(mConfig.activeUsers.retainDays);
+            int         purged = mDbConnection.executePrepared(
+                dbType == "postgresql" ? "DELETE FROM active_user_sketches WHERE day < $1;"
+                                               : "DELETE FROM active_user_sketches WHERE day < ?;",
+                {cutoff}
+            );
+            mLastPurgeDay = today;
+            if (purged > 0) {
+                mLogger.info("已清理 {} 个早于 {} 的活跃玩家草图。", purged, cutoff);
+            }
+        } catch (const std::exception& e) {
+            mLogger.error("清理过期的活跃玩家草图失败: {}", e.what());
+        }
+    }
+    return dirty.size();
+}
+
+std::optional<std::map<std::pair<std::string, std::string>, HyperLogLog>>
+ActiveUserTracker::collect(const std::string& currencyType, int days) {
+    days                  = std::clamp(days, 1, MAX_QUERY_DAYS);
+    std::string startDay  = dayString(days - 1);
+    std::string endDay    = dayString();
+    std::string dbType    = mDbConnection.getDbType();
+    bool        pg        = dbType == "postgresql";
+
+    std::string  sql = "SELECT day, reason1, registers FROM active_user_sketches WHERE day >= "
+                    + std::string(pg ? "$1" : "?") + " AND day <= " + (pg ? "$2" : "?");
+    db::DbParams params{startDay, endDay};
+    if (!currencyType.empty()) {
+        sql += " AND currency_type = " + std::string(pg ? "$3" : "?");
+        params.emplace_back(currencyType);
+    }
+    sql += ";";
+
+    std::map<std::pair<std::string, std::string>, HyperLogLog> merged;
+    try {
+        db::DbResult rows = mDbConnection.queryPrepared(sql, params);
+        for (const auto& row : rows) {
+            if (row.size() != 3) continue;
+            auto sketch = HyperLogLog::deserialize(db::toString(row[2]));
+            if (sketch) {
+                merged[{db::toString(row[0]), db::toString(row[1])}].merge(*sketch);
+            }
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("查询活跃玩家草图失败: {}", e.what());
+        return std::nullopt;
+    } catch (const std::exception& e) {
+        mLogger.error("查询活跃玩家草图时发生意外错误: {}", e.what());
+        return std::nullopt;
+    }
+
+    // 内存中的草图包含尚未写入的部分；合并取最大值，与数据库中的旧版本重复合并不会多计
+    std::lock_guard lock(mMutex);
+    for (const auto& [key, entry] : mSketches) {
+        const auto& [day, currency, reason] = key;
+        if (day < startDay || day > endDay) continue;
+        if (!currencyType.empty() && currency != currencyType) continue;
+        merged[{day, reason}].merge(entry.sketch);
+    }
+    return merged;
+}
+
+std::optional<uint64_t>
+ActiveUserTracker::countUnique(const std::string& currencyType, int days, const std::optional<std::string>& reason1) {
+    auto merged = collect(currencyType, days);
+    if (!merged) {
+        return std::nullopt;
+    }
+    std::string reason = reason1 ? truncateReason(*reason1) : std::string(ALL_KEY);
+    HyperLogLog result;
+    for (const auto& [key, sketch] : *merged) {
+        if (key.second == reason) {
+            result.merge(sketch);
+        }
+    }
+    return result.estimate();
+}
+
+std::vector<std::pair<std::string, uint64_t>>
+ActiveUserTracker::countDaily(const std::string& currencyType, int days, const std::optional<std::string>& reason1) {
+    std::vector<std::pair<std::string, uint64_t>> result;
+    auto                                          merged = collect(currencyType, days);
+    if (!merged) {
+        return result;
+    }
+    std::string reason = reason1 ? truncateReason(*reason1) : std::string(ALL_KEY);
+    days               = std::clamp(days, 1, MAX_QUERY_DAYS);
+    result.reserve(static_cast<size_t>(days));
+    for (int i = days - 1; i >= 0; --i) {
+        std::string day = dayString(i);
+        auto        it  = merged->find({day, reason});
+        result.emplace_back(day, it != merged->end() ? it->second.estimate() : 0);
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, uint64_t>> ActiveUserTracker::countByReason(const std::string& currencyType, int days) {
+    std::vector<std::pair<std::string, uint64_t>> result;
+    auto                                          merged = collect(currencyType, days);
+    if (!merged) {
+        return result;
+    }
+    std::map<std::string, HyperLogLog> byReason;
+    for (const auto& [key, sketch] : *merged) {
+        if (key.second != ALL_KEY) {
+            byReason[key.second].merge(sketch);
+        }
+    }
+    result.reserve(byReason.size());
+    for (const auto& [reason, sketch] : byReason) {
+        result.emplace_back(reason, sketch.estimate());
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    return result;
+}
+
+} // namespace czmoney
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "ll/api/io/Logger.h"
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace czmoney {
+
+/**
+ * @brief HyperLogLog 基数估计
+ *
+ * 4096 个寄存器 (精度 12)，标准误差约 1.6%。两个草图合并即逐个寄存器取最大值，
+ * 因此同一集合重复合并不会多计，可以任意组合多天、多货币、多理由的草图。
+ */
+class HyperLogLog {
+public:
+    static constexpr uint32_t PRECISION = 12;
+    static constexpr uint32_t REGISTERS = 1u << PRECISION;
+
+    /**
+     * @brief 加入一个元素
+     * @param value 元素 (例如玩家 UUID)
+     */
+    void add(const std::string& value);
+
+    /**
+     * @brief 合并另一个草图 (并集)
+     */
+    void merge(const HyperLogLog& other);
+
+    /**
+     * @brief 估计不同元素的数量
+     */
+    [[nodiscard]] uint64_t estimate() const;
+
+    /**
+     * @brief 序列化为紧凑的文本 (稀疏时只保存非零寄存器)
+     */
+    [[nodiscard]] std::string serialize() const;
+
+    /**
+     * @brief 从 serialize() 的结果还原
+     * @return std::optional<HyperLogLog> 格式错误时返回 std::nullopt
+     */
+    static std::optional<HyperLogLog> deserialize(const std::string& text);
+
+private:
+    std::array<uint8_t, REGISTERS> mRegisters{};
+};
+
+/**
+ * @brief 每日活跃经济参与者统计
+ *
+ * 每次余额变动提交后把玩家 UUID 加入 (日期, 货币, reason1) 与 (日期, 货币, 全部理由) 的 HyperLogLog 草图，
+ * 定期把有变化的草图写入 active_user_sketches 表。查询任意日期范围时把范围内的草图合并后估计，
+ * 不需要对 economy_log 执行 COUNT(DISTINCT uuid)。日期按服务器本地时间划分。
+ */
+class ActiveUserTracker {
+public:
+    static constexpr const char* ALL_KEY   = "<all>";   // 不区分理由的草图
+    static constexpr const char* OTHER_KEY = "<other>"; // 超出跟踪上限的理由归入该键
+
+    /**
+     * @brief 构造函数
+     * @param dbConn 数据库连接
+     * @param config 配置对象
+     */
+    ActiveUserTracker(db::IDatabaseConnection& dbConn, const Config& config);
+
+    ActiveUserTracker(const ActiveUserTracker&) = delete;
+    ActiveUserTracker& operator=(const ActiveUserTracker&) = delete;
+
+    /**
+     * @brief 创建 active_user_sketches 表 (如果不存在)，并加载当天已保存的草图
+     * @return bool 操作是否成功
+     */
+    bool initializeTable();
+
+    /**
+     * @brief 记录一次已提交的余额变动
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     * @param reason1 理由 1 (调用方插件)
+     */
+    void record(const std::string& uuid, const std::string& currencyType, const std::string& reason1);
+
+    /**
+     * @brief 估计最近若干天 (含今天) 内的不同活跃玩家数
+     * @param currencyType 货币类型，为空时合并所有货币
+     * @param days 天数，1 为今天，7 为最近一周
+     * @param reason1 只统计该理由；std::nullopt 表示所有理由
+     * @return std::optional<uint64_t> 查询失败时返回 std::nullopt
+     */
+    std::optional<uint64_t>
+    countUnique(const std::string& currencyType, int days, const std::optional<std::string>& reason1 = std::nullopt);
+
+    /**
+     * @brief 逐日的活跃玩家数 (从早到晚)
+     * @param currencyType 货币类型，为空时合并所有货币
+     * @param days 天数 (含今天)
+     * @param reason1 只统计该理由；std::nullopt 表示所有理由
+     * @return 每天的 (日期, 活跃玩家数)，查询失败时为空
+     */
+    std::vector<std::pair<std::string, uint64_t>>
+    countDaily(const std::string& currencyType, int days, const std::optional<std::string>& reason1 = std::nullopt);
+
+    /**
+     * @brief 各理由在日期范围内的活跃玩家数 (按人数降序)
+     * @param currencyType 货币类型，为空时合并所有货币
+     * @param days 天数 (含今天)
+     * @return 每个理由的 (reason1, 活跃玩家数)，查询失败时为空
+     */
+    std::vector<std::pair<std::string, uint64_t>> countByReason(const std::string& currencyType, int days);
+
+    /**
+     * @brief 把有变化的草图写入数据库，并清理超过保留天数的草图
+     * @return size_t 写入的行数
+     */
+    size_t flush();
+
+    /**
+     * @brief 获取服务器本地时间下往前 daysAgo 天的日期
+     * @return std::string 格式为 "YYYY-MM-DD"
+     */
+    static std::string dayString(int daysAgo = 0);
+
+private:
+    struct Entry {
+        HyperLogLog sketch;
+        bool        dirty = false;
+    };
+    // 键: (日期, 货币, reason1)
+    using Key = std::tuple<std::string, std::string, std::string>;
+
+    db::IDatabaseConnection& mDbConnection;
+    const Config&            mConfig;
+    ll::io::Logger&          mLogger;
+
+    mutable std::mutex   mMutex;
+    std::map<Key, Entry> mSketches;      // 当天 (以及尚未写入的前几天) 的草图
+    std::string          mLastPurgeDay;  // 上次清理过期草图的日期
+    std::string          mCurrentDay;        // record() 使用的当天日期 (缓存)
+    std::time_t          mCurrentDayEnd = 0; // 当天结束 (下一个本地午夜) 的时间戳，到达后重新计算
+
+    // 刷新缓存的当天日期与结束时间 (需持有 mMutex)
+    void refreshCurrentDayLocked(std::time_t now);
+
+    // 合并日期范围内 (数据库 + 内存) 的草图，键为 (日期, reason1)
+    std::optional<std::map<std::pair<std::string, std::string>, HyperLogLog>>
+    collect(const std::string& currencyType, int days);
+};
+
+} // namespace czmoney
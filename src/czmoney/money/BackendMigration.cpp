@@ -0,0 +1,748 @@
+#include "czmoney/money/BackendMigration.h"
+#include "czmoney/money/BalanceSnapshot.h"
+#include "czmoney/money/BulkAdjustment.h" // SUMMARY_LOG_UUID
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/ScheduledPayment.h"
+#include "czmoney/money/money.h"
+#include "czmoney/db/columnar.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace czmoney {
+
+// 迁移的表：列按主键在前的顺序排列，keyCount 为主键列数 (也是 keyset 分块的游标)
+struct BackendMigrator::Table {
+    enum class Type {
+        Integer,
+        Text,
+        Time, // 时间戳按文本复制，不参与校验和 (各数据库返回的格式不同)
+    };
+    struct Column {
+        std::string name;
+        Type        type;
+    };
+
+    std::string         name;
+    std::vector<Column> columns;
+    size_t              keyCount = 1;
+};
+
+namespace {
+using Table = BackendMigrator::Table;
+using Type  = Table::Type;
+
+constexpr int SNAPSHOT_PAGES_PER_STEP = 256; // SQLite 源库快照每个调度任务复制的页数
+
+constexpr Type I = Type::Integer;
+constexpr Type T = Type::Text;
+constexpr Type D = Type::Time;
+
+const Table BALANCES{
+    "player_balances",
+    {{"id", I}, {"uuid", T}, {"currency_type", T}, {"amount", I}, {"last_updated", D}}
+};
+
+Table logTable(bool chainHash) {
+    Table table{
+        "economy_log",
+        {{"id", I},
+         {"timestamp", D},
+         {"uuid", T},
+         {"currency_type", T},
+         {"change_amount", I},
+         {"previous_amount", I},
+         {"reason1", T},
+         {"reason2", T},
+         {"reason3", T}}
+    };
+    if (chainHash) {
+        table.columns.push_back({"chain_hash", T});
+    }
+    return table;
+}
+
+const Table SNAPSHOT_ROWS{
+    "balance_snapshot_rows",
+    {{"uuid", T}, {"currency_type", T}, {"snapshot_id", I}, {"amount", I}, {"log_id", I}},
+    3
+};
+
+// 追赶时整表替换的小表
+const std::vector<Table> SMALL_TABLES{
+    {"holds",
+     {{"hold_id", I},
+      {"uuid", T},
+      {"currency_type", T},
+      {"amount", I},
+      {"created_at", D},
+      {"reason1", T},
+      {"reason2", T},
+      {"reason3", T}}},
+    {"scheduled_payments",
+     {{"id", I},
+      {"payer_uuid", T},
+      {"payee_uuid", T},
+      {"currency_type", T},
+      {"amount", I},
+      {"interval_seconds", I},
+      {"next_run", I},
+      {"remaining_runs", I},
+      {"failure_count", I},
+      {"active", I},
+      {"last_status", T},
+      {"reason1", T},
+      {"reason2", T},
+      {"reason3", T}}},
+    {"bulk_adjustment_jobs",
+     {{"id", I},
+      {"currency_type", T},
+      {"rate_bp", I},
+      {"threshold", I},
+      {"last_id", I},
+      {"total_accounts", I},
+      {"processed_accounts", I},
+      {"total_delta", I},
+      {"status", T},
+      {"reason1", T},
+      {"reason2", T},
+      {"reason3", T},
+      {"created_at", D}}},
+    {"balance_snapshots",
+     {{"id", I},
+      {"kind", T},
+      {"status", T},
+      {"start_log_id", I},
+      {"base_log_id", I},
+      {"base_account_id", I},
+      {"last_id", I},
+      {"row_count", I},
+      {"created_at", D},
+      {"completed_at", D}}},
+    {"flow_counters",
+     {{"currency_type", T},
+      {"reason1", T},
+      {"reason2", T},
+      {"sum_in", I},
+      {"sum_out", I},
+      {"op_count", I},
+      {"last_updated", D}},
+     3},
+    {"active_user_sketches",
+     {{"day", T}, {"currency_type", T}, {"reason1", T}, {"registers", T}, {"last_updated", D}},
+     3},
+};
+
+// 全部表，按复制顺序
+std::vector<Table> allTables(bool chainHash) {
+    std::vector<Table> tables{BALANCES, logTable(chainHash)};
+    tables.insert(tables.end(), SMALL_TABLES.begin(), SMALL_TABLES.end());
+    tables.push_back(SNAPSHOT_ROWS);
+    return tables;
+}
+
+std::string joinColumns(const Table& table, size_t count) {
+    std::string joined;
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) joined += ", ";
+        joined += table.columns[i].name;
+    }
+    return joined;
+}
+
+// 未启用过哈希链时 chain_hash 列不存在 (PostgreSQL 中失败的语句会中止事务，必须在事务外探测)
+bool hasChainHashColumn(db::IDatabaseConnection& conn) {
+    return conn.tryQueryColumnar("SELECT chain_hash FROM economy_log WHERE 1 = 0;", {}).has_value();
+}
+
+int64_t queryInt(db::IDatabaseConnection& conn, const std::string& sql) {
+    db::ColumnarResult result = conn.queryColumnar(sql, {});
+    return result.empty() ? 0 : result.getInt64(0, 0).value_or(0);
+}
+
+int64_t maxId(db::IDatabaseConnection& conn, const std::string& table, const std::string& column = "id") {
+    return queryInt(conn, "SELECT COALESCE(MAX(" + column + "), 0) FROM " + table + ";");
+}
+
+// 按列声明的类型取值：不同后端对同一列返回的类型不同 (MySQL/PostgreSQL 的整数也可能是文本)
+db::DbValue cellValue(const db::ColumnarResult& rows, size_t row, size_t col, Type type) {
+    if (rows.isNull(row, col)) {
+        return nullptr;
+    }
+    if (type == Type::Integer) {
+        if (auto value = rows.getInt64(row, col)) {
+            return *value;
+        }
+    }
+    if (rows.kind(row, col) == db::ColumnKind::Text) {
+        return std::string(rows.getText(row, col));
+    }
+    return rows.getString(row, col);
+}
+
+// 按 keyset 分块读取整张表 (或满足 filter 的行)，每块调用一次 onChunk
+void scanTable(
+    db::IDatabaseConnection&                              conn,
+    const Table&                                          table,
+    const std::string&                                    filter,
+    int                                                   chunkSize,
+    const std::atomic<bool>&                              cancelled,
+    const std::function<void(const db::ColumnarResult&)>& onChunk
+) {
+    std::string dbType = conn.getDbType();
+    std::string keys   = joinColumns(table, table.keyCount);
+    std::string cursor;
+    if (table.keyCount == 1) {
+        cursor = keys + " > " + placeholder(dbType, 1);
+    } else {
+        cursor = "(" + keys + ") > (";
+        for (size_t i = 0; i < table.keyCount; ++i) {
+            cursor += (i > 0 ? ", " : "") + placeholder(dbType, static_cast<int>(i) + 1);
+        }
+        cursor += ")";
+    }
+    auto buildSql = [&](bool withCursor) {
+        std::string where;
+        if (!filter.empty()) where = "(" + filter + ")";
+        if (withCursor) where += (where.empty() ? "" : " AND ") + cursor;
+        return "SELECT " + joinColumns(table, table.columns.size()) + " FROM " + table.name
+             + (where.empty() ? "" : " WHERE " + where) + " ORDER BY " + keys + " LIMIT " + std::to_string(chunkSize)
+             + ";";
+    };
+    const std::string firstSql = buildSql(false);
+    const std::string nextSql  = buildSql(true);
+
+    db::DbParams params;
+    bool         first = true;
+    while (!cancelled) {
+        db::ColumnarResult rows = conn.queryColumnar(first ? firstSql : nextSql, params);
+        if (rows.empty()) {
+            break;
+        }
+        if (rows.columnCount() != table.columns.size()) {
+            throw std::runtime_error(table.name + " 查询返回的列数不正确");
+        }
+        onChunk(rows);
+        if (rows.rowCount() < static_cast<size_t>(chunkSize)) {
+            break;
+        }
+        first = false;
+        params.clear();
+        for (size_t col = 0; col < table.keyCount; ++col) {
+            params.push_back(cellValue(rows, rows.rowCount() - 1, col, table.columns[col].type));
+        }
+    }
+}
+
+// 每行各列 (不含时间戳) 的 FNV-1a 哈希，经 splitmix64 打散后求和，与行的顺序无关
+uint64_t rowHash(const db::ColumnarResult& rows, size_t row, const Table& table) {
+    uint64_t hash  = FNV_OFFSET_BASIS;
+    auto     bytes = [&hash](const void* data, size_t size) {
+        hash = fnv1a(hash, std::string_view(static_cast<const char*>(data), size));
+    };
+    for (size_t col = 0; col < table.columns.size(); ++col) {
+        Type type = table.columns[col].type;
+        if (type == Type::Time) {
+            continue;
+        }
+        db::DbValue value = cellValue(rows, row, col, type);
+        if (std::holds_alternative<std::nullptr_t>(value)) {
+            unsigned char marker = 0xFF;
+            bytes(&marker, 1);
+        } else if (std::holds_alternative<int64_t>(value)) {
+            int64_t v = std::get<int64_t>(value);
+            bytes(&v, sizeof(v));
+        } else {
+            std::string text = db::toString(value);
+            uint64_t    size = text.size();
+            bytes(&size, sizeof(size));
+            bytes(text.data(), text.size());
+        }
+    }
+    return mix64(hash + 0x9E3779B97F4A7C15ull);
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+BackendMigrator::BackendMigrator(
+    db::IDatabaseConnection&  mainConn,
+    scheduler::TaskScheduler& scheduler,
+    const Config&             config,
+    std::filesystem::path     snapshotPath,
+    ConnectionFactory         sourceFactory,
+    ConnectionFactory         targetFactory
+)
+: mMainConn(mainConn),
+  mScheduler(scheduler),
+  mConfig(config),
+  mSnapshotPath(std::move(snapshotPath)),
+  mSourceFactory(std::move(sourceFactory)),
+  mTargetFactory(std::move(targetFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+BackendMigrator::~BackendMigrator() { stop(); }
+
+bool BackendMigrator::isRunning() const {
+    std::lock_guard lock(mMutex);
+    return mReport.running;
+}
+
+bool BackendMigrator::isCopied() const {
+    std::lock_guard lock(mMutex);
+    return mCopied;
+}
+
+MigrationReport BackendMigrator::getReport() const {
+    std::lock_guard lock(mMutex);
+    MigrationReport report = mReport;
+    if (report.running) {
+        report.elapsedMs = millisecondsSince(mStartedAt);
+    }
+    return report;
+}
+
+void BackendMigrator::stop() {
+    mCancelled = true;
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    // SQLite 快照仍在分步复制：直接结束 (调度器中剩余的步骤发现快照已释放后什么也不做)
+    if (mSnapshot) {
+        mSnapshot.reset();
+        finish("");
+    }
+}
+
+bool BackendMigrator::start() { return beginTask("copy"); }
+
+bool BackendMigrator::catchUp() {
+    if (!isCopied()) {
+        mLogger.error("尚未完成全量复制，无法追赶。请先执行 money admin migrate start。");
+        return false;
+    }
+    return beginTask("catchup");
+}
+
+bool BackendMigrator::beginTask(const std::string& phase) {
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+    }
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+
+    // SQLite：先在主连接上开始在线备份，工作线程只读快照
+    bool sqlite = mMainConn.getDbType() == "sqlite";
+    if (sqlite) {
+        auto* source = dynamic_cast<db::SQLiteConnection*>(&mMainConn);
+        if (!source) {
+            mLogger.error("无法建立 SQLite 源库快照: 主连接不是 SQLite 连接");
+            return false;
+        }
+        try {
+            mSnapshot = std::make_unique<db::SQLiteSnapshot>(*source, mSnapshotPath);
+        } catch (const db::DatabaseException& e) {
+            mLogger.error("无法建立 SQLite 源库快照: {}", e.what());
+            return false;
+        }
+    }
+
+    mCancelled = false;
+    {
+        std::lock_guard lock(mMutex);
+        mReport              = MigrationReport{};
+        mReport.phase        = phase;
+        mReport.sourceType   = mConfig.db_type;
+        mReport.targetType   = mConfig.migration.targetType;
+        mReport.running      = true;
+        mReport.currentTable = sqlite ? "snapshot" : "";
+        for (const auto& table : allTables(false)) {
+            mReport.tables.push_back({table.name});
+        }
+        mStartedAt = std::chrono::steady_clock::now();
+    }
+    mLogger.info(
+        "开始{}: {} -> {}",
+        phase == "copy" ? "迁移经济数据 (全量复制)" : "迁移追赶与校验",
+        mConfig.db_type,
+        mConfig.migration.targetType
+    );
+    if (sqlite) {
+        scheduleSnapshotStep(phase == "copy");
+    } else {
+        startWorker(phase == "copy", std::nullopt);
+    }
+    return true;
+}
+
+void BackendMigrator::scheduleSnapshotStep(bool initial) {
+    // 每个任务只复制一部分页，服务器在两步之间照常写入
+    mScheduler.submit(
+        "migration-snapshot",
+        [this, initial]() {
+            if (!mSnapshot) {
+                return; // 已被 stop() 结束
+            }
+            if (mCancelled) {
+                mSnapshot.reset();
+                finish("");
+                return;
+            }
+            try {
+                if (!mSnapshot->step(SNAPSHOT_PAGES_PER_STEP)) {
+                    scheduleSnapshotStep(initial);
+                    return;
+                }
+            } catch (const db::DatabaseException& e) {
+                mSnapshot.reset();
+                finish(std::string("无法建立 SQLite 源库快照: ") + e.what());
+                return;
+            }
+            std::filesystem::path copy = mSnapshot->path();
+            mSnapshot.reset();
+            startWorker(initial, copy);
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+void BackendMigrator::startWorker(bool initial, std::optional<std::filesystem::path> sourceSnapshot) {
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    mWorker = std::thread([this, initial, sourceSnapshot = std::move(sourceSnapshot)]() {
+        worker(initial, sourceSnapshot);
+    });
+}
+
+void BackendMigrator::worker(bool initial, std::optional<std::filesystem::path> sourceSnapshot) {
+    std::string error;
+    try {
+        std::unique_ptr<db::IDatabaseConnection> source;
+        if (sourceSnapshot) {
+            source = std::make_unique<db::SQLiteConnection>(sourceSnapshot->string());
+        } else if (mSourceFactory) {
+            source = mSourceFactory();
+        }
+        std::unique_ptr<db::IDatabaseConnection> target = mTargetFactory ? mTargetFactory() : nullptr;
+        if (!source || !source->connect()) {
+            error = "无法连接源数据库";
+        } else if (!target || !target->connect()) {
+            error = "无法连接目标数据库 (请检查配置 migration)";
+        } else {
+            if (initial) {
+                initialCopy(*source, *target);
+            }
+            if (!mCancelled) {
+                catchUpPass(*source, *target);
+            }
+            if (!initial && !mCancelled) {
+                verify(*source, *target);
+            }
+        }
+    } catch (const db::DatabaseException& e) {
+        error = std::string("数据库操作失败: ") + e.what();
+    } catch (const std::exception& e) {
+        error = std::string("迁移时发生意外错误: ") + e.what();
+    }
+    if (sourceSnapshot) {
+        std::error_code ec;
+        std::filesystem::remove(*sourceSnapshot, ec);
+    }
+    if (initial && (!error.empty() || mCancelled)) {
+        std::lock_guard lock(mMutex);
+        mCopied = false;
+    }
+    finish(error);
+}
+
+void BackendMigrator::finish(const std::string& error) {
+    std::lock_guard lock(mMutex);
+    mReport.running   = false;
+    mReport.elapsedMs = millisecondsSince(mStartedAt);
+    if (!error.empty()) {
+        mReport.error = error;
+        mLogger.error("经济数据迁移失败 (表: {}): {}", mReport.currentTable, error);
+    } else if (mCancelled) {
+        mReport.cancelled = true;
+        mLogger.info("经济数据迁移已取消。");
+    } else if (mReport.phase == "copy") {
+        mLogger.info("经济数据全量复制完成，耗时 {:.0f}ms。停止经济写入后执行 migrate catchup 完成追赶与校验。", mReport.elapsedMs);
+    } else if (mReport.mismatches == 0) {
+        mLogger.info(
+            "迁移追赶完成，全部表校验一致，耗时 {:.0f}ms。可以把 database.type 改为 {} 并重启服务器。",
+            mReport.elapsedMs,
+            mReport.targetType
+        );
+    } else {
+        mLogger.warn(
+            "迁移追赶完成，但有 {} 个表校验不一致 (追赶期间仍有写入时属正常现象，停止写入后再执行一次 catchup)。",
+            mReport.mismatches
+        );
+    }
+}
+
+void BackendMigrator::addCopied(const std::string& table, uint64_t rows) {
+    std::lock_guard lock(mMutex);
+    for (auto& entry : mReport.tables) {
+        if (entry.table == table) {
+            entry.copiedRows += rows;
+            return;
+        }
+    }
+}
+
+void BackendMigrator::setCurrentTable(const std::string& table) {
+    std::lock_guard lock(mMutex);
+    mReport.currentTable = table;
+}
+
+uint64_t BackendMigrator::copyRows(
+    db::IDatabaseConnection& source,
+    db::IDatabaseConnection& target,
+    const Table&             table,
+    const std::string&       filter,
+    bool                     upsert
+) {
+    setCurrentTable(table.name);
+    std::string targetType = target.getDbType();
+    size_t      columns    = table.columns.size();
+    size_t      maxParams  = targetType == "sqlite" ? 999 : 65535; // 单条语句的参数数量上限
+    size_t      perInsert =
+        std::min<size_t>(static_cast<size_t>(std::max(1, mConfig.migration.batchRows)), std::max<size_t>(1, maxParams / columns));
+    int chunkSize = std::clamp(mConfig.migration.chunkSize, 1, 100000);
+
+    // 追赶时目标库中可能已有这些行，改为覆盖写入
+    std::string conflict;
+    if (upsert) {
+        for (size_t col = table.keyCount; col < columns; ++col) {
+            const std::string& name = table.columns[col].name;
+            conflict += conflict.empty() ? "" : ", ";
+            conflict += targetType == "mysql" ? name + " = VALUES(" + name + ")" : name + " = excluded." + name;
+        }
+        conflict = targetType == "mysql" ? " ON DUPLICATE KEY UPDATE " + conflict
+                                         : " ON CONFLICT (" + joinColumns(table, table.keyCount) + ") DO UPDATE SET " + conflict;
+    }
+    auto buildInsert = [&](size_t rowCount) {
+        std::string sql = "INSERT INTO " + table.name + " (" + joinColumns(table, columns) + ") VALUES ";
+        int         index = 1;
+        for (size_t row = 0; row < rowCount; ++row) {
+            sql += row == 0 ? "(" : ", (";
+            for (size_t col = 0; col < columns; ++col) {
+                if (col > 0) sql += ", ";
+                sql += placeholder(targetType, index++);
+            }
+            sql += ")";
+        }
+        return sql + conflict + ";";
+    };
+    const std::string fullBatchSql = buildInsert(perInsert);
+
+    // 目标库的 player_balances_touch 触发器 (UPDATE OF amount) 会把覆盖写入的行的 last_updated 改成复制的时刻，
+    // 之后再单独写回源库的值 (只更新 last_updated 不会再次触发)。MySQL 中显式赋值的列不会自动更新
+    bool        restoreTouched = upsert && table.name == BALANCES.name && targetType != "mysql";
+    size_t      touchedColumn  = 4; // BALANCES 中 last_updated 的位置
+    std::string touchSql       = "UPDATE player_balances SET last_updated = " + placeholder(targetType, 1)
+                         + " WHERE id = " + placeholder(targetType, 2) + ";";
+
+    uint64_t copied = 0;
+    scanTable(source, table, filter, chunkSize, mCancelled, [&](const db::ColumnarResult& rows) {
+        // 每块一个目标库事务，失败时整块回滚
+        db::ScopedTransaction transaction(target);
+        db::DbParams          params;
+        params.reserve(perInsert * columns);
+        for (size_t row = 0; row < rows.rowCount(); ++row) {
+            for (size_t col = 0; col < columns; ++col) {
+                params.push_back(cellValue(rows, row, col, table.columns[col].type));
+            }
+            if (params.size() == perInsert * columns) {
+                target.executePrepared(fullBatchSql, params);
+                params.clear();
+            }
+        }
+        if (!params.empty()) {
+            target.executePrepared(buildInsert(params.size() / columns), params);
+        }
+        if (restoreTouched) {
+            for (size_t row = 0; row < rows.rowCount(); ++row) {
+                target.executePrepared(
+                    touchSql,
+                    {cellValue(rows, row, touchedColumn, Type::Time), cellValue(rows, row, 0, Type::Integer)}
+                );
+            }
+        }
+        transaction.commit();
+        copied += rows.rowCount();
+        addCopied(table.name, rows.rowCount());
+    });
+    return copied;
+}
+
+void BackendMigrator::initialCopy(db::IDatabaseConnection& source, db::IDatabaseConnection& target) {
+    // 1. 在目标库建立表结构 (与各组件启动时创建的完全相同)
+    setCurrentTable("schema");
+    bool sourceChain = hasChainHashColumn(source);
+    {
+        MoneyManager           money(target, mConfig);
+        FlowCounters           flows(target, mConfig);
+        ActiveUserTracker      activeUsers(target, mConfig);
+        ScheduledPaymentEngine payments(target, money, mConfig);
+        BulkAdjustmentEngine   bulk(target, mConfig);
+        BalanceSnapshotEngine  snapshots(target, mConfig);
+        if (!money.initializeTable() || !flows.initializeTable() || !activeUsers.initializeTable()
+            || !payments.initializeTable() || !bulk.initializeTable() || !snapshots.initializeTable()) {
+            throw std::runtime_error("无法在目标库中创建表");
+        }
+        // 源库有哈希链时保留历史流水的 chain_hash，即使当前配置未启用
+        if (sourceChain && !LedgerChain(mConfig).initializeColumn(target)) {
+            throw std::runtime_error("无法为目标库的流水表添加 chain_hash 列");
+        }
+    }
+    mChainHash = sourceChain && hasChainHashColumn(target);
+
+    // 防止覆盖一个正在使用的数据库
+    if (maxId(target, BALANCES.name) != 0 || maxId(target, "economy_log") != 0) {
+        throw std::runtime_error("目标库中的 player_balances 或 economy_log 不为空，请使用空库作为迁移目标");
+    }
+
+    // 2. 全量复制。余额复制前记下流水位置，之后有流水的账户在追赶时重新复制
+    mBalanceMark = maxId(source, "economy_log");
+    copyRows(source, target, BALANCES, "", false);
+    mBalanceCursor = maxId(target, BALANCES.name);
+    if (mCancelled) return;
+
+    copyRows(source, target, logTable(mChainHash), "", false);
+    mLogCursor = maxId(target, "economy_log");
+    if (mCancelled) return;
+
+    // 其余表 (包括快照行) 由随后的第一轮追赶复制
+    mSnapshotFloor = 0;
+    std::lock_guard lock(mMutex);
+    mCopied = true;
+}
+
+void BackendMigrator::catchUpPass(db::IDatabaseConnection& source, db::IDatabaseConnection& target) {
+    std::string sourceType = source.getDbType();
+    // 自增 id 不一定按提交顺序可见 (MySQL/PostgreSQL 并发事务)，游标回看一个分块，回看范围内的行覆盖写入
+    int64_t lookback = std::clamp(mConfig.migration.chunkSize, 1, 100000);
+
+    // 1. 流水只追加
+    int64_t newMark = maxId(source, "economy_log");
+    copyRows(source, target, logTable(mChainHash), "id > " + std::to_string(std::max<int64_t>(0, mLogCursor - lookback)), true);
+    mLogCursor = maxId(target, "economy_log");
+    if (mCancelled) return;
+
+    // 2. 余额：窗口内有流水的账户 + 新开的账户；旧版本批量调整的汇总流水无法定位账户，整表覆盖
+    int64_t     windowStart = std::max<int64_t>(0, mBalanceMark - lookback);
+    std::string window      = "id > " + std::to_string(windowStart) + " AND id <= " + std::to_string(newMark);
+    bool        bulkInWindow =
+        !source
+             .queryColumnar(
+                 "SELECT id FROM economy_log WHERE " + window + " AND uuid = " + placeholder(sourceType, 1) + " LIMIT 1;",
+                 {std::string(BulkAdjustmentEngine::SUMMARY_LOG_UUID)}
+             )
+             .empty();
+    if (bulkInWindow) {
+        mLogger.info("追赶窗口内有批量调整，重新同步全部余额。");
+        copyRows(source, target, BALANCES, "", true);
+    } else {
+        copyRows(
+            source,
+            target,
+            BALANCES,
+            "(uuid, currency_type) IN (SELECT uuid, currency_type FROM economy_log WHERE " + window + ")",
+            true
+        );
+    }
+    if (mCancelled) return;
+    copyRows(source, target, BALANCES, "id > " + std::to_string(std::max<int64_t>(0, mBalanceCursor - lookback)), true);
+    mBalanceMark   = newMark;
+    mBalanceCursor = maxId(target, BALANCES.name);
+    if (mCancelled) return;
+
+    // 3. 小表整表替换
+    for (const auto& table : SMALL_TABLES) {
+        if (mCancelled) return;
+        setCurrentTable(table.name);
+        target.execute("DELETE FROM " + table.name + ";");
+        copyRows(source, target, table, "", false);
+    }
+
+    // 4. 快照行：已完成的快照不再变化，只重新复制上一轮未完成 (或之后创建) 的快照；源库已清理的旧快照在目标库中删除
+    if (mCancelled) return;
+    setCurrentTable(SNAPSHOT_ROWS.name);
+    int64_t incomplete = queryInt(source, "SELECT COALESCE(MIN(id), 0) FROM balance_snapshots WHERE status <> 'completed';");
+    int64_t newFloor   = incomplete != 0 ? incomplete : maxId(source, "balance_snapshots") + 1;
+    int64_t oldest     = queryInt(source, "SELECT COALESCE(MIN(id), 0) FROM balance_snapshots;");
+    target.execute(
+        "DELETE FROM balance_snapshot_rows WHERE snapshot_id >= " + std::to_string(mSnapshotFloor)
+        + " OR snapshot_id < " + std::to_string(oldest) + ";"
+    );
+    copyRows(source, target, SNAPSHOT_ROWS, "snapshot_id >= " + std::to_string(mSnapshotFloor), false);
+    if (mCancelled) return;
+    mSnapshotFloor = newFloor;
+
+    // 5. 显式写入的 id 不会推进 PostgreSQL 的序列
+    if (target.getDbType() == "postgresql") {
+        target.query("SELECT setval(pg_get_serial_sequence('player_balances', 'id'), "
+                     "COALESCE((SELECT MAX(id) FROM player_balances), 0) + 1, false);");
+        target.query("SELECT setval(pg_get_serial_sequence('economy_log', 'id'), "
+                     "COALESCE((SELECT MAX(id) FROM economy_log), 0) + 1, false);");
+    }
+
+    std::lock_guard lock(mMutex);
+    ++mReport.passes;
+}
+
+void BackendMigrator::verify(db::IDatabaseConnection& source, db::IDatabaseConnection& target) {
+    int chunkSize = std::clamp(mConfig.migration.chunkSize, 1, 100000);
+    for (const auto& table : allTables(mChainHash)) {
+        if (mCancelled) return;
+        setCurrentTable(table.name);
+        auto summarize = [&](db::IDatabaseConnection& conn, uint64_t& rowCount, uint64_t& checksum) {
+            rowCount = 0;
+            checksum = 0;
+            scanTable(conn, table, "", chunkSize, mCancelled, [&](const db::ColumnarResult& rows) {
+                for (size_t row = 0; row < rows.rowCount(); ++row) {
+                    checksum += rowHash(rows, row, table);
+                }
+                rowCount += rows.rowCount();
+            });
+        };
+        MigrationTableReport result{table.name};
+        summarize(source, result.sourceRows, result.sourceChecksum);
+        summarize(target, result.targetRows, result.targetChecksum);
+        if (mCancelled) return;
+        result.verified = true;
+        bool matched    = result.sourceRows == result.targetRows && result.sourceChecksum == result.targetChecksum;
+        if (!matched) {
+            mLogger.warn(
+                "迁移校验不一致: {} (源库 {} 行，目标库 {} 行)",
+                table.name,
+                result.sourceRows,
+                result.targetRows
+            );
+        }
+
+        std::lock_guard lock(mMutex);
+        for (auto& entry : mReport.tables) {
+            if (entry.table == table.name) {
+                result.copiedRows = entry.copiedRows;
+                entry             = result;
+            }
+        }
+        if (!matched) {
+            ++mReport.mismatches;
+        }
+    }
+}
+
+} // namespace czmoney
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/db/sqlite.h"
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace czmoney {
+
+// 单个表的复制与校验结果
+struct MigrationTableReport {
+    std::string table;
+    uint64_t    copiedRows = 0;      // 全量复制与追赶中写入目标库的行数 (追赶时同一行可能被重复写入)
+    bool        verified = false;    // 是否已经校验过
+    uint64_t    sourceRows = 0;
+    uint64_t    targetRows = 0;
+    uint64_t    sourceChecksum = 0;
+    uint64_t    targetChecksum = 0;
+};
+
+// 迁移任务的进度与结果
+struct MigrationReport {
+    std::string                       phase;          // "copy" (全量复制) 或 "catchup" (追赶 + 校验)
+    std::string                       sourceType;
+    std::string                       targetType;
+    bool                              running = false;
+    bool                              cancelled = false;
+    std::string                       error;          // 非空时表示任务失败
+    std::string                       currentTable;   // 正在处理的表
+    uint64_t                          passes = 0;     // 已完成的追赶轮数
+    uint64_t                          mismatches = 0; // 校验不一致的表数量
+    double                            elapsedMs = 0;
+    std::vector<MigrationTableReport> tables;
+};
+
+/**
+ * @brief 在线把 czmoney 的全部表从当前数据库复制到另一种数据库
+ *
+ * 工作线程使用两条独立连接 (源库与目标库)，不占用服务器线程，迁移期间经济系统照常运行。
+ * 源库是 SQLite 时，其他连接的读事务会让服务器的写入失败，因此每个任务开始前先由调度器在主连接上
+ * 分步复制出一个快照文件，工作线程读取快照 (追赶读取的是任务开始时刻的数据)：
+ * 1. 全量复制 (start)：用各组件的 initializeTable 在目标库建立相同的表结构，然后每个表按主键做 keyset 分块，
+ *    分块读取源库、在目标库中每块一个事务批量插入 (保留原主键)，结束后立即进行一轮追赶。
+ * 2. 追赶 (catchUp)：
+ *    - economy_log 只追加，从已复制的最大 id 继续；
+ *    - player_balances 以流水为变更记录：上一轮之后有流水的账户和新开的账户覆盖写入；
+ *      窗口内出现批量调整 (只有汇总流水) 时整表覆盖写入；
+ *    - 快照行只重新复制上一轮仍未完成的快照；
+ *    - 其余小表 (冻结、定时付款、批量任务、快照头、资金流向、活跃统计) 整表替换。
+ * 3. 校验：追赶后逐表比较行数和校验和 (每行各列的哈希之和，不计时间戳列，因为各数据库的时间格式不同)。
+ *    只有在停止经济写入 (维护时段) 后执行的最后一轮追赶，校验结果才有意义。
+ * 校验通过后把配置中的 database.type 改为目标类型并重启服务器即可完成切换。
+ */
+class BackendMigrator {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (只在服务器线程上使用，源库为 SQLite 时用于建立快照)
+     * @param scheduler 后台任务调度器
+     * @param config 配置对象
+     * @param snapshotPath 源库为 SQLite 时快照文件的路径
+     * @param sourceFactory 创建源库 (生产数据库) 连接的工厂 (MySQL / PostgreSQL)
+     * @param targetFactory 创建目标库连接的工厂，目标与生产数据库相同时应返回 nullptr
+     */
+    BackendMigrator(
+        db::IDatabaseConnection&  mainConn,
+        scheduler::TaskScheduler& scheduler,
+        const Config&             config,
+        std::filesystem::path     snapshotPath,
+        ConnectionFactory         sourceFactory,
+        ConnectionFactory         targetFactory
+    );
+    ~BackendMigrator();
+
+    BackendMigrator(const BackendMigrator&) = delete;
+    BackendMigrator& operator=(const BackendMigrator&) = delete;
+
+    /**
+     * @brief 开始全量复制 (目标库中的余额表和流水表必须为空)
+     * @return bool 是否成功开始 (已有任务在运行时返回 false)
+     */
+    bool start();
+
+    /**
+     * @brief 进行一轮追赶并校验 (必须先完成全量复制)
+     * @return bool 是否成功开始
+     */
+    bool catchUp();
+
+    /**
+     * @brief 取消正在运行的任务，并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 是否有任务在运行
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * @brief 是否已完成全量复制，可以进行追赶
+     */
+    [[nodiscard]] bool isCopied() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 任务的进度与结果
+     */
+    [[nodiscard]] MigrationReport getReport() const;
+
+    struct Table; // 表的描述 (列、主键、追赶方式)，定义在实现文件中
+
+private:
+    db::IDatabaseConnection&  mMainConn;
+    scheduler::TaskScheduler& mScheduler;
+    const Config&             mConfig;
+    std::filesystem::path     mSnapshotPath;
+    ConnectionFactory         mSourceFactory;
+    ConnectionFactory         mTargetFactory;
+    ll::io::Logger&           mLogger;
+
+    mutable std::mutex                    mMutex; // 保护 mReport
+    MigrationReport                       mReport;
+    std::atomic<bool>                     mCancelled{false};
+    std::thread                           mWorker;
+    std::chrono::steady_clock::time_point mStartedAt;
+    std::unique_ptr<db::SQLiteSnapshot>   mSnapshot; // SQLite 源库快照 (分步复制期间)
+
+    bool mCopied = false; // 全量复制已完成 (由 mMutex 保护)
+
+    // 追赶状态 (只在工作线程中访问，任务之间保留)
+    bool    mChainHash = false;    // 源库和目标库都有 chain_hash 列
+    int64_t mLogCursor = 0;        // 已复制到目标库的最大 economy_log.id
+    int64_t mBalanceMark = 0;      // 余额已同步到的流水 id (之后有流水的账户需要重新同步)
+    int64_t mBalanceCursor = 0;    // 已复制的最大 player_balances.id
+    int64_t mSnapshotFloor = 0;    // 上一轮仍未完成的最小快照 id (快照行从这里开始重新复制)
+
+    bool     beginTask(const std::string& phase);
+    void     scheduleSnapshotStep(bool initial);
+    void     startWorker(bool initial, std::optional<std::filesystem::path> sourceSnapshot);
+    void     worker(bool initial, std::optional<std::filesystem::path> sourceSnapshot);
+    void     initialCopy(db::IDatabaseConnection& source, db::IDatabaseConnection& target);
+    void     catchUpPass(db::IDatabaseConnection& source, db::IDatabaseConnection& target);
+    void     verify(db::IDatabaseConnection& source, db::IDatabaseConnection& target);
+    uint64_t copyRows(
+        db::IDatabaseConnection& source,
+        db::IDatabaseConnection& target,
+        const Table&             table,
+        const std::string&       filter,
+        bool                     upsert
+    );
+    void addCopied(const std::string& table, uint64_t rows);
+    void finish(const std::string& error);
+    void setCurrentTable(const std::string& table);
+};
+
+} // namespace czmoney
@@ -0,0 +1,136 @@
+#include "czmoney/money/BalanceBrowser.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/db/columnar.h"
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace czmoney {
+
+BalanceBrowser::BalanceBrowser(db::IDatabaseConnection& conn) : mConn(conn), mDbType(conn.getDbType()) {}
+
+std::string BalanceBrowser::placeholder(size_t index) const {
+    return czmoney::placeholder(mDbType, static_cast<int>(index));
+}
+
+std::string BalanceBrowser::buildFilter(const BalanceBrowseQuery& query, db::DbParams& params) const {
+    params.emplace_back(query.currencyType);
+    std::string filter = "currency_type = " + placeholder(params.size());
+    if (query.minAmount) {
+        params.emplace_back(*query.minAmount);
+        filter += " AND amount >= " + placeholder(params.size());
+    }
+    if (query.maxAmount) {
+        params.emplace_back(*query.maxAmount);
+        filter += " AND amount <= " + placeholder(params.size());
+    }
+    if (query.updatedWithinDays > 0) {
+        // 各数据库的 last_updated 都由自己的 CURRENT_TIMESTAMP 写入，截止时间也在数据库端计算
+        std::string sinceExpr;
+        if (mDbType == "mysql") {
+            sinceExpr = fmt::format("NOW() - INTERVAL {} DAY", query.updatedWithinDays);
+        } else if (mDbType == "postgresql") {
+            sinceExpr = fmt::format("LOCALTIMESTAMP - INTERVAL '{} days'", query.updatedWithinDays);
+        } else {
+            sinceExpr = fmt::format("DATETIME('now', '-{} days')", query.updatedWithinDays);
+        }
+        filter += " AND last_updated >= " + sinceExpr;
+    }
+    if (query.sortKey == BalanceSortKey::LastUpdated) {
+        filter += " AND last_updated IS NOT NULL"; // NULL 无法参与 keyset 比较
+    }
+    return filter;
+}
+
+std::vector<BalanceBrowseRow> BalanceBrowser::fetch(
+    const BalanceBrowseQuery&              query,
+    const std::optional<BalanceBrowseRow>& boundary,
+    bool                                   forward,
+    size_t                                 limit
+) {
+    std::string  key       = query.sortKey == BalanceSortKey::Amount ? "amount" : "last_updated";
+    bool         ascending = forward ? !query.descending : query.descending; // 向前翻页时反向扫描
+    db::DbParams params;
+    std::string  sql = "SELECT id, uuid, amount, last_updated FROM player_balances WHERE " + buildFilter(query, params);
+
+    if (boundary) {
+        db::DbValue keyValue = query.sortKey == BalanceSortKey::Amount ? db::DbValue(boundary->amount)
+                                                                        : db::DbValue(boundary->lastUpdated);
+        std::string op = ascending ? ">" : "<";
+        params.push_back(keyValue);
+        sql += " AND (" + key + " " + op + " " + placeholder(params.size());
+        params.push_back(keyValue);
+        sql += " OR (" + key + " = " + placeholder(params.size());
+        params.emplace_back(boundary->id);
+        sql += " AND id " + op + " " + placeholder(params.size()) + "))";
+    }
+
+    std::string direction = ascending ? "ASC" : "DESC";
+    params.emplace_back(static_cast<int64_t>(limit));
+    sql += " ORDER BY " + key + " " + direction + ", id " + direction + " LIMIT " + placeholder(params.size()) + ";";
+
+    db::ColumnarResult            result = mConn.queryColumnar(sql, params);
+    std::vector<BalanceBrowseRow> rows;
+    rows.reserve(result.rowCount());
+    for (size_t row = 0; row < result.rowCount(); ++row) {
+        BalanceBrowseRow entry;
+        entry.id          = result.getInt64(row, 0).value_or(0);
+        entry.uuid        = result.getString(row, 1);
+        entry.amount      = result.getInt64(row, 2).value_or(0);
+        entry.lastUpdated = result.getString(row, 3);
+        rows.push_back(std::move(entry));
+    }
+    if (!forward) {
+        std::reverse(rows.begin(), rows.end());
+    }
+    return rows;
+}
+
+std::vector<BalanceBrowseRow>
+BalanceBrowser::pageAfter(const BalanceBrowseQuery& query, const std::optional<BalanceBrowseRow>& after, size_t limit) {
+    return fetch(query, after, true, limit);
+}
+
+std::vector<BalanceBrowseRow>
+BalanceBrowser::pageBefore(const BalanceBrowseQuery& query, const BalanceBrowseRow& before, size_t limit) {
+    return fetch(query, before, false, limit);
+}
+
+std::vector<BalanceBrowseRow> BalanceBrowser::page(const BalanceBrowseQuery& query, size_t pageIndex, size_t limit) {
+    if (pageIndex == 0 || limit == 0) {
+        return pageAfter(query, std::nullopt, limit);
+    }
+
+    // 只读排序键和 id，OFFSET 在索引上跳过前面的页，找到上一页的最后一行
+    std::string  key       = query.sortKey == BalanceSortKey::Amount ? "amount" : "last_updated";
+    std::string  direction = query.descending ? "DESC" : "ASC";
+    db::DbParams params;
+    std::string  sql = "SELECT id, " + key + " FROM player_balances WHERE " + buildFilter(query, params);
+    params.emplace_back(static_cast<int64_t>(pageIndex * limit - 1));
+    sql += " ORDER BY " + key + " " + direction + ", id " + direction + " LIMIT 1 OFFSET " + placeholder(params.size())
+         + ";";
+
+    db::ColumnarResult result = mConn.queryColumnar(sql, params);
+    if (result.rowCount() == 0) {
+        return {};
+    }
+    BalanceBrowseRow boundary;
+    boundary.id = result.getInt64(0, 0).value_or(0);
+    if (query.sortKey == BalanceSortKey::Amount) {
+        boundary.amount = result.getInt64(0, 1).value_or(0);
+    } else {
+        boundary.lastUpdated = result.getString(0, 1);
+    }
+    return pageAfter(query, boundary, limit);
+}
+
+uint64_t BalanceBrowser::count(const BalanceBrowseQuery& query) {
+    db::DbParams       params;
+    std::string        sql    = "SELECT COUNT(*) FROM player_balances WHERE " + buildFilter(query, params) + ";";
+    db::ColumnarResult result = mConn.queryColumnar(sql, params);
+    if (result.rowCount() == 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::max<int64_t>(0, result.getInt64(0, 0).value_or(0)));
+}
+
+} // namespace czmoney
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "czmoney/database_interface.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace czmoney {
+
+// 账户浏览的排序键
+enum class BalanceSortKey {
+    Amount,      // 按余额
+    LastUpdated, // 按最后更新时间
+};
+
+// 账户浏览条件
+struct BalanceBrowseQuery {
+    std::string            currencyType;
+    BalanceSortKey         sortKey = BalanceSortKey::Amount;
+    bool                   descending = true;
+    std::optional<int64_t> minAmount;            // 余额下限 (分，含)
+    std::optional<int64_t> maxAmount;            // 余额上限 (分，含)
+    int                    updatedWithinDays = 0; // 只看最近 N 天内有变动的账户，0 表示不限
+};
+
+// 浏览结果中的一个账户
+struct BalanceBrowseRow {
+    int64_t     id = 0;
+    std::string uuid;
+    int64_t     amount = 0;
+    std::string lastUpdated;
+};
+
+/**
+ * @brief 在数据库端分页浏览某种货币的全部账户
+ *
+ * 按 (排序键, id) 做 keyset 分页，由 idx_player_balances_amount / idx_player_balances_updated 索引直接定位，
+ * 每次只读取一页，不需要把全部玩家加载到内存：
+ * - 下一页 / 上一页以当前页最后 / 第一行为边界；
+ * - 跳转到第 N 页时先在索引上用 OFFSET 找到上一页的最后一行 (只读排序键和 id)，再从它开始 keyset。
+ * 不持有状态，可以在表单加载线程上使用其自己的连接。
+ */
+class BalanceBrowser {
+public:
+    explicit BalanceBrowser(db::IDatabaseConnection& conn);
+
+    /**
+     * @brief 读取排在 after 之后的一页
+     * @param after 边界行 (上一页的最后一行)，为空时从第一行开始
+     * @param limit 每页行数
+     */
+    std::vector<BalanceBrowseRow>
+    pageAfter(const BalanceBrowseQuery& query, const std::optional<BalanceBrowseRow>& after, size_t limit);
+
+    /**
+     * @brief 读取排在 before 之前的一页 (结果仍按浏览顺序排列)
+     * @param before 边界行 (当前页的第一行)
+     * @param limit 每页行数
+     */
+    std::vector<BalanceBrowseRow>
+    pageBefore(const BalanceBrowseQuery& query, const BalanceBrowseRow& before, size_t limit);
+
+    /**
+     * @brief 读取第 pageIndex 页 (从 0 开始)
+     * @return std::vector<BalanceBrowseRow> 页码超出范围时为空
+     */
+    std::vector<BalanceBrowseRow> page(const BalanceBrowseQuery& query, size_t pageIndex, size_t limit);
+
+    /**
+     * @brief 符合条件的账户数量
+     */
+    uint64_t count(const BalanceBrowseQuery& query);
+
+private:
+    db::IDatabaseConnection& mConn;
+    std::string              mDbType;
+
+    std::string placeholder(size_t index) const;
+    std::string buildFilter(const BalanceBrowseQuery& query, db::DbParams& params) const;
+    std::vector<BalanceBrowseRow> fetch(
+        const BalanceBrowseQuery&              query,
+        const std::optional<BalanceBrowseRow>& boundary,
+        bool                                   forward,
+        size_t                                 limit
+    );
+};
+
+} // namespace czmoney
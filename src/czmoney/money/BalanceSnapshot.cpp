@@ -0,0 +1,529 @@
+#include "czmoney/money/BalanceSnapshot.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/BulkAdjustment.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <vector>
+
+namespace czmoney {
+
+namespace {
+// SELECT 的列顺序，与 rowToSnapshot 保持一致
+constexpr const char* SNAPSHOT_COLUMNS =
+    "id, kind, status, start_log_id, base_log_id, base_account_id, last_id, row_count, completed_at";
+constexpr size_t SNAPSHOT_COLUMN_COUNT = 9;
+
+// 解析 "3d" / "12h" / "30m" / "45s" 形式的相对时间，返回距现在的秒数
+std::optional<int64_t> parseSecondsAgo(const std::string& text) {
+    if (text.size() < 2 || text.size() > 10) {
+        return std::nullopt;
+    }
+    int64_t value = 0;
+    for (size_t i = 0; i + 1 < text.size(); ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return std::nullopt;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    switch (text.back()) {
+    case 'd':
+        return value * 86400;
+    case 'h':
+        return value * 3600;
+    case 'm':
+        return value * 60;
+    case 's':
+        return value;
+    default:
+        return std::nullopt;
+    }
+}
+} // namespace
+
+BalanceSnapshotEngine::BalanceSnapshotEngine(db::IDatabaseConnection& dbConn, const Config& config)
+: mDbConnection(dbConn),
+  mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+std::string BalanceSnapshotEngine::placeholder(int index) const {
+    return czmoney::placeholder(mDbConnection.getDbType(), index);
+}
+
+std::string BalanceSnapshotEngine::timeBoundExpr(int index, bool relative) const {
+    // economy_log.timestamp 与 completed_at 都由各自数据库的 CURRENT_TIMESTAMP 写入 (SQLite 为 UTC，其余为会话本地时间)，
+    // 因此查询时间点也在数据库端换算成同一时钟下的时间值再比较，不依赖字符串格式
+    std::string dbType = mDbConnection.getDbType();
+    std::string param  = placeholder(index);
+    if (relative) { // 参数为距现在的秒数
+        if (dbType == "mysql") {
+            return "NOW() - INTERVAL " + param + " SECOND";
+        } else if (dbType == "postgresql") {
+            return "LOCALTIMESTAMP - CAST(" + param + " AS BIGINT) * INTERVAL '1 second'";
+        }
+        return "DATETIME('now', '-' || " + param + " || ' seconds')";
+    }
+    if (dbType == "mysql") {
+        return "CAST(" + param + " AS DATETIME)";
+    } else if (dbType == "postgresql") {
+        return "CAST(" + param + " AS TIMESTAMP)";
+    }
+    return "DATETIME(" + param + ", 'utc')"; // 按本地时间解析后转为 UTC
+}
+
+int64_t BalanceSnapshotEngine::queryInt64(const std::string& sql, const db::DbParams& params) {
+    db::DbResult result = params.empty() ? mDbConnection.query(sql) : mDbConnection.queryPrepared(sql, params);
+    if (result.empty() || result[0].empty()) {
+        return 0;
+    }
+    return db::toInt64(result[0][0]).value_or(0);
+}
+
+bool BalanceSnapshotEngine::initializeTable() {
+    std::string              dbType = mDbConnection.getDbType();
+    std::vector<std::string> createSQLs;
+
+    if (dbType == "mysql") {
+        createSQLs.push_back(R"(
+            CREATE TABLE IF NOT EXISTS balance_snapshots (
+                id BIGINT PRIMARY KEY,
+                kind VARCHAR(8) NOT NULL,
+                status VARCHAR(16) NOT NULL,
+                start_log_id BIGINT NOT NULL DEFAULT 0,
+                base_log_id BIGINT NOT NULL DEFAULT 0,
+                base_account_id BIGINT NOT NULL DEFAULT 0,
+                last_id BIGINT NOT NULL DEFAULT 0,
+                row_count BIGINT NOT NULL DEFAULT 0,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                completed_at TIMESTAMP NULL DEFAULT NULL
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )");
+        createSQLs.push_back(R"(
+            CREATE TABLE IF NOT EXISTS balance_snapshot_rows (
+                snapshot_id BIGINT NOT NULL,
+                uuid VARCHAR(36) NOT NULL,
+                currency_type VARCHAR(50) NOT NULL,
+                amount BIGINT NOT NULL,
+                log_id BIGINT NOT NULL,
+                PRIMARY KEY (uuid, currency_type, snapshot_id),
+                INDEX idx_snapshot_id (snapshot_id)
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )");
+    } else if (dbType == "sqlite") {
+        createSQLs.push_back(R"(
+            CREATE TABLE IF NOT EXISTS balance_snapshots (
+                id INTEGER PRIMARY KEY,
+                kind TEXT NOT NULL,
+                status TEXT NOT NULL,
+                start_log_id INTEGER NOT NULL DEFAULT 0,
+                base_log_id INTEGER NOT NULL DEFAULT 0,
+                base_account_id INTEGER NOT NULL DEFAULT 0,
+                last_id INTEGER NOT NULL DEFAULT 0,
+                row_count INTEGER NOT NULL DEFAULT 0,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                completed_at TIMESTAMP DEFAULT NULL
+            );
+        )");
+        createSQLs.push_back(R"(
+            CREATE TABLE IF NOT EXISTS balance_snapshot_rows (
+                snapshot_id INTEGER NOT NULL,
+                uuid TEXT NOT NULL,
+                currency_type TEXT NOT NULL,
+                amount INTEGER NOT NULL,
+                log_id INTEGER NOT NULL,
+                PRIMARY KEY (uuid, currency_type, snapshot_id)
+            ) WITHOUT ROWID;
+        )");
+        createSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_snapshot_rows_snapshot_id ON balance_snapshot_rows (snapshot_id);");
+    } else if (dbType == "postgresql") {
+        createSQLs.push_back(R"(
+            CREATE TABLE IF NOT EXISTS balance_snapshots (
+                id BIGINT PRIMARY KEY,
+                kind VARCHAR(8) NOT NULL,
+                status VARCHAR(16) NOT NULL,
+                start_log_id BIGINT NOT NULL DEFAULT 0,
+                base_log_id BIGINT NOT NULL DEFAULT 0,
+                base_account_id BIGINT NOT NULL DEFAULT 0,
+                last_id BIGINT NOT NULL DEFAULT 0,
+                row_count BIGINT NOT NULL DEFAULT 0,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                completed_at TIMESTAMP DEFAULT NULL
+            );
+        )");
+        createSQLs.push_back(R"(
+            CREATE TABLE IF NOT EXISTS balance_snapshot_rows (
+                snapshot_id BIGINT NOT NULL,
+                uuid VARCHAR(36) NOT NULL,
+                currency_type VARCHAR(50) NOT NULL,
+                amount BIGINT NOT NULL,
+                log_id BIGINT NOT NULL,
+                PRIMARY KEY (uuid, currency_type, snapshot_id)
+            );
+        )");
+        createSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_snapshot_rows_snapshot_id ON balance_snapshot_rows (snapshot_id);");
+    } else {
+        mLogger.error("不支持的数据库类型 '{}'，无法创建 balance_snapshots 表。", dbType);
+        return false;
+    }
+
+    try {
+        for (const auto& sql : createSQLs) {
+            mDbConnection.execute(sql);
+        }
+
+        std::lock_guard lock(mMutex);
+        mSnapshot.reset();
+        mLastCompleted.reset();
+        mSnapshotsSinceFull = 0;
+
+        db::DbResult latest = mDbConnection.query(
+            std::string("SELECT ") + SNAPSHOT_COLUMNS + " FROM balance_snapshots ORDER BY id DESC LIMIT 1;"
+        );
+        if (!latest.empty() && latest[0].size() == SNAPSHOT_COLUMN_COUNT) {
+            mSnapshot = rowToSnapshot(latest[0]);
+        }
+        db::DbResult completed = mDbConnection.query(
+            std::string("SELECT ") + SNAPSHOT_COLUMNS
+            + " FROM balance_snapshots WHERE status = 'completed' ORDER BY id DESC LIMIT 1;"
+        );
+        if (!completed.empty() && completed[0].size() == SNAPSHOT_COLUMN_COUNT) {
+            mLastCompleted      = rowToSnapshot(completed[0]);
+            mSnapshotsSinceFull = queryInt64(
+                "SELECT COUNT(*) FROM balance_snapshots WHERE status = 'completed' AND id > "
+                "(SELECT COALESCE(MAX(id), 0) FROM balance_snapshots WHERE status = 'completed' AND kind = 'full');"
+            );
+        }
+
+        if (mSnapshot && mSnapshot->status == "running") {
+            mLogger.warn(
+                "检测到未完成的余额快照 #{} ({}，已写入 {} 行)，将从中断处继续。",
+                mSnapshot->id,
+                mSnapshot->kind,
+                mSnapshot->rowCount
+            );
+        }
+        mLogger.info("'balance_snapshots' 表初始化成功 (类型: {}).", dbType);
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建或验证 'balance_snapshots' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("创建或验证 'balance_snapshots' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+BalanceSnapshotInfo BalanceSnapshotEngine::rowToSnapshot(const db::DbRow& row) {
+    BalanceSnapshotInfo snapshot;
+    snapshot.id            = db::toInt64(row[0]).value_or(0);
+    snapshot.kind          = db::toString(row[1]);
+    snapshot.status        = db::toString(row[2]);
+    snapshot.startLogId    = db::toInt64(row[3]).value_or(0);
+    snapshot.baseLogId     = db::toInt64(row[4]).value_or(0);
+    snapshot.baseAccountId = db::toInt64(row[5]).value_or(0);
+    snapshot.lastId        = db::toInt64(row[6]).value_or(0);
+    snapshot.rowCount      = db::toInt64(row[7]).value_or(0);
+    snapshot.completedAt   = db::toString(row[8]);
+    return snapshot;
+}
+
+api::MoneyApiResult BalanceSnapshotEngine::startSnapshot(bool forceFull, int64_t& outSnapshotId) {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法开始余额快照：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    std::lock_guard lock(mMutex);
+    if (mSnapshot && mSnapshot->status == "running") {
+        return api::MoneyApiResult::JobInProgress;
+    }
+
+    // 没有基准、被要求全量、或增量快照已达到配置次数时生成全量快照
+    int  fullEvery = std::max(1, mConfig.snapshots.fullSnapshotEvery);
+    bool full      = forceFull || mForceFullNext || !mLastCompleted || mSnapshotsSinceFull + 1 >= fullEvery;
+
+    BalanceSnapshotInfo snapshot;
+    snapshot.id     = (mSnapshot ? mSnapshot->id : 0) + 1;
+    snapshot.kind   = full ? KIND_FULL : KIND_DELTA;
+    snapshot.status = "running";
+    if (!full) {
+        snapshot.baseLogId     = mLastCompleted->startLogId;
+        snapshot.baseAccountId = mLastCompleted->lastId;
+    }
+
+    try {
+        snapshot.startLogId = queryInt64("SELECT COALESCE(MAX(id), 0) FROM economy_log;");
+        std::string sql =
+            "INSERT INTO balance_snapshots (id, kind, status, start_log_id, base_log_id, base_account_id, last_id, "
+            "row_count) VALUES ("
+            + placeholder(1) + ", " + placeholder(2) + ", 'running', " + placeholder(3) + ", " + placeholder(4) + ", "
+            + placeholder(5) + ", 0, 0);";
+        db::DbParams params =
+            {snapshot.id, snapshot.kind, snapshot.startLogId, snapshot.baseLogId, snapshot.baseAccountId};
+        if (mDbConnection.executePrepared(sql, params) <= 0) {
+            mLogger.error("创建余额快照失败 (INSERT 未影响任何行)。");
+            return api::MoneyApiResult::DatabaseError;
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建余额快照时发生数据库错误: {}", e.what());
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("创建余额快照时发生意外错误: {}", e.what());
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    mSnapshot      = snapshot;
+    mForceFullNext = false;
+    outSnapshotId  = snapshot.id;
+    mLogger.info("余额快照 #{} ({}) 开始生成。", snapshot.id, snapshot.kind);
+    return api::MoneyApiResult::Success;
+}
+
+void BalanceSnapshotEngine::requestFullSnapshot() {
+    std::lock_guard lock(mMutex);
+    mForceFullNext = true;
+}
+
+void BalanceSnapshotEngine::saveSnapshotState(const BalanceSnapshotInfo& snapshot) {
+    std::string sql = "UPDATE balance_snapshots SET last_id = " + placeholder(1) + ", row_count = " + placeholder(2)
+                    + ", status = " + placeholder(3) + " WHERE id = " + placeholder(4) + ";";
+    mDbConnection.executePrepared(sql, {snapshot.lastId, snapshot.rowCount, snapshot.status, snapshot.id});
+}
+
+void BalanceSnapshotEngine::completeSnapshotLocked(BalanceSnapshotInfo snapshot) {
+    snapshot.status = "completed";
+    mDbConnection.executePrepared(
+        "UPDATE balance_snapshots SET status = 'completed', completed_at = CURRENT_TIMESTAMP WHERE id = "
+            + placeholder(1) + ";",
+        {snapshot.id}
+    );
+    // 读回数据库写入的完成时间，查询时与流水的 timestamp 使用同一时钟比较
+    db::DbResult completedAt = mDbConnection.queryPrepared(
+        "SELECT completed_at FROM balance_snapshots WHERE id = " + placeholder(1) + ";",
+        {snapshot.id}
+    );
+    if (!completedAt.empty() && !completedAt[0].empty()) {
+        snapshot.completedAt = db::toString(completedAt[0][0]);
+    }
+
+    if (snapshot.kind == KIND_FULL) {
+        mSnapshotsSinceFull = 0;
+    } else {
+        ++mSnapshotsSinceFull;
+    }
+    mSnapshot      = snapshot;
+    mLastCompleted = snapshot;
+    mLogger.info("余额快照 #{} ({}) 完成：写入 {} 个账户。", snapshot.id, snapshot.kind, snapshot.rowCount);
+
+    if (snapshot.kind == KIND_FULL) {
+        pruneOldSnapshotsLocked();
+    }
+}
+
+// 只保留最近 retainFullSnapshots 个全量快照及其之后的增量快照
+// 增量快照依赖更早的快照行，所以只能以全量快照为界整段删除
+void BalanceSnapshotEngine::pruneOldSnapshotsLocked() {
+    int retain = mConfig.snapshots.retainFullSnapshots;
+    if (retain <= 0) {
+        return;
+    }
+    try {
+        db::DbResult fulls = mDbConnection.query(fmt::format(
+            "SELECT id FROM balance_snapshots WHERE status = 'completed' AND kind = 'full' ORDER BY id DESC LIMIT 1 "
+            "OFFSET {};",
+            retain - 1
+        ));
+        if (fulls.empty() || fulls[0].empty()) {
+            return;
+        }
+        int64_t oldestKept = db::toInt64(fulls[0][0]).value_or(0);
+        if (oldestKept <= 0) {
+            return;
+        }
+        db::ScopedTransaction transaction(mDbConnection);
+        int rows = mDbConnection.executePrepared(
+            "DELETE FROM balance_snapshot_rows WHERE snapshot_id < " + placeholder(1) + ";",
+            {oldestKept}
+        );
+        int snapshots =
+            mDbConnection.executePrepared("DELETE FROM balance_snapshots WHERE id < " + placeholder(1) + ";", {oldestKept});
+        transaction.commit();
+        if (snapshots > 0) {
+            mLogger.info("已清理 {} 个旧余额快照 ({} 行)。", snapshots, rows);
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("清理旧余额快照时发生数据库错误: {}", e.what());
+    } catch (const std::exception& e) {
+        mLogger.error("清理旧余额快照时发生意外错误: {}", e.what());
+    }
+}
+
+bool BalanceSnapshotEngine::runNextChunk() {
+    std::lock_guard lock(mMutex);
+    if (!mSnapshot || mSnapshot->status != "running" || !mDbConnection.isConnected()) {
+        return false;
+    }
+    BalanceSnapshotInfo snapshot  = *mSnapshot;
+    int64_t             chunkSize = std::max(1, mConfig.snapshots.chunkSize);
+
+    try {
+        // 1. 确定本块的 id 上界 (keyset 分页，走主键范围扫描)
+        std::optional<int64_t> upperId;
+        db::DbResult           boundResult = mDbConnection.queryPrepared(
+            "SELECT MAX(id) FROM (SELECT id FROM player_balances WHERE id > " + placeholder(1) + " ORDER BY id LIMIT "
+                + placeholder(2) + ") chunk;",
+            {snapshot.lastId, chunkSize}
+        );
+        if (!boundResult.empty() && !boundResult[0].empty()) {
+            upperId = db::toInt64(boundResult[0][0]);
+        }
+        if (!upperId) {
+            completeSnapshotLocked(snapshot);
+            return false;
+        }
+
+        // 2. 在一个事务中读取流水水位并复制本块账户，同时推进游标
+        // 所有数值都来自数据库或快照记录，直接拼入 SQL，避免 INSERT ... SELECT 中参数类型推断的差异
+        db::ScopedTransaction transaction(mDbConnection);
+        int64_t               logWatermark = queryInt64("SELECT COALESCE(MAX(id), 0) FROM economy_log;");
+        std::string           sql          = fmt::format(
+            "INSERT INTO balance_snapshot_rows (snapshot_id, uuid, currency_type, amount, log_id) "
+                                  "SELECT {}, b.uuid, b.currency_type, b.amount, {} FROM player_balances b WHERE b.id > {} AND b.id <= {}",
+            snapshot.id,
+            logWatermark,
+            snapshot.lastId,
+            *upperId
+        );
+        if (snapshot.kind == KIND_DELTA) {
+            // 增量：上个快照之后新开的账户，或上个快照开始之后有流水的账户
+            sql += fmt::format(
+                " AND (b.id > {} OR EXISTS (SELECT 1 FROM economy_log l WHERE l.uuid = b.uuid "
+                "AND l.currency_type = b.currency_type AND l.id > {}))",
+                snapshot.baseAccountId,
+                snapshot.baseLogId
+            );
+        }
+        sql += ";";
+        int inserted = mDbConnection.executePrepared(sql, {});
+
+        snapshot.lastId    = *upperId;
+        snapshot.rowCount += std::max(0, inserted);
+        saveSnapshotState(snapshot);
+        transaction.commit();
+
+        mSnapshot = snapshot;
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error(
+            "余额快照 #{} 处理分块 (id > {}) 时发生数据库错误，快照已暂停，稍后继续: {}",
+            snapshot.id,
+            snapshot.lastId,
+            e.what()
+        );
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("余额快照 #{} 处理分块时发生意外错误，快照已暂停: {}", snapshot.id, e.what());
+        return false;
+    }
+}
+
+bool BalanceSnapshotEngine::hasPendingWork() const {
+    std::lock_guard lock(mMutex);
+    return mSnapshot && mSnapshot->status == "running";
+}
+
+std::optional<BalanceSnapshotInfo> BalanceSnapshotEngine::getSnapshotStatus() const {
+    std::lock_guard lock(mMutex);
+    return mSnapshot;
+}
+
+std::optional<BalanceAtTime> BalanceSnapshotEngine::getBalanceAt(
+    const std::string& uuid,
+    const std::string& currencyType,
+    const std::string& timestamp
+) {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法推算历史余额：数据库未连接。");
+        return std::nullopt;
+    }
+
+    try {
+        BalanceAtTime          result;
+        int64_t                replayFromLogId = 0;
+        std::optional<int64_t> secondsAgo      = parseSecondsAgo(timestamp);
+        bool                   relative        = secondsAgo.has_value();
+        db::DbValue            bound           = relative ? db::DbValue(*secondsAgo) : db::DbValue(timestamp);
+
+        // 1. 完成时间不晚于 T 的最近一行快照 (主键 uuid, currency_type, snapshot_id 上的倒序范围扫描)
+        db::DbResult snapshotRow = mDbConnection.queryPrepared(
+            "SELECT r.amount, r.log_id, r.snapshot_id FROM balance_snapshot_rows r "
+            "JOIN balance_snapshots s ON s.id = r.snapshot_id WHERE r.uuid = "
+                + placeholder(1) + " AND r.currency_type = " + placeholder(2)
+                + " AND s.status = 'completed' AND s.completed_at <= " + timeBoundExpr(3, relative)
+                + " ORDER BY r.snapshot_id DESC LIMIT 1;",
+            {uuid, currencyType, bound}
+        );
+
+        if (!snapshotRow.empty() && snapshotRow[0].size() == 3) {
+            // 2a. 快照余额 + 快照之后、T 之前的流水
+            result.amount     = db::toInt64(snapshotRow[0][0]).value_or(0);
+            replayFromLogId   = db::toInt64(snapshotRow[0][1]).value_or(0);
+            result.snapshotId = db::toInt64(snapshotRow[0][2]).value_or(0);
+
+            db::DbResult replay = mDbConnection.queryPrepared(
+                "SELECT COUNT(*), COALESCE(SUM(change_amount), 0) FROM economy_log WHERE uuid = " + placeholder(1)
+                    + " AND currency_type = " + placeholder(2) + " AND id > " + placeholder(3)
+                    + " AND timestamp <= " + timeBoundExpr(4, relative) + ";",
+                {uuid, currencyType, replayFromLogId, bound}
+            );
+            if (!replay.empty() && replay[0].size() == 2) {
+                result.replayedRows  = db::toInt64(replay[0][0]).value_or(0);
+                result.amount       += db::toInt64(replay[0][1]).value_or(0);
+            }
+        } else {
+            // 2b. 没有可用快照：T 之前最后一条流水的变动后余额
+            db::DbResult lastLog = mDbConnection.queryPrepared(
+                "SELECT id, previous_amount + change_amount FROM economy_log WHERE uuid = " + placeholder(1)
+                    + " AND currency_type = " + placeholder(2) + " AND timestamp <= " + timeBoundExpr(3, relative)
+                    + " ORDER BY id DESC LIMIT 1;",
+                {uuid, currencyType, bound}
+            );
+            if (!lastLog.empty() && lastLog[0].size() == 2) {
+                replayFromLogId     = db::toInt64(lastLog[0][0]).value_or(0);
+                result.amount       = db::toInt64(lastLog[0][1]).value_or(0);
+                result.replayedRows = 1;
+            } else {
+                // T 之前没有任何记录：用 T 之后第一条流水的变动前余额，账户当时可能尚未创建
+                db::DbResult nextLog = mDbConnection.queryPrepared(
+                    "SELECT previous_amount FROM economy_log WHERE uuid = " + placeholder(1)
+                        + " AND currency_type = " + placeholder(2) + " AND timestamp > " + timeBoundExpr(3, relative)
+                        + " ORDER BY id ASC LIMIT 1;",
+                    {uuid, currencyType, bound}
+                );
+                if (nextLog.empty() || nextLog[0].empty()) {
+                    return std::nullopt;
+                }
+                result.amount      = db::toInt64(nextLog[0][0]).value_or(0);
+                result.approximate = true;
+                return result;
+            }
+        }
+
+        // 3. 区间内有旧版本批量调整写入的汇总流水时无法按账户重放，标记为近似值
+        int64_t bulkRows = queryInt64(
+            "SELECT COUNT(*) FROM economy_log WHERE uuid = " + placeholder(1) + " AND currency_type = " + placeholder(2)
+                + " AND id > " + placeholder(3) + " AND timestamp <= " + timeBoundExpr(4, relative) + ";",
+            {std::string(BulkAdjustmentEngine::SUMMARY_LOG_UUID), currencyType, replayFromLogId, bound}
+        );
+        result.approximate = bulkRows > 0;
+        return result;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("推算历史余额时发生数据库错误 (UUID: {}, Currency: {}): {}", uuid, currencyType, e.what());
+        return std::nullopt;
+    } catch (const std::exception& e) {
+        mLogger.error("推算历史余额时发生意外错误 (UUID: {}, Currency: {}): {}", uuid, currencyType, e.what());
+        return std::nullopt;
+    }
+}
+
+} // namespace czmoney
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/money/money_api.h" // 包含 MoneyApiResult 枚举
+#include "ll/api/io/Logger.h"
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace czmoney {
+
+// 余额快照的头信息 (balance_snapshots 表的一行)
+struct BalanceSnapshotInfo {
+    int64_t     id = 0;
+    std::string kind;               // full / delta
+    std::string status;             // running / completed
+    int64_t     startLogId = 0;     // 快照开始时 economy_log 的最大 id
+    int64_t     baseLogId = 0;      // 增量快照：上一个快照的 startLogId，之后有流水的账户才写入
+    int64_t     baseAccountId = 0;  // 增量快照：上一个快照扫描到的最大 player_balances.id，之后新开的账户也写入
+    int64_t     lastId = 0;         // 已处理到的 player_balances.id (keyset 游标)
+    int64_t     rowCount = 0;       // 已写入的账户行数
+    std::string completedAt;        // 完成时间 (数据库时间)，未完成时为空
+};
+
+// 按时间点推算出的余额
+struct BalanceAtTime {
+    int64_t amount = 0;        // 余额 (整数，实际金额 * 100)
+    int64_t snapshotId = 0;    // 作为起点的快照编号，0 表示没有可用快照 (直接使用流水)
+    int64_t replayedRows = 0;  // 在快照之后重放的流水条数
+    bool    approximate = false; // 区间内有批量调整 (只有汇总流水) 或账户可能尚未创建，结果仅供参考
+};
+
+/**
+ * @brief 余额快照与按时间点查询余额
+ *
+ * 定期把 player_balances 写入 balance_snapshot_rows，每行带上写入时 economy_log 的最大 id (log_id)。
+ * 查询某账户在时间 T 的余额时，取完成时间不晚于 T 的最近一行快照，再加上 id > log_id 且不晚于 T 的流水，
+ * 因此只需重放一个快照间隔内的少量流水，不必从头汇总。
+ * - 全量快照写入所有账户；增量快照只写入上一个快照之后有流水或新开的账户，其余账户沿用更早的快照行。
+ * - 按 player_balances.id 做 keyset 分块，每块一个事务，游标与快照行在同一事务中写入，中断后从游标处继续。
+ * - 批量调整只写汇总流水，无法按账户重放，调用方应在批量调整完成后生成一次全量快照。
+ */
+class BalanceSnapshotEngine {
+public:
+    static constexpr const char* KIND_FULL  = "full";
+    static constexpr const char* KIND_DELTA = "delta";
+
+    /**
+     * @brief 构造函数
+     * @param dbConn 数据库连接
+     * @param config 配置对象
+     */
+    BalanceSnapshotEngine(db::IDatabaseConnection& dbConn, const Config& config);
+
+    BalanceSnapshotEngine(const BalanceSnapshotEngine&) = delete;
+    BalanceSnapshotEngine& operator=(const BalanceSnapshotEngine&) = delete;
+
+    /**
+     * @brief 创建 balance_snapshots / balance_snapshot_rows 表 (如果不存在)，并加载最近的快照状态
+     * @return bool 操作是否成功
+     */
+    bool initializeTable();
+
+    /**
+     * @brief 开始生成一个新快照
+     * @param forceFull 是否强制生成全量快照 (否则按 fullSnapshotEvery 决定全量或增量)
+     * @param[out] outSnapshotId 成功时写入快照编号
+     * @return api::MoneyApiResult 操作结果；已有快照在生成时返回 JobInProgress
+     */
+    api::MoneyApiResult startSnapshot(bool forceFull, int64_t& outSnapshotId);
+
+    /**
+     * @brief 让下一次快照生成全量快照 (例如批量调整之后)
+     */
+    void requestFullSnapshot();
+
+    /**
+     * @brief 处理下一个分块
+     * @return bool 是否还有剩余分块需要处理
+     */
+    bool runNextChunk();
+
+    /**
+     * @brief 是否有正在生成的快照
+     */
+    bool hasPendingWork() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 快照的进度
+     * @return std::optional<BalanceSnapshotInfo> 没有任何快照记录时返回 std::nullopt
+     */
+    std::optional<BalanceSnapshotInfo> getSnapshotStatus() const;
+
+    /**
+     * @brief 推算账户在指定时间点的余额
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     * @param timestamp 时间点：服务器本地时间 (例如 "2025-01-01 12:00:00")，或距现在的时长 (例如 "3d"、"12h"、"30m")
+     * @return std::optional<BalanceAtTime> 没有任何快照或流水可供推算时返回 std::nullopt
+     */
+    std::optional<BalanceAtTime>
+    getBalanceAt(const std::string& uuid, const std::string& currencyType, const std::string& timestamp);
+
+private:
+    db::IDatabaseConnection& mDbConnection;
+    const Config&            mConfig;
+    ll::io::Logger&          mLogger;
+
+    mutable std::mutex                 mMutex;              // 串行化分块处理与快照状态
+    std::optional<BalanceSnapshotInfo> mSnapshot;           // 当前或最近一次快照
+    std::optional<BalanceSnapshotInfo> mLastCompleted;      // 最近一次完成的快照 (增量快照的基准)
+    int64_t                            mSnapshotsSinceFull = 0; // 最近一次全量快照之后完成的增量快照数
+    bool                               mForceFullNext = false;
+
+    std::string placeholder(int index) const;
+    std::string timeBoundExpr(int index, bool relative) const;
+    int64_t     queryInt64(const std::string& sql, const db::DbParams& params = {});
+    void        saveSnapshotState(const BalanceSnapshotInfo& snapshot);
+    void        completeSnapshotLocked(BalanceSnapshotInfo snapshot);
+    void        pruneOldSnapshotsLocked();
+    static BalanceSnapshotInfo rowToSnapshot(const db::DbRow& row);
+};
+
+} // namespace czmoney
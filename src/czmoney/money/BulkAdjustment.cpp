@@ -0,0 +1,457 @@
+#include "czmoney/money/BulkAdjustment.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/money.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+
+namespace czmoney {
+
+namespace {
+// SELECT 的列顺序，与 rowToJob 保持一致
+constexpr const char* JOB_COLUMNS = "id, currency_type, rate_bp, threshold, last_id, total_accounts, processed_accounts, "
+                                    "total_delta, status, reason1, reason2, reason3";
+constexpr size_t      JOB_COLUMN_COUNT = 12;
+} // namespace
+
+BulkAdjustmentEngine::BulkAdjustmentEngine(db::IDatabaseConnection& dbConn, const Config& config)
+: mDbConnection(dbConn),
+  mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()),
+  mLedgerChain(config) {}
+
+std::string BulkAdjustmentEngine::placeholder(int index) const {
+    return czmoney::placeholder(mDbConnection.getDbType(), index);
+}
+
+// 账户当前的冻结总额 (相关子查询，走 holds 的 (uuid, currency_type) 索引)
+std::string BulkAdjustmentEngine::heldExpression() const {
+    // PostgreSQL 的 SUM(BIGINT) 返回 NUMERIC，MySQL 返回 DECIMAL，转回整数以保证后面的除法截断
+    const char* intType = mDbConnection.getDbType() == "mysql" ? "SIGNED" : "BIGINT";
+    return fmt::format(
+        "CAST(COALESCE((SELECT SUM(h.amount) FROM holds h WHERE h.uuid = player_balances.uuid "
+        "AND h.currency_type = player_balances.currency_type), 0) AS {})",
+        intType
+    );
+}
+
+// 参与计算的部分: 余额 - 冻结 - 下限。利息的下限是起息点；
+// 财富税的下限是 max(起征点, minimumBalance)，-100% 时恰好把可用余额降到下限而不会更低
+std::string BulkAdjustmentEngine::baseExpression(const BulkAdjustmentJob& job) const {
+    int64_t floor = job.threshold;
+    if (job.rateBasisPoints < 0) {
+        auto it = mConfig.economy.find(job.currencyType);
+        if (it != mConfig.economy.end()) {
+            floor = std::max(floor, static_cast<int64_t>(std::llround(it->second.minimumBalance * 100.0)));
+        }
+    }
+    return fmt::format("(amount - {} - {})", heldExpression(), floor);
+}
+
+// 单个账户的变动金额: base * rate / 10000，向 0 截断 (财富税向下取整对玩家有利)
+// 先除后乘避免 base * rate 溢出 int64: base = q * 10000 + r，结果 = q * rate + r * rate / 10000，
+// q * rate 与 r * rate 同号，分开截断与整体截断相同
+// rate 与下限都是校验过的整数，直接拼入 SQL，避免在多个语句中重复绑定参数
+std::string BulkAdjustmentEngine::deltaExpression(const BulkAdjustmentJob& job) const {
+    // MySQL 的 "/" 返回 DECIMAL，需要用 DIV 做整数除法；SQLite 与 PostgreSQL 的整数 "/" 本身即截断
+    const char* divOp = mDbConnection.getDbType() == "mysql" ? "DIV" : "/";
+    std::string base  = baseExpression(job);
+    return fmt::format(
+        "(({0} {1} 10000) * {2} + (({0} % 10000) * {2}) {1} 10000)",
+        base,
+        divOp,
+        job.rateBasisPoints
+    );
+}
+
+bool BulkAdjustmentEngine::initializeTable() {
+    std::string dbType = mDbConnection.getDbType();
+    std::string createTableSQL;
+
+    if (dbType == "mysql") {
+        createTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS bulk_adjustment_jobs (
+                id BIGINT PRIMARY KEY,
+                currency_type VARCHAR(50) NOT NULL,
+                rate_bp BIGINT NOT NULL,
+                threshold BIGINT NOT NULL DEFAULT 0,
+                last_id BIGINT NOT NULL DEFAULT 0,
+                total_accounts BIGINT NOT NULL DEFAULT 0,
+                processed_accounts BIGINT NOT NULL DEFAULT 0,
+                total_delta BIGINT NOT NULL DEFAULT 0,
+                status VARCHAR(16) NOT NULL,
+                reason1 VARCHAR(255) DEFAULT NULL,
+                reason2 VARCHAR(255) DEFAULT NULL,
+                reason3 VARCHAR(255) DEFAULT NULL,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )";
+    } else if (dbType == "sqlite") {
+        createTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS bulk_adjustment_jobs (
+                id INTEGER PRIMARY KEY,
+                currency_type TEXT NOT NULL,
+                rate_bp INTEGER NOT NULL,
+                threshold INTEGER NOT NULL DEFAULT 0,
+                last_id INTEGER NOT NULL DEFAULT 0,
+                total_accounts INTEGER NOT NULL DEFAULT 0,
+                processed_accounts INTEGER NOT NULL DEFAULT 0,
+                total_delta INTEGER NOT NULL DEFAULT 0,
+                status TEXT NOT NULL,
+                reason1 TEXT DEFAULT NULL,
+                reason2 TEXT DEFAULT NULL,
+                reason3 TEXT DEFAULT NULL,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+            );
+        )";
+    } else if (dbType == "postgresql") {
+        createTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS bulk_adjustment_jobs (
+                id BIGINT PRIMARY KEY,
+                currency_type VARCHAR(50) NOT NULL,
+                rate_bp BIGINT NOT NULL,
+                threshold BIGINT NOT NULL DEFAULT 0,
+                last_id BIGINT NOT NULL DEFAULT 0,
+                total_accounts BIGINT NOT NULL DEFAULT 0,
+                processed_accounts BIGINT NOT NULL DEFAULT 0,
+                total_delta BIGINT NOT NULL DEFAULT 0,
+                status VARCHAR(16) NOT NULL,
+                reason1 VARCHAR(255) DEFAULT NULL,
+                reason2 VARCHAR(255) DEFAULT NULL,
+                reason3 VARCHAR(255) DEFAULT NULL,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+            );
+        )";
+    } else {
+        mLogger.error("不支持的数据库类型 '{}'，无法创建 bulk_adjustment_jobs 表。", dbType);
+        return false;
+    }
+
+    try {
+        mDbConnection.execute(createTableSQL);
+
+        // 加载最近一次任务；若仍为 running，说明上次被中断，由调用方安排继续处理
+        db::DbResult latest = mDbConnection.query(
+            std::string("SELECT ") + JOB_COLUMNS + " FROM bulk_adjustment_jobs ORDER BY id DESC LIMIT 1;"
+        );
+        std::lock_guard lock(mMutex);
+        mJob.reset();
+        if (!latest.empty() && latest[0].size() == JOB_COLUMN_COUNT) {
+            mJob = rowToJob(latest[0]);
+            if (mJob->status == "running") {
+                mLogger.warn(
+                    "检测到未完成的批量调整任务 #{} ({}，已处理 {}/{} 个账户)，将从中断处继续。",
+                    mJob->id,
+                    mJob->currencyType,
+                    mJob->processedAccounts,
+                    mJob->totalAccounts
+                );
+            }
+        }
+        mLogger.info("'bulk_adjustment_jobs' 表初始化成功 (类型: {}).", dbType);
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建或验证 'bulk_adjustment_jobs' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("创建或验证 'bulk_adjustment_jobs' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+BulkAdjustmentJob BulkAdjustmentEngine::rowToJob(const db::DbRow& row) {
+    BulkAdjustmentJob job;
+    job.id                = db::toInt64(row[0]).value_or(0);
+    job.currencyType      = db::toString(row[1]);
+    job.rateBasisPoints   = db::toInt64(row[2]).value_or(0);
+    job.threshold         = db::toInt64(row[3]).value_or(0);
+    job.lastId            = db::toInt64(row[4]).value_or(0);
+    job.totalAccounts     = db::toInt64(row[5]).value_or(0);
+    job.processedAccounts = db::toInt64(row[6]).value_or(0);
+    job.totalDelta        = db::toInt64(row[7]).value_or(0);
+    job.status            = db::toString(row[8]);
+    job.reason1           = db::toString(row[9]);
+    job.reason2           = db::toString(row[10]);
+    job.reason3           = db::toString(row[11]);
+    return job;
+}
+
+api::MoneyApiResult BulkAdjustmentEngine::startJob(
+    const std::string& currencyType,
+    int64_t            rateBasisPoints,
+    int64_t            threshold,
+    int64_t&           outJobId,
+    const std::string& reason1,
+    const std::string& reason2,
+    const std::string& reason3
+) {
+    if (mConfig.economy.find(currencyType) == mConfig.economy.end()) {
+        mLogger.error("无法开始批量调整：货币类型 '{}' 未在配置中定义。", currencyType);
+        return api::MoneyApiResult::UnknownError;
+    }
+    // 比例上限 100%；财富税在 -100% 时恰好把余额降到起征点，不会低于起征点
+    if (rateBasisPoints == 0 || rateBasisPoints < -10000 || rateBasisPoints > 10000 || threshold < 0) {
+        return api::MoneyApiResult::InvalidAmount;
+    }
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法开始批量调整：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    std::lock_guard lock(mMutex);
+    if (mJob && mJob->status == "running") {
+        return api::MoneyApiResult::JobInProgress;
+    }
+
+    BulkAdjustmentJob job;
+    job.id              = (mJob ? mJob->id : 0) + 1;
+    job.currencyType    = currencyType;
+    job.rateBasisPoints = rateBasisPoints;
+    job.threshold       = threshold;
+    job.status          = "running";
+    job.reason1         = reason1.empty() ? "BulkAdjustment" : reason1;
+    job.reason2         = reason2;
+    job.reason3         = reason3;
+
+    try {
+        // 总数只用于估算进度，任务进行中新开的账户也会被处理 (不扣除冻结，只是估计)
+        std::string countSql = "SELECT COUNT(*) FROM player_balances WHERE currency_type = " + placeholder(1)
+                             + " AND amount > " + placeholder(2) + ";";
+        db::DbResult countResult = mDbConnection.queryPrepared(countSql, {currencyType, threshold});
+        if (!countResult.empty() && !countResult[0].empty()) {
+            job.totalAccounts = db::toInt64(countResult[0][0]).value_or(0);
+        }
+
+        std::string sql = "INSERT INTO bulk_adjustment_jobs (id, currency_type, rate_bp, threshold, last_id, total_accounts, "
+                          "processed_accounts, total_delta, status, reason1, reason2, reason3) VALUES ("
+                        + placeholder(1) + ", " + placeholder(2) + ", " + placeholder(3) + ", " + placeholder(4)
+                        + ", 0, " + placeholder(5) + ", 0, 0, 'running', " + placeholder(6) + ", " + placeholder(7)
+                        + ", " + placeholder(8) + ");";
+        db::DbParams params = {
+            job.id,
+            job.currencyType,
+            job.rateBasisPoints,
+            job.threshold,
+            job.totalAccounts,
+            job.reason1,
+            job.reason2,
+            job.reason3
+        };
+        if (mDbConnection.executePrepared(sql, params) <= 0) {
+            mLogger.error("创建批量调整任务失败 (INSERT 未影响任何行)。");
+            return api::MoneyApiResult::DatabaseError;
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建批量调整任务时发生数据库错误: {}", e.what());
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("创建批量调整任务时发生意外错误: {}", e.what());
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    mJob               = job;
+    mLastLoggedPercent = 0;
+    outJobId           = job.id;
+    mLogger.info(
+        "批量调整任务 #{} 开始：货币 {}，比例 {:.2f}%，起点 {}，预计 {} 个账户",
+        job.id,
+        job.currencyType,
+        static_cast<double>(job.rateBasisPoints) / 100.0,
+        MoneyManager::formatBalance(job.threshold),
+        job.totalAccounts
+    );
+    return api::MoneyApiResult::Success;
+}
+
+api::MoneyApiResult BulkAdjustmentEngine::cancelJob() {
+    std::lock_guard lock(mMutex);
+    if (!mJob || mJob->status != "running") {
+        return api::MoneyApiResult::JobNotFound;
+    }
+    BulkAdjustmentJob cancelled = *mJob;
+    cancelled.status            = "cancelled";
+    try {
+        saveJobState(cancelled);
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("取消批量调整任务 #{} 时发生数据库错误: {}", cancelled.id, e.what());
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("取消批量调整任务 #{} 时发生意外错误: {}", cancelled.id, e.what());
+        return api::MoneyApiResult::UnknownError;
+    }
+    mJob = cancelled;
+    mLogger.warn(
+        "批量调整任务 #{} 已取消 (已处理 {} 个账户，总变动 {})。",
+        cancelled.id,
+        cancelled.processedAccounts,
+        MoneyManager::formatBalance(cancelled.totalDelta)
+    );
+    return api::MoneyApiResult::Success;
+}
+
+void BulkAdjustmentEngine::saveJobState(const BulkAdjustmentJob& job) {
+    std::string sql = "UPDATE bulk_adjustment_jobs SET last_id = " + placeholder(1) + ", processed_accounts = "
+                    + placeholder(2) + ", total_delta = " + placeholder(3) + ", status = " + placeholder(4)
+                    + " WHERE id = " + placeholder(5) + ";";
+    mDbConnection.executePrepared(sql, {job.lastId, job.processedAccounts, job.totalDelta, job.status, job.id});
+}
+
+void BulkAdjustmentEngine::logProgressLocked() {
+    const BulkAdjustmentJob& job  = *mJob;
+    int                      step = mConfig.bulkAdjustment.progressLogPercentStep;
+    if (step <= 0 || job.totalAccounts <= 0) {
+        return;
+    }
+    int64_t percent = std::min<int64_t>(100, job.processedAccounts * 100 / job.totalAccounts);
+    if (percent >= mLastLoggedPercent + step) {
+        mLastLoggedPercent = percent - percent % step;
+        mLogger.info(
+            "批量调整任务 #{} 进度：{}% ({}/{} 个账户，总变动 {})",
+            job.id,
+            percent,
+            job.processedAccounts,
+            job.totalAccounts,
+            MoneyManager::formatBalance(job.totalDelta)
+        );
+    }
+}
+
+bool BulkAdjustmentEngine::runNextChunk() {
+    std::lock_guard lock(mMutex);
+    if (!mJob || mJob->status != "running" || !mDbConnection.isConnected()) {
+        return false;
+    }
+    BulkAdjustmentJob job       = *mJob;
+    int64_t           chunkSize = std::max(1, mConfig.bulkAdjustment.chunkSize);
+
+    try {
+        // 1. 确定本块的 id 上界 (keyset 分页，走主键范围扫描)
+        std::string boundSql = "SELECT MAX(id) FROM (SELECT id FROM player_balances WHERE currency_type = " + placeholder(1)
+                             + " AND id > " + placeholder(2) + " ORDER BY id LIMIT " + placeholder(3) + ") chunk;";
+        db::DbResult           boundResult = mDbConnection.queryPrepared(boundSql, {job.currencyType, job.lastId, chunkSize});
+        std::optional<int64_t> upperId;
+        if (!boundResult.empty() && !boundResult[0].empty()) {
+            upperId = db::toInt64(boundResult[0][0]);
+        }
+
+        if (!upperId) {
+            // 没有剩余账户，任务完成
+            job.status = "completed";
+            saveJobState(job);
+            mJob = job;
+            mLogger.info(
+                "批量调整任务 #{} 完成：共调整 {} 个账户，总变动 {} {}",
+                job.id,
+                job.processedAccounts,
+                MoneyManager::formatBalance(job.totalDelta),
+                job.currencyType
+            );
+            return false;
+        }
+
+        // 2. 在一个事务中完成：汇总 -> 每个账户一条流水 -> 集合式 UPDATE -> 推进游标
+        // 只处理高于下限 (base > 0) 且变动不为 0 的账户；利息会使余额溢出的账户跳过
+        std::string delta = deltaExpression(job);
+        std::string where = " WHERE currency_type = " + placeholder(1) + " AND id > " + placeholder(2) + " AND id <= "
+                          + placeholder(3) + " AND " + baseExpression(job) + " > 0 AND " + delta + " <> 0";
+        if (job.rateBasisPoints > 0) {
+            where += " AND amount <= 9223372036854775807 - " + delta;
+        }
+        db::DbParams whereParams = {job.currencyType, job.lastId, *upperId};
+        std::string  reason2     = job.reason2.empty() ? fmt::format("Bulk #{}", job.id) : job.reason2;
+        std::string  reason3     = job.reason3.empty()
+                                     ? fmt::format(
+                                         "{:.2f}% (起点 {})",
+                                         static_cast<double>(job.rateBasisPoints) / 100.0,
+                                         MoneyManager::formatBalance(job.threshold)
+                                     )
+                                     : job.reason3;
+
+        mDbConnection.beginTransaction();
+        try {
+            db::DbResult summary = mDbConnection.queryPrepared(
+                "SELECT COUNT(*), COALESCE(SUM(" + delta + "), 0) FROM player_balances" + where + ";",
+                whereParams
+            );
+            int64_t accounts = 0;
+            int64_t change   = 0;
+            if (!summary.empty() && summary[0].size() == 2) {
+                accounts = db::toInt64(summary[0][0]).value_or(0);
+                change   = db::toInt64(summary[0][1]).value_or(0);
+            }
+
+            if (accounts > 0) {
+                // 先按调整前的余额写流水，再更新余额；同一事务中两条语句看到的是同一批行
+                int64_t lastLogId = 0;
+                if (mLedgerChain.isEnabled()) {
+                    db::DbResult maxLog = mDbConnection.query("SELECT COALESCE(MAX(id), 0) FROM economy_log;");
+                    if (!maxLog.empty() && !maxLog[0].empty()) {
+                        lastLogId = db::toInt64(maxLog[0][0]).value_or(0);
+                    }
+                }
+                // "?" 按出现顺序绑定，理由出现在 WHERE 之前；PostgreSQL 按编号绑定
+                bool        numbered = mDbConnection.getDbType() == "postgresql";
+                std::string logSql   = "INSERT INTO economy_log (uuid, currency_type, change_amount, previous_amount, reason1, "
+                                       "reason2, reason3) SELECT uuid, currency_type, "
+                                   + delta + ", amount, " + placeholder(4) + ", " + placeholder(5) + ", " + placeholder(6)
+                                   + " FROM player_balances" + where + " ORDER BY id;";
+                db::DbParams logParams = numbered
+                                           ? db::DbParams{job.currencyType, job.lastId, *upperId, job.reason1, reason2, reason3}
+                                           : db::DbParams{job.reason1, reason2, reason3, job.currencyType, job.lastId, *upperId};
+                mDbConnection.executePrepared(logSql, logParams);
+                if (mLedgerChain.isEnabled()) {
+                    mLedgerChain.sealAfter(mDbConnection, job.currencyType, lastLogId);
+                }
+                mDbConnection.executePrepared(
+                    "UPDATE player_balances SET amount = amount + " + delta + ", last_updated = CURRENT_TIMESTAMP" + where + ";",
+                    whereParams
+                );
+            }
+
+            job.lastId             = *upperId;
+            job.processedAccounts += accounts;
+            job.totalDelta        += change;
+            saveJobState(job);
+            mDbConnection.commitTransaction();
+            if (mFlowCounters && change != 0) {
+                // 计数器按分块汇总计入一次，避免每个账户各占一次计数
+                mFlowCounters->record(job.currencyType, job.reason1, reason2, change);
+            }
+        } catch (...) {
+            try {
+                mDbConnection.rollbackTransaction();
+            } catch (const db::DatabaseException& rbEx) {
+                mLogger.error("回滚批量调整分块时也发生错误: {}", rbEx.what());
+            }
+            throw;
+        }
+
+        mJob = job;
+        logProgressLocked();
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error(
+            "批量调整任务 #{} 处理分块 (id > {}) 时发生数据库错误，任务已暂停，可稍后继续: {}",
+            job.id,
+            job.lastId,
+            e.what()
+        );
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("批量调整任务 #{} 处理分块时发生意外错误，任务已暂停: {}", job.id, e.what());
+        return false;
+    }
+}
+
+bool BulkAdjustmentEngine::hasPendingWork() const {
+    std::lock_guard lock(mMutex);
+    return mJob && mJob->status == "running";
+}
+
+std::optional<BulkAdjustmentJob> BulkAdjustmentEngine::getJobStatus() const {
+    std::lock_guard lock(mMutex);
+    return mJob;
+}
+
+} // namespace czmoney
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/money/money_api.h" // 包含 MoneyApiResult 枚举
+#include "czmoney/money/LedgerChain.h"
+#include "czmoney/money/FlowCounters.h"
+#include "ll/api/io/Logger.h"
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace czmoney {
+
+// 批量调整任务 (利息/财富税) 的进度记录
+struct BulkAdjustmentJob {
+    int64_t     id = 0;
+    std::string currencyType;
+    int64_t     rateBasisPoints = 0;   // 调整比例 (万分比)，正数为利息，负数为财富税
+    int64_t     threshold = 0;         // 只调整余额高于该值的部分 (整数，实际金额 * 100)
+    int64_t     lastId = 0;            // 已处理到的 player_balances.id (keyset 游标)
+    int64_t     totalAccounts = 0;     // 任务开始时符合条件的账户数 (用于估算进度)
+    int64_t     processedAccounts = 0; // 已调整的账户数
+    int64_t     totalDelta = 0;        // 已产生的总变动金额
+    std::string status;                // running / completed / cancelled
+    std::string reason1;
+    std::string reason2;
+    std::string reason3;
+};
+
+/**
+ * @brief 批量利息与财富税处理器
+ *
+ * 对某种货币的所有账户按比例调整余额，不逐个调用 addPlayerBalance/subtractPlayerBalance：
+ * - 按 player_balances.id 做 keyset 分块，每块一个事务，块内用一条集合式 UPDATE 完成调整。
+ * - 块内每个账户一条流水，用一条 INSERT ... SELECT 写入，对账、历史余额等按账户读取流水的功能不受影响。
+ * - 冻结金额不参与计算；财富税最多把可用余额降到 max(起征点, minimumBalance)，利息不会使余额溢出。
+ * - 游标与累计值和调整在同一事务中写入 bulk_adjustment_jobs，中断 (崩溃、停服) 后从游标处继续，
+ *   不会重复或遗漏。
+ * - 批量调整不触发单个账户的余额变动事件。
+ */
+class BulkAdjustmentEngine {
+public:
+    // 旧版本每个分块只写一条汇总流水，uuid 为该值；新版本按账户写流水，读取流水的功能仍需跳过这些旧行
+    static constexpr const char* SUMMARY_LOG_UUID = "@bulk";
+
+    /**
+     * @brief 构造函数
+     * @param dbConn 数据库连接
+     * @param config 配置对象
+     */
+    BulkAdjustmentEngine(db::IDatabaseConnection& dbConn, const Config& config);
+
+    BulkAdjustmentEngine(const BulkAdjustmentEngine&) = delete;
+    BulkAdjustmentEngine& operator=(const BulkAdjustmentEngine&) = delete;
+
+    /**
+     * @brief 创建 bulk_adjustment_jobs 表 (如果不存在)，并加载未完成的任务
+     * @return bool 操作是否成功
+     */
+    bool initializeTable();
+
+    /**
+     * @brief 开始一个新的批量调整任务
+     * @param currencyType 货币类型
+     * @param rateBasisPoints 调整比例 (万分比)，范围 [-10000, 10000]，不能为 0
+     * @param threshold 起征点/起息点 (整数，实际金额 * 100)，只调整高于该值的部分，不能为负数
+     * @param[out] outJobId 成功时写入任务编号
+     * @param reason1 流水的理由 1 (为空时记为 "BulkAdjustment")
+     * @param reason2 流水的理由 2 (为空时记为 "Bulk #任务编号")
+     * @param reason3 流水的理由 3 (为空时记为比例与起点)
+     * @return api::MoneyApiResult 操作结果；已有任务在运行时返回 JobInProgress
+     */
+    api::MoneyApiResult startJob(
+        const std::string& currencyType,
+        int64_t            rateBasisPoints,
+        int64_t            threshold,
+        int64_t&           outJobId,
+        const std::string& reason1 = "",
+        const std::string& reason2 = "",
+        const std::string& reason3 = ""
+    );
+
+    /**
+     * @brief 取消正在运行的任务 (已处理的分块保持不变)
+     * @return api::MoneyApiResult 操作结果；没有运行中的任务时返回 JobNotFound
+     */
+    api::MoneyApiResult cancelJob();
+
+    /**
+     * @brief 处理下一个分块
+     * @return bool 是否还有剩余分块需要处理
+     */
+    bool runNextChunk();
+
+    /**
+     * @brief 是否有运行中的任务
+     */
+    bool hasPendingWork() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 任务的进度
+     * @return std::optional<BulkAdjustmentJob> 没有任何任务记录时返回 std::nullopt
+     */
+    std::optional<BulkAdjustmentJob> getJobStatus() const;
+
+    /**
+     * @brief 设置资金流向计数器，每个分块提交后计入汇总变动
+     * @param counters 计数器指针 (不持有所有权)
+     */
+    void setFlowCounters(FlowCounters* counters) { mFlowCounters = counters; }
+
+private:
+    db::IDatabaseConnection& mDbConnection;
+    const Config&            mConfig;
+    ll::io::Logger&          mLogger;
+    LedgerChain              mLedgerChain; // 启用时封存每个分块写入的流水
+    FlowCounters*            mFlowCounters = nullptr; // 资金流向计数器 (由 MyMod 持有)
+
+    mutable std::mutex               mMutex; // 串行化分块处理与任务状态
+    std::optional<BulkAdjustmentJob> mJob;   // 当前或最近一次任务
+    int64_t                          mLastLoggedPercent = 0;
+
+    std::string placeholder(int index) const;
+    std::string heldExpression() const;
+    std::string baseExpression(const BulkAdjustmentJob& job) const;
+    std::string deltaExpression(const BulkAdjustmentJob& job) const;
+    void        saveJobState(const BulkAdjustmentJob& job);
+    void        logProgressLocked();
+    static BulkAdjustmentJob rowToJob(const db::DbRow& row);
+};
+
+} // namespace czmoney
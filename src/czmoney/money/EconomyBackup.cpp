@@ -0,0 +1,1003 @@
+#include "czmoney/money/EconomyBackup.h"
+#include "czmoney/db/columnar.h"
+#include "czmoney/db/sqlite.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/LedgerChain.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace czmoney {
+
+namespace {
+constexpr char     MAGIC[8]        = {'C', 'Z', 'M', 'B', 'A', 'C', 'K', '\0'};
+constexpr uint32_t FORMAT_VERSION  = 2;        // 版本 2 增加了 holds 表；仍可读取版本 1 的文件
+constexpr uint32_t FLAG_LOG        = 1u << 0; // 包含 economy_log
+constexpr uint32_t FLAG_CHAIN_HASH = 1u << 1; // 流水包含 chain_hash 列
+constexpr uint32_t FLAG_HOLDS      = 1u << 2; // 包含 holds
+constexpr uint8_t  TABLE_END       = 0;
+constexpr uint8_t  TABLE_BALANCES  = 1;
+constexpr uint8_t  TABLE_LOG       = 2;
+constexpr uint8_t  TABLE_HOLDS     = 3;
+constexpr uint32_t MAX_BLOCK_BYTES = 256u * 1024 * 1024; // 读取时拒绝异常大的块 (损坏的长度字段)
+constexpr int      SNAPSHOT_PAGES_PER_STEP = 256;        // SQLite 在线备份每个调度任务复制的页数
+
+// 备份的表：第一列总是整数主键 (keyset 游标)，其余列分为整数列和文本列
+struct TableSpec {
+    uint8_t                  tag;
+    std::string              name;
+    std::vector<std::string> columns;
+    std::vector<bool>        text;
+};
+
+TableSpec balancesSpec() {
+    return {
+        TABLE_BALANCES,
+        "player_balances",
+        {"id", "uuid", "currency_type", "amount", "last_updated"},
+        {false, true, true, false, true}
+    };
+}
+
+TableSpec holdsSpec() {
+    return {
+        TABLE_HOLDS,
+        "holds",
+        {"hold_id", "uuid", "currency_type", "amount", "created_at", "reason1", "reason2", "reason3"},
+        {false, true, true, false, true, true, true, true}
+    };
+}
+
+TableSpec logSpec(bool chainHash) {
+    TableSpec spec{
+        TABLE_LOG,
+        "economy_log",
+        {"id", "timestamp", "uuid", "currency_type", "change_amount", "previous_amount", "reason1", "reason2", "reason3"},
+        {false, true, true, true, false, false, true, true, true}
+    };
+    if (chainHash) {
+        spec.columns.push_back("chain_hash");
+        spec.text.push_back(true);
+    }
+    return spec;
+}
+
+// 恢复时暂存数据的临时表 (只对主连接可见，连接断开后自动消失)
+std::string stagingTable(const TableSpec& spec) { return "czmoney_restore_" + spec.name; }
+
+std::string dropStagingSql(const std::string& dbType, const TableSpec& spec) {
+    if (dbType == "mysql") {
+        return "DROP TEMPORARY TABLE IF EXISTS " + stagingTable(spec) + ";";
+    } else if (dbType == "postgresql") {
+        return "DROP TABLE IF EXISTS pg_temp." + stagingTable(spec) + ";";
+    }
+    return "DROP TABLE IF EXISTS temp." + stagingTable(spec) + ";";
+}
+
+std::string joinColumns(const TableSpec& spec) {
+    std::string joined;
+    for (const auto& column : spec.columns) {
+        if (!joined.empty()) joined += ", ";
+        joined += column;
+    }
+    return joined;
+}
+
+// 未启用过哈希链时 chain_hash 列不存在 (PostgreSQL 中失败的语句会中止事务，必须在事务外探测)
+bool hasChainHashColumn(db::IDatabaseConnection& conn) {
+    return conn.tryQueryColumnar("SELECT chain_hash FROM economy_log WHERE 1 = 0;", {}).has_value();
+}
+
+// 流水表的二级索引，与 MoneyManager::initializeLogTable 中的定义保持一致
+std::vector<std::string> logIndexStatements(const std::string& dbType, bool drop) {
+    if (dbType == "mysql") {
+        if (drop) {
+            return {
+                "ALTER TABLE economy_log DROP INDEX idx_uuid;",
+                "ALTER TABLE economy_log DROP INDEX idx_currency_type;",
+                "ALTER TABLE economy_log DROP INDEX idx_timestamp;"
+            };
+        }
+        return {
+            "ALTER TABLE economy_log ADD INDEX idx_uuid (uuid);",
+            "ALTER TABLE economy_log ADD INDEX idx_currency_type (currency_type);",
+            "ALTER TABLE economy_log ADD INDEX idx_timestamp (timestamp);"
+        };
+    }
+    std::string prefix = dbType == "postgresql" ? "idx_economy_log_" : "idx_";
+    if (drop) {
+        return {
+            "DROP INDEX IF EXISTS " + prefix + "uuid;",
+            "DROP INDEX IF EXISTS " + prefix + "currency_type;",
+            "DROP INDEX IF EXISTS " + prefix + "timestamp;"
+        };
+    }
+    return {
+        "CREATE INDEX IF NOT EXISTS " + prefix + "uuid ON economy_log (uuid);",
+        "CREATE INDEX IF NOT EXISTS " + prefix + "currency_type ON economy_log (currency_type);",
+        "CREATE INDEX IF NOT EXISTS " + prefix + "timestamp ON economy_log (timestamp);"
+    };
+}
+
+// CRC-32 (IEEE 802.3)
+uint32_t crc32(std::string_view data) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char byte : data) {
+        crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// 定长整数按小端写入，文件在不同平台之间通用
+void writeFixed(std::ostream& out, uint64_t value, int bytes) {
+    char buffer[8];
+    for (int i = 0; i < bytes; ++i) {
+        buffer[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    out.write(buffer, bytes);
+}
+
+bool readFixed(std::istream& in, uint64_t& value, int bytes) {
+    unsigned char buffer[8];
+    if (!in.read(reinterpret_cast<char*>(buffer), bytes)) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+    }
+    return true;
+}
+
+// 块编码：整数列按列差分 + zigzag 变长整数；文本列 0 = NULL，1 = 新字符串 (随后是长度和内容)，k + 2 = 字典中第 k 项
+class BlockEncoder {
+public:
+    explicit BlockEncoder(size_t columns) : mPrevious(columns, 0) {}
+
+    void putInt(size_t col, int64_t value) {
+        // 在 uint64 上做回绕减法，任意 int64 之间的差都可逆
+        auto delta     = static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(mPrevious[col]));
+        mPrevious[col] = value;
+        putVarint((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+    }
+
+    void putNull() { putVarint(0); }
+
+    void putText(std::string_view value) {
+        auto [it, inserted] = mDictionary.try_emplace(std::string(value), mDictionary.size());
+        if (!inserted) {
+            putVarint(it->second + 2);
+            return;
+        }
+        putVarint(1);
+        putVarint(value.size());
+        mData.append(value);
+    }
+
+    [[nodiscard]] const std::string& data() const { return mData; }
+
+private:
+    std::string                               mData;
+    std::vector<int64_t>                      mPrevious;
+    std::unordered_map<std::string, uint64_t> mDictionary;
+
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            mData.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        mData.push_back(static_cast<char>(value));
+    }
+};
+
+class BlockDecoder {
+public:
+    BlockDecoder(std::string_view data, size_t columns) : mData(data), mPrevious(columns, 0) {}
+
+    bool getInt(size_t col, int64_t& value) {
+        uint64_t zigzag = 0;
+        if (!getVarint(zigzag)) return false;
+        auto delta     = static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        value          = static_cast<int64_t>(static_cast<uint64_t>(mPrevious[col]) + static_cast<uint64_t>(delta));
+        mPrevious[col] = value;
+        return true;
+    }
+
+    bool getText(db::DbValue& value) {
+        uint64_t tag = 0;
+        if (!getVarint(tag)) return false;
+        if (tag == 0) {
+            value = nullptr;
+            return true;
+        }
+        if (tag >= 2) {
+            if (tag - 2 >= mDictionary.size()) return false;
+            value = mDictionary[tag - 2];
+            return true;
+        }
+        uint64_t length = 0;
+        if (!getVarint(length) || length > mData.size() - mPos) return false;
+        mDictionary.emplace_back(mData.substr(mPos, length));
+        mPos  += length;
+        value  = mDictionary.back();
+        return true;
+    }
+
+    [[nodiscard]] bool atEnd() const { return mPos == mData.size(); }
+
+private:
+    std::string_view         mData;
+    size_t                   mPos = 0;
+    std::vector<int64_t>     mPrevious;
+    std::vector<std::string> mDictionary;
+
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (mPos >= mData.size()) return false;
+            auto byte  = static_cast<unsigned char>(mData[mPos++]);
+            value     |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+struct FileHeader {
+    uint32_t    version = FORMAT_VERSION;
+    uint32_t    flags = 0;
+    uint64_t    createdAt = 0;
+    std::string sourceType;
+};
+
+struct BlockHeader {
+    uint8_t  table = TABLE_END;
+    uint32_t rows = 0;
+    uint32_t crc = 0;
+};
+
+void writeHeader(std::ostream& out, const FileHeader& header) {
+    out.write(MAGIC, sizeof(MAGIC));
+    writeFixed(out, header.version, 4);
+    writeFixed(out, header.flags, 4);
+    writeFixed(out, header.createdAt, 8);
+    writeFixed(out, header.sourceType.size(), 1);
+    out.write(header.sourceType.data(), static_cast<std::streamsize>(header.sourceType.size()));
+}
+
+bool readHeader(std::istream& in, FileHeader& header, std::string& error) {
+    char     magic[sizeof(MAGIC)];
+    uint64_t version = 0, flags = 0, length = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "不是 czmoney 备份文件";
+        return false;
+    }
+    if (!readFixed(in, version, 4) || version < 1 || version > FORMAT_VERSION) {
+        error = "不支持的备份文件版本";
+        return false;
+    }
+    header.version = static_cast<uint32_t>(version);
+    if (!readFixed(in, flags, 4) || !readFixed(in, header.createdAt, 8) || !readFixed(in, length, 1)) {
+        error = "备份文件头不完整";
+        return false;
+    }
+    header.flags = static_cast<uint32_t>(flags);
+    header.sourceType.resize(length);
+    if (!in.read(header.sourceType.data(), static_cast<std::streamsize>(length))) {
+        error = "备份文件头不完整";
+        return false;
+    }
+    return true;
+}
+
+void writeBlock(std::ostream& out, uint8_t table, size_t rows, const std::string& payload) {
+    out.put(static_cast<char>(table));
+    writeFixed(out, rows, 4);
+    writeFixed(out, payload.size(), 4);
+    writeFixed(out, crc32(payload), 4);
+    out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+}
+
+// 读取下一块并校验 CRC；遇到结束标记时 header.table 为 TABLE_END，payload 为空
+bool readBlock(std::istream& in, BlockHeader& header, std::string& payload, std::string& error) {
+    int tag = in.get();
+    if (tag == EOF) {
+        error = "备份文件被截断 (缺少结束标记)";
+        return false;
+    }
+    header.table = static_cast<uint8_t>(tag);
+    payload.clear();
+    if (header.table == TABLE_END) {
+        return true;
+    }
+    if (header.table != TABLE_BALANCES && header.table != TABLE_LOG && header.table != TABLE_HOLDS) {
+        error = "备份文件中有未知的数据块";
+        return false;
+    }
+    uint64_t rows = 0, size = 0, crc = 0;
+    if (!readFixed(in, rows, 4) || !readFixed(in, size, 4) || !readFixed(in, crc, 4) || size > MAX_BLOCK_BYTES) {
+        error = "备份文件数据块头损坏";
+        return false;
+    }
+    payload.resize(size);
+    if (!in.read(payload.data(), static_cast<std::streamsize>(size))) {
+        error = "备份文件被截断";
+        return false;
+    }
+    if (crc32(payload) != crc) {
+        error = "备份文件数据块校验失败 (CRC32 不匹配)";
+        return false;
+    }
+    header.rows = static_cast<uint32_t>(rows);
+    header.crc  = static_cast<uint32_t>(crc);
+    return true;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+EconomyBackup::EconomyBackup(
+    db::IDatabaseConnection&  mainConn,
+    scheduler::TaskScheduler& scheduler,
+    const Config&             config,
+    std::filesystem::path     directory,
+    ConnectionFactory         connectionFactory
+)
+: mMainConn(mainConn),
+  mScheduler(scheduler),
+  mConfig(config),
+  mDirectory(std::move(directory)),
+  mConnectionFactory(std::move(connectionFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+EconomyBackup::~EconomyBackup() { stop(); }
+
+std::optional<std::filesystem::path> EconomyBackup::resolveFile(const std::string& fileName) const {
+    // 只允许备份目录下的文件名，避免通过命令读写任意路径
+    if (fileName.empty() || fileName.find_first_of("/\\:") != std::string::npos || fileName.find("..") != std::string::npos) {
+        return std::nullopt;
+    }
+    return mDirectory / fileName;
+}
+
+bool EconomyBackup::isRunning() const {
+    std::lock_guard lock(mMutex);
+    return mReport.running;
+}
+
+BackupReport EconomyBackup::getReport() const {
+    std::lock_guard lock(mMutex);
+    BackupReport report = mReport;
+    if (report.running) {
+        report.elapsedMs = millisecondsSince(mStartedAt);
+    }
+    return report;
+}
+
+void EconomyBackup::stop() {
+    mCancelled = true;
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    // SQLite 快照仍在分步复制：直接结束 (调度器中剩余的步骤发现句柄已关闭后什么也不做)
+    if (mSnapshot) {
+        mSnapshot.reset();
+        finish("");
+    }
+}
+
+void EconomyBackup::finish(const std::string& error) {
+    std::lock_guard lock(mMutex);
+    const char* action = mReport.mode == "backup" ? "备份" : "恢复";
+    mReport.running    = false;
+    mReport.elapsedMs  = millisecondsSince(mStartedAt);
+    if (!error.empty()) {
+        mReport.error = error;
+        mLogger.error("经济数据{}失败: {}", action, error);
+    } else if (mCancelled) {
+        mReport.cancelled = true;
+        mLogger.info("经济数据{}已取消。", action);
+    } else {
+        mLogger.info(
+            "经济数据{}完成: {} 个账户，{} 条冻结，{} 条流水，耗时 {:.0f}ms",
+            action,
+            mReport.balanceRows,
+            mReport.holdRows,
+            mReport.logRows,
+            mReport.elapsedMs
+        );
+    }
+}
+
+// --- 备份 ---
+
+bool EconomyBackup::startBackup(const std::string& fileName, bool includeLog) {
+    auto path = resolveFile(fileName);
+    if (!path) {
+        mLogger.error("无效的备份文件名: {}", fileName);
+        return false;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+    }
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(mDirectory, ec);
+
+    // SQLite：用在线备份 API 把主连接的数据库按页复制成快照文件 (比逐行读取快得多)，工作线程只读副本
+    bool sqlite = mMainConn.getDbType() == "sqlite";
+    if (sqlite) {
+        auto* source = dynamic_cast<db::SQLiteConnection*>(&mMainConn);
+        if (!source) {
+            mLogger.error("无法建立 SQLite 快照文件: 主连接不是 SQLite 连接");
+            return false;
+        }
+        std::filesystem::path copy = *path;
+        copy += ".snapshot";
+        try {
+            mSnapshot = std::make_unique<db::SQLiteSnapshot>(*source, copy);
+        } catch (const db::DatabaseException& e) {
+            mLogger.error("无法建立 SQLite 快照文件: {}", e.what());
+            return false;
+        }
+    }
+
+    mCancelled = false;
+    {
+        std::lock_guard lock(mMutex);
+        mReport             = BackupReport{};
+        mReport.mode        = "backup";
+        mReport.file        = fileName;
+        mReport.sourceType  = mMainConn.getDbType();
+        mReport.includesLog = includeLog;
+        mReport.running     = true;
+        mStartedAt          = std::chrono::steady_clock::now();
+    }
+    mLogger.info("开始备份经济数据到 {} (包含流水: {})", path->string(), includeLog ? "是" : "否");
+    if (sqlite) {
+        scheduleSnapshotStep(*path, includeLog);
+    } else {
+        startBackupWorker(*path, includeLog, std::nullopt);
+    }
+    return true;
+}
+
+void EconomyBackup::scheduleSnapshotStep(std::filesystem::path path, bool includeLog) {
+    // 每个任务只复制一部分页，服务器在两步之间照常写入
+    mScheduler.submit(
+        "backup-snapshot",
+        [this, path = std::move(path), includeLog]() {
+            if (!mSnapshot) {
+                return; // 已被 stop() 结束
+            }
+            if (mCancelled) {
+                mSnapshot.reset();
+                finish("");
+                return;
+            }
+            try {
+                if (!mSnapshot->step(SNAPSHOT_PAGES_PER_STEP)) {
+                    scheduleSnapshotStep(path, includeLog);
+                    return;
+                }
+            } catch (const db::DatabaseException& e) {
+                mSnapshot.reset();
+                finish(std::string("无法建立 SQLite 快照文件: ") + e.what());
+                return;
+            }
+            std::filesystem::path copy = mSnapshot->path();
+            mSnapshot.reset();
+            startBackupWorker(path, includeLog, copy);
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+void EconomyBackup::startBackupWorker(
+    std::filesystem::path                path,
+    bool                                 includeLog,
+    std::optional<std::filesystem::path> sqliteCopy
+) {
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    mWorker = std::thread([this, path = std::move(path), includeLog, sqliteCopy = std::move(sqliteCopy)]() {
+        backupWorker(path, includeLog, sqliteCopy);
+    });
+}
+
+void EconomyBackup::backupWorker(
+    std::filesystem::path                path,
+    bool                                 includeLog,
+    std::optional<std::filesystem::path> sqliteCopy
+) {
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    std::string error;
+    try {
+        std::unique_ptr<db::IDatabaseConnection> conn;
+        if (sqliteCopy) {
+            conn = std::make_unique<db::SQLiteConnection>(sqliteCopy->string());
+        } else if (mConnectionFactory) {
+            conn = mConnectionFactory();
+        }
+        if (!conn || !conn->connect()) {
+            error = "无法为备份建立数据库连接";
+        } else {
+            error = writeBackup(*conn, tmpPath, includeLog);
+        }
+    } catch (const db::DatabaseException& e) {
+        error = std::string("读取数据失败: ") + e.what();
+    } catch (const std::exception& e) {
+        error = std::string("备份时发生意外错误: ") + e.what();
+    }
+
+    std::error_code ec;
+    if (sqliteCopy) {
+        std::filesystem::remove(*sqliteCopy, ec);
+    }
+    if (error.empty() && !mCancelled) {
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            error = "无法重命名备份文件: " + ec.message();
+        } else {
+            std::lock_guard lock(mMutex);
+            mReport.fileBytes = std::filesystem::file_size(path, ec);
+        }
+    }
+    if (!error.empty() || mCancelled) {
+        std::filesystem::remove(tmpPath, ec);
+    }
+    finish(error);
+}
+
+std::string EconomyBackup::writeBackup(db::IDatabaseConnection& conn, const std::filesystem::path& path, bool includeLog) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return "无法写入备份文件: " + path.string();
+    }
+
+    std::string dbType    = conn.getDbType();
+    bool        chainHash = includeLog && hasChainHashColumn(conn);
+    int         chunkSize = std::clamp(mConfig.backup.chunkSize, 1, 100000);
+
+    // 之后的所有分块查询都读取同一个快照
+    bool inSnapshot = true;
+    if (dbType == "mysql") {
+        conn.execute("SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ;");
+        conn.execute("START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY;");
+    } else if (dbType == "postgresql") {
+        conn.execute("BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY;");
+    } else {
+        inSnapshot = false; // SQLite 副本没有其他写入者
+    }
+
+    FileHeader header;
+    header.flags      = FLAG_HOLDS | (includeLog ? FLAG_LOG : 0) | (chainHash ? FLAG_CHAIN_HASH : 0);
+    header.createdAt  = static_cast<uint64_t>(std::time(nullptr));
+    header.sourceType = mMainConn.getDbType();
+    writeHeader(out, header);
+
+    auto dumpTable = [&](const TableSpec& spec, uint64_t BackupReport::* counter) -> std::string {
+        const std::string& key = spec.columns[0];
+        const std::string  sql = "SELECT " + joinColumns(spec) + " FROM " + spec.name + " WHERE " + key + " > "
+                              + (dbType == "postgresql" ? "$1" : "?") + " ORDER BY " + key + " LIMIT "
+                              + std::to_string(chunkSize) + ";";
+        int64_t cursor = 0;
+        while (!mCancelled) {
+            db::ColumnarResult rows = conn.queryColumnar(sql, {cursor});
+            if (rows.empty()) {
+                break;
+            }
+            if (rows.columnCount() != spec.columns.size()) {
+                return spec.name + " 查询返回的列数不正确";
+            }
+
+            BlockEncoder encoder(spec.columns.size());
+            uint64_t     rawBytes = 0;
+            for (size_t row = 0; row < rows.rowCount(); ++row) {
+                for (size_t col = 0; col < spec.columns.size(); ++col) {
+                    if (!spec.text[col]) {
+                        encoder.putInt(col, rows.getInt64(row, col).value_or(0));
+                        rawBytes += sizeof(int64_t);
+                    } else if (rows.isNull(row, col)) {
+                        encoder.putNull();
+                    } else if (rows.kind(row, col) == db::ColumnKind::Text) {
+                        std::string_view value = rows.getText(row, col);
+                        encoder.putText(value);
+                        rawBytes += value.size();
+                    } else {
+                        std::string value = rows.getString(row, col);
+                        encoder.putText(value);
+                        rawBytes += value.size();
+                    }
+                }
+            }
+            cursor = rows.getInt64(rows.rowCount() - 1, 0).value_or(cursor);
+            writeBlock(out, spec.tag, rows.rowCount(), encoder.data());
+            if (!out) {
+                return "写入备份文件失败";
+            }
+            {
+                std::lock_guard lock(mMutex);
+                mReport.*counter += rows.rowCount();
+                mReport.rawBytes += rawBytes;
+            }
+            if (rows.rowCount() < static_cast<size_t>(chunkSize)) {
+                break;
+            }
+        }
+        return "";
+    };
+
+    std::string error = dumpTable(balancesSpec(), &BackupReport::balanceRows);
+    if (error.empty()) {
+        error = dumpTable(holdsSpec(), &BackupReport::holdRows);
+    }
+    if (error.empty() && includeLog) {
+        error = dumpTable(logSpec(chainHash), &BackupReport::logRows);
+    }
+    if (inSnapshot) {
+        conn.execute("COMMIT;");
+    }
+    if (!error.empty() || mCancelled) {
+        return error;
+    }
+
+    // 结束标记与总行数，恢复时用于发现被截断的文件
+    BackupReport report = getReport();
+    out.put(static_cast<char>(TABLE_END));
+    writeFixed(out, report.balanceRows, 8);
+    writeFixed(out, report.logRows, 8);
+    writeFixed(out, report.holdRows, 8);
+    out.flush();
+    if (!out) {
+        return "写入备份文件失败";
+    }
+    return "";
+}
+
+// --- 恢复 ---
+
+struct EconomyBackup::RestoreJob {
+    std::filesystem::path  path;
+    std::function<void()>  onRestored;
+    std::ifstream          in;
+    std::streampos         dataStart;
+    bool                   includesLog = false;
+    bool                   fileChain   = false; // 备份中的流水带有 chain_hash
+    bool                   targetChain = false; // 当前数据库有 chain_hash 列
+    std::string            dbType;
+    std::vector<TableSpec> tables;              // 需要替换的表 (按写入临时表时的列)
+};
+
+bool EconomyBackup::startRestore(const std::string& fileName, std::function<void()> onRestored) {
+    auto path = resolveFile(fileName);
+    if (!path || !std::filesystem::exists(*path)) {
+        mLogger.error("备份文件不存在或文件名无效: {}", fileName);
+        return false;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+    }
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+
+    mCancelled = false;
+    {
+        std::lock_guard lock(mMutex);
+        mReport         = BackupReport{};
+        mReport.mode    = "restore";
+        mReport.file    = fileName;
+        mReport.running = true;
+        mStartedAt      = std::chrono::steady_clock::now();
+    }
+    mLogger.warn("开始从 {} 恢复经济数据，当前的余额、冻结 (以及备份中包含的流水) 将被替换。", path->string());
+    mWorker = std::thread([this, target = *path, onRestored = std::move(onRestored)]() mutable {
+        restoreWorker(std::move(target), std::move(onRestored));
+    });
+    return true;
+}
+
+void EconomyBackup::restoreWorker(std::filesystem::path path, std::function<void()> onRestored) {
+    // 1. 在工作线程上完整校验文件，任何一块损坏都不改动数据库
+    auto job        = std::make_shared<RestoreJob>();
+    job->path       = std::move(path);
+    job->onRestored = std::move(onRestored);
+    std::string error;
+    try {
+        std::ifstream in(job->path, std::ios::binary);
+        FileHeader    header;
+        if (!in) {
+            error = "无法读取备份文件: " + job->path.string();
+        } else if (readHeader(in, header, error)) {
+            job->dataStart = in.tellg();
+            uint64_t    balanceRows = 0, logRows = 0, holdRows = 0;
+            BlockHeader block;
+            std::string payload;
+            while (!mCancelled && readBlock(in, block, payload, error) && block.table != TABLE_END) {
+                (block.table == TABLE_BALANCES ? balanceRows : block.table == TABLE_LOG ? logRows : holdRows) +=
+                    block.rows;
+            }
+            uint64_t expectedBalances = 0, expectedLogs = 0, expectedHolds = 0;
+            if (error.empty() && !mCancelled
+                && (!readFixed(in, expectedBalances, 8) || !readFixed(in, expectedLogs, 8)
+                    || (header.version >= 2 && !readFixed(in, expectedHolds, 8)) || expectedBalances != balanceRows
+                    || expectedLogs != logRows || expectedHolds != holdRows)) {
+                error = "备份文件的总行数与数据块不一致";
+            }
+        }
+        job->includesLog = (header.flags & FLAG_LOG) != 0;
+        job->fileChain   = (header.flags & FLAG_CHAIN_HASH) != 0;
+        std::lock_guard lock(mMutex);
+        mReport.sourceType  = header.sourceType;
+        mReport.includesLog = job->includesLog;
+    } catch (const std::exception& e) {
+        error = std::string("读取备份文件时发生意外错误: ") + e.what();
+    }
+    if (!error.empty() || mCancelled) {
+        finish(error);
+        return;
+    }
+
+    // 2. 回到服务器线程，在主连接上写入临时表
+    mScheduler.submit("backup-restore-prepare", [this, job]() { prepareRestore(job); }, scheduler::TaskPriority::Low);
+}
+
+void EconomyBackup::prepareRestore(const std::shared_ptr<RestoreJob>& job) {
+    if (mCancelled) {
+        finish("");
+        return;
+    }
+    try {
+        job->dbType      = mMainConn.getDbType();
+        job->targetChain = job->includesLog && hasChainHashColumn(mMainConn);
+        if (job->fileChain && !job->targetChain) {
+            mLogger.warn("备份中的流水带有哈希链，但当前数据库未启用哈希链，chain_hash 将被丢弃。");
+        }
+        // 旧版本的备份不含 holds，此时恢复后冻结表为空 (与备份时刻的余额一致)
+        job->tables = {balancesSpec(), holdsSpec()};
+        if (job->includesLog) {
+            job->tables.push_back(logSpec(job->fileChain && job->targetChain));
+        }
+        for (const auto& spec : job->tables) {
+            mMainConn.execute(dropStagingSql(job->dbType, spec));
+            mMainConn.execute(
+                "CREATE TEMPORARY TABLE " + stagingTable(spec) + " AS SELECT " + joinColumns(spec) + " FROM " + spec.name
+                + " WHERE 1 = 0;"
+            );
+        }
+        job->in.open(job->path, std::ios::binary);
+        job->in.seekg(job->dataStart);
+        if (!job->in) {
+            throw std::runtime_error("无法读取备份文件: " + job->path.string());
+        }
+    } catch (const db::DatabaseException& e) {
+        dropStagingTables(*job);
+        finish(std::string("创建临时表失败: ") + e.what());
+        return;
+    } catch (const std::exception& e) {
+        dropStagingTables(*job);
+        finish(std::string("恢复时发生意外错误: ") + e.what());
+        return;
+    }
+    scheduleRestoreChunk(job);
+}
+
+void EconomyBackup::scheduleRestoreChunk(std::shared_ptr<RestoreJob> job) {
+    mScheduler.submit(
+        "backup-restore-chunk",
+        [this, job]() {
+            try {
+                if (mCancelled) {
+                    dropStagingTables(*job);
+                    finish("");
+                    return;
+                }
+                if (stageNextBlock(*job)) {
+                    scheduleRestoreChunk(job);
+                    return;
+                }
+                // 3. 所有数据块都已写入临时表，用一个事务替换正式表
+                swapRestoredTables(*job);
+            } catch (const db::DatabaseException& e) {
+                dropStagingTables(*job);
+                finish(std::string("写入数据失败: ") + e.what());
+            } catch (const std::exception& e) {
+                dropStagingTables(*job);
+                finish(std::string("恢复时发生意外错误: ") + e.what());
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+bool EconomyBackup::stageNextBlock(RestoreJob& job) {
+    BlockHeader block;
+    std::string payload;
+    std::string error;
+    if (!readBlock(job.in, block, payload, error)) {
+        throw std::runtime_error(error + " (文件在校验后被修改)");
+    }
+    if (block.table == TABLE_END) {
+        return false;
+    }
+
+    TableSpec decodeSpec = block.table == TABLE_BALANCES ? balancesSpec()
+                         : block.table == TABLE_HOLDS    ? holdsSpec()
+                                                         : logSpec(job.fileChain);
+    TableSpec insertSpec = block.table == TABLE_LOG ? logSpec(job.fileChain && job.targetChain) : decodeSpec;
+    size_t    maxParams  = job.dbType == "sqlite" ? 999 : 65535; // 单条语句的参数数量上限
+    size_t    columns    = insertSpec.columns.size();
+    size_t    perInsert  = std::min<size_t>(
+        static_cast<size_t>(std::max(1, mConfig.backup.restoreBatchRows)),
+        std::max<size_t>(1, maxParams / columns)
+    );
+
+    auto buildInsert = [&](size_t rowCount) {
+        std::string sql   = "INSERT INTO " + stagingTable(insertSpec) + " (" + joinColumns(insertSpec) + ") VALUES ";
+        int         index = 1;
+        for (size_t row = 0; row < rowCount; ++row) {
+            sql += row == 0 ? "(" : ", (";
+            for (size_t col = 0; col < columns; ++col) {
+                if (col > 0) sql += ", ";
+                sql += placeholder(job.dbType, index++);
+            }
+            sql += ")";
+        }
+        return sql + ";";
+    };
+    const std::string fullBatchSql = buildInsert(perInsert);
+
+    db::ScopedTransaction transaction(mMainConn);
+    BlockDecoder          decoder(payload, decodeSpec.columns.size());
+    db::DbParams          params;
+    db::DbValue           text;
+    params.reserve(perInsert * columns);
+    for (uint32_t row = 0; row < block.rows; ++row) {
+        for (size_t col = 0; col < decodeSpec.columns.size(); ++col) {
+            bool ok;
+            if (decodeSpec.text[col]) {
+                ok = decoder.getText(text);
+                if (col < columns) params.push_back(std::move(text));
+            } else {
+                int64_t value = 0;
+                ok            = decoder.getInt(col, value);
+                if (col < columns) params.emplace_back(value);
+            }
+            if (!ok) {
+                throw std::runtime_error("备份文件数据块无法解码");
+            }
+        }
+        if (params.size() == perInsert * columns) {
+            mMainConn.executePrepared(fullBatchSql, params);
+            params.clear();
+        }
+    }
+    if (!params.empty()) {
+        mMainConn.executePrepared(buildInsert(params.size() / columns), params);
+    }
+    if (!decoder.atEnd()) {
+        throw std::runtime_error("备份文件数据块长度与行数不一致");
+    }
+    transaction.commit();
+
+    std::lock_guard lock(mMutex);
+    (block.table == TABLE_BALANCES ? mReport.balanceRows
+     : block.table == TABLE_HOLDS  ? mReport.holdRows
+                                   : mReport.logRows) += block.rows;
+    return true;
+}
+
+void EconomyBackup::swapRestoredTables(RestoreJob& job) {
+    bool indexesDropped = false;
+    if (job.includesLog) {
+        // MySQL 的 DDL 会隐式提交，因此索引的删除与重建都放在事务之外
+        for (const auto& sql : logIndexStatements(job.dbType, true)) {
+            if (auto dropped = mMainConn.tryExecute(sql); !dropped) {
+                mLogger.warn("删除流水索引失败 (将继续恢复): {}", dropped.error().message);
+            }
+        }
+        indexesDropped = true;
+    }
+
+    auto rebuildIndexes = [&]() {
+        if (!indexesDropped) return;
+        for (const auto& sql : logIndexStatements(job.dbType, false)) {
+            if (auto created = mMainConn.tryExecute(sql); !created) {
+                mLogger.error("重建流水索引失败: {}", created.error().message);
+            }
+        }
+    };
+
+    // 任何失败都会让事务在作用域结束时回滚
+    size_t resealed = 0;
+    try {
+        db::ScopedTransaction transaction(mMainConn);
+        for (const auto& spec : job.tables) {
+            mMainConn.execute("DELETE FROM " + spec.name + ";");
+            mMainConn.execute(
+                "INSERT INTO " + spec.name + " (" + joinColumns(spec) + ") SELECT " + joinColumns(spec) + " FROM "
+                + stagingTable(spec) + ";"
+            );
+        }
+        if (job.includesLog && job.dbType == "sqlite") {
+            // 全文索引的补建进度指向被替换前的流水 (未启用理由索引时表不存在)
+            (void)mMainConn.tryExecute("DELETE FROM economy_log_fts_backfill;");
+        }
+        if (job.dbType == "postgresql") {
+            // 显式写入的 id 不会推进序列
+            mMainConn.query("SELECT setval(pg_get_serial_sequence('player_balances', 'id'), "
+                            "COALESCE((SELECT MAX(id) FROM player_balances), 0) + 1, false);");
+            if (job.includesLog) {
+                mMainConn.query("SELECT setval(pg_get_serial_sequence('economy_log', 'id'), "
+                                "COALESCE((SELECT MAX(id) FROM economy_log), 0) + 1, false);");
+            }
+        }
+
+        // 备份不含哈希链而当前数据库启用了哈希链：恢复的流水没有 chain_hash，按 id 顺序重新封存
+        LedgerChain chain(mConfig);
+        if (job.includesLog && chain.isEnabled() && job.targetChain && !job.fileChain) {
+            db::DbResult currencies = mMainConn.query("SELECT DISTINCT currency_type FROM economy_log;");
+            for (const auto& row : currencies) {
+                if (!row.empty()) {
+                    resealed += chain.sealAfter(mMainConn, db::toString(row[0]), 0);
+                }
+            }
+        }
+        transaction.commit();
+    } catch (...) {
+        rebuildIndexes(); // 恢复失败也要把索引建回来
+        throw;
+    }
+    rebuildIndexes();
+    dropStagingTables(job);
+    if (resealed > 0) {
+        mLogger.info("已为恢复的 {} 条流水重新封存哈希链。", resealed);
+    }
+    finish("");
+    if (job.onRestored) {
+        job.onRestored();
+    }
+}
+
+void EconomyBackup::dropStagingTables(const RestoreJob& job) {
+    for (const auto& spec : job.tables) {
+        if (auto dropped = mMainConn.tryExecute(dropStagingSql(job.dbType, spec)); !dropped) {
+            mLogger.warn("删除临时表 {} 失败: {}", stagingTable(spec), dropped.error().message);
+        }
+    }
+}
+
+} // namespace czmoney
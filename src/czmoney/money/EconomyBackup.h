@@ -0,0 +1,141 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/db/sqlite.h"
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace czmoney {
+
+// 备份或恢复的进度与结果
+struct BackupReport {
+    std::string mode;               // "backup" 或 "restore"
+    std::string file;
+    std::string sourceType;         // 备份文件来源的数据库类型
+    bool        running = false;
+    bool        cancelled = false;
+    bool        includesLog = false; // 是否包含 economy_log
+    std::string error;              // 非空时表示任务失败
+    uint64_t    balanceRows = 0;
+    uint64_t    logRows = 0;
+    uint64_t    holdRows = 0;
+    uint64_t    rawBytes = 0;       // 按文本估算的原始数据大小
+    uint64_t    fileBytes = 0;      // 备份文件大小
+    double      elapsedMs = 0;
+};
+
+/**
+ * @brief 与数据库类型无关的二进制备份 / 恢复
+ *
+ * 备份文件由若干独立的块组成，每块对应一次 keyset 分块查询 (按 id 顺序)，带有行数和 CRC32 校验：
+ * - 整数列按列做差分后以 zigzag 变长整数写入 (id、余额这类单调或相近的值通常只占 1~2 字节)；
+ * - 文本列用块内字典编码，UUID、货币类型、理由等重复值只写一次，之后只写字典下标；
+ * - 文件末尾记录各表的总行数，用于发现截断的文件。
+ * 备份在工作线程中读取一个一致性快照：
+ * - MySQL：独立连接上的 START TRANSACTION WITH CONSISTENT SNAPSHOT；
+ * - PostgreSQL：独立连接上的 REPEATABLE READ 只读事务；
+ * - SQLite：其他连接的读事务会让服务器的写入失败，因此由调度器在主连接上用在线备份 API 分步复制出快照文件
+ *   (主连接上的写入会同步到副本)，工作线程再从副本读取。
+ * 恢复分三步：工作线程完整校验文件；调度器在主连接上逐块把数据写入临时表；最后一个任务在一个事务中
+ * 用临时表替换正式表 (保留原 id，替换前删除流水二级索引、完成后重建)，只有这一步会短暂阻塞服务器。
+ * 备份不含哈希链而当前数据库启用了哈希链时，恢复后重新封存全部流水。
+ * 包含 player_balances、holds 和 (可选的) economy_log，定时付款、快照等表不在备份范围内。
+ */
+class EconomyBackup {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (只在服务器线程上使用)
+     * @param scheduler 后台任务调度器
+     * @param config 配置对象
+     * @param directory 备份文件所在的目录
+     * @param connectionFactory 为备份工作线程创建独立连接的工厂 (连接生产数据库)
+     */
+    EconomyBackup(
+        db::IDatabaseConnection&  mainConn,
+        scheduler::TaskScheduler& scheduler,
+        const Config&             config,
+        std::filesystem::path     directory,
+        ConnectionFactory         connectionFactory
+    );
+    ~EconomyBackup();
+
+    EconomyBackup(const EconomyBackup&) = delete;
+    EconomyBackup& operator=(const EconomyBackup&) = delete;
+
+    /**
+     * @brief 开始备份
+     * @param fileName 文件名 (位于备份目录下，不能包含路径)
+     * @param includeLog 是否同时备份 economy_log
+     * @return bool 是否成功开始 (已有任务在运行、文件名无效或无法建立快照时返回 false)
+     */
+    bool startBackup(const std::string& fileName, bool includeLog);
+
+    /**
+     * @brief 开始从备份文件恢复 (会替换当前的余额、冻结和备份中包含的流水)
+     * @param fileName 备份文件名
+     * @param onRestored 替换提交后在服务器线程上调用 (用于重新加载依赖这些表的缓存)
+     * @return bool 是否成功开始 (已有任务在运行或文件不存在时返回 false)，结果见 getReport()
+     */
+    bool startRestore(const std::string& fileName, std::function<void()> onRestored);
+
+    /**
+     * @brief 取消正在运行的备份或恢复，并等待工作线程退出 (恢复的最后一步开始后无法取消)
+     */
+    void stop();
+
+    /**
+     * @brief 是否有备份或恢复在运行
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 任务的进度与结果
+     */
+    [[nodiscard]] BackupReport getReport() const;
+
+private:
+    struct RestoreJob; // 恢复任务在调度器各步骤之间传递的状态
+
+    db::IDatabaseConnection&  mMainConn;
+    scheduler::TaskScheduler& mScheduler;
+    const Config&             mConfig;
+    std::filesystem::path     mDirectory;
+    ConnectionFactory         mConnectionFactory;
+    ll::io::Logger&           mLogger;
+
+    mutable std::mutex                    mMutex; // 保护 mReport
+    BackupReport                          mReport;
+    std::atomic<bool>                     mCancelled{false};
+    std::thread                           mWorker;
+    std::chrono::steady_clock::time_point mStartedAt;
+    std::unique_ptr<db::SQLiteSnapshot>   mSnapshot; // SQLite 快照 (分步复制期间)
+
+    std::optional<std::filesystem::path> resolveFile(const std::string& fileName) const;
+    void scheduleSnapshotStep(std::filesystem::path path, bool includeLog);
+    void startBackupWorker(std::filesystem::path path, bool includeLog, std::optional<std::filesystem::path> sqliteCopy);
+    void backupWorker(std::filesystem::path path, bool includeLog, std::optional<std::filesystem::path> sqliteCopy);
+    std::string writeBackup(db::IDatabaseConnection& conn, const std::filesystem::path& path, bool includeLog);
+    void        restoreWorker(std::filesystem::path path, std::function<void()> onRestored);
+    void        prepareRestore(const std::shared_ptr<RestoreJob>& job);
+    void        scheduleRestoreChunk(std::shared_ptr<RestoreJob> job);
+    bool        stageNextBlock(RestoreJob& job);
+    void        swapRestoredTables(RestoreJob& job);
+    void        dropStagingTables(const RestoreJob& job);
+    void        finish(const std::string& error);
+};
+
+} // namespace czmoney
@@ -0,0 +1,259 @@
+#include "czmoney/money/ExploitDetector.h"
+#include "czmoney/event/ExploitAlertEvent.h"
+#include "czmoney/money/money.h"
+#include "ll/api/event/EventBus.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <cmath>
+
+namespace czmoney {
+
+namespace {
+constexpr size_t MAX_SLOTS          = 60;
+constexpr size_t MAX_RECENT_ALERTS  = 50;
+constexpr size_t MAX_IDLE_CATCH_UP  = 240; // 长时间空闲后最多补入的零样本数量
+} // namespace
+
+ExploitDetector::ExploitDetector(const ExploitDetectionConfig& config)
+: mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+void ExploitDetector::updateBaseline(Stream& stream, double sample) const {
+    double alpha = std::clamp(mConfig.baselineAlpha, 0.001, 1.0);
+    if (stream.samples == 0) {
+        stream.mean     = sample;
+        stream.variance = 0;
+    } else {
+        double diff      = sample - stream.mean;
+        double increment = alpha * diff;
+        stream.mean     += increment;
+        stream.variance  = (1.0 - alpha) * (stream.variance + diff * increment);
+    }
+    if (stream.samples < UINT32_MAX) {
+        ++stream.samples;
+    }
+}
+
+void ExploitDetector::advance(Stream& stream, int64_t slotNow, size_t slots) const {
+    if (stream.currentSlot < 0 || stream.slotAmount.size() != slots) {
+        stream.windowAmount = 0;
+        stream.windowCount  = 0;
+        stream.slotAmount.assign(slots, 0);
+        stream.slotCount.assign(slots, 0);
+        stream.currentSlot = slotNow;
+        return;
+    }
+    int64_t elapsed = slotNow - stream.currentSlot;
+    if (elapsed <= 0) {
+        return;
+    }
+    // 每结束一个时间槽，用当时的窗口总额更新一次基线，再清空最旧的槽
+    int64_t rotations = std::min<int64_t>(elapsed, static_cast<int64_t>(slots));
+    for (int64_t i = 0; i < rotations; ++i) {
+        updateBaseline(stream, static_cast<double>(stream.windowAmount));
+        size_t oldest        = static_cast<size_t>((stream.currentSlot + i + 1) % static_cast<int64_t>(slots));
+        stream.windowAmount -= stream.slotAmount[oldest];
+        stream.windowCount  -= stream.slotCount[oldest];
+        stream.slotAmount[oldest] = 0;
+        stream.slotCount[oldest]  = 0;
+    }
+    // 超过一个窗口的空闲期：窗口已清空，补入若干个零样本 (有上限，避免长时间空闲后循环过久)
+    int64_t idle = std::min<int64_t>(elapsed - rotations, static_cast<int64_t>(MAX_IDLE_CATCH_UP));
+    for (int64_t i = 0; i < idle; ++i) {
+        updateBaseline(stream, 0.0);
+    }
+    stream.currentSlot = slotNow;
+}
+
+bool ExploitDetector::record(
+    Stream&           stream,
+    int64_t           slotNow,
+    size_t            slots,
+    int64_t           amount,
+    double            minAlertAmount,
+    uint32_t          warmupWindows,
+    Clock::time_point now,
+    double&           outZScore
+) const {
+    advance(stream, slotNow, slots);
+    size_t slot               = static_cast<size_t>(slotNow % static_cast<int64_t>(slots));
+    stream.slotAmount[slot]  += amount;
+    stream.slotCount[slot]   += 1;
+    stream.windowAmount      += amount;
+    stream.windowCount       += 1;
+    stream.lastSeen           = now;
+
+    double windowAmount = static_cast<double>(stream.windowAmount);
+    if (windowAmount < minAlertAmount || stream.samples < warmupWindows) {
+        return false;
+    }
+    // 标准差设下限：基线几乎为常数时，只有超出基线至少 minAlertAmount 才告警
+    double threshold = std::max(0.1, mConfig.zScoreThreshold);
+    double stddev    = std::max(std::sqrt(stream.variance), minAlertAmount / threshold);
+    double zScore    = stddev > 0 ? (windowAmount - stream.mean) / stddev : 0.0;
+    if (zScore < threshold) {
+        return false;
+    }
+    if (stream.lastAlert != Clock::time_point{}
+        && now - stream.lastAlert < std::chrono::seconds(std::max(0, mConfig.alertCooldownSeconds))) {
+        return false;
+    }
+    stream.lastAlert = now;
+    outZScore        = zScore;
+    return true;
+}
+
+void ExploitDetector::evictIdle(StreamMap& streams, Clock::time_point now) const {
+    // 超过两个窗口没有收入的键基线已衰减，删除后重新建立的代价很小
+    auto idleLimit = std::chrono::seconds(std::max(1, mConfig.windowSeconds) * 2);
+    for (auto it = streams.begin(); it != streams.end();) {
+        if (now - it->second.lastSeen >= idleLimit) {
+            it = streams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ExploitDetector::observe(
+    const std::string& playerUuid,
+    const std::string& currencyType,
+    int64_t            amount,
+    const std::string& reason1,
+    const std::string& reason2
+) {
+    if (!mConfig.enabled || amount <= 0) {
+        return;
+    }
+
+    const auto now       = Clock::now();
+    size_t     slots     = std::clamp<size_t>(static_cast<size_t>(std::max(1, mConfig.slotsPerWindow)), 1, MAX_SLOTS);
+    int64_t    slotMs    = std::max<int64_t>(1, static_cast<int64_t>(std::max(1, mConfig.windowSeconds)) * 1000 / slots);
+    int64_t    slotNow   = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / slotMs;
+    double     playerMin = std::max(0.0, mConfig.playerMinAlertAmount) * 100.0;
+    double     reasonMin = std::max(0.0, mConfig.reasonMinAlertAmount) * 100.0;
+
+    std::vector<ExploitAlert> alerts;
+    {
+        std::lock_guard lock(mMutex);
+
+        if (mConfig.maxTrackedKeys > 0
+            && mPlayerStreams.size() + mReasonStreams.size() >= static_cast<size_t>(mConfig.maxTrackedKeys)
+            && now - mLastEviction >= std::chrono::seconds(1)) {
+            evictIdle(mPlayerStreams, now);
+            evictIdle(mReasonStreams, now);
+            mLastEviction = now;
+        }
+        bool full = mConfig.maxTrackedKeys > 0
+                 && mPlayerStreams.size() + mReasonStreams.size() >= static_cast<size_t>(mConfig.maxTrackedKeys);
+
+        // 玩家收入速率：与自己的基线比较，不需要预热 (新账户突然大量进账本身就可疑)
+        std::string playerKey = currencyType + '\x1f' + playerUuid;
+        auto        playerIt  = full ? mPlayerStreams.find(playerKey) : mPlayerStreams.try_emplace(playerKey).first;
+        double      zScore    = 0;
+        if (playerIt != mPlayerStreams.end()
+            && record(playerIt->second, slotNow, slots, amount, playerMin, 0, now, zScore)) {
+            alerts.push_back(
+                {"player",
+                 playerUuid,
+                 currencyType,
+                 "",
+                 "",
+                 playerIt->second.windowAmount,
+                 playerIt->second.windowCount,
+                 playerIt->second.mean,
+                 zScore,
+                 std::chrono::system_clock::now()}
+            );
+        }
+
+        // 同一理由的收入总量：需要足够的历史窗口建立基线
+        std::string reasonKey = currencyType + '\x1f' + reason1 + '\x1f' + reason2;
+        auto        reasonIt  = full ? mReasonStreams.find(reasonKey) : mReasonStreams.try_emplace(reasonKey).first;
+        if (reasonIt != mReasonStreams.end()
+            && record(
+                reasonIt->second,
+                slotNow,
+                slots,
+                amount,
+                reasonMin,
+                static_cast<uint32_t>(std::max(0, mConfig.warmupWindows)),
+                now,
+                zScore
+            )) {
+            alerts.push_back(
+                {"reason",
+                 "",
+                 currencyType,
+                 reason1,
+                 reason2,
+                 reasonIt->second.windowAmount,
+                 reasonIt->second.windowCount,
+                 reasonIt->second.mean,
+                 zScore,
+                 std::chrono::system_clock::now()}
+            );
+        }
+
+        for (const auto& alert : alerts) {
+            ++mAlertCount;
+            mRecentAlerts.push_front(alert);
+            if (mRecentAlerts.size() > MAX_RECENT_ALERTS) {
+                mRecentAlerts.pop_back();
+            }
+        }
+    }
+
+    // 在锁外输出日志和发布事件，监听器可以安全地调用经济 API
+    for (const auto& alert : alerts) {
+        if (alert.kind == "player") {
+            mLogger.warn(
+                "异常收入告警：玩家 {} 在 {} 秒内获得 {} {} ({} 笔)，基线 {}，z = {:.1f}",
+                alert.playerUuid,
+                mConfig.windowSeconds,
+                MoneyManager::formatBalance(alert.windowAmount),
+                alert.currencyType,
+                alert.windowCount,
+                MoneyManager::formatBalance(static_cast<int64_t>(alert.baseline)),
+                alert.zScore
+            );
+        } else {
+            mLogger.warn(
+                "异常收入告警：理由 '{}' / '{}' 在 {} 秒内发放 {} {} ({} 笔)，基线 {}，z = {:.1f}",
+                alert.reason1,
+                alert.reason2,
+                mConfig.windowSeconds,
+                MoneyManager::formatBalance(alert.windowAmount),
+                alert.currencyType,
+                alert.windowCount,
+                MoneyManager::formatBalance(static_cast<int64_t>(alert.baseline)),
+                alert.zScore
+            );
+        }
+        auto event = event::ExploitAlertEvent(
+            alert.kind,
+            alert.playerUuid,
+            alert.currencyType,
+            alert.reason1,
+            alert.reason2,
+            alert.windowAmount,
+            alert.windowCount,
+            alert.baseline,
+            alert.zScore
+        );
+        ll::event::EventBus::getInstance().publish(event);
+    }
+}
+
+std::vector<ExploitAlert> ExploitDetector::getRecentAlerts(size_t limit) const {
+    std::lock_guard lock(mMutex);
+    size_t          count = std::min(limit, mRecentAlerts.size());
+    return {mRecentAlerts.begin(), mRecentAlerts.begin() + static_cast<std::ptrdiff_t>(count)};
+}
+
+uint64_t ExploitDetector::getAlertCount() const {
+    std::lock_guard lock(mMutex);
+    return mAlertCount;
+}
+
+} // namespace czmoney
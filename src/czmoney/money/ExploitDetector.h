@@ -0,0 +1,120 @@
+#pragma once
+
+#include "czmoney/config.h" // 包含 ExploitDetectionConfig
+#include "ll/api/io/Logger.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace czmoney {
+
+// 一条异常收入告警
+struct ExploitAlert {
+    std::string kind;          // "player" (玩家收入速率) 或 "reason" (同一理由的收入总量)
+    std::string playerUuid;    // kind 为 player 时有效
+    std::string currencyType;
+    std::string reason1;       // kind 为 reason 时有效
+    std::string reason2;
+    int64_t     windowAmount = 0; // 滑动窗口内的收入总额 (整数，实际金额 * 100)
+    int64_t     windowCount = 0;  // 滑动窗口内的收入次数
+    double      baseline = 0;     // 历史窗口收入的指数移动平均
+    double      zScore = 0;
+    std::chrono::system_clock::time_point raisedAt;
+};
+
+/**
+ * @brief 在线异常收入检测 (复制漏洞等)
+ *
+ * 只在内存中消费已提交的入账 (加款、设置余额的增加、兑换所得，由 MoneyManager 在外层事务提交后调用)，不访问数据库：
+ * - 每个 (玩家, 货币) 与每个 (货币, reason1, reason2) 各维护一个滑动窗口，窗口由若干个时间槽组成的环表示；
+ * - 每个时间槽结束时，用当时的窗口总额更新该键的指数移动平均和方差 (基线)；
+ * - 每次加款后计算当前窗口总额相对基线的 z 分数，超过阈值且总额超过下限时告警 (日志 + ExploitAlertEvent)。
+ * 每次观察只有两次哈希查找和常数次算术；空闲的键在数量超过上限时被清理。
+ */
+class ExploitDetector {
+public:
+    /**
+     * @brief 构造函数
+     * @param config 检测配置的引用
+     */
+    explicit ExploitDetector(const ExploitDetectionConfig& config);
+
+    ExploitDetector(const ExploitDetector&) = delete;
+    ExploitDetector& operator=(const ExploitDetector&) = delete;
+
+    /**
+     * @brief 观察一笔已提交的加款，必要时发出告警
+     * @param playerUuid 收款玩家的 UUID
+     * @param currencyType 货币类型
+     * @param amount 加款金额 (整数，实际金额 * 100)
+     * @param reason1 理由 1 (通常是调用方插件)
+     * @param reason2 理由 2
+     */
+    void observe(
+        const std::string& playerUuid,
+        const std::string& currencyType,
+        int64_t            amount,
+        const std::string& reason1,
+        const std::string& reason2
+    );
+
+    /**
+     * @brief 获取最近的告警 (最新的在前)
+     * @param limit 最多返回的条数
+     */
+    [[nodiscard]] std::vector<ExploitAlert> getRecentAlerts(size_t limit) const;
+
+    /**
+     * @brief 累计告警次数
+     */
+    [[nodiscard]] uint64_t getAlertCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stream {
+        std::vector<int64_t>  slotAmount;     // 环形时间槽内的收入总额
+        std::vector<uint32_t> slotCount;      // 环形时间槽内的收入次数
+        int64_t               currentSlot = -1; // 当前时间槽的绝对编号
+        int64_t               windowAmount = 0; // 环内所有槽之和
+        int64_t               windowCount = 0;
+        double                mean = 0;       // 窗口总额的指数移动平均
+        double                variance = 0;   // 窗口总额的指数移动方差
+        uint32_t              samples = 0;    // 参与基线的窗口样本数
+        Clock::time_point     lastAlert{};
+        Clock::time_point     lastSeen{};
+    };
+
+    using StreamMap = std::unordered_map<std::string, Stream>;
+
+    const ExploitDetectionConfig& mConfig;
+    ll::io::Logger&               mLogger;
+    mutable std::mutex            mMutex;
+    StreamMap                     mPlayerStreams;
+    StreamMap                     mReasonStreams;
+    std::deque<ExploitAlert>      mRecentAlerts;
+    uint64_t                      mAlertCount = 0;
+    Clock::time_point             mLastEviction{};
+
+    void advance(Stream& stream, int64_t slotNow, size_t slots) const;
+    void updateBaseline(Stream& stream, double sample) const;
+    // 加入一笔收入并检查是否需要告警，需要时返回 z 分数
+    bool record(
+        Stream&           stream,
+        int64_t           slotNow,
+        size_t            slots,
+        int64_t           amount,
+        double            minAlertAmount,
+        uint32_t          warmupWindows,
+        Clock::time_point now,
+        double&           outZScore
+    ) const;
+    void evictIdle(StreamMap& streams, Clock::time_point now) const;
+};
+
+} // namespace czmoney
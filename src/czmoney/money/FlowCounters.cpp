@@ -0,0 +1,246 @@
+#include "czmoney/money/FlowCounters.h"
+#include "czmoney/money/Helpers.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+
+namespace czmoney {
+
+namespace {
+constexpr char KEY_SEPARATOR = '\x1f';
+} // namespace
+
+FlowCounters::FlowCounters(db::IDatabaseConnection& dbConn, const Config& config)
+: mDbConnection(dbConn),
+  mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+void FlowCounters::addTo(FlowCounter& counter, int64_t change) {
+    if (change > 0) {
+        counter.sumIn += change;
+    } else {
+        counter.sumOut -= change;
+    }
+    counter.ops += 1;
+}
+
+bool FlowCounters::initializeTable() {
+    std::string dbType = mDbConnection.getDbType();
+    std::string createSQL;
+
+    if (dbType == "mysql") {
+        createSQL = R"(
+            CREATE TABLE IF NOT EXISTS flow_counters (
+                currency_type VARCHAR(50) NOT NULL,
+                reason1 VARCHAR(255) NOT NULL DEFAULT '',
+                reason2 VARCHAR(255) NOT NULL DEFAULT '',
+                sum_in BIGINT NOT NULL DEFAULT 0,
+                sum_out BIGINT NOT NULL DEFAULT 0,
+                op_count BIGINT NOT NULL DEFAULT 0,
+                last_updated TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+                PRIMARY KEY (currency_type, reason1, reason2)
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )";
+    } else if (dbType == "sqlite") {
+        createSQL = R"(
+            CREATE TABLE IF NOT EXISTS flow_counters (
+                currency_type TEXT NOT NULL,
+                reason1 TEXT NOT NULL DEFAULT '',
+                reason2 TEXT NOT NULL DEFAULT '',
+                sum_in INTEGER NOT NULL DEFAULT 0,
+                sum_out INTEGER NOT NULL DEFAULT 0,
+                op_count INTEGER NOT NULL DEFAULT 0,
+                last_updated TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                PRIMARY KEY (currency_type, reason1, reason2)
+            ) WITHOUT ROWID;
+        )";
+    } else if (dbType == "postgresql") {
+        createSQL = R"(
+            CREATE TABLE IF NOT EXISTS flow_counters (
+                currency_type VARCHAR(50) NOT NULL,
+                reason1 VARCHAR(255) NOT NULL DEFAULT '',
+                reason2 VARCHAR(255) NOT NULL DEFAULT '',
+                sum_in BIGINT NOT NULL DEFAULT 0,
+                sum_out BIGINT NOT NULL DEFAULT 0,
+                op_count BIGINT NOT NULL DEFAULT 0,
+                last_updated TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                PRIMARY KEY (currency_type, reason1, reason2)
+            );
+        )";
+    } else {
+        mLogger.error("不支持的数据库类型 '{}'，无法创建 flow_counters 表。", dbType);
+        return false;
+    }
+
+    try {
+        mDbConnection.execute(createSQL);
+
+        db::DbResult rows = mDbConnection.query(
+            "SELECT currency_type, reason1, reason2, sum_in, sum_out, op_count FROM flow_counters;"
+        );
+        std::lock_guard lock(mMutex);
+        mByPlugin.clear();
+        mByReason.clear();
+        for (const auto& row : rows) {
+            if (row.size() != 6) continue;
+            FlowCounter counter;
+            counter.currencyType = db::toString(row[0]);
+            counter.reason1      = db::toString(row[1]);
+            counter.reason2      = db::toString(row[2]);
+            counter.sumIn        = db::toInt64(row[3]).value_or(0);
+            counter.sumOut       = db::toInt64(row[4]).value_or(0);
+            counter.ops          = db::toInt64(row[5]).value_or(0);
+
+            auto& plugin = mByPlugin[counter.currencyType + KEY_SEPARATOR + counter.reason1];
+            if (plugin.currencyType.empty()) {
+                plugin.currencyType = counter.currencyType;
+                plugin.reason1      = counter.reason1;
+            }
+            plugin.sumIn  += counter.sumIn;
+            plugin.sumOut += counter.sumOut;
+            plugin.ops    += counter.ops;
+
+            std::string key = counter.currencyType + KEY_SEPARATOR + counter.reason1 + KEY_SEPARATOR + counter.reason2;
+            mByReason[key]  = Entry{std::move(counter), false};
+        }
+        mLogger.info("'flow_counters' 表初始化成功 (类型: {})，已加载 {} 组计数。", dbType, mByReason.size());
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建或加载 'flow_counters' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("创建或加载 'flow_counters' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+void FlowCounters::record(
+    const std::string& currencyType,
+    const std::string& reason1,
+    const std::string& reason2,
+    int64_t            change
+) {
+    if (!mConfig.flowCounters.enabled || change == 0) {
+        return;
+    }
+
+    std::string r1 = truncateReason(reason1);
+    std::string r2 = truncateReason(reason2);
+
+    std::lock_guard lock(mMutex);
+    size_t          limit = static_cast<size_t>(std::max(1, mConfig.flowCounters.maxTrackedReasons));
+
+    // 理由数量达到上限后，新理由的 reason2 归入 OTHER_KEY；插件本身也过多时 reason1 同样归入
+    std::string pluginKey = currencyType + KEY_SEPARATOR + r1;
+    if (!mByPlugin.contains(pluginKey) && mByPlugin.size() >= limit) {
+        r1        = OTHER_KEY;
+        pluginKey = currencyType + KEY_SEPARATOR + r1;
+    }
+    std::string reasonKey = pluginKey + KEY_SEPARATOR + r2;
+    if (!mByReason.contains(reasonKey) && mByReason.size() >= limit) {
+        r2        = OTHER_KEY;
+        reasonKey = pluginKey + KEY_SEPARATOR + r2;
+    }
+
+    auto [pluginIt, pluginInserted] = mByPlugin.try_emplace(pluginKey);
+    if (pluginInserted) {
+        pluginIt->second.currencyType = currencyType;
+        pluginIt->second.reason1      = r1;
+    }
+    addTo(pluginIt->second, change);
+
+    auto [reasonIt, reasonInserted] = mByReason.try_emplace(reasonKey);
+    if (reasonInserted) {
+        reasonIt->second.counter.currencyType = currencyType;
+        reasonIt->second.counter.reason1      = r1;
+        reasonIt->second.counter.reason2      = r2;
+    }
+    addTo(reasonIt->second.counter, change);
+    reasonIt->second.dirty = true;
+}
+
+std::vector<FlowCounter> FlowCounters::getCounters(const std::string& currencyType, bool byReason) const {
+    std::vector<FlowCounter> counters;
+    {
+        std::lock_guard lock(mMutex);
+        if (byReason) {
+            for (const auto& [key, entry] : mByReason) {
+                if (currencyType.empty() || entry.counter.currencyType == currencyType) {
+                    counters.push_back(entry.counter);
+                }
+            }
+        } else {
+            for (const auto& [key, counter] : mByPlugin) {
+                if (currencyType.empty() || counter.currencyType == currencyType) {
+                    counters.push_back(counter);
+                }
+            }
+        }
+    }
+    std::sort(counters.begin(), counters.end(), [](const FlowCounter& a, const FlowCounter& b) {
+        return a.sumIn + a.sumOut > b.sumIn + b.sumOut;
+    });
+    return counters;
+}
+
+size_t FlowCounters::flush() {
+    std::vector<FlowCounter> dirty;
+    {
+        std::lock_guard lock(mMutex);
+        for (auto& [key, entry] : mByReason) {
+            if (entry.dirty) {
+                dirty.push_back(entry.counter);
+                entry.dirty = false;
+            }
+        }
+    }
+    if (dirty.empty()) {
+        return 0;
+    }
+
+    // 写入的是累计值，重复写入同一行是幂等的
+    std::string dbType = mDbConnection.getDbType();
+    std::string sql;
+    if (dbType == "sqlite") {
+        sql = "INSERT OR REPLACE INTO flow_counters (currency_type, reason1, reason2, sum_in, sum_out, op_count, "
+              "last_updated) VALUES (?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP);";
+    } else if (dbType == "mysql") {
+        sql = "INSERT INTO flow_counters (currency_type, reason1, reason2, sum_in, sum_out, op_count) "
+              "VALUES (?, ?, ?, ?, ?, ?) ON DUPLICATE KEY UPDATE sum_in = VALUES(sum_in), "
+              "sum_out = VALUES(sum_out), op_count = VALUES(op_count);";
+    } else if (dbType == "postgresql") {
+        sql = "INSERT INTO flow_counters (currency_type, reason1, reason2, sum_in, sum_out, op_count) "
+              "VALUES ($1, $2, $3, $4, $5, $6) ON CONFLICT (currency_type, reason1, reason2) DO UPDATE SET "
+              "sum_in = EXCLUDED.sum_in, sum_out = EXCLUDED.sum_out, op_count = EXCLUDED.op_count, "
+              "last_updated = CURRENT_TIMESTAMP;";
+    } else {
+        return 0;
+    }
+
+    try {
+        db::ScopedTransaction transaction(mDbConnection);
+        for (const auto& counter : dirty) {
+            mDbConnection.executePrepared(
+                sql,
+                {counter.currencyType, counter.reason1, counter.reason2, counter.sumIn, counter.sumOut, counter.ops}
+            );
+        }
+        transaction.commit();
+        mLogger.debug("已保存 {} 组资金流向计数。", dirty.size());
+        return dirty.size();
+    } catch (const std::exception& e) {
+        mLogger.error("保存资金流向计数失败，将在下次重试: {}", e.what());
+        // 重新标记为脏，下次保存时写入最新的累计值
+        std::lock_guard lock(mMutex);
+        for (const auto& counter : dirty) {
+            auto it = mByReason.find(
+                counter.currencyType + KEY_SEPARATOR + counter.reason1 + KEY_SEPARATOR + counter.reason2
+            );
+            if (it != mByReason.end()) {
+                it->second.dirty = true;
+            }
+        }
+        return 0;
+    }
+}
+
+} // namespace czmoney
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "ll/api/io/Logger.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace czmoney {
+
+// 一组资金流向计数
+struct FlowCounter {
+    std::string currencyType;
+    std::string reason1;    // 调用方插件 (API 的 reason1)
+    std::string reason2;    // 按理由统计时有效，按插件汇总时为空
+    int64_t     sumIn = 0;  // 流入 (加款) 总额，整数形式 (实际金额 * 100)
+    int64_t     sumOut = 0; // 流出 (扣款) 总额，取正值
+    int64_t     ops = 0;    // 操作次数
+};
+
+/**
+ * @brief 按插件 / 理由统计的资金流向计数器
+ *
+ * 每次余额变动提交后在内存中累加 (货币, reason1) 与 (货币, reason1, reason2) 两级计数，
+ * 读取不需要扫描 economy_log。计数是自启用以来的累计值，定期把有变化的行写入 flow_counters 表，
+ * 启动时从表中加载；插件级计数由理由级的行汇总得到。
+ * 嵌套事务 (保存点) 中的变动在保存点释放时计入，外层事务随后回滚的极少数情况会略微多计。
+ */
+class FlowCounters {
+public:
+    static constexpr const char* OTHER_KEY = "<other>"; // 超出跟踪上限的理由归入该键
+
+    /**
+     * @brief 构造函数
+     * @param dbConn 数据库连接
+     * @param config 配置对象
+     */
+    FlowCounters(db::IDatabaseConnection& dbConn, const Config& config);
+
+    FlowCounters(const FlowCounters&) = delete;
+    FlowCounters& operator=(const FlowCounters&) = delete;
+
+    /**
+     * @brief 创建 flow_counters 表 (如果不存在)，并加载已保存的计数
+     * @return bool 操作是否成功
+     */
+    bool initializeTable();
+
+    /**
+     * @brief 记录一次已提交的余额变动
+     * @param currencyType 货币类型
+     * @param reason1 理由 1 (调用方插件)
+     * @param reason2 理由 2
+     * @param change 变动量 (正数为流入，负数为流出)
+     */
+    void record(const std::string& currencyType, const std::string& reason1, const std::string& reason2, int64_t change);
+
+    /**
+     * @brief 获取计数 (按流入 + 流出总量降序)
+     * @param currencyType 货币类型，为空时返回所有货币
+     * @param byReason true 按 (reason1, reason2) 返回，false 按 reason1 (插件) 汇总
+     */
+    [[nodiscard]] std::vector<FlowCounter> getCounters(const std::string& currencyType, bool byReason) const;
+
+    /**
+     * @brief 把有变化的计数写入数据库
+     * @return size_t 写入的行数
+     */
+    size_t flush();
+
+private:
+    struct Entry {
+        FlowCounter counter;
+        bool        dirty = false;
+    };
+
+    db::IDatabaseConnection& mDbConnection;
+    const Config&            mConfig;
+    ll::io::Logger&          mLogger;
+
+    mutable std::mutex                           mMutex;
+    std::unordered_map<std::string, FlowCounter> mByPlugin; // 键: 货币 + reason1
+    std::unordered_map<std::string, Entry>       mByReason; // 键: 货币 + reason1 + reason2 (持久化的粒度)
+
+    static void addTo(FlowCounter& counter, int64_t change);
+};
+
+} // namespace czmoney
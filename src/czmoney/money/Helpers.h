@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace czmoney {
+
+// 与 economy_log 的 reason 列长度一致
+inline constexpr size_t MAX_REASON_LENGTH = 255;
+
+/**
+ * @brief 按 UTF-8 字符边界截断理由，避免写入 VARCHAR(255) 时超长
+ */
+inline std::string truncateReason(const std::string& reason) {
+    if (reason.size() <= MAX_REASON_LENGTH) {
+        return reason;
+    }
+    size_t length = MAX_REASON_LENGTH;
+    while (length > 0 && (static_cast<unsigned char>(reason[length]) & 0xC0) == 0x80) {
+        --length;
+    }
+    return reason.substr(0, length);
+}
+
+/**
+ * @brief 预处理语句中第 index 个参数的占位符 (PostgreSQL 为 $N，其他数据库为 ?)
+ */
+inline std::string placeholder(const std::string& dbType, int index) {
+    return dbType == "postgresql" ? "$" + std::to_string(index) : "?";
+}
+
+inline constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+/**
+ * @brief FNV-1a 哈希，从 hash 继续累加 value 的字节 (首次调用传入 FNV_OFFSET_BASIS)
+ */
+inline uint64_t fnv1a(uint64_t hash, std::string_view value) {
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief splitmix64 终结函数，使高位分布均匀
+ */
+inline uint64_t mix64(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/**
+ * @brief 跨进程、跨重启稳定的字符串哈希 (FNV-1a + splitmix64)
+ *
+ * 结果会被持久化或在不同连接间比较时使用，不能用 std::hash 代替。
+ */
+inline uint64_t stableHash(std::string_view value) { return mix64(fnv1a(FNV_OFFSET_BASIS, value)); }
+
+} // namespace czmoney
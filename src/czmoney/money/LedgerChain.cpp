@@ -0,0 +1,618 @@
+#include "czmoney/money/LedgerChain.h"
+#include "czmoney/money/Helpers.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <array>
+#include <fmt/format.h>
+#include <random>
+#include <string_view>
+
+namespace czmoney {
+
+namespace {
+
+// --- SHA-256 / HMAC-SHA256 (FIPS 180-4 / RFC 2104) ---
+
+constexpr std::array<uint32_t, 64> SHA256_K = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+using Digest = std::array<uint8_t, 32>;
+
+constexpr uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+class Sha256 {
+public:
+    void update(std::string_view data) {
+        for (char c : data) {
+            mBlock[mBlockLen++] = static_cast<uint8_t>(c);
+            if (mBlockLen == 64) {
+                transform();
+                mBlockLen = 0;
+            }
+        }
+        mTotalLen += data.size();
+    }
+
+    Digest finish() {
+        uint64_t bitLen = mTotalLen * 8;
+        mBlock[mBlockLen++] = 0x80;
+        if (mBlockLen > 56) {
+            std::fill(mBlock.begin() + mBlockLen, mBlock.end(), 0);
+            transform();
+            mBlockLen = 0;
+        }
+        std::fill(mBlock.begin() + mBlockLen, mBlock.begin() + 56, 0);
+        for (int i = 0; i < 8; ++i) {
+            mBlock[63 - i] = static_cast<uint8_t>(bitLen >> (8 * i));
+        }
+        transform();
+
+        Digest digest{};
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                digest[i * 4 + j] = static_cast<uint8_t>(mState[i] >> (24 - 8 * j));
+            }
+        }
+        return digest;
+    }
+
+private:
+    std::array<uint32_t, 8> mState = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::array<uint8_t, 64> mBlock{};
+    size_t                  mBlockLen = 0;
+    uint64_t                mTotalLen = 0;
+
+    void transform() {
+        std::array<uint32_t, 64> w{};
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t(mBlock[i * 4]) << 24) | (uint32_t(mBlock[i * 4 + 1]) << 16)
+                 | (uint32_t(mBlock[i * 4 + 2]) << 8) | uint32_t(mBlock[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i]        = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = mState[0], b = mState[1], c = mState[2], d = mState[3];
+        uint32_t e = mState[4], f = mState[5], g = mState[6], h = mState[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t s1    = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch    = (e & f) ^ (~e & g);
+            uint32_t temp1 = h + s1 + ch + SHA256_K[i] + w[i];
+            uint32_t s0    = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj   = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = s0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+        mState[0] += a;
+        mState[1] += b;
+        mState[2] += c;
+        mState[3] += d;
+        mState[4] += e;
+        mState[5] += f;
+        mState[6] += g;
+        mState[7] += h;
+    }
+};
+
+std::string hmacSha256Hex(std::string_view key, std::string_view message) {
+    std::array<uint8_t, 64> keyBlock{};
+    if (key.size() > keyBlock.size()) {
+        Sha256 keyHash;
+        keyHash.update(key);
+        Digest digest = keyHash.finish();
+        std::copy(digest.begin(), digest.end(), keyBlock.begin());
+    } else {
+        std::copy(key.begin(), key.end(), keyBlock.begin());
+    }
+
+    std::string innerPad(64, '\0');
+    std::string outerPad(64, '\0');
+    for (size_t i = 0; i < 64; ++i) {
+        innerPad[i] = static_cast<char>(keyBlock[i] ^ 0x36);
+        outerPad[i] = static_cast<char>(keyBlock[i] ^ 0x5c);
+    }
+
+    Sha256 inner;
+    inner.update(innerPad);
+    inner.update(message);
+    Digest innerDigest = inner.finish();
+
+    Sha256 outer;
+    outer.update(outerPad);
+    outer.update(std::string_view(reinterpret_cast<const char*>(innerDigest.data()), innerDigest.size()));
+    Digest digest = outer.finish();
+
+    static constexpr char HEX[] = "0123456789abcdef";
+    std::string           hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex.push_back(HEX[byte >> 4]);
+        hex.push_back(HEX[byte & 0x0f]);
+    }
+    return hex;
+}
+
+// 长度前缀编码，避免字段内容中的分隔符造成歧义
+void appendField(std::string& out, std::string_view value) {
+    out += std::to_string(value.size());
+    out += ':';
+    out += value;
+    out += ';';
+}
+
+} // namespace
+
+// --- LedgerChain ---
+
+LedgerChain::LedgerChain(const Config& config) : mConfig(config) {}
+
+std::string LedgerChain::generateSecret() {
+    std::random_device                      rd;
+    std::uniform_int_distribution<uint32_t> dist(0, 255);
+    static constexpr char                   HEX[] = "0123456789abcdef";
+    std::string                             secret;
+    for (int i = 0; i < 32; ++i) {
+        uint32_t byte = dist(rd);
+        secret.push_back(HEX[byte >> 4]);
+        secret.push_back(HEX[byte & 0x0f]);
+    }
+    return secret;
+}
+
+LedgerRow LedgerChain::rowFrom(const db::DbRow& row) {
+    LedgerRow entry;
+    entry.id             = db::toInt64(row[0]).value_or(0);
+    entry.timestamp      = db::toString(row[1]);
+    entry.uuid           = db::toString(row[2]);
+    entry.currencyType   = db::toString(row[3]);
+    entry.changeAmount   = db::toInt64(row[4]).value_or(0);
+    entry.previousAmount = db::toInt64(row[5]).value_or(0);
+    entry.reason1        = db::toString(row[6]);
+    entry.reason2        = db::toString(row[7]);
+    entry.reason3        = db::toString(row[8]);
+    entry.chainHash      = db::toString(row[9]);
+    return entry;
+}
+
+std::string LedgerChain::computeHash(const std::string& prevHash, const LedgerRow& row) const {
+    std::string message;
+    message.reserve(256);
+    appendField(message, prevHash);
+    appendField(message, std::to_string(row.id));
+    appendField(message, row.timestamp);
+    appendField(message, row.uuid);
+    appendField(message, row.currencyType);
+    appendField(message, std::to_string(row.changeAmount));
+    appendField(message, std::to_string(row.previousAmount));
+    appendField(message, row.reason1);
+    appendField(message, row.reason2);
+    appendField(message, row.reason3);
+    return hmacSha256Hex(mConfig.ledgerChain.secret, message);
+}
+
+bool LedgerChain::initializeColumn(db::IDatabaseConnection& conn) {
+    auto& logger = ll::mod::NativeMod::current()->getLogger();
+    try {
+        conn.query("SELECT chain_hash FROM economy_log WHERE 1 = 0;");
+        return true; // 列已存在
+    } catch (const db::DatabaseException&) {
+        // 列不存在，继续添加
+    }
+
+    std::string dbType = conn.getDbType();
+    std::string columnType = dbType == "sqlite" ? "TEXT" : "VARCHAR(64)";
+    try {
+        conn.execute("ALTER TABLE economy_log ADD COLUMN chain_hash " + columnType + " DEFAULT NULL;");
+        logger.info("已为 'economy_log' 表添加 chain_hash 列 (类型: {}).", dbType);
+        return true;
+    } catch (const db::DatabaseException& e) {
+        logger.error("为 'economy_log' 表添加 chain_hash 列失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        logger.error("为 'economy_log' 表添加 chain_hash 列时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+void LedgerChain::sealLatest(db::IDatabaseConnection& conn, const std::string& currencyType) const {
+    std::string dbType = conn.getDbType();
+    std::string p1     = placeholder(dbType, 1);
+
+    // 本事务刚写入的行是该货币 id 最大的行 (所有写入都在主连接上串行进行)
+    db::DbResult latest = conn.queryPrepared(
+        std::string("SELECT ") + ROW_COLUMNS + " FROM economy_log WHERE currency_type = " + p1
+            + " ORDER BY id DESC LIMIT 1;",
+        {currencyType}
+    );
+    if (latest.empty() || latest[0].size() != 10) {
+        throw db::DatabaseException("封存流水失败：找不到刚写入的流水行");
+    }
+    LedgerRow row = rowFrom(latest[0]);
+
+    std::string  prevHash;
+    db::DbResult previous = conn.queryPrepared(
+        "SELECT chain_hash FROM economy_log WHERE currency_type = " + p1 + " AND id < " + placeholder(dbType, 2)
+            + " AND chain_hash IS NOT NULL ORDER BY id DESC LIMIT 1;",
+        {currencyType, row.id}
+    );
+    if (!previous.empty() && !previous[0].empty()) {
+        prevHash = db::toString(previous[0][0]);
+    }
+
+    int affected = conn.executePrepared(
+        "UPDATE economy_log SET chain_hash = " + p1 + " WHERE id = " + placeholder(dbType, 2) + ";",
+        {computeHash(prevHash, row), row.id}
+    );
+    if (affected <= 0) {
+        throw db::DatabaseException(fmt::format("封存流水 #{} 失败：UPDATE 未影响任何行", row.id));
+    }
+}
+
+size_t LedgerChain::sealAfter(db::IDatabaseConnection& conn, const std::string& currencyType, int64_t afterId) const {
+    std::string dbType = conn.getDbType();
+    std::string p1     = placeholder(dbType, 1);
+    std::string p2     = placeholder(dbType, 2);
+
+    std::string  prevHash;
+    db::DbResult previous = conn.queryPrepared(
+        "SELECT chain_hash FROM economy_log WHERE currency_type = " + p1 + " AND id <= " + p2
+            + " AND chain_hash IS NOT NULL ORDER BY id DESC LIMIT 1;",
+        {currencyType, afterId}
+    );
+    if (!previous.empty() && !previous[0].empty()) {
+        prevHash = db::toString(previous[0][0]);
+    }
+
+    db::DbResult rows = conn.queryPrepared(
+        std::string("SELECT ") + ROW_COLUMNS + " FROM economy_log WHERE currency_type = " + p1 + " AND id > " + p2
+            + " ORDER BY id ASC;",
+        {currencyType, afterId}
+    );
+    std::string updateSql = "UPDATE economy_log SET chain_hash = " + p1 + " WHERE id = " + p2 + ";";
+    size_t      sealed    = 0;
+    for (const auto& raw : rows) {
+        if (raw.size() != 10) {
+            continue;
+        }
+        LedgerRow   row  = rowFrom(raw);
+        std::string hash = computeHash(prevHash, row);
+        if (conn.executePrepared(updateSql, {hash, row.id}) <= 0) {
+            throw db::DatabaseException(fmt::format("封存流水 #{} 失败：UPDATE 未影响任何行", row.id));
+        }
+        prevHash = std::move(hash);
+        ++sealed;
+    }
+    return sealed;
+}
+
+// --- LedgerVerifier ---
+
+LedgerVerifier::LedgerVerifier(
+    db::IDatabaseConnection&  mainConn,
+    scheduler::TaskScheduler& scheduler,
+    const Config&             config,
+    ConnectionFactory         connectionFactory
+)
+: mMainConn(mainConn),
+  mScheduler(scheduler),
+  mConfig(config),
+  mConnectionFactory(std::move(connectionFactory)),
+  mChain(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+LedgerVerifier::~LedgerVerifier() { stop(); }
+
+
+bool LedgerVerifier::start() {
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+    }
+    // 回收上一次已结束的工作线程
+    for (auto& worker : mWorkers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    mWorkers.clear();
+
+    int64_t minId = 0;
+    int64_t maxId = 0;
+    try {
+        // 未启用过哈希链时 chain_hash 列不存在，这里会直接失败
+        mMainConn.query("SELECT chain_hash FROM economy_log WHERE 1 = 0;");
+        db::DbResult range = mMainConn.query("SELECT MIN(id), MAX(id) FROM economy_log;");
+        if (!range.empty() && range[0].size() == 2) {
+            minId = db::toInt64(range[0][0]).value_or(0);
+            maxId = db::toInt64(range[0][1]).value_or(0);
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("哈希链校验开始失败 (是否从未启用过 ledgerChain?): {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("哈希链校验开始时发生意外错误: {}", e.what());
+        return false;
+    }
+
+    uint64_t generation = ++mGeneration;
+    mCancelled          = false;
+    mStartedAt          = Clock::now();
+    {
+        std::lock_guard lock(mMutex);
+        mReport         = LedgerVerifyReport{};
+        mReport.running = true;
+    }
+
+    if (maxId <= 0 || maxId < minId) {
+        mActiveWorkers = 1;
+        onWorkerFinished(generation);
+        return true;
+    }
+
+    std::string dbType = mMainConn.getDbType();
+    if (dbType == "sqlite" || !mConnectionFactory) {
+        mActiveWorkers = 1;
+        scheduleMainConnectionChunk(minId - 1, minId - 1, maxId, std::make_shared<ChainHeads>(), generation);
+        mLogger.info("哈希链校验开始 (调度器模式)，流水 id 范围 [{}, {}]", minId, maxId);
+        return true;
+    }
+
+    // 按 id 均分成若干 (lower, upper] 区间，每个工作线程处理一个
+    int64_t span    = maxId - minId + 1;
+    int     threads = static_cast<int>(
+        std::clamp<int64_t>(mConfig.ledgerChain.verifyThreads, 1, std::min<int64_t>(16, span))
+    );
+    mActiveWorkers = threads;
+    int64_t lower  = minId - 1;
+    for (int i = 0; i < threads; ++i) {
+        int64_t upper = (i == threads - 1) ? maxId : minId - 1 + span * (i + 1) / threads;
+        mWorkers.emplace_back([this, lower, upper, generation]() { workerLoop(lower, upper, generation); });
+        lower = upper;
+    }
+    mLogger.info("哈希链校验开始 ({} 个工作线程)，流水 id 范围 [{}, {}]", threads, minId, maxId);
+    return true;
+}
+
+void LedgerVerifier::stop() {
+    mCancelled = true;
+    for (auto& worker : mWorkers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    mWorkers.clear();
+
+    std::lock_guard lock(mMutex);
+    if (mReport.running) {
+        mReport.running   = false;
+        mReport.cancelled = true;
+        mReport.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - mStartedAt).count();
+        mLogger.warn("哈希链校验已取消 (已检查 {} 行)。", mReport.checkedRows);
+    }
+}
+
+bool LedgerVerifier::isRunning() const {
+    std::lock_guard lock(mMutex);
+    return mReport.running;
+}
+
+LedgerVerifyReport LedgerVerifier::getReport() const {
+    std::lock_guard    lock(mMutex);
+    LedgerVerifyReport report = mReport;
+    if (report.running) {
+        report.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - mStartedAt).count();
+    }
+    return report;
+}
+
+bool LedgerVerifier::verifyChunk(
+    db::IDatabaseConnection& conn,
+    int64_t                  lowerId,
+    int64_t&                 cursor,
+    int64_t                  upperId,
+    ChainHeads&              heads
+) {
+    std::string  dbType    = conn.getDbType();
+    int64_t      chunkSize = std::max(1, mConfig.ledgerChain.verifyChunkSize);
+    db::DbResult result    = conn.queryPrepared(
+        std::string("SELECT ") + LedgerChain::ROW_COLUMNS + " FROM economy_log WHERE id > " + placeholder(dbType, 1)
+            + " AND id <= " + placeholder(dbType, 2) + " ORDER BY id LIMIT " + placeholder(dbType, 3) + ";",
+        {cursor, upperId, chunkSize}
+    );
+    if (result.empty()) {
+        return false;
+    }
+
+    std::vector<LedgerBreak> breaks;
+    uint64_t                 checked  = 0;
+    uint64_t                 unsealed = 0;
+    for (const auto& dbRow : result) {
+        if (dbRow.size() != 10) continue;
+        LedgerRow row = LedgerChain::rowFrom(dbRow);
+        cursor        = row.id;
+        ++checked;
+
+        // 本范围内第一次遇到该货币：取范围起点之前最后一条已封存行的哈希作为链头
+        auto head = heads.find(row.currencyType);
+        if (head == heads.end()) {
+            db::DbResult previous = conn.queryPrepared(
+                "SELECT chain_hash FROM economy_log WHERE currency_type = " + placeholder(dbType, 1) + " AND id <= "
+                    + placeholder(dbType, 2) + " AND chain_hash IS NOT NULL ORDER BY id DESC LIMIT 1;",
+                {row.currencyType, lowerId}
+            );
+            std::optional<std::string> prevHash;
+            if (!previous.empty() && !previous[0].empty()) {
+                prevHash = db::toString(previous[0][0]);
+            }
+            head = heads.emplace(row.currencyType, std::move(prevHash)).first;
+        }
+
+        if (row.chainHash.empty()) {
+            if (head->second.has_value()) {
+                breaks.push_back({row.id, row.currencyType, "缺少哈希 (绕过插件写入或哈希被清除)"});
+            } else {
+                ++unsealed; // 链开始之前的旧流水
+            }
+            continue;
+        }
+
+        std::string expected = mChain.computeHash(head->second.value_or(""), row);
+        if (expected != row.chainHash) {
+            breaks.push_back({row.id, row.currencyType, "哈希不匹配 (本行内容被修改，或前一条已封存行被删除/修改)"});
+        }
+        // 继续使用存储的哈希作为链头，使每处篡改只在它所在的位置报告一次
+        head->second = row.chainHash;
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        mReport.checkedRows  += checked;
+        mReport.unsealedRows += unsealed;
+    }
+    if (!breaks.empty()) {
+        recordBreaks(std::move(breaks));
+    }
+    return static_cast<int64_t>(result.size()) >= chunkSize && cursor < upperId;
+}
+
+void LedgerVerifier::recordBreaks(std::vector<LedgerBreak> breaks) {
+    std::lock_guard lock(mMutex);
+    size_t          maxSamples = static_cast<size_t>(std::max(0, mConfig.ledgerChain.maxReportedBreaks));
+    for (auto& brk : breaks) {
+        mLogger.warn("哈希链断裂：流水 #{} ({})：{}", brk.logId, brk.currencyType, brk.reason);
+        mReport.brokenLinks += 1;
+        if (!mReport.firstBreak || brk.logId < mReport.firstBreak->logId) {
+            mReport.firstBreak = brk;
+        }
+        if (mReport.samples.size() < maxSamples) {
+            mReport.samples.push_back(std::move(brk));
+        }
+    }
+}
+
+void LedgerVerifier::workerLoop(int64_t lowerId, int64_t upperId, uint64_t generation) {
+    std::unique_ptr<db::IDatabaseConnection> conn;
+    try {
+        conn = mConnectionFactory();
+        if (!conn || !conn->connect()) {
+            throw std::runtime_error("无法建立工作线程的数据库连接");
+        }
+    } catch (const std::exception& e) {
+        mLogger.error("哈希链校验工作线程 (id {}~{}) 启动失败: {}", lowerId + 1, upperId, e.what());
+        {
+            std::lock_guard lock(mMutex);
+            mReport.errors += 1;
+        }
+        onWorkerFinished(generation);
+        return;
+    }
+
+    ChainHeads heads;
+    int64_t    cursor = lowerId;
+    while (!isStale(generation)) {
+        bool more = false;
+        try {
+            more = verifyChunk(*conn, lowerId, cursor, upperId, heads);
+        } catch (const std::exception& e) {
+            mLogger.error("哈希链校验读取分块 (id > {}) 失败，放弃剩余范围 (至 {}): {}", cursor, upperId, e.what());
+            std::lock_guard lock(mMutex);
+            mReport.errors += 1;
+            break;
+        }
+        if (!more) {
+            break;
+        }
+    }
+
+    try {
+        conn->disconnect();
+    } catch (...) {}
+    onWorkerFinished(generation);
+}
+
+void LedgerVerifier::scheduleMainConnectionChunk(
+    int64_t                     lowerId,
+    int64_t                     cursor,
+    int64_t                     upperId,
+    std::shared_ptr<ChainHeads> heads,
+    uint64_t                    generation
+) {
+    mScheduler.submit(
+        "ledger-verify-chunk",
+        [this, lowerId, cursor, upperId, heads = std::move(heads), generation]() mutable {
+            if (isStale(generation)) {
+                return;
+            }
+            bool more = false;
+            try {
+                more = verifyChunk(mMainConn, lowerId, cursor, upperId, *heads);
+            } catch (const std::exception& e) {
+                mLogger.error("哈希链校验读取分块 (id > {}) 失败，校验提前结束: {}", cursor, e.what());
+                {
+                    std::lock_guard lock(mMutex);
+                    mReport.errors += 1;
+                }
+                onWorkerFinished(generation);
+                return;
+            }
+            if (more) {
+                scheduleMainConnectionChunk(lowerId, cursor, upperId, std::move(heads), generation);
+            } else {
+                onWorkerFinished(generation);
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+void LedgerVerifier::onWorkerFinished(uint64_t generation) {
+    if (generation != mGeneration || --mActiveWorkers > 0) {
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    if (!mReport.running) {
+        return;
+    }
+    mReport.running   = false;
+    mReport.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - mStartedAt).count();
+    if (mReport.firstBreak) {
+        mLogger.error(
+            "哈希链校验完成：检查 {} 行，断链 {} 处，最早的断链位于流水 #{} ({})，耗时 {:.0f}ms",
+            mReport.checkedRows,
+            mReport.brokenLinks,
+            mReport.firstBreak->logId,
+            mReport.firstBreak->currencyType,
+            mReport.elapsedMs
+        );
+    } else {
+        mLogger.info(
+            "哈希链校验完成：检查 {} 行 (链开始前的旧流水 {} 行)，未发现断链，出错分块 {} 个，耗时 {:.0f}ms",
+            mReport.checkedRows,
+            mReport.unsealedRows,
+            mReport.errors,
+            mReport.elapsedMs
+        );
+    }
+}
+
+} // namespace czmoney
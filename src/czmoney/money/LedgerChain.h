@@ -0,0 +1,213 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace czmoney {
+
+// 参与哈希计算的一行流水
+struct LedgerRow {
+    int64_t     id = 0;
+    std::string timestamp;
+    std::string uuid;
+    std::string currencyType;
+    int64_t     changeAmount = 0;
+    int64_t     previousAmount = 0;
+    std::string reason1;
+    std::string reason2;
+    std::string reason3;
+    std::string chainHash; // 为空表示该行未封存 (启用哈希链之前写入，或绕过插件写入)
+};
+
+/**
+ * @brief 流水哈希链 (可选，防篡改)
+ *
+ * 每种货币一条链：新写入的流水行在同一事务中计算
+ * chain_hash = HMAC-SHA256(secret, 同货币上一条已封存行的 chain_hash + 本行内容)，
+ * 不同货币的写入互不依赖，不需要全局串行。
+ * 密钥只保存在配置文件中，只有数据库权限的人修改、删除或插入流水后无法重新计算出正确的哈希。
+ * 注意：只删除链尾的若干行无法仅靠链本身发现。
+ */
+class LedgerChain {
+public:
+    // SELECT 的列顺序，与 rowFrom 保持一致
+    static constexpr const char* ROW_COLUMNS = "id, timestamp, uuid, currency_type, change_amount, previous_amount, "
+                                               "reason1, reason2, reason3, chain_hash";
+
+    /**
+     * @brief 构造函数
+     * @param config 配置对象 (读取 ledgerChain 设置)
+     */
+    explicit LedgerChain(const Config& config);
+
+    /**
+     * @brief 是否为新流水计算哈希
+     */
+    [[nodiscard]] bool isEnabled() const { return mConfig.ledgerChain.enabled; }
+
+    /**
+     * @brief 为 economy_log 添加 chain_hash 列 (如果不存在)
+     * @param conn 数据库连接
+     * @return bool 操作是否成功
+     */
+    bool initializeColumn(db::IDatabaseConnection& conn);
+
+    /**
+     * @brief 封存某货币最新写入的一行流水 (必须与 INSERT 处于同一事务，且在 INSERT 之后调用)
+     * @param conn 写入该行的数据库连接
+     * @param currencyType 货币类型
+     * @throws db::DatabaseException 读取或更新失败时抛出
+     */
+    void sealLatest(db::IDatabaseConnection& conn, const std::string& currencyType) const;
+
+    /**
+     * @brief 按 id 顺序封存 (或重新封存) 某货币 id 大于 afterId 的所有流水，接在 afterId 之前最后一条已封存行之后
+     *
+     * 用于一条语句写入多行流水 (批量调整)，以及恢复备份后重建链尾。
+     * @param conn 数据库连接 (批量写入时必须与 INSERT 处于同一事务)
+     * @param currencyType 货币类型
+     * @param afterId 从该 id 之后开始封存
+     * @return size_t 封存的行数
+     * @throws db::DatabaseException 读取或更新失败时抛出
+     */
+    size_t sealAfter(db::IDatabaseConnection& conn, const std::string& currencyType, int64_t afterId) const;
+
+    /**
+     * @brief 计算一行流水的链式哈希
+     * @param prevHash 同货币上一条已封存行的哈希 (链首为空字符串)
+     * @param row 流水内容 (忽略 row.chainHash)
+     * @return std::string 十六进制小写哈希
+     */
+    [[nodiscard]] std::string computeHash(const std::string& prevHash, const LedgerRow& row) const;
+
+    /**
+     * @brief 生成新的随机密钥 (十六进制)
+     */
+    static std::string generateSecret();
+
+    static LedgerRow rowFrom(const db::DbRow& row);
+
+private:
+    const Config& mConfig;
+};
+
+// 校验发现的一处断链
+struct LedgerBreak {
+    int64_t     logId = 0;
+    std::string currencyType;
+    std::string reason;
+};
+
+// 哈希链校验的进度与结果
+struct LedgerVerifyReport {
+    bool                       running = false;
+    bool                       cancelled = false;
+    uint64_t                   checkedRows = 0;   // 读取的流水行数
+    uint64_t                   unsealedRows = 0;  // 链开始之前的未封存行 (启用哈希链之前写入)
+    uint64_t                   brokenLinks = 0;
+    uint64_t                   errors = 0;        // 出错的分块数量
+    double                     elapsedMs = 0;
+    std::optional<LedgerBreak> firstBreak;        // id 最小的断链，即最早被篡改的位置
+    std::vector<LedgerBreak>   samples;           // 最多保留 maxReportedBreaks 条
+};
+
+/**
+ * @brief 哈希链并行校验器
+ *
+ * 每行存有自己的哈希，校验第 i 行只需要同货币上一条已封存行的哈希，不依赖重新计算整条链，
+ * 因此可以把 economy_log 按 id 切成若干范围并行校验，最后取 id 最小的断链作为第一处被篡改的位置。
+ * - MySQL / PostgreSQL：每个工作线程使用独立的只读连接。
+ * - SQLite：与对账相同，在后台任务调度器中使用主连接逐块处理。
+ */
+class LedgerVerifier {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (只在服务器线程上使用)
+     * @param scheduler 后台任务调度器
+     * @param config 配置对象
+     * @param connectionFactory 为工作线程创建独立连接的工厂
+     */
+    LedgerVerifier(
+        db::IDatabaseConnection&  mainConn,
+        scheduler::TaskScheduler& scheduler,
+        const Config&             config,
+        ConnectionFactory         connectionFactory
+    );
+    ~LedgerVerifier();
+
+    LedgerVerifier(const LedgerVerifier&) = delete;
+    LedgerVerifier& operator=(const LedgerVerifier&) = delete;
+
+    /**
+     * @brief 开始一次校验
+     * @return bool 是否成功开始 (已有校验在运行或无法读取流水范围时返回 false)
+     */
+    bool start();
+
+    /**
+     * @brief 取消正在运行的校验，并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 是否有校验在运行
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 校验的进度与结果
+     */
+    [[nodiscard]] LedgerVerifyReport getReport() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    // 货币类型 -> 上一条已封存行的哈希 (std::nullopt 表示该货币的链在此之前尚未开始)
+    using ChainHeads = std::unordered_map<std::string, std::optional<std::string>>;
+
+    db::IDatabaseConnection&  mMainConn;
+    scheduler::TaskScheduler& mScheduler;
+    const Config&             mConfig;
+    ConnectionFactory         mConnectionFactory;
+    LedgerChain               mChain;
+    ll::io::Logger&           mLogger;
+
+    mutable std::mutex       mMutex; // 保护 mReport
+    LedgerVerifyReport       mReport;
+    Clock::time_point        mStartedAt;
+    std::atomic<bool>        mCancelled{false};
+    std::atomic<uint64_t>    mGeneration{0}; // 每次 start 递增，旧任务据此自行退出
+    std::atomic<int>         mActiveWorkers{0};
+    std::vector<std::thread> mWorkers;
+
+    // 校验 (cursor, upperId] 范围内的下一块流水，返回是否还有剩余
+    bool verifyChunk(db::IDatabaseConnection& conn, int64_t lowerId, int64_t& cursor, int64_t upperId, ChainHeads& heads);
+    void workerLoop(int64_t lowerId, int64_t upperId, uint64_t generation);
+    void scheduleMainConnectionChunk(
+        int64_t                     lowerId,
+        int64_t                     cursor,
+        int64_t                     upperId,
+        std::shared_ptr<ChainHeads> heads,
+        uint64_t                    generation
+    );
+    void recordBreaks(std::vector<LedgerBreak> breaks);
+    void onWorkerFinished(uint64_t generation);
+    bool isStale(uint64_t generation) const { return mCancelled || generation != mGeneration; }
+};
+
+} // namespace czmoney
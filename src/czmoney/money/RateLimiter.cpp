@@ -0,0 +1,151 @@
+#include "czmoney/money/RateLimiter.h"
+#include <algorithm>
+
+namespace czmoney {
+
+RateLimiter::RateLimiter(const RateLimitConfig& config) : mConfig(config) {}
+
+void RateLimiter::evictIdle(BucketMap& buckets, double capacity, double refillPerSecond, Clock::time_point now) {
+    // 已经回满的桶与新建的桶等价，可以安全删除
+    for (auto it = buckets.begin(); it != buckets.end();) {
+        double elapsed = std::chrono::duration<double>(now - it->second.lastRefill).count();
+        if (it->second.tokens + elapsed * refillPerSecond >= capacity) {
+            it = buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RateLimiter::evictOldest(BucketMap& buckets, size_t count) {
+    if (count == 0 || buckets.empty()) {
+        return;
+    }
+    count = std::min(count, buckets.size());
+    std::vector<std::pair<Clock::time_point, const std::string*>> order;
+    order.reserve(buckets.size());
+    for (const auto& [key, bucket] : buckets) {
+        order.emplace_back(bucket.lastRefill, &key);
+    }
+    std::nth_element(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(count - 1), order.end());
+    // 先复制键再删除，避免删除时指针失效
+    std::vector<std::string> victims;
+    victims.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        victims.push_back(*order[i].second);
+    }
+    for (const auto& key : victims) {
+        buckets.erase(key);
+    }
+}
+
+RateLimiter::Bucket* RateLimiter::refilledBucket(RateLimitScope scope, const std::string& key, Clock::time_point now) {
+    bool       isPlayer   = scope == RateLimitScope::Player;
+    BucketMap& buckets    = isPlayer ? mPlayerBuckets : mPluginBuckets;
+    double     capacity   = isPlayer ? mConfig.playerBurst : mConfig.pluginBurst;
+    double     refillRate = isPlayer ? mConfig.playerPerSecond : mConfig.pluginPerSecond;
+
+    // 容量不大于 0 视为该维度不限流
+    if (capacity <= 0.0) {
+        return nullptr;
+    }
+
+    // 桶数量达到上限时先清理空闲桶 (每秒最多一次)；仍然放不下时淘汰最久未使用的 1/8，
+    // 一次淘汰一批使扫描的开销分摊到后续的插入上。正在被限流的桶刚刚被访问过，不会先被淘汰
+    if (mConfig.maxTrackedKeys > 0 && buckets.size() >= static_cast<size_t>(mConfig.maxTrackedKeys)
+        && !buckets.contains(key)) {
+        if (now - mLastEviction >= std::chrono::seconds(1)) {
+            evictIdle(buckets, capacity, refillRate, now);
+            mLastEviction = now;
+        }
+        if (buckets.size() >= static_cast<size_t>(mConfig.maxTrackedKeys)) {
+            evictOldest(buckets, std::max<size_t>(1, buckets.size() / 8));
+        }
+    }
+
+    auto [it, inserted] = buckets.try_emplace(key, Bucket{capacity, now});
+    Bucket& bucket      = it->second;
+    if (!inserted) {
+        // 按距离上次补充经过的时间补充令牌，最多补满
+        double elapsed    = std::chrono::duration<double>(now - bucket.lastRefill).count();
+        bucket.tokens     = std::min(capacity, bucket.tokens + elapsed * std::max(0.0, refillRate));
+        bucket.lastRefill = now;
+    }
+    return &bucket;
+}
+
+bool RateLimiter::reject(Bucket& bucket, bool* firstRejection) {
+    if (firstRejection) {
+        *firstRejection = !bucket.rejecting;
+    }
+    bucket.rejecting = true;
+    return false;
+}
+
+bool RateLimiter::tryAcquire(RateLimitScope scope, const std::string& key, bool* firstRejection) {
+    if (!mConfig.enabled) {
+        return true;
+    }
+
+    const auto      now = Clock::now();
+    std::lock_guard lock(mMutex);
+
+    Bucket* bucket = refilledBucket(scope, key, now);
+    if (!bucket) {
+        return true;
+    }
+    if (bucket->tokens < 1.0) {
+        ++mRejected;
+        return reject(*bucket, firstRejection);
+    }
+    bucket->tokens    -= 1.0;
+    bucket->rejecting  = false;
+    return true;
+}
+
+bool RateLimiter::tryAcquireBoth(
+    const std::string& playerKey,
+    const std::string& pluginKey,
+    RateLimitScope*    rejectedScope,
+    bool*              firstRejection
+) {
+    if (!mConfig.enabled) {
+        return true;
+    }
+
+    const auto      now = Clock::now();
+    std::lock_guard lock(mMutex);
+
+    // 两个桶都检查完再扣除，被拒绝的操作不消耗另一个桶的令牌
+    Bucket* player = refilledBucket(RateLimitScope::Player, playerKey, now);
+    Bucket* plugin = refilledBucket(RateLimitScope::Plugin, pluginKey, now);
+    for (auto [bucket, scope] : {std::pair{player, RateLimitScope::Player}, std::pair{plugin, RateLimitScope::Plugin}}) {
+        if (bucket && bucket->tokens < 1.0) {
+            if (rejectedScope) {
+                *rejectedScope = scope;
+            }
+            ++mRejected;
+            return reject(*bucket, firstRejection);
+        }
+    }
+    for (Bucket* bucket : {player, plugin}) {
+        if (bucket) {
+            bucket->tokens    -= 1.0;
+            bucket->rejecting  = false;
+        }
+    }
+    return true;
+}
+
+void RateLimiter::reset() {
+    std::lock_guard lock(mMutex);
+    mPlayerBuckets.clear();
+    mPluginBuckets.clear();
+}
+
+uint64_t RateLimiter::getRejectedCount() const {
+    std::lock_guard lock(mMutex);
+    return mRejected;
+}
+
+} // namespace czmoney
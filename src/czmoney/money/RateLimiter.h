@@ -0,0 +1,100 @@
+#pragma once
+
+#include "czmoney/config.h" // 包含 RateLimitConfig
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace czmoney {
+
+// 限流维度
+enum class RateLimitScope {
+    Player, // 按发起操作的玩家 UUID 限流
+    Plugin  // 按调用方插件 (API 的 reason1) 限流
+};
+
+/**
+ * @brief 令牌桶限流器
+ *
+ * 每个玩家 / 每个调用插件各自拥有一个令牌桶，写操作在访问数据库前消耗一个令牌。
+ * 桶按需创建，检查只涉及一次哈希查找和少量算术，为 O(1)。
+ * 桶数量达到上限时，先清除已经回满 (即近期没有活动) 的桶，仍然放不下时淘汰最久未使用的一批桶，
+ * 新的玩家/调用方总能得到自己的桶。
+ */
+class RateLimiter {
+public:
+    /**
+     * @brief 构造函数
+     * @param config 限流配置的引用
+     */
+    explicit RateLimiter(const RateLimitConfig& config);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /**
+     * @brief 尝试从指定的令牌桶中取出一个令牌
+     * @param scope 限流维度
+     * @param key 桶的键 (玩家 UUID 或插件名)
+     * @param[out] firstRejection 被拒绝时，如果这是该桶自上次放行以来的第一次拒绝则置为 true (用于只记录一条警告)
+     * @return bool 取到令牌返回 true；桶已空 (应拒绝本次操作) 返回 false
+     */
+    bool tryAcquire(RateLimitScope scope, const std::string& key, bool* firstRejection = nullptr);
+
+    /**
+     * @brief 同时从玩家桶和调用方桶各取一个令牌
+     *
+     * 先检查两个桶，都有令牌时才同时扣除；任一个桶为空都不扣除另一个桶的令牌。
+     * @param playerKey 玩家 UUID
+     * @param pluginKey 调用方插件名
+     * @param[out] rejectedScope 被拒绝时写入拒绝的维度 (两个桶都为空时为 Player)
+     * @param[out] firstRejection 被拒绝时，如果这是该桶自上次放行以来的第一次拒绝则置为 true
+     * @return bool 两个桶都取到令牌返回 true，否则返回 false
+     */
+    bool tryAcquireBoth(
+        const std::string& playerKey,
+        const std::string& pluginKey,
+        RateLimitScope*    rejectedScope  = nullptr,
+        bool*              firstRejection = nullptr
+    );
+
+    /**
+     * @brief 清空所有令牌桶 (例如重载配置后)
+     */
+    void reset();
+
+    /**
+     * @brief 累计被拒绝的请求数
+     */
+    [[nodiscard]] uint64_t getRejectedCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Bucket {
+        double            tokens;
+        Clock::time_point lastRefill;
+        bool              rejecting = false; // 自上次放行以来是否已经拒绝过
+    };
+
+    using BucketMap = std::unordered_map<std::string, Bucket>;
+
+    const RateLimitConfig& mConfig;
+    mutable std::mutex     mMutex;
+    BucketMap              mPlayerBuckets;
+    BucketMap              mPluginBuckets;
+    uint64_t               mRejected = 0;
+    Clock::time_point      mLastEviction{};
+
+    // 找到 (必要时创建) 桶并补充令牌；该维度不限流时返回 nullptr。调用时必须持有 mMutex
+    Bucket*     refilledBucket(RateLimitScope scope, const std::string& key, Clock::time_point now);
+    static bool reject(Bucket& bucket, bool* firstRejection);
+    static void evictIdle(BucketMap& buckets, double capacity, double refillPerSecond, Clock::time_point now);
+    static void evictOldest(BucketMap& buckets, size_t count);
+};
+
+} // namespace czmoney
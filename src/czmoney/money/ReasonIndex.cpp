@@ -0,0 +1,317 @@
+#include "czmoney/money/ReasonIndex.h"
+#include "czmoney/money/money.h"
+#include "ll/api/mod/NativeMod.h"
+#include <stdexcept>
+
+namespace czmoney {
+
+namespace {
+constexpr const char* REASON_COLUMNS[] = {"reason1", "reason2", "reason3"};
+
+// SQLite 每个调度任务补建的流水行数
+constexpr int64_t BACKFILL_CHUNK_ROWS = 2000;
+
+// 在连接上创建索引结构，返回索引是否已完整
+bool prepareIndex(db::IDatabaseConnection& conn, size_t& ngramTokenSize) {
+    std::string dbType = conn.getDbType();
+    if (dbType == "sqlite") {
+        // 外部内容 FTS5 表只保存 trigram 倒排索引，不复制流水内容；由触发器与 economy_log 保持同步
+        db::DbResult existing =
+            conn.query("SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'economy_log_fts';");
+        db::ScopedTransaction transaction(conn);
+        conn.execute(R"(
+            CREATE VIRTUAL TABLE IF NOT EXISTS economy_log_fts USING fts5(
+                reason1, reason2, reason3,
+                content = 'economy_log', content_rowid = 'id', tokenize = 'trigram'
+            );
+        )");
+        // 补建进度：(cursor, upper_id] 范围内的已有流水尚未进入索引，补建完成后删除该行
+        conn.execute(R"(
+            CREATE TABLE IF NOT EXISTS economy_log_fts_backfill (
+                id INTEGER PRIMARY KEY CHECK (id = 1),
+                cursor INTEGER NOT NULL,
+                upper_id INTEGER NOT NULL
+            );
+        )");
+        if (existing.empty()) {
+            conn.execute(
+                "INSERT INTO economy_log_fts_backfill (id, cursor, upper_id) "
+                "SELECT 1, 0, COALESCE(MAX(id), 0) FROM economy_log;"
+            );
+        }
+        // 新流水由触发器直接写入索引；删除/修改尚未补建的旧流水时跳过，避免从索引中删除不存在的词元
+        conn.execute(R"(
+            CREATE TRIGGER IF NOT EXISTS economy_log_fts_ai AFTER INSERT ON economy_log BEGIN
+                INSERT INTO economy_log_fts (rowid, reason1, reason2, reason3)
+                VALUES (new.id, new.reason1, new.reason2, new.reason3);
+            END;
+        )");
+        conn.execute(R"(
+            CREATE TRIGGER IF NOT EXISTS economy_log_fts_ad AFTER DELETE ON economy_log
+            WHEN NOT EXISTS (SELECT 1 FROM economy_log_fts_backfill WHERE old.id > cursor AND old.id <= upper_id) BEGIN
+                INSERT INTO economy_log_fts (economy_log_fts, rowid, reason1, reason2, reason3)
+                VALUES ('delete', old.id, old.reason1, old.reason2, old.reason3);
+            END;
+        )");
+        conn.execute(R"(
+            CREATE TRIGGER IF NOT EXISTS economy_log_fts_au AFTER UPDATE OF reason1, reason2, reason3 ON economy_log
+            WHEN NOT EXISTS (SELECT 1 FROM economy_log_fts_backfill WHERE old.id > cursor AND old.id <= upper_id) BEGIN
+                INSERT INTO economy_log_fts (economy_log_fts, rowid, reason1, reason2, reason3)
+                VALUES ('delete', old.id, old.reason1, old.reason2, old.reason3);
+                INSERT INTO economy_log_fts (rowid, reason1, reason2, reason3)
+                VALUES (new.id, new.reason1, new.reason2, new.reason3);
+            END;
+        )");
+        transaction.commit();
+        db::DbResult pending = conn.query("SELECT COUNT(*) FROM economy_log_fts_backfill;");
+        return pending.empty() || pending[0].empty() || db::toInt64(pending[0][0]).value_or(0) == 0;
+    } else if (dbType == "postgresql") {
+        // pg_trgm 的 GIN 索引可以直接服务 LIKE '%...%'，由查询规划器自动选用
+        db::DbResult valid = conn.query(
+            "SELECT COUNT(*) FROM pg_index i JOIN pg_class c ON c.oid = i.indexrelid "
+            "WHERE c.relname IN ('idx_economy_log_reason1_trgm', 'idx_economy_log_reason2_trgm', "
+            "'idx_economy_log_reason3_trgm') AND i.indisvalid;"
+        );
+        return !valid.empty() && !valid[0].empty() && db::toInt64(valid[0][0]).value_or(0) == 3;
+    } else if (dbType == "mysql") {
+        db::DbResult tokenSize = conn.query("SELECT @@ngram_token_size;");
+        if (!tokenSize.empty() && !tokenSize[0].empty()) {
+            int64_t size    = db::toInt64(tokenSize[0][0]).value_or(2);
+            ngramTokenSize = size > 0 ? static_cast<size_t>(size) : 2;
+        }
+        db::DbResult exists = conn.query(
+            "SELECT COUNT(DISTINCT INDEX_NAME) FROM information_schema.STATISTICS WHERE TABLE_SCHEMA = DATABASE() "
+            "AND TABLE_NAME = 'economy_log' AND INDEX_NAME IN ('ft_economy_log_reason1', 'ft_economy_log_reason2', "
+            "'ft_economy_log_reason3');"
+        );
+        return !exists.empty() && !exists[0].empty() && db::toInt64(exists[0][0]).value_or(0) == 3;
+    }
+    throw std::runtime_error("不支持的数据库类型: " + dbType);
+}
+
+// SQLite：补建下一块已有流水，返回是否还有剩余
+bool runBackfillChunk(db::IDatabaseConnection& conn) {
+    db::DbResult progress = conn.query("SELECT cursor, upper_id FROM economy_log_fts_backfill WHERE id = 1;");
+    if (progress.empty() || progress[0].size() != 2) {
+        return false;
+    }
+    int64_t cursor  = db::toInt64(progress[0][0]).value_or(0);
+    int64_t upperId = db::toInt64(progress[0][1]).value_or(0);
+
+    // 本块的结束 id；区间内已没有流水时直接推进到 upper_id
+    db::DbResult last = conn.queryPrepared(
+        "SELECT MAX(id) FROM (SELECT id FROM economy_log WHERE id > ? AND id <= ? ORDER BY id LIMIT ?);",
+        {cursor, upperId, BACKFILL_CHUNK_ROWS}
+    );
+    int64_t next = upperId;
+    if (!last.empty() && !last[0].empty()) {
+        next = db::toInt64(last[0][0]).value_or(upperId);
+    }
+
+    db::ScopedTransaction transaction(conn);
+    conn.executePrepared(
+        "INSERT INTO economy_log_fts (rowid, reason1, reason2, reason3) "
+        "SELECT id, reason1, reason2, reason3 FROM economy_log WHERE id > ? AND id <= ?;",
+        {cursor, next}
+    );
+    if (next >= upperId) {
+        conn.execute("DELETE FROM economy_log_fts_backfill;");
+    } else {
+        conn.executePrepared("UPDATE economy_log_fts_backfill SET cursor = ? WHERE id = 1;", {next});
+    }
+    transaction.commit();
+    return next < upperId;
+}
+
+// MySQL：建立 ngram 全文索引 (耗时很长，不能在服务器线程上调用)
+void buildMysqlIndexes(db::IDatabaseConnection& conn, ll::io::Logger& logger, const std::atomic<bool>& cancelled) {
+    for (const char* column : REASON_COLUMNS) {
+        if (cancelled) {
+            throw std::runtime_error("已取消");
+        }
+        std::string  indexName = std::string("ft_economy_log_") + column;
+        db::DbResult exists    = conn.queryPrepared(
+            "SELECT COUNT(*) FROM information_schema.STATISTICS WHERE TABLE_SCHEMA = DATABASE() "
+            "AND TABLE_NAME = 'economy_log' AND INDEX_NAME = ?;",
+            {indexName}
+        );
+        if (!exists.empty() && !exists[0].empty() && db::toInt64(exists[0][0]).value_or(0) > 0) {
+            continue;
+        }
+        logger.info("正在为流水的 {} 列建立全文索引...", column);
+        // 索引建立时记录停用词设置；默认的英文停用词会使 ngram 丢弃包含单个字母停用词的词元，
+        // 导致子串匹配漏行，因此在本会话中关闭停用词后再建立索引，无论成功与否都恢复
+        conn.execute("SET SESSION innodb_ft_enable_stopword = OFF;");
+        try {
+            conn.execute(
+                "ALTER TABLE economy_log ADD FULLTEXT INDEX " + indexName + " (" + column + ") WITH PARSER ngram;"
+            );
+        } catch (...) {
+            (void)conn.tryExecute("SET SESSION innodb_ft_enable_stopword = ON;");
+            throw;
+        }
+        conn.execute("SET SESSION innodb_ft_enable_stopword = ON;");
+    }
+}
+
+// PostgreSQL：建立 pg_trgm 索引 (不阻塞写入，但同样耗时很长)
+void buildPostgresIndexes(db::IDatabaseConnection& conn, const std::atomic<bool>& cancelled) {
+    conn.execute("CREATE EXTENSION IF NOT EXISTS pg_trgm;");
+    for (const char* column : REASON_COLUMNS) {
+        if (cancelled) {
+            throw std::runtime_error("已取消");
+        }
+        std::string indexName = std::string("idx_economy_log_") + column + "_trgm";
+        // 中断的 CONCURRENTLY 构建会留下无效索引，IF NOT EXISTS 会跳过它，因此先删除
+        db::DbResult invalid = conn.queryPrepared(
+            "SELECT 1 FROM pg_index i JOIN pg_class c ON c.oid = i.indexrelid WHERE c.relname = $1 AND NOT i.indisvalid;",
+            {indexName}
+        );
+        if (!invalid.empty()) {
+            conn.execute("DROP INDEX CONCURRENTLY IF EXISTS " + indexName + ";");
+        }
+        conn.execute(
+            "CREATE INDEX CONCURRENTLY IF NOT EXISTS " + indexName + " ON economy_log USING GIN (" + column
+            + " gin_trgm_ops);"
+        );
+    }
+}
+} // namespace
+
+ReasonIndexBuilder::ReasonIndexBuilder(
+    db::IDatabaseConnection&  mainConn,
+    scheduler::TaskScheduler& scheduler,
+    MoneyManager&             moneyManager,
+    ConnectionFactory         connectionFactory
+)
+: mMainConn(mainConn),
+  mScheduler(scheduler),
+  mMoneyManager(moneyManager),
+  mConnectionFactory(std::move(connectionFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+ReasonIndexBuilder::~ReasonIndexBuilder() { stop(); }
+
+void ReasonIndexBuilder::start() {
+    std::string dbType = mMainConn.getDbType();
+    try {
+        if (prepareIndex(mMainConn, mNgramTokenSize)) {
+            markReady();
+            return;
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.warn("创建流水理由全文索引失败，按理由查询流水将使用全表扫描: {}", e.what());
+        return;
+    } catch (const std::exception& e) {
+        mLogger.warn("创建流水理由全文索引时发生意外错误，按理由查询流水将使用全表扫描: {}", e.what());
+        return;
+    }
+
+    mCancelled = false;
+    if (dbType == "sqlite" || !mConnectionFactory) {
+        mLogger.info("正在后台为已有流水建立理由全文索引，完成前按理由查询仍使用全表扫描。");
+        scheduleBackfillChunk();
+        return;
+    }
+    mLogger.info("正在后台建立流水理由全文索引 (类型: {})，完成前按理由查询仍使用全表扫描。", dbType);
+    mWorker = std::thread([this]() { workerMain(); });
+}
+
+void ReasonIndexBuilder::stop() {
+    mCancelled = true;
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+}
+
+// 每个任务只补建一块，仍有剩余时重新提交
+void ReasonIndexBuilder::scheduleBackfillChunk() {
+    mScheduler.submit(
+        "reason-index-backfill",
+        [this]() {
+            if (mCancelled) {
+                return;
+            }
+            try {
+                if (runBackfillChunk(mMainConn)) {
+                    scheduleBackfillChunk();
+                    return;
+                }
+            } catch (const db::DatabaseException& e) {
+                mLogger.warn("补建流水理由全文索引失败，下次启动时继续: {}", e.what());
+                return;
+            } catch (const std::exception& e) {
+                mLogger.warn("补建流水理由全文索引时发生意外错误，下次启动时继续: {}", e.what());
+                return;
+            }
+            markReady();
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+void ReasonIndexBuilder::workerMain() {
+    std::unique_ptr<db::IDatabaseConnection> conn;
+    try {
+        conn = mConnectionFactory();
+        if (!conn || !conn->connect()) {
+            throw std::runtime_error("无法建立工作线程的数据库连接");
+        }
+        if (conn->getDbType() == "mysql") {
+            buildMysqlIndexes(*conn, mLogger, mCancelled);
+        } else {
+            buildPostgresIndexes(*conn, mCancelled);
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.warn("创建流水理由全文索引失败，按理由查询流水将使用全表扫描: {}", e.what());
+        return;
+    } catch (const std::exception& e) {
+        mLogger.warn("创建流水理由全文索引时发生意外错误，按理由查询流水将使用全表扫描: {}", e.what());
+        return;
+    }
+    try {
+        conn->disconnect();
+    } catch (...) {}
+
+    if (!mCancelled) {
+        mScheduler.submit("reason-index-ready", [this]() {
+            if (!mCancelled) {
+                markReady();
+            }
+        });
+    }
+}
+
+bool ReasonIndexBuilder::buildNow(db::IDatabaseConnection& conn, MoneyManager& moneyManager) {
+    ll::io::Logger&   logger = ll::mod::NativeMod::current()->getLogger();
+    std::atomic<bool> cancelled{false};
+    try {
+        size_t ngramTokenSize = 2;
+        if (!prepareIndex(conn, ngramTokenSize)) {
+            std::string dbType = conn.getDbType();
+            if (dbType == "sqlite") {
+                while (runBackfillChunk(conn)) {}
+            } else if (dbType == "mysql") {
+                buildMysqlIndexes(conn, logger, cancelled);
+            } else {
+                buildPostgresIndexes(conn, cancelled);
+            }
+        }
+        moneyManager.enableReasonIndex(ngramTokenSize);
+        return true;
+    } catch (const db::DatabaseException& e) {
+        logger.warn("创建流水理由全文索引失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        logger.warn("创建流水理由全文索引时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+void ReasonIndexBuilder::markReady() {
+    mReady = true;
+    mMoneyManager.enableReasonIndex(mNgramTokenSize);
+    mLogger.info("流水理由全文索引已就绪 (类型: {}).", mMainConn.getDbType());
+}
+
+} // namespace czmoney
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "czmoney/database_interface.h"
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace czmoney {
+
+class MoneyManager;
+
+/**
+ * @brief 流水理由全文索引的后台构建器
+ *
+ * 在已有大量流水的库上建立索引可能需要很久，不能阻塞插件启用。
+ * prepare() 只在主连接上创建空的索引结构 (很快)；索引完整前 MoneyManager 的按理由查询继续使用 LIKE，
+ * 构建完成后在服务器线程上通知 MoneyManager 改用索引。
+ * - SQLite：外部内容 FTS5 表由触发器同步新流水，已有流水由调度器在主连接上逐块补建
+ *   (其他连接的读锁会让服务器的写入直接失败)，进度保存在 economy_log_fts_backfill 中，重启后继续。
+ * - MySQL：在独立连接的工作线程上执行 ALTER TABLE ... ADD FULLTEXT。
+ * - PostgreSQL：在独立连接的工作线程上执行 CREATE INDEX CONCURRENTLY，不阻塞写入。
+ */
+class ReasonIndexBuilder {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (只在服务器线程上使用)
+     * @param scheduler 后台任务调度器
+     * @param moneyManager 索引就绪后需要通知的经济管理器
+     * @param connectionFactory 为工作线程创建独立连接的工厂
+     */
+    ReasonIndexBuilder(
+        db::IDatabaseConnection&  mainConn,
+        scheduler::TaskScheduler& scheduler,
+        MoneyManager&             moneyManager,
+        ConnectionFactory         connectionFactory
+    );
+    ~ReasonIndexBuilder();
+
+    ReasonIndexBuilder(const ReasonIndexBuilder&) = delete;
+    ReasonIndexBuilder& operator=(const ReasonIndexBuilder&) = delete;
+
+    /**
+     * @brief 创建索引结构；索引已完整时立即通知 MoneyManager，否则开始后台构建
+     */
+    void start();
+
+    /**
+     * @brief 取消后台构建，并等待工作线程退出 (正在执行的 DDL 无法中断，会等待其完成)
+     */
+    void stop();
+
+    /**
+     * @brief 索引是否已可用
+     */
+    [[nodiscard]] bool isReady() const { return mReady; }
+
+    /**
+     * @brief 在给定连接上同步建立完整索引，完成后通知 MoneyManager
+     *
+     * 供回放目标库等不服务玩家的独立连接在工作线程上使用，调用线程会一直阻塞到索引建立完成。
+     * @return bool 索引是否可用
+     */
+    static bool buildNow(db::IDatabaseConnection& conn, MoneyManager& moneyManager);
+
+private:
+    db::IDatabaseConnection&  mMainConn;
+    scheduler::TaskScheduler& mScheduler;
+    MoneyManager&             mMoneyManager;
+    ConnectionFactory         mConnectionFactory;
+    ll::io::Logger&           mLogger;
+
+    std::atomic<bool> mCancelled{false};
+    std::atomic<bool> mReady{false};
+    size_t            mNgramTokenSize = 2; // MySQL ngram 分词长度 (prepare 时读取)
+    std::thread       mWorker;
+
+    void scheduleBackfillChunk();
+    // MySQL / PostgreSQL：在工作线程的连接上建立索引
+    void workerMain();
+    void markReady();
+};
+
+} // namespace czmoney
@@ -0,0 +1,516 @@
+#include "czmoney/money/Reconciliation.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/money.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace czmoney {
+
+namespace {
+std::string accountKey(const std::string& uuid, const std::string& currencyType) { return uuid + ":" + currencyType; }
+} // namespace
+
+ReconciliationEngine::ReconciliationEngine(
+    db::IDatabaseConnection&  mainConn,
+    scheduler::TaskScheduler& scheduler,
+    const Config&             config,
+    ConnectionFactory         connectionFactory
+)
+: mMainConn(mainConn),
+  mScheduler(scheduler),
+  mConfig(config),
+  mConnectionFactory(std::move(connectionFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()),
+  mLedgerChain(config) {}
+
+ReconciliationEngine::~ReconciliationEngine() { stop(); }
+
+size_t ReconciliationEngine::inListLimit(const std::string& dbType) {
+    if (dbType == "sqlite") {
+        return 900; // 低于 SQLITE_MAX_VARIABLE_NUMBER 的默认值 999，留出余量
+    }
+    return 10000;
+}
+
+bool ReconciliationEngine::start(bool repair) {
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+    }
+    // 回收上一次已结束的工作线程
+    for (auto& worker : mWorkers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    mWorkers.clear();
+
+    int64_t minId = 0;
+    int64_t maxId = 0;
+    try {
+        db::DbResult range = mMainConn.query("SELECT MIN(id), MAX(id) FROM player_balances;");
+        if (!range.empty() && range[0].size() == 2) {
+            minId = db::toInt64(range[0][0]).value_or(0);
+            maxId = db::toInt64(range[0][1]).value_or(0);
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("对账开始失败，无法读取账户范围: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("对账开始时发生意外错误: {}", e.what());
+        return false;
+    }
+
+    uint64_t generation = ++mGeneration;
+    mCancelled          = false;
+    mStartedAt          = Clock::now();
+    {
+        std::lock_guard lock(mMutex);
+        mReport         = ReconcileReport{};
+        mReport.running = true;
+        mReport.repair  = repair;
+    }
+
+    if (maxId <= 0 || maxId < minId) {
+        mActiveWorkers = 1;
+        onWorkerFinished(generation);
+        return true;
+    }
+
+    const auto& cfg    = mConfig.reconciliation;
+    std::string dbType = mMainConn.getDbType();
+    if (dbType == "sqlite" || !mConnectionFactory) {
+        mActiveWorkers = 1;
+        scheduleMainConnectionChunk(minId - 1, maxId, generation);
+        mLogger.info("对账开始 (调度器模式，{})，账户 id 范围 [{}, {}]", repair ? "修复" : "只读", minId, maxId);
+        return true;
+    }
+
+    // 按 id 均分成若干 (lower, upper] 区间，每个工作线程处理一个
+    int64_t span    = maxId - minId + 1;
+    int     threads = static_cast<int>(std::clamp<int64_t>(cfg.workerThreads, 1, std::min<int64_t>(16, span)));
+    mActiveWorkers  = threads;
+    int64_t lower   = minId - 1;
+    for (int i = 0; i < threads; ++i) {
+        int64_t upper = (i == threads - 1) ? maxId : minId - 1 + span * (i + 1) / threads;
+        mWorkers.emplace_back([this, lower, upper, generation]() { workerLoop(lower, upper, generation); });
+        lower = upper;
+    }
+    mLogger.info("对账开始 ({} 个工作线程，{})，账户 id 范围 [{}, {}]", threads, repair ? "修复" : "只读", minId, maxId);
+    return true;
+}
+
+void ReconciliationEngine::stop() {
+    mCancelled = true;
+    for (auto& worker : mWorkers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    mWorkers.clear();
+
+    std::lock_guard lock(mMutex);
+    if (mReport.running) {
+        mReport.running   = false;
+        mReport.cancelled = true;
+        mReport.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - mStartedAt).count();
+        mLogger.warn("对账已取消 (已扫描 {} 个账户)。", mReport.scannedAccounts);
+    }
+}
+
+bool ReconciliationEngine::isRunning() const {
+    std::lock_guard lock(mMutex);
+    return mReport.running;
+}
+
+ReconcileReport ReconciliationEngine::getReport() const {
+    std::lock_guard lock(mMutex);
+    ReconcileReport report = mReport;
+    if (report.running) {
+        report.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - mStartedAt).count();
+    }
+    return report;
+}
+
+std::vector<ReconcileMismatch>
+ReconciliationEngine::checkAccounts(db::IDatabaseConnection& conn, const std::vector<AccountRow>& rows) {
+    std::vector<ReconcileMismatch> mismatches;
+    if (rows.empty()) {
+        return mismatches;
+    }
+    std::string dbType = conn.getDbType();
+
+    // 1. 按 uuid 聚合本块账户的流水 (走 economy_log 的 uuid 索引)
+    std::vector<std::string>        uuids;
+    std::unordered_set<std::string> seen;
+    for (const auto& row : rows) {
+        if (seen.insert(row.uuid).second) {
+            uuids.push_back(row.uuid);
+        }
+    }
+
+    // 超过 IN 列表上限时按 uuid 拆成多段分别检查
+    size_t limit = inListLimit(dbType);
+    if (uuids.size() > limit) {
+        std::unordered_map<std::string, size_t> batchOf;
+        for (size_t i = 0; i < uuids.size(); ++i) {
+            batchOf[uuids[i]] = i / limit;
+        }
+        std::vector<std::vector<AccountRow>> batches((uuids.size() + limit - 1) / limit);
+        for (const auto& row : rows) {
+            batches[batchOf[row.uuid]].push_back(row);
+        }
+        for (const auto& batch : batches) {
+            auto part = checkAccounts(conn, batch);
+            std::move(part.begin(), part.end(), std::back_inserter(mismatches));
+        }
+        return mismatches;
+    }
+
+    std::string  inList;
+    db::DbParams params;
+    for (size_t i = 0; i < uuids.size(); ++i) {
+        inList += (i == 0 ? "" : ", ") + placeholder(dbType, static_cast<int>(i) + 1);
+        params.emplace_back(uuids[i]);
+    }
+
+    struct LogAggregate {
+        int64_t rows = 0;
+        int64_t sumChange = 0;
+        int64_t firstId = 0;
+        int64_t firstPrevious = 0;
+    };
+    std::unordered_map<std::string, LogAggregate> aggregates;
+    db::DbResult aggResult = conn.queryPrepared(
+        "SELECT uuid, currency_type, COUNT(*), SUM(change_amount), MIN(id) FROM economy_log WHERE uuid IN (" + inList
+            + ") GROUP BY uuid, currency_type;",
+        params
+    );
+    for (const auto& row : aggResult) {
+        if (row.size() != 5) continue;
+        LogAggregate agg;
+        agg.rows      = db::toInt64(row[2]).value_or(0);
+        agg.sumChange = db::toInt64(row[3]).value_or(0);
+        agg.firstId   = db::toInt64(row[4]).value_or(0);
+        aggregates[accountKey(db::toString(row[0]), db::toString(row[1]))] = agg;
+    }
+
+    // 2. 取每个账户首条流水的 previous_amount 作为起点 (一个 uuid 可能有多种货币，同样按上限分段)
+    std::unordered_map<int64_t, std::string> keyByFirstId;
+    for (const auto& [key, agg] : aggregates) {
+        keyByFirstId[agg.firstId] = key;
+    }
+    auto next = keyByFirstId.begin();
+    while (next != keyByFirstId.end()) {
+        std::string  idList;
+        db::DbParams idParams;
+        for (int index = 1; next != keyByFirstId.end() && idParams.size() < limit; ++next, ++index) {
+            idList += (index == 1 ? "" : ", ") + placeholder(dbType, index);
+            idParams.emplace_back(next->first);
+        }
+        db::DbResult firstRows =
+            conn.queryPrepared("SELECT id, previous_amount FROM economy_log WHERE id IN (" + idList + ");", idParams);
+        for (const auto& row : firstRows) {
+            if (row.size() != 2) continue;
+            auto it = keyByFirstId.find(db::toInt64(row[0]).value_or(0));
+            if (it != keyByFirstId.end()) {
+                aggregates[it->second].firstPrevious = db::toInt64(row[1]).value_or(0);
+            }
+        }
+    }
+
+    // 3. 比较推算余额与实际余额
+    // 没有流水的账户无从推算 (开户流水默认不写，且初始余额配置可能已改过)，直接跳过
+    for (const auto& row : rows) {
+        auto it = aggregates.find(accountKey(row.uuid, row.currencyType));
+        if (it == aggregates.end()) {
+            continue;
+        }
+        ReconcileMismatch mismatch;
+        mismatch.uuid         = row.uuid;
+        mismatch.currencyType = row.currencyType;
+        mismatch.actual       = row.amount;
+        mismatch.expected     = it->second.firstPrevious + it->second.sumChange;
+        mismatch.logRows      = it->second.rows;
+        if (mismatch.expected != mismatch.actual) {
+            mismatches.push_back(std::move(mismatch));
+        }
+    }
+    return mismatches;
+}
+
+bool ReconciliationEngine::scanChunk(
+    db::IDatabaseConnection&        conn,
+    int64_t&                        cursor,
+    int64_t                         upperId,
+    std::vector<ReconcileMismatch>& outSuspects
+) {
+    std::string dbType    = conn.getDbType();
+    int64_t     chunkSize = std::max(1, mConfig.reconciliation.chunkSize);
+    db::DbResult result    = conn.queryPrepared(
+        "SELECT id, uuid, currency_type, amount FROM player_balances WHERE id > " + placeholder(dbType, 1)
+            + " AND id <= " + placeholder(dbType, 2) + " ORDER BY id LIMIT " + placeholder(dbType, 3) + ";",
+        {cursor, upperId, chunkSize}
+    );
+    if (result.empty()) {
+        return false;
+    }
+
+    std::vector<AccountRow> rows;
+    rows.reserve(result.size());
+    for (const auto& row : result) {
+        if (row.size() != 4) continue;
+        AccountRow account;
+        account.id           = db::toInt64(row[0]).value_or(0);
+        account.uuid         = db::toString(row[1]);
+        account.currencyType = db::toString(row[2]);
+        account.amount       = db::toInt64(row[3]).value_or(0);
+        rows.push_back(std::move(account));
+    }
+    if (rows.empty()) {
+        return false;
+    }
+    cursor      = rows.back().id;
+    outSuspects = checkAccounts(conn, rows);
+    {
+        std::lock_guard lock(mMutex);
+        mReport.scannedAccounts += rows.size();
+    }
+    return static_cast<int64_t>(result.size()) >= chunkSize && cursor < upperId;
+}
+
+void ReconciliationEngine::workerLoop(int64_t lowerId, int64_t upperId, uint64_t generation) {
+    std::unique_ptr<db::IDatabaseConnection> conn;
+    try {
+        conn = mConnectionFactory();
+        if (!conn || !conn->connect()) {
+            throw std::runtime_error("无法建立工作线程的数据库连接");
+        }
+    } catch (const std::exception& e) {
+        mLogger.error("对账工作线程 (id {}~{}) 启动失败: {}", lowerId + 1, upperId, e.what());
+        {
+            std::lock_guard lock(mMutex);
+            mReport.errors += 1;
+        }
+        onWorkerFinished(generation);
+        return;
+    }
+
+    int64_t cursor = lowerId;
+    while (!isStale(generation)) {
+        std::vector<ReconcileMismatch> suspects;
+        bool                           more = false;
+        try {
+            more = scanChunk(*conn, cursor, upperId, suspects);
+        } catch (const std::exception& e) {
+            // 游标无法前进，放弃本线程剩余的范围
+            mLogger.error("对账工作线程读取分块 (id > {}) 失败，放弃剩余范围 (至 {}): {}", cursor, upperId, e.what());
+            std::lock_guard lock(mMutex);
+            mReport.errors += 1;
+            break;
+        }
+        if (!suspects.empty()) {
+            mScheduler.submit("reconcile-confirm", [this, suspects = std::move(suspects), generation]() {
+                confirmOnServerThread(suspects, generation);
+            });
+        }
+        if (!more) {
+            break;
+        }
+        if (mConfig.reconciliation.chunkPauseMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(mConfig.reconciliation.chunkPauseMs));
+        }
+    }
+
+    try {
+        conn->disconnect();
+    } catch (...) {}
+    onWorkerFinished(generation);
+}
+
+void ReconciliationEngine::scheduleMainConnectionChunk(int64_t cursor, int64_t upperId, uint64_t generation) {
+    mScheduler.submit(
+        "reconcile-chunk",
+        [this, cursor, upperId, generation]() mutable {
+            if (isStale(generation)) {
+                return;
+            }
+            std::vector<ReconcileMismatch> suspects;
+            bool                           more = false;
+            try {
+                more = scanChunk(mMainConn, cursor, upperId, suspects);
+            } catch (const std::exception& e) {
+                mLogger.error("对账读取分块 (id > {}) 失败，对账提前结束: {}", cursor, e.what());
+                {
+                    std::lock_guard lock(mMutex);
+                    mReport.errors += 1;
+                }
+                onWorkerFinished(generation);
+                return;
+            }
+            if (!suspects.empty()) {
+                confirmOnServerThread(suspects, generation);
+            }
+            if (more) {
+                scheduleMainConnectionChunk(cursor, upperId, generation);
+            } else {
+                onWorkerFinished(generation);
+            }
+        },
+        scheduler::TaskPriority::Low
+    );
+}
+
+bool ReconciliationEngine::appendRepairLog(const ReconcileMismatch& mismatch) {
+    std::string dbType = mMainConn.getDbType();
+    std::string sql    = "INSERT INTO economy_log (uuid, currency_type, change_amount, previous_amount, reason1, reason2, "
+                         "reason3) VALUES ("
+                    + placeholder(dbType, 1) + ", " + placeholder(dbType, 2) + ", " + placeholder(dbType, 3) + ", "
+                    + placeholder(dbType, 4) + ", " + placeholder(dbType, 5) + ", " + placeholder(dbType, 6) + ", "
+                    + placeholder(dbType, 7) + ");";
+    try {
+        // 写入与封存在同一事务中完成
+        db::ScopedTransaction transaction(mMainConn);
+        int                   affected = mMainConn.executePrepared(
+            sql,
+            {mismatch.uuid,
+             mismatch.currencyType,
+             mismatch.actual - mismatch.expected,
+             mismatch.expected,
+             std::string(REPAIR_REASON),
+             fmt::format("流水推算 {}", MoneyManager::formatBalance(mismatch.expected)),
+             fmt::format("实际余额 {}", MoneyManager::formatBalance(mismatch.actual))}
+        );
+        if (affected <= 0) {
+            return false;
+        }
+        if (mLedgerChain.isEnabled()) {
+            mLedgerChain.sealLatest(mMainConn, mismatch.currencyType);
+        }
+        transaction.commit();
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("写入对账修复流水失败 (UUID: {}, Currency: {}): {}", mismatch.uuid, mismatch.currencyType, e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("写入对账修复流水时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+void ReconciliationEngine::confirmOnServerThread(const std::vector<ReconcileMismatch>& suspects, uint64_t generation) {
+    if (isStale(generation) || suspects.empty()) {
+        return;
+    }
+
+    // 用主连接重新读取这些账户：对账期间发生的正常写入在这里会变回一致
+    std::vector<ReconcileMismatch> confirmed;
+    try {
+        std::string                     dbType = mMainConn.getDbType();
+        size_t                          limit  = inListLimit(dbType);
+        std::unordered_set<std::string> suspectKeys;
+        std::unordered_set<std::string> seenUuids;
+        std::vector<std::string>        uuids;
+        for (const auto& suspect : suspects) {
+            suspectKeys.insert(accountKey(suspect.uuid, suspect.currencyType));
+            if (seenUuids.insert(suspect.uuid).second) {
+                uuids.push_back(suspect.uuid);
+            }
+        }
+        std::vector<AccountRow> rows;
+        for (size_t begin = 0; begin < uuids.size(); begin += limit) {
+            std::string  inList;
+            db::DbParams params;
+            for (size_t i = begin; i < std::min(uuids.size(), begin + limit); ++i) {
+                inList += (params.empty() ? "" : ", ") + placeholder(dbType, static_cast<int>(params.size()) + 1);
+                params.emplace_back(uuids[i]);
+            }
+            db::DbResult result = mMainConn.queryPrepared(
+                "SELECT id, uuid, currency_type, amount FROM player_balances WHERE uuid IN (" + inList + ");",
+                params
+            );
+            for (const auto& row : result) {
+                if (row.size() != 4) continue;
+                AccountRow account;
+                account.id           = db::toInt64(row[0]).value_or(0);
+                account.uuid         = db::toString(row[1]);
+                account.currencyType = db::toString(row[2]);
+                account.amount       = db::toInt64(row[3]).value_or(0);
+                if (suspectKeys.count(accountKey(account.uuid, account.currencyType))) {
+                    rows.push_back(std::move(account));
+                }
+            }
+        }
+        confirmed = checkAccounts(mMainConn, rows);
+    } catch (const std::exception& e) {
+        mLogger.error("复核对账结果失败: {}", e.what());
+        std::lock_guard lock(mMutex);
+        mReport.errors += 1;
+        return;
+    }
+
+    bool repair;
+    {
+        std::lock_guard lock(mMutex);
+        repair = mReport.repair;
+    }
+    for (auto& mismatch : confirmed) {
+        mLogger.warn(
+            "对账不一致：UUID {}，货币 {}，余额 {}，流水推算 {} ({} 条流水)",
+            mismatch.uuid,
+            mismatch.currencyType,
+            MoneyManager::formatBalance(mismatch.actual),
+            MoneyManager::formatBalance(mismatch.expected),
+            mismatch.logRows
+        );
+        if (repair) {
+            mismatch.repaired = appendRepairLog(mismatch);
+        }
+    }
+
+    std::lock_guard lock(mMutex);
+    mReport.mismatches += confirmed.size();
+    size_t maxSamples   = static_cast<size_t>(std::max(0, mConfig.reconciliation.maxReportedMismatches));
+    for (auto& mismatch : confirmed) {
+        if (mismatch.repaired) {
+            mReport.repaired += 1;
+        }
+        if (mReport.samples.size() < maxSamples) {
+            mReport.samples.push_back(std::move(mismatch));
+        }
+    }
+}
+
+void ReconciliationEngine::onWorkerFinished(uint64_t generation) {
+    if (generation != mGeneration || --mActiveWorkers > 0) {
+        return;
+    }
+    // 最后一个工作线程结束后，在服务器线程上收尾 (排在它提交的复核任务之后)
+    mScheduler.submit("reconcile-finish", [this, generation]() {
+        if (generation != mGeneration) {
+            return;
+        }
+        std::lock_guard lock(mMutex);
+        if (!mReport.running) {
+            return;
+        }
+        mReport.running   = false;
+        mReport.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - mStartedAt).count();
+        mLogger.info(
+            "对账完成：扫描 {} 个账户，不一致 {} 个，已修复 {} 个，出错分块 {} 个，耗时 {:.0f}ms",
+            mReport.scannedAccounts,
+            mReport.mismatches,
+            mReport.repaired,
+            mReport.errors,
+            mReport.elapsedMs
+        );
+    });
+}
+
+} // namespace czmoney
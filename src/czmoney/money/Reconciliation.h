@@ -0,0 +1,147 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/money/LedgerChain.h"
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace czmoney {
+
+// 对账发现的单个不一致账户
+struct ReconcileMismatch {
+    std::string uuid;
+    std::string currencyType;
+    int64_t     actual = 0;   // player_balances 中的余额
+    int64_t     expected = 0; // 由 economy_log 推算出的余额
+    int64_t     logRows = 0;  // 该账户的流水条数
+    bool        repaired = false;
+};
+
+// 对账任务的进度与结果
+struct ReconcileReport {
+    bool                           running = false;
+    bool                           repair = false;   // 是否修复不一致
+    bool                           cancelled = false;
+    uint64_t                       scannedAccounts = 0;
+    uint64_t                       mismatches = 0;   // 在服务器线程上复核确认后的数量
+    uint64_t                       repaired = 0;
+    uint64_t                       errors = 0;       // 出错的分块数量
+    double                         elapsedMs = 0;
+    std::vector<ReconcileMismatch> samples;          // 最多保留 maxReportedMismatches 条
+};
+
+/**
+ * @brief 流水与余额对账器
+ *
+ * 旧版本中余额 UPDATE 与 logTransaction 不在同一事务中，崩溃或外部直接改库后 economy_log 与 player_balances 可能不一致。
+ * 对账器按 player_balances.id 切分成若干范围，流式读取每块账户，并用 economy_log 的聚合结果
+ * (首条流水的 previous_amount + 全部 change_amount 之和) 重新推算余额。
+ * - MySQL / PostgreSQL：每个工作线程使用独立的只读连接，不占用服务器线程。
+ * - SQLite：回滚日志模式下其他连接的读锁会让服务器的写入直接失败 (SQLITE_BUSY)，
+ *   因此改为在后台任务调度器中使用主连接逐块处理，受每 tick 预算约束。
+ * 工作线程只产生“疑似不一致”，由服务器线程用主连接复核 (排除对账期间的正常写入)，
+ * 修复模式下追加一条 "Reconcile" 流水使流水与余额重新一致 (以余额为准，因为丢失的是流水)。
+ * 内存占用与分块大小成正比，与账户总数无关。
+ */
+class ReconciliationEngine {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    // 修复时写入流水的 reason1
+    static constexpr const char* REPAIR_REASON = "Reconcile";
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (只在服务器线程上使用)
+     * @param scheduler 后台任务调度器
+     * @param config 配置对象
+     * @param connectionFactory 为工作线程创建独立连接的工厂
+     */
+    ReconciliationEngine(
+        db::IDatabaseConnection&  mainConn,
+        scheduler::TaskScheduler& scheduler,
+        const Config&             config,
+        ConnectionFactory         connectionFactory
+    );
+    ~ReconciliationEngine();
+
+    ReconciliationEngine(const ReconciliationEngine&) = delete;
+    ReconciliationEngine& operator=(const ReconciliationEngine&) = delete;
+
+    /**
+     * @brief 开始一次对账
+     * @param repair 是否修复发现的不一致
+     * @return bool 是否成功开始 (已有对账在运行时返回 false)
+     */
+    bool start(bool repair);
+
+    /**
+     * @brief 取消正在运行的对账，并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 是否有对账在运行
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 对账的进度与结果
+     */
+    [[nodiscard]] ReconcileReport getReport() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct AccountRow {
+        int64_t     id = 0;
+        std::string uuid;
+        std::string currencyType;
+        int64_t     amount = 0;
+    };
+
+    db::IDatabaseConnection&  mMainConn;
+    scheduler::TaskScheduler& mScheduler;
+    const Config&             mConfig;
+    ConnectionFactory         mConnectionFactory;
+    ll::io::Logger&           mLogger;
+    LedgerChain               mLedgerChain; // 启用时封存修复流水
+
+    mutable std::mutex       mMutex; // 保护 mReport
+    ReconcileReport          mReport;
+    Clock::time_point        mStartedAt;
+    std::atomic<bool>        mCancelled{false};
+    std::atomic<uint64_t>    mGeneration{0}; // 每次 start 递增，旧任务据此自行退出
+    std::atomic<int>         mActiveWorkers{0};
+    std::vector<std::thread> mWorkers;
+
+    // 读取 (cursor, upperId] 范围内的下一块账户并检查，返回是否还有剩余
+    bool scanChunk(
+        db::IDatabaseConnection&        conn,
+        int64_t&                        cursor,
+        int64_t                         upperId,
+        std::vector<ReconcileMismatch>& outSuspects
+    );
+    // 用给定连接检查一组账户，返回余额与流水不一致的账户
+    std::vector<ReconcileMismatch> checkAccounts(db::IDatabaseConnection& conn, const std::vector<AccountRow>& rows);
+    void workerLoop(int64_t lowerId, int64_t upperId, uint64_t generation);
+    void scheduleMainConnectionChunk(int64_t cursor, int64_t upperId, uint64_t generation);
+    void confirmOnServerThread(const std::vector<ReconcileMismatch>& suspects, uint64_t generation);
+    bool appendRepairLog(const ReconcileMismatch& mismatch);
+    void onWorkerFinished(uint64_t generation);
+    bool isStale(uint64_t generation) const { return mCancelled || generation != mGeneration; }
+    // 单条 IN (...) 列表允许的最多参数数量 (SQLite 限制为 999 个绑定参数)
+    static size_t inListLimit(const std::string& dbType);
+};
+
+} // namespace czmoney
@@ -0,0 +1,457 @@
+#include "czmoney/money/ScheduledPayment.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/money.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+
+namespace czmoney {
+
+namespace {
+// SELECT 的列顺序，与 rowToPayment 保持一致
+constexpr const char* PAYMENT_COLUMNS =
+    "id, payer_uuid, payee_uuid, currency_type, amount, interval_seconds, next_run, remaining_runs, "
+    "failure_count, active, last_status, reason1, reason2, reason3";
+} // namespace
+
+ScheduledPaymentEngine::ScheduledPaymentEngine(
+    db::IDatabaseConnection& dbConn,
+    MoneyManager&            moneyManager,
+    const Config&            config
+)
+: mDbConnection(dbConn),
+  mMoneyManager(moneyManager),
+  mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+int64_t ScheduledPaymentEngine::nowEpochSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+std::string ScheduledPaymentEngine::placeholder(int index) const {
+    return czmoney::placeholder(mDbConnection.getDbType(), index);
+}
+
+bool ScheduledPaymentEngine::initializeTable() {
+    std::string              dbType = mDbConnection.getDbType();
+    std::string              createTableSQL;
+    std::vector<std::string> createIndexSQLs;
+
+    if (dbType == "mysql") {
+        createTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS scheduled_payments (
+                id BIGINT PRIMARY KEY,
+                payer_uuid VARCHAR(36) NOT NULL,
+                payee_uuid VARCHAR(36) NOT NULL DEFAULT '',
+                currency_type VARCHAR(50) NOT NULL,
+                amount BIGINT NOT NULL,
+                interval_seconds BIGINT NOT NULL DEFAULT 0,
+                next_run BIGINT NOT NULL,
+                remaining_runs BIGINT NOT NULL DEFAULT -1,
+                failure_count INT NOT NULL DEFAULT 0,
+                active TINYINT NOT NULL DEFAULT 1,
+                last_status VARCHAR(32) DEFAULT NULL,
+                reason1 VARCHAR(255) DEFAULT NULL,
+                reason2 VARCHAR(255) DEFAULT NULL,
+                reason3 VARCHAR(255) DEFAULT NULL,
+                INDEX idx_scheduled_due (active, next_run),
+                INDEX idx_scheduled_payer (payer_uuid)
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )";
+    } else if (dbType == "sqlite") {
+        createTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS scheduled_payments (
+                id INTEGER PRIMARY KEY,
+                payer_uuid TEXT NOT NULL,
+                payee_uuid TEXT NOT NULL DEFAULT '',
+                currency_type TEXT NOT NULL,
+                amount INTEGER NOT NULL,
+                interval_seconds INTEGER NOT NULL DEFAULT 0,
+                next_run INTEGER NOT NULL,
+                remaining_runs INTEGER NOT NULL DEFAULT -1,
+                failure_count INTEGER NOT NULL DEFAULT 0,
+                active INTEGER NOT NULL DEFAULT 1,
+                last_status TEXT DEFAULT NULL,
+                reason1 TEXT DEFAULT NULL,
+                reason2 TEXT DEFAULT NULL,
+                reason3 TEXT DEFAULT NULL
+            );
+        )";
+        createIndexSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_scheduled_due ON scheduled_payments (active, next_run);");
+        createIndexSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_scheduled_payer ON scheduled_payments (payer_uuid);");
+    } else if (dbType == "postgresql") {
+        createTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS scheduled_payments (
+                id BIGINT PRIMARY KEY,
+                payer_uuid VARCHAR(36) NOT NULL,
+                payee_uuid VARCHAR(36) NOT NULL DEFAULT '',
+                currency_type VARCHAR(50) NOT NULL,
+                amount BIGINT NOT NULL,
+                interval_seconds BIGINT NOT NULL DEFAULT 0,
+                next_run BIGINT NOT NULL,
+                remaining_runs BIGINT NOT NULL DEFAULT -1,
+                failure_count INTEGER NOT NULL DEFAULT 0,
+                active SMALLINT NOT NULL DEFAULT 1,
+                last_status VARCHAR(32) DEFAULT NULL,
+                reason1 VARCHAR(255) DEFAULT NULL,
+                reason2 VARCHAR(255) DEFAULT NULL,
+                reason3 VARCHAR(255) DEFAULT NULL
+            );
+        )";
+        createIndexSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_scheduled_due ON scheduled_payments (active, next_run);");
+        createIndexSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_scheduled_payer ON scheduled_payments (payer_uuid);");
+    } else {
+        mLogger.error("不支持的数据库类型 '{}'，无法创建 scheduled_payments 表。", dbType);
+        return false;
+    }
+
+    try {
+        mDbConnection.execute(createTableSQL);
+        for (const auto& sql : createIndexSQLs) {
+            mDbConnection.execute(sql);
+        }
+        // 编号由本插件分配，从现有最大编号继续
+        db::DbResult maxResult = mDbConnection.query("SELECT MAX(id) FROM scheduled_payments;");
+        std::lock_guard lock(mMutex);
+        mNextId = 1;
+        if (!maxResult.empty() && !maxResult[0].empty()) {
+            mNextId = db::toInt64(maxResult[0][0]).value_or(0) + 1;
+        }
+        mLogger.info("'scheduled_payments' 表初始化成功 (类型: {}).", dbType);
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建或验证 'scheduled_payments' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("创建或验证 'scheduled_payments' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+ScheduledPayment ScheduledPaymentEngine::rowToPayment(const db::DbRow& row) {
+    ScheduledPayment payment;
+    payment.id              = db::toInt64(row[0]).value_or(0);
+    payment.payerUuid       = db::toString(row[1]);
+    payment.payeeUuid       = db::toString(row[2]);
+    payment.currencyType    = db::toString(row[3]);
+    payment.amount          = db::toInt64(row[4]).value_or(0);
+    payment.intervalSeconds = db::toInt64(row[5]).value_or(0);
+    payment.nextRun         = db::toInt64(row[6]).value_or(0);
+    payment.remainingRuns   = db::toInt64(row[7]).value_or(-1);
+    payment.failureCount    = db::toInt64(row[8]).value_or(0);
+    payment.active          = db::toInt64(row[9]).value_or(0) != 0;
+    payment.lastStatus      = db::toString(row[10]);
+    payment.reason1         = db::toString(row[11]);
+    payment.reason2         = db::toString(row[12]);
+    payment.reason3         = db::toString(row[13]);
+    return payment;
+}
+
+api::MoneyApiResult ScheduledPaymentEngine::createPayment(const ScheduledPayment& payment, int64_t& outId) {
+    if (mConfig.economy.find(payment.currencyType) == mConfig.economy.end()) {
+        mLogger.error("无法创建付款计划：货币类型 '{}' 未在配置中定义。", payment.currencyType);
+        return api::MoneyApiResult::UnknownError;
+    }
+    if (payment.amount <= 0 || payment.intervalSeconds < 0 || payment.remainingRuns == 0) {
+        return api::MoneyApiResult::InvalidAmount;
+    }
+    if (payment.payerUuid.empty() || payment.payerUuid == payment.payeeUuid) {
+        return api::MoneyApiResult::AccountNotFound;
+    }
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法创建付款计划：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    std::lock_guard lock(mMutex);
+    int64_t         id  = mNextId;
+    std::string     sql = "INSERT INTO scheduled_payments (id, payer_uuid, payee_uuid, currency_type, amount, "
+                          "interval_seconds, next_run, remaining_runs, failure_count, active, reason1, reason2, reason3) "
+                          "VALUES ("
+                    + placeholder(1) + ", " + placeholder(2) + ", " + placeholder(3) + ", " + placeholder(4) + ", "
+                    + placeholder(5) + ", " + placeholder(6) + ", " + placeholder(7) + ", " + placeholder(8) + ", 0, 1, "
+                    + placeholder(9) + ", " + placeholder(10) + ", " + placeholder(11) + ");";
+    db::DbParams params = {
+        id,
+        payment.payerUuid,
+        payment.payeeUuid,
+        payment.currencyType,
+        payment.amount,
+        payment.intervalSeconds,
+        payment.nextRun,
+        payment.remainingRuns,
+        payment.reason1,
+        payment.reason2,
+        payment.reason3
+    };
+
+    try {
+        if (mDbConnection.executePrepared(sql, params) <= 0) {
+            mLogger.error("创建付款计划失败 (INSERT 未影响任何行)。");
+            return api::MoneyApiResult::DatabaseError;
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建付款计划时发生数据库错误: {}", e.what());
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("创建付款计划时发生意外错误: {}", e.what());
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    mNextId = id + 1;
+    outId   = id;
+    mLogger.info(
+        "已创建付款计划 #{}: {} -> {}，{} {}，周期 {} 秒",
+        id,
+        payment.payerUuid,
+        payment.payeeUuid.empty() ? "<系统>" : payment.payeeUuid,
+        MoneyManager::formatBalance(payment.amount),
+        payment.currencyType,
+        payment.intervalSeconds
+    );
+    return api::MoneyApiResult::Success;
+}
+
+api::MoneyApiResult ScheduledPaymentEngine::cancelPayment(int64_t id) {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法取消付款计划：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+    std::string sql = "UPDATE scheduled_payments SET active = 0, last_status = 'cancelled' WHERE id = " + placeholder(1)
+                    + " AND active = 1;";
+    try {
+        std::lock_guard lock(mMutex);
+        if (mDbConnection.executePrepared(sql, {id}) <= 0) {
+            return api::MoneyApiResult::ScheduleNotFound;
+        }
+        mLogger.info("付款计划 #{} 已取消。", id);
+        return api::MoneyApiResult::Success;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("取消付款计划 #{} 时发生数据库错误: {}", id, e.what());
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("取消付款计划 #{} 时发生意外错误: {}", id, e.what());
+        return api::MoneyApiResult::UnknownError;
+    }
+}
+
+std::vector<ScheduledPayment> ScheduledPaymentEngine::listPayments(const std::string& uuid) {
+    std::vector<ScheduledPayment> payments;
+    std::string sql = std::string("SELECT ") + PAYMENT_COLUMNS + " FROM scheduled_payments WHERE active = 1 AND (payer_uuid = "
+                    + placeholder(1) + " OR payee_uuid = " + placeholder(2) + ") ORDER BY next_run, id;";
+    try {
+        db::DbResult rows = mDbConnection.queryPrepared(sql, {uuid, uuid});
+        payments.reserve(rows.size());
+        for (const auto& row : rows) {
+            if (row.size() == 14) {
+                payments.push_back(rowToPayment(row));
+            }
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("查询付款计划时发生数据库错误: {}", e.what());
+    } catch (const std::exception& e) {
+        mLogger.error("查询付款计划时发生意外错误: {}", e.what());
+    }
+    return payments;
+}
+
+std::vector<ScheduledPayment> ScheduledPaymentEngine::fetchDue(int64_t nowEpoch, size_t limit) {
+    std::vector<ScheduledPayment> due;
+    std::string sql = std::string("SELECT ") + PAYMENT_COLUMNS + " FROM scheduled_payments WHERE active = 1 AND next_run <= "
+                    + placeholder(1) + " ORDER BY next_run, id LIMIT " + placeholder(2) + ";";
+    db::DbResult rows = mDbConnection.queryPrepared(sql, {nowEpoch, static_cast<int64_t>(limit)});
+    due.reserve(rows.size());
+    for (const auto& row : rows) {
+        if (row.size() == 14) {
+            due.push_back(rowToPayment(row));
+        }
+    }
+    return due;
+}
+
+ScheduledPaymentEngine::RunOutcome ScheduledPaymentEngine::payOnce(const ScheduledPayment& payment) {
+    // 先按最低余额与冻结金额检查可用余额，不足时不产生任何写入
+    std::optional<int64_t> spendable = mMoneyManager.getSpendableBalance(payment.payerUuid, payment.currencyType);
+    if (!spendable || *spendable - payment.amount < mMoneyManager.getMinimumBalance(payment.currencyType)) {
+        return RunOutcome::InsufficientFunds;
+    }
+
+    std::string reason1 = payment.reason1.empty() ? "ScheduledPayment" : payment.reason1;
+    std::string reason2 = payment.reason2.empty() ? fmt::format("Schedule #{}", payment.id) : payment.reason2;
+
+    // 扣款失败时余额未被修改，只算作本计划失败，不影响同批其他计划
+    if (!mMoneyManager.subtractPlayerBalance(payment.payerUuid, payment.currencyType, payment.amount, reason1, reason2, payment.reason3)) {
+        return RunOutcome::InsufficientFunds;
+    }
+    // 已扣款但加款失败：必须回滚整批
+    if (!payment.payeeUuid.empty()
+        && !mMoneyManager.addPlayerBalance(payment.payeeUuid, payment.currencyType, payment.amount, reason1, reason2, payment.reason3)) {
+        return RunOutcome::PaymentFailed;
+    }
+    return RunOutcome::Paid;
+}
+
+void ScheduledPaymentEngine::saveState(const ScheduledPayment& payment) {
+    std::string sql = "UPDATE scheduled_payments SET next_run = " + placeholder(1) + ", remaining_runs = " + placeholder(2)
+                    + ", failure_count = " + placeholder(3) + ", active = " + placeholder(4) + ", last_status = "
+                    + placeholder(5) + " WHERE id = " + placeholder(6) + ";";
+    mDbConnection.executePrepared(
+        sql,
+        {payment.nextRun,
+         payment.remainingRuns,
+         payment.failureCount,
+         static_cast<int64_t>(payment.active ? 1 : 0),
+         payment.lastStatus,
+         payment.id}
+    );
+}
+
+bool ScheduledPaymentEngine::processBatch(
+    const std::vector<ScheduledPayment>&  batch,
+    int64_t                               nowEpoch,
+    std::chrono::steady_clock::time_point deadline,
+    size_t&                               processed
+) {
+    const auto& cfg = mConfig.scheduledPayments;
+    processed       = 0;
+    try {
+        // 整批在一个事务中提交；抛出异常时由析构自动回滚 (已在外层事务中时只回滚到保存点)
+        db::ScopedTransaction transaction(mDbConnection);
+
+        for (ScheduledPayment payment : batch) {
+            // 至少处理一个计划，之后每个计划前检查 tick 预算，超出时提交已处理的部分
+            if (processed > 0 && std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            // 1. 计算本次应执行的次数 (补跑停机期间错过的付款)
+            int64_t behind  = 1;
+            if (payment.intervalSeconds > 0 && nowEpoch > payment.nextRun) {
+                behind = (nowEpoch - payment.nextRun) / payment.intervalSeconds + 1;
+            }
+            int64_t runsDue = cfg.catchUpMissedRuns ? std::min<int64_t>(behind, std::max(1, cfg.maxCatchUpRuns)) : 1;
+            if (payment.remainingRuns >= 0) {
+                runsDue = std::min(runsDue, payment.remainingRuns);
+            }
+
+            // 2. 逐次付款，余额不足时停止
+            int64_t paid        = 0;
+            bool    insufficient = false;
+            for (int64_t i = 0; i < runsDue; ++i) {
+                RunOutcome outcome = payOnce(payment);
+                if (outcome == RunOutcome::PaymentFailed) {
+                    throw std::runtime_error(fmt::format("付款计划 #{} 已扣款但无法为收款方加款", payment.id));
+                }
+                if (outcome == RunOutcome::InsufficientFunds) {
+                    insufficient = true;
+                    break;
+                }
+                ++paid;
+            }
+
+            // 3. 更新计划状态
+            if (payment.remainingRuns >= 0) {
+                payment.remainingRuns -= paid;
+            }
+            if (payment.intervalSeconds > 0) {
+                // 已付的次数向后推进；未补跑的错过次数直接跳过
+                payment.nextRun += paid * payment.intervalSeconds;
+                if (!insufficient && payment.nextRun <= nowEpoch) {
+                    payment.nextRun += ((nowEpoch - payment.nextRun) / payment.intervalSeconds + 1) * payment.intervalSeconds;
+                }
+            }
+
+            if (insufficient) {
+                payment.failureCount += 1;
+                if (cfg.maxConsecutiveFailures > 0 && payment.failureCount >= cfg.maxConsecutiveFailures) {
+                    payment.active     = false;
+                    payment.lastStatus = "suspended";
+                    mLogger.warn("付款计划 #{} 连续 {} 次余额不足，已暂停。", payment.id, payment.failureCount);
+                } else {
+                    payment.lastStatus = "insufficient_funds";
+                    payment.nextRun    = std::max(payment.nextRun, nowEpoch + std::max<int64_t>(1, cfg.retryDelaySeconds));
+                }
+            } else {
+                payment.failureCount = 0;
+                payment.lastStatus   = "ok";
+            }
+            if (payment.remainingRuns == 0 || (payment.intervalSeconds <= 0 && paid > 0)) {
+                payment.active     = false;
+                payment.lastStatus = "completed";
+            }
+            saveState(payment);
+            ++processed;
+        }
+
+        transaction.commit();
+        return true;
+    } catch (const std::exception& e) {
+        processed = 0;
+        mLogger.error("处理付款批次 ({} 个计划) 时发生错误，整批回滚: {}", batch.size(), e.what());
+        return false;
+    }
+}
+
+void ScheduledPaymentEngine::markError(const ScheduledPayment& payment, int64_t nowEpoch) {
+    ScheduledPayment failed = payment;
+    failed.failureCount += 1;
+    failed.lastStatus    = "error";
+    failed.nextRun       = nowEpoch + std::max<int64_t>(1, mConfig.scheduledPayments.retryDelaySeconds);
+    if (mConfig.scheduledPayments.maxConsecutiveFailures > 0
+        && failed.failureCount >= mConfig.scheduledPayments.maxConsecutiveFailures) {
+        failed.active     = false;
+        failed.lastStatus = "suspended";
+    }
+    try {
+        saveState(failed);
+    } catch (const std::exception& e) {
+        mLogger.error("记录付款计划 #{} 的错误状态失败: {}", payment.id, e.what());
+    }
+}
+
+size_t ScheduledPaymentEngine::runDueBatch(int64_t nowEpoch, bool& hasMore) {
+    hasMore = false;
+    if (!mDbConnection.isConnected()) {
+        return 0;
+    }
+    std::lock_guard lock(mMutex);
+
+    size_t                        batchSize = static_cast<size_t>(std::max(1, mConfig.scheduledPayments.batchSize));
+    std::vector<ScheduledPayment> batch;
+    try {
+        batch = fetchDue(nowEpoch, batchSize);
+    } catch (const std::exception& e) {
+        mLogger.error("读取到期付款计划失败: {}", e.what());
+        return 0;
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+
+    // 与调度器相同的每 tick 预算，付款在服务器线程上执行，不能因一批计划卡住一个 tick
+    const auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double, std::milli>(mConfig.scheduler.tickBudgetMs)
+                        );
+
+    size_t processed = 0;
+    if (!processBatch(batch, nowEpoch, deadline, processed)) {
+        // 整批失败时逐条重试，隔离出问题的计划，避免一条坏数据阻塞所有付款
+        for (const auto& payment : batch) {
+            if (processed > 0 && std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            size_t single = 0;
+            if (!processBatch({payment}, nowEpoch, deadline, single)) {
+                markError(payment, nowEpoch);
+            }
+            ++processed;
+        }
+    }
+    hasMore = processed < batch.size() || batch.size() >= batchSize;
+    mLogger.debug("已处理 {} 个到期付款计划 (读取 {} 个)。", processed, batch.size());
+    return processed;
+}
+
+} // namespace czmoney
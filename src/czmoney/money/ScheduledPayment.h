@@ -0,0 +1,130 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/money/money_api.h" // 包含 MoneyApiResult 枚举
+#include "ll/api/io/Logger.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace czmoney {
+
+class MoneyManager;
+
+// 定时/周期付款记录
+struct ScheduledPayment {
+    int64_t     id = 0;
+    std::string payerUuid;           // 付款方
+    std::string payeeUuid;           // 收款方，为空表示付给系统 (例如租金、订阅费)
+    std::string currencyType;
+    int64_t     amount = 0;          // 每次付款金额 (整数，实际金额 * 100)
+    int64_t     intervalSeconds = 0; // 周期 (秒)，0 表示一次性付款
+    int64_t     nextRun = 0;         // 下次执行时间 (Unix 时间戳，秒)
+    int64_t     remainingRuns = -1;  // 剩余次数，-1 表示不限
+    int64_t     failureCount = 0;    // 连续失败次数
+    bool        active = true;
+    std::string lastStatus;          // 最近一次执行结果 (ok / insufficient_funds / suspended / completed / error)
+    std::string reason1;
+    std::string reason2;
+    std::string reason3;
+};
+
+/**
+ * @brief 定时与周期付款引擎
+ *
+ * 付款计划持久化在 scheduled_payments 表中，由后台任务调度器周期性触发。
+ * - 到期付款按批读取，每批在一个事务中执行并更新计划。
+ * - 付款前按 CurrencyConfig::minimumBalance (以及冻结金额) 检查可用余额，不足时记录失败并延迟重试，
+ *   连续失败达到上限后暂停该计划。
+ * - 停机期间错过的付款在启动后按配置补跑 (有上限)，超出部分跳过。
+ * - 某一批出现无法局部处理的错误时整批回滚，再逐条重试以隔离出问题的计划。
+ */
+class ScheduledPaymentEngine {
+public:
+    /**
+     * @brief 构造函数
+     * @param dbConn 数据库连接
+     * @param moneyManager 用于执行扣款/加款的 MoneyManager
+     * @param config 配置对象
+     */
+    ScheduledPaymentEngine(db::IDatabaseConnection& dbConn, MoneyManager& moneyManager, const Config& config);
+
+    ScheduledPaymentEngine(const ScheduledPaymentEngine&) = delete;
+    ScheduledPaymentEngine& operator=(const ScheduledPaymentEngine&) = delete;
+
+    /**
+     * @brief 创建 scheduled_payments 表 (如果不存在)
+     * @return bool 操作是否成功
+     */
+    bool initializeTable();
+
+    /**
+     * @brief 新建付款计划
+     * @param payment 计划内容 (id、failureCount、lastStatus 会被忽略)
+     * @param[out] outId 成功时写入计划编号
+     * @return api::MoneyApiResult 操作结果
+     */
+    api::MoneyApiResult createPayment(const ScheduledPayment& payment, int64_t& outId);
+
+    /**
+     * @brief 取消付款计划
+     * @param id 计划编号
+     * @return api::MoneyApiResult 操作结果；计划不存在或已结束时返回 ScheduleNotFound
+     */
+    api::MoneyApiResult cancelPayment(int64_t id);
+
+    /**
+     * @brief 查询与某个玩家相关 (付款方或收款方) 的有效付款计划
+     * @param uuid 玩家 UUID
+     * @return std::vector<ScheduledPayment> 计划列表
+     */
+    std::vector<ScheduledPayment> listPayments(const std::string& uuid);
+
+    /**
+     * @brief 处理一批到期的付款
+     *
+     * 在服务器线程上执行，每处理完一个计划检查一次调度器的 tick 预算 (SchedulerConfig::tickBudgetMs)，
+     * 超出时提交已处理的部分并停止，剩余的计划仍然到期，下次继续处理。
+     * @param nowEpoch 当前时间 (Unix 时间戳，秒)
+     * @param[out] hasMore 批次已满或因预算提前停止时为 true，说明可能还有待处理的计划
+     * @return size_t 本次处理的计划数量
+     */
+    size_t runDueBatch(int64_t nowEpoch, bool& hasMore);
+
+    /**
+     * @brief 获取当前 Unix 时间戳 (秒)
+     */
+    static int64_t nowEpochSeconds();
+
+private:
+    // 单个计划本次执行的结果
+    enum class RunOutcome { Paid, InsufficientFunds, PaymentFailed };
+
+    db::IDatabaseConnection& mDbConnection;
+    MoneyManager&            mMoneyManager;
+    const Config&            mConfig;
+    ll::io::Logger&          mLogger;
+
+    std::mutex mMutex;      // 串行化批处理与编号分配
+    int64_t    mNextId = 1;
+
+    std::string placeholder(int index) const;
+    std::vector<ScheduledPayment> fetchDue(int64_t nowEpoch, size_t limit);
+    // 处理批次，每个计划之后检查 deadline；返回 false 表示整批已回滚
+    bool processBatch(
+        const std::vector<ScheduledPayment>&  batch,
+        int64_t                               nowEpoch,
+        std::chrono::steady_clock::time_point deadline,
+        size_t&                               processed
+    );
+    RunOutcome payOnce(const ScheduledPayment& payment);
+    void       saveState(const ScheduledPayment& payment);
+    void       markError(const ScheduledPayment& payment, int64_t nowEpoch);
+    static ScheduledPayment rowToPayment(const db::DbRow& row);
+};
+
+} // namespace czmoney
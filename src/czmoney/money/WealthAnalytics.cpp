@@ -0,0 +1,543 @@
+#include "czmoney/money/WealthAnalytics.h"
+#include "czmoney/money/money.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace czmoney {
+
+namespace {
+
+std::string jsonEscape(const std::string& value) {
+    std::string out;
+    out.reserve(value.size() + 2);
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += fmt::format("\\u{:04x}", static_cast<int>(c));
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// 金额以两位小数的数字写入 JSON
+std::string jsonAmount(int64_t amount) { return MoneyManager::formatBalance(amount); }
+
+} // namespace
+
+// --- QuantileSketch ---
+
+QuantileSketch::QuantileSketch(double relativeAccuracy, size_t maxBuckets)
+: mMaxBuckets(std::max<size_t>(16, maxBuckets)) {
+    double accuracy = std::clamp(relativeAccuracy, 0.0001, 0.5);
+    mGamma          = (1.0 + accuracy) / (1.0 - accuracy);
+    mLogGamma       = std::log(mGamma);
+}
+
+int QuantileSketch::bucketIndex(double absValue) const {
+    return static_cast<int>(std::ceil(std::log(absValue) / mLogGamma));
+}
+
+double QuantileSketch::bucketValue(int index) const { return 2.0 * std::pow(mGamma, index) / (mGamma + 1.0); }
+
+void QuantileSketch::collapseLowest(std::map<int, Bucket>& buckets, size_t maxBuckets) {
+    while (buckets.size() > maxBuckets) {
+        auto lowest = buckets.begin();
+        auto next   = std::next(lowest);
+        next->second.count += lowest->second.count;
+        next->second.sum   += lowest->second.sum;
+        buckets.erase(lowest);
+    }
+}
+
+void QuantileSketch::add(int64_t value) {
+    ++mCount;
+    if (value == 0) {
+        ++mZeroCount;
+        return;
+    }
+    double absValue = std::abs(static_cast<double>(value));
+    auto&  buckets  = value > 0 ? mPositive : mNegative;
+    auto&  bucket   = buckets[bucketIndex(absValue)];
+    bucket.count   += 1;
+    bucket.sum     += absValue;
+    collapseLowest(buckets, mMaxBuckets);
+}
+
+int64_t QuantileSketch::quantile(double q) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    double   rank       = std::clamp(q, 0.0, 1.0) * static_cast<double>(mCount - 1);
+    uint64_t cumulative = 0;
+    // 升序：负数 (绝对值从大到小)，0，正数 (从小到大)
+    for (auto it = mNegative.rbegin(); it != mNegative.rend(); ++it) {
+        cumulative += it->second.count;
+        if (static_cast<double>(cumulative) > rank) {
+            return -static_cast<int64_t>(std::llround(bucketValue(it->first)));
+        }
+    }
+    cumulative += mZeroCount;
+    if (static_cast<double>(cumulative) > rank) {
+        return 0;
+    }
+    for (const auto& [index, bucket] : mPositive) {
+        cumulative += bucket.count;
+        if (static_cast<double>(cumulative) > rank) {
+            return static_cast<int64_t>(std::llround(bucketValue(index)));
+        }
+    }
+    return mPositive.empty() ? 0 : static_cast<int64_t>(std::llround(bucketValue(mPositive.rbegin()->first)));
+}
+
+std::vector<QuantileSketch::Bucket> QuantileSketch::nonNegativeAscending() const {
+    std::vector<Bucket> buckets;
+    buckets.reserve(mPositive.size() + 1);
+    uint64_t nonPositive = mZeroCount;
+    for (const auto& [index, bucket] : mNegative) {
+        nonPositive += bucket.count;
+    }
+    if (nonPositive > 0) {
+        buckets.push_back({nonPositive, 0.0});
+    }
+    for (const auto& [index, bucket] : mPositive) {
+        buckets.push_back(bucket);
+    }
+    return buckets;
+}
+
+double QuantileSketch::gini() const {
+    if (mCount == 0) {
+        return 0.0;
+    }
+    std::vector<Bucket> buckets = nonNegativeAscending();
+    double              total   = 0.0;
+    for (const auto& bucket : buckets) {
+        total += bucket.sum;
+    }
+    if (total <= 0.0) {
+        return 0.0;
+    }
+    // 洛伦兹曲线下的面积 (桶内账户视为余额相同)，G = 1 - 2B
+    double area       = 0.0;
+    double cumulative = 0.0;
+    for (const auto& bucket : buckets) {
+        double previousShare = cumulative / total;
+        cumulative          += bucket.sum;
+        double share         = cumulative / total;
+        area += static_cast<double>(bucket.count) / static_cast<double>(mCount) * (previousShare + share) / 2.0;
+    }
+    return std::clamp(1.0 - 2.0 * area, 0.0, 1.0);
+}
+
+double QuantileSketch::topShare(double fraction) const {
+    if (mCount == 0) {
+        return 0.0;
+    }
+    std::vector<Bucket> buckets = nonNegativeAscending();
+    double              total   = 0.0;
+    for (const auto& bucket : buckets) {
+        total += bucket.sum;
+    }
+    if (total <= 0.0) {
+        return 0.0;
+    }
+    double remaining = std::clamp(fraction, 0.0, 1.0) * static_cast<double>(mCount);
+    double held      = 0.0;
+    for (auto it = buckets.rbegin(); it != buckets.rend() && remaining > 0.0; ++it) {
+        double take = std::min(remaining, static_cast<double>(it->count));
+        held       += it->sum * take / static_cast<double>(it->count);
+        remaining  -= take;
+    }
+    return std::clamp(held / total, 0.0, 1.0);
+}
+
+// --- WealthAnalyticsEngine ---
+
+WealthAnalyticsEngine::WealthAnalyticsEngine(
+    db::IDatabaseConnection& dbConn,
+    const Config&            config,
+    std::filesystem::path    dumpPath,
+    ConnectionFactory        connectionFactory
+)
+: mDbConnection(dbConn),
+  mConfig(config),
+  mDumpPath(std::move(dumpPath)),
+  mConnectionFactory(std::move(connectionFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+WealthAnalyticsEngine::~WealthAnalyticsEngine() { stop(); }
+
+bool WealthAnalyticsEngine::start() {
+    {
+        std::lock_guard lock(mMutex);
+        if (mRunning) {
+            return false;
+        }
+    }
+    // 上一次统计的工作线程已经完成 (mRunning 为 false)，回收线程
+    if (mFlowWorker.joinable()) {
+        mFlowWorker.join();
+    }
+    std::lock_guard lock(mMutex);
+    mRunning   = true;
+    mCancelled = false;
+    mCursor    = 0;
+    mScanned   = 0;
+    mFlowDay   = -1;
+    mStartedAt = std::chrono::steady_clock::now();
+    mAccumulators.clear();
+    mFlows.clear();
+    mLogger.debug("财富分布统计开始。");
+    return true;
+}
+
+void WealthAnalyticsEngine::stop() {
+    mCancelled = true;
+    if (mFlowWorker.joinable()) {
+        mFlowWorker.join();
+    }
+    std::lock_guard lock(mMutex);
+    if (mRunning) {
+        mRunning = false;
+        mAccumulators.clear();
+        mFlows.clear();
+        mLogger.warn("财富分布统计已取消。");
+    }
+}
+
+bool WealthAnalyticsEngine::isRunning() const {
+    std::lock_guard lock(mMutex);
+    return mRunning;
+}
+
+std::optional<WealthReport> WealthAnalyticsEngine::getLastReport() const {
+    std::lock_guard lock(mMutex);
+    return mLastReport;
+}
+
+bool WealthAnalyticsEngine::runNextChunk() {
+    int64_t cursor  = 0;
+    int     flowDay = -1;
+    {
+        std::lock_guard lock(mMutex);
+        if (!mRunning) {
+            return false;
+        }
+        cursor  = mCursor;
+        flowDay = mFlowDay;
+    }
+
+    // SQLite：每个任务汇总一天的流水，从最早的一天开始，结果保持按日期排序
+    if (flowDay >= 0) {
+        std::vector<DailyMoneyFlow> flows = queryDailyFlows(mDbConnection, flowDay, flowDay);
+        bool                        more  = false;
+        {
+            std::lock_guard lock(mMutex);
+            if (!mRunning) {
+                return false;
+            }
+            mFlows.insert(mFlows.end(), std::make_move_iterator(flows.begin()), std::make_move_iterator(flows.end()));
+            mFlowDay = flowDay - 1;
+            more     = mFlowDay >= 0;
+        }
+        if (!more) {
+            finish(&mDbConnection);
+        }
+        return more;
+    }
+
+    std::string dbType    = mDbConnection.getDbType();
+    bool        pg        = dbType == "postgresql";
+    int64_t     chunkSize = std::max(1, mConfig.analytics.chunkSize);
+    db::DbResult result;
+    try {
+        result = mDbConnection.queryPrepared(
+            std::string("SELECT id, currency_type, amount FROM player_balances WHERE id > ") + (pg ? "$1" : "?")
+                + " ORDER BY id LIMIT " + (pg ? "$2" : "?") + ";",
+            {cursor, chunkSize}
+        );
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("财富分布统计读取账户 (id > {}) 失败，本次统计中止: {}", cursor, e.what());
+        std::lock_guard lock(mMutex);
+        mRunning = false;
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("财富分布统计时发生意外错误，本次统计中止: {}", e.what());
+        std::lock_guard lock(mMutex);
+        mRunning = false;
+        return false;
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        if (!mRunning) {
+            return false;
+        }
+        for (const auto& row : result) {
+            if (row.size() != 3) continue;
+            mCursor             = db::toInt64(row[0]).value_or(mCursor);
+            int64_t amount      = db::toInt64(row[2]).value_or(0);
+            auto [it, inserted] = mAccumulators.try_emplace(db::toString(row[1]));
+            auto& acc           = it->second;
+            if (inserted) {
+                acc.sketch = QuantileSketch(mConfig.analytics.relativeAccuracy);
+            }
+            acc.sketch.add(amount);
+            acc.accounts += 1;
+            acc.total    += amount;
+            if (amount == 0) {
+                acc.zeroAccounts += 1;
+            } else if (amount < 0) {
+                acc.negativeAccounts += 1;
+            }
+            ++mScanned;
+        }
+        if (static_cast<int64_t>(result.size()) >= chunkSize) {
+            return true;
+        }
+        // 账户遍历完成，SQLite 接着在服务器线程上逐天汇总流水
+        if (dbType == "sqlite" || !mConnectionFactory) {
+            mFlowDay = std::max(1, mConfig.analytics.flowDays) - 1;
+            return true;
+        }
+    }
+
+    // MySQL / PostgreSQL：在工作线程中用独立连接汇总流水
+    if (mFlowWorker.joinable()) {
+        mFlowWorker.join();
+    }
+    mFlowWorker = std::thread([this]() { flowWorkerLoop(); });
+    return false;
+}
+
+void WealthAnalyticsEngine::flowWorkerLoop() {
+    std::unique_ptr<db::IDatabaseConnection> conn;
+    try {
+        conn = mConnectionFactory();
+        if (!conn || !conn->connect()) {
+            throw std::runtime_error("无法建立工作线程的数据库连接");
+        }
+    } catch (const std::exception& e) {
+        // 流水汇总只是报告的一部分，账户分布照常输出
+        mLogger.error("财富分布统计无法汇总每日流水: {}", e.what());
+        conn.reset();
+    }
+
+    if (conn) {
+        std::vector<DailyMoneyFlow> flows = queryDailyFlows(*conn, 0, std::max(1, mConfig.analytics.flowDays) - 1);
+        std::lock_guard             lock(mMutex);
+        mFlows = std::move(flows);
+    }
+    if (!mCancelled) {
+        finish(conn.get());
+    }
+}
+
+std::vector<DailyMoneyFlow>
+WealthAnalyticsEngine::queryDailyFlows(db::IDatabaseConnection& conn, int newestDay, int oldestDay) {
+    std::vector<DailyMoneyFlow> flows;
+    std::string                 dbType = conn.getDbType();
+    std::string                 dayExpr;
+    // 第 offset 天前的零点
+    std::function<std::string(int)> dayStart;
+    if (dbType == "mysql") {
+        dayExpr  = "DATE(timestamp)";
+        dayStart = [](int offset) { return fmt::format("CURRENT_DATE - INTERVAL {} DAY", offset); };
+    } else if (dbType == "sqlite") {
+        dayExpr  = "DATE(timestamp)";
+        dayStart = [](int offset) { return fmt::format("DATE('now', '-{} days')", offset); };
+    } else if (dbType == "postgresql") {
+        dayExpr  = "CAST(timestamp AS DATE)";
+        dayStart = [](int offset) { return fmt::format("CURRENT_DATE - {}", offset); };
+    } else {
+        return flows;
+    }
+
+    std::string range = "timestamp >= " + dayStart(oldestDay);
+    if (newestDay > 0) {
+        range += " AND timestamp < " + dayStart(newestDay - 1);
+    }
+    std::string sql = "SELECT " + dayExpr + ", currency_type, "
+                    + "COALESCE(SUM(CASE WHEN change_amount > 0 THEN change_amount ELSE 0 END), 0), "
+                    + "COALESCE(SUM(CASE WHEN change_amount < 0 THEN -change_amount ELSE 0 END), 0), COUNT(*) "
+                    + "FROM economy_log WHERE " + range + " GROUP BY 1, 2 ORDER BY 1, 2;";
+    try {
+        db::DbResult result = conn.query(sql);
+        for (const auto& row : result) {
+            if (row.size() != 5) continue;
+            DailyMoneyFlow flow;
+            flow.day          = db::toString(row[0]);
+            flow.currencyType = db::toString(row[1]);
+            flow.created      = db::toInt64(row[2]).value_or(0);
+            flow.destroyed    = db::toInt64(row[3]).value_or(0);
+            flow.entries      = db::toInt64(row[4]).value_or(0);
+            flows.push_back(std::move(flow));
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("汇总每日流水失败: {}", e.what());
+    } catch (const std::exception& e) {
+        mLogger.error("汇总每日流水时发生意外错误: {}", e.what());
+    }
+    return flows;
+}
+
+void WealthAnalyticsEngine::finish(db::IDatabaseConnection* conn) {
+    std::map<std::string, CurrencyAccumulator> accumulators;
+    WealthReport                               report;
+    {
+        std::lock_guard lock(mMutex);
+        accumulators           = std::move(mAccumulators);
+        report.dailyFlows      = std::move(mFlows);
+        report.accountsScanned = mScanned;
+        mAccumulators.clear();
+        mFlows.clear();
+    }
+
+    std::vector<double> percentiles = mConfig.analytics.percentiles;
+    for (auto& [currency, acc] : accumulators) {
+        CurrencyWealthStats stats;
+        stats.currencyType     = currency;
+        stats.accounts         = acc.accounts;
+        stats.zeroAccounts     = acc.zeroAccounts;
+        stats.negativeAccounts = acc.negativeAccounts;
+        stats.totalSupply      = acc.total;
+        stats.mean             = acc.accounts > 0 ? acc.total / static_cast<int64_t>(acc.accounts) : 0;
+        stats.gini             = acc.sketch.gini();
+        stats.top1Share        = acc.sketch.topShare(0.01);
+        stats.top10Share       = acc.sketch.topShare(0.10);
+        for (double p : percentiles) {
+            double clamped = std::clamp(p, 0.0, 100.0);
+            stats.percentiles.emplace_back(clamped, acc.sketch.quantile(clamped / 100.0));
+        }
+        report.currencies.push_back(std::move(stats));
+    }
+
+    if (conn) {
+        try {
+            db::DbResult now = conn->query("SELECT CURRENT_TIMESTAMP;");
+            if (!now.empty() && !now[0].empty()) {
+                report.generatedAt = db::toString(now[0][0]);
+            }
+        } catch (const std::exception&) {
+            // 时间只用于展示，读取失败时留空
+        }
+    }
+    report.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartedAt).count();
+
+    mLogger.info(
+        "财富分布统计完成：{} 个账户，{} 种货币，耗时 {:.0f}ms",
+        report.accountsScanned,
+        report.currencies.size(),
+        report.elapsedMs
+    );
+    writeDump(report);
+
+    std::lock_guard lock(mMutex);
+    mRunning    = false;
+    mLastReport = std::move(report);
+}
+
+void WealthAnalyticsEngine::writeDump(const WealthReport& report) {
+    if (mDumpPath.empty()) {
+        return;
+    }
+    try {
+        if (mDumpPath.has_parent_path()) {
+            std::filesystem::create_directories(mDumpPath.parent_path());
+        }
+        // 先写临时文件再替换，外部程序不会读到写了一半的文件
+        std::filesystem::path tmpPath = mDumpPath;
+        tmpPath += ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                mLogger.error("无法写入财富统计文件: {}", tmpPath.string());
+                return;
+            }
+            out << toJson(report);
+        }
+        std::filesystem::rename(tmpPath, mDumpPath);
+    } catch (const std::exception& e) {
+        mLogger.error("写入财富统计文件 {} 失败: {}", mDumpPath.string(), e.what());
+    }
+}
+
+std::string WealthAnalyticsEngine::toJson(const WealthReport& report) {
+    std::string json = "{\n";
+    json += fmt::format("  \"generatedAt\": {},\n", jsonEscape(report.generatedAt));
+    json += fmt::format("  \"accountsScanned\": {},\n", report.accountsScanned);
+    json += fmt::format("  \"elapsedMs\": {:.1f},\n", report.elapsedMs);
+
+    json += "  \"currencies\": {";
+    for (size_t i = 0; i < report.currencies.size(); ++i) {
+        const auto& stats = report.currencies[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += fmt::format("    {}: {{\n", jsonEscape(stats.currencyType));
+        json += fmt::format("      \"accounts\": {},\n", stats.accounts);
+        json += fmt::format("      \"zeroAccounts\": {},\n", stats.zeroAccounts);
+        json += fmt::format("      \"negativeAccounts\": {},\n", stats.negativeAccounts);
+        json += fmt::format("      \"totalSupply\": {},\n", jsonAmount(stats.totalSupply));
+        json += fmt::format("      \"mean\": {},\n", jsonAmount(stats.mean));
+        json += fmt::format("      \"gini\": {:.4f},\n", stats.gini);
+        json += fmt::format("      \"top1Share\": {:.4f},\n", stats.top1Share);
+        json += fmt::format("      \"top10Share\": {:.4f},\n", stats.top10Share);
+        json += "      \"percentiles\": {";
+        for (size_t j = 0; j < stats.percentiles.size(); ++j) {
+            json += fmt::format(
+                "{}\"p{:g}\": {}",
+                j == 0 ? "" : ", ",
+                stats.percentiles[j].first,
+                jsonAmount(stats.percentiles[j].second)
+            );
+        }
+        json += "}\n    }";
+    }
+    json += report.currencies.empty() ? "},\n" : "\n  },\n";
+
+    json += "  \"dailyFlows\": [";
+    for (size_t i = 0; i < report.dailyFlows.size(); ++i) {
+        const auto& flow = report.dailyFlows[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += fmt::format(
+            "    {{\"day\": {}, \"currency\": {}, \"created\": {}, \"destroyed\": {}, \"net\": {}, \"entries\": {}}}",
+            jsonEscape(flow.day),
+            jsonEscape(flow.currencyType),
+            jsonAmount(flow.created),
+            jsonAmount(flow.destroyed),
+            jsonAmount(flow.created - flow.destroyed),
+            flow.entries
+        );
+    }
+    json += report.dailyFlows.empty() ? "]\n" : "\n  ]\n";
+    json += "}\n";
+    return json;
+}
+
+} // namespace czmoney
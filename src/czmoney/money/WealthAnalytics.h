@@ -0,0 +1,217 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace czmoney {
+
+/**
+ * @brief 固定内存的分位数草图 (对数分桶，相对误差有界)
+ *
+ * 值 v 落入下标为 ceil(log_gamma(|v|)) 的桶，gamma = (1 + a) / (1 - a)，
+ * 用桶的代表值估计分位数时相对误差不超过 a。负数使用镜像的一组桶，0 单独计数。
+ * 每个桶同时记录数量与总和，用于估算洛伦兹曲线 (基尼系数、头部份额)。
+ * 桶数量超过上限时合并最小的桶，内存与账户数量无关。
+ */
+class QuantileSketch {
+public:
+    /**
+     * @brief 构造函数
+     * @param relativeAccuracy 相对误差 (0 到 1 之间，例如 0.01)
+     * @param maxBuckets 每一侧 (正/负) 最多保留的桶数量
+     */
+    explicit QuantileSketch(double relativeAccuracy = 0.01, size_t maxBuckets = 2048);
+
+    void add(int64_t value);
+
+    [[nodiscard]] uint64_t count() const { return mCount; }
+
+    /**
+     * @brief 估算分位数
+     * @param q 0 到 1 之间的分位点
+     * @return int64_t 估计值，草图为空时返回 0
+     */
+    [[nodiscard]] int64_t quantile(double q) const;
+
+    /**
+     * @brief 估算基尼系数 (负余额按 0 计算)
+     * @return double 0 到 1 之间，总额为 0 时返回 0
+     */
+    [[nodiscard]] double gini() const;
+
+    /**
+     * @brief 估算余额最高的一部分账户持有的份额 (负余额按 0 计算)
+     * @param fraction 账户比例，例如 0.01 表示前 1%
+     * @return double 0 到 1 之间
+     */
+    [[nodiscard]] double topShare(double fraction) const;
+
+private:
+    struct Bucket {
+        uint64_t count = 0;
+        double   sum   = 0; // 桶内实际值之和 (绝对值)
+    };
+
+    double                  mGamma;
+    double                  mLogGamma;
+    size_t                  mMaxBuckets;
+    std::map<int, Bucket>   mPositive;
+    std::map<int, Bucket>   mNegative;
+    uint64_t                mZeroCount = 0;
+    uint64_t                mCount     = 0;
+
+    int    bucketIndex(double absValue) const;
+    double bucketValue(int index) const;
+    static void collapseLowest(std::map<int, Bucket>& buckets, size_t maxBuckets);
+    // 按升序排列的非负桶 (数量, 总和)，负数桶记为 0
+    std::vector<Bucket> nonNegativeAscending() const;
+};
+
+// 单个货币的财富分布统计
+struct CurrencyWealthStats {
+    std::string currencyType;
+    uint64_t    accounts = 0;
+    uint64_t    zeroAccounts = 0;
+    uint64_t    negativeAccounts = 0;
+    int64_t     totalSupply = 0;  // 余额总和 (整数，实际金额 * 100)
+    int64_t     mean = 0;
+    double      gini = 0;
+    double      top1Share = 0;    // 前 1% 账户持有的份额
+    double      top10Share = 0;   // 前 10% 账户持有的份额
+    std::vector<std::pair<double, int64_t>> percentiles; // (百分位, 估计余额)
+};
+
+// 某天某货币的流水汇总
+struct DailyMoneyFlow {
+    std::string day;           // 数据库日期，例如 "2025-01-01"
+    std::string currencyType;
+    int64_t     created = 0;   // 正向变动之和
+    int64_t     destroyed = 0; // 负向变动之和 (取正值)
+    int64_t     entries = 0;   // 流水条数
+};
+
+// 一次统计的结果
+struct WealthReport {
+    std::string                      generatedAt;     // 完成时间 (数据库时间)
+    uint64_t                         accountsScanned = 0;
+    double                           elapsedMs = 0;
+    std::vector<CurrencyWealthStats> currencies;
+    std::vector<DailyMoneyFlow>      dailyFlows;
+};
+
+/**
+ * @brief 财富分布统计
+ *
+ * 按 player_balances.id 做 keyset 分块，单次遍历所有账户，把余额喂给每种货币各自的 QuantileSketch，
+ * 总额、账户数等精确值顺带累加；遍历结束后再按天汇总最近几天的流水：
+ * - MySQL / PostgreSQL：在独立连接的工作线程中用一条 GROUP BY 查询完成，不占用服务器线程。
+ * - SQLite：其他连接的读锁会让服务器的写入失败，因此仍使用主连接，但每个调度器任务只汇总一天。
+ * 数据库读写期间不持有内部锁，读取结果与上一次统计不会被阻塞。
+ * 分块之间余额仍可能变动，因此结果是近似的“遍历期间”视图，而不是某一时刻的精确快照。
+ * 流水中的转账会同时计入 created 和 destroyed，净值 (created - destroyed) 才是货币总量的实际变化。
+ */
+class WealthAnalyticsEngine {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    /**
+     * @brief 构造函数
+     * @param dbConn 主数据库连接 (只在服务器线程上使用)
+     * @param config 配置对象
+     * @param dumpPath 每次统计完成后写入 JSON 的文件路径，为空时不写入
+     * @param connectionFactory 为汇总流水的工作线程创建独立连接的工厂，为空时使用主连接
+     */
+    WealthAnalyticsEngine(
+        db::IDatabaseConnection& dbConn,
+        const Config&            config,
+        std::filesystem::path    dumpPath,
+        ConnectionFactory        connectionFactory = {}
+    );
+    ~WealthAnalyticsEngine();
+
+    WealthAnalyticsEngine(const WealthAnalyticsEngine&) = delete;
+    WealthAnalyticsEngine& operator=(const WealthAnalyticsEngine&) = delete;
+
+    /**
+     * @brief 开始一次统计
+     * @return bool 是否成功开始 (已有统计在运行时返回 false)
+     */
+    bool start();
+
+    /**
+     * @brief 取消正在运行的统计，并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 处理下一个分块 (账户，或 SQLite 下的一天流水)，全部处理完后写入 JSON
+     * @return bool 是否还有剩余分块需要在服务器线程上处理
+     */
+    bool runNextChunk();
+
+    /**
+     * @brief 是否有统计在运行
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * @brief 获取最近一次完成的统计结果
+     * @return std::optional<WealthReport> 从未完成过统计时返回 std::nullopt
+     */
+    [[nodiscard]] std::optional<WealthReport> getLastReport() const;
+
+    /**
+     * @brief 把统计结果序列化为 JSON
+     */
+    static std::string toJson(const WealthReport& report);
+
+private:
+    struct CurrencyAccumulator {
+        QuantileSketch sketch;
+        uint64_t       accounts = 0;
+        uint64_t       zeroAccounts = 0;
+        uint64_t       negativeAccounts = 0;
+        int64_t        total = 0;
+    };
+
+    db::IDatabaseConnection& mDbConnection;
+    const Config&            mConfig;
+    std::filesystem::path    mDumpPath;
+    ConnectionFactory        mConnectionFactory;
+    ll::io::Logger&          mLogger;
+
+    mutable std::mutex                         mMutex; // 保护下面的运行状态与结果 (不在数据库读写期间持有)
+    bool                                       mRunning = false;
+    int64_t                                    mCursor = 0;
+    uint64_t                                   mScanned = 0;
+    int                                        mFlowDay = -1; // SQLite 下下一个要汇总的日期 (几天前)，-1 表示不在汇总流水
+    std::chrono::steady_clock::time_point      mStartedAt;
+    std::map<std::string, CurrencyAccumulator> mAccumulators;
+    std::vector<DailyMoneyFlow>                mFlows;
+    std::optional<WealthReport>                mLastReport;
+    std::atomic<bool>                          mCancelled{false};
+    std::thread                                mFlowWorker;
+
+    // 汇总 [newestDay, oldestDay] 天前 (0 表示今天) 的每日流水
+    std::vector<DailyMoneyFlow> queryDailyFlows(db::IDatabaseConnection& conn, int newestDay, int oldestDay);
+    void                        flowWorkerLoop();
+    // 生成报告并写入 JSON；conn 用于读取数据库时间，可为 nullptr
+    void                        finish(db::IDatabaseConnection* conn);
+    void                        writeDump(const WealthReport& report);
+};
+
+} // namespace czmoney
@@ -0,0 +1,564 @@
+#include "czmoney/money/WorkloadReplay.h"
+#include "czmoney/money/BulkAdjustment.h" // SUMMARY_LOG_UUID
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/ReasonIndex.h"
+#include "czmoney/money/money.h"
+#include "czmoney/db/columnar.h"
+#include "ll/api/mod/NativeMod.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <utility>
+
+namespace czmoney {
+
+namespace {
+constexpr const char* CSV_HEADER =
+    "id,timestamp,uuid,currency_type,change_amount,previous_amount,reason1,reason2,reason3";
+constexpr size_t CSV_COLUMNS = 9;
+
+// 写入一个 CSV 字段 (包含逗号、引号或换行时加引号并转义)
+void writeCsvField(std::ostream& out, std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out << value;
+        return;
+    }
+    out << '"';
+    for (char c : value) {
+        if (c == '"') out << '"';
+        out << c;
+    }
+    out << '"';
+}
+
+// 读取一条 CSV 记录 (支持引号内的逗号、换行和转义的双引号)，文件结束时返回 false
+bool readCsvRecord(std::istream& in, std::vector<std::string>& fields) {
+    fields.clear();
+    std::string field;
+    bool        quoted = false;
+    bool        any    = false;
+    int         c;
+    while ((c = in.get()) != EOF) {
+        any = true;
+        if (quoted) {
+            if (c == '"') {
+                if (in.peek() == '"') {
+                    field += '"';
+                    in.get();
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += static_cast<char>(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else if (c == '\n') {
+            break;
+        } else if (c != '\r') {
+            field += static_cast<char>(c);
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    fields.push_back(std::move(field));
+    return true;
+}
+
+// 把 "YYYY-MM-DD HH:MM:SS[.ffffff]" 转换为秒数，只用于计算相对间隔
+std::optional<double> parseTimestamp(const std::string& text) {
+    int    year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    double second = 0;
+    if (std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%lf", &year, &month, &day, &hour, &minute, &second) != 6) {
+        return std::nullopt;
+    }
+    // days_from_civil (Howard Hinnant)
+    year             -= month <= 2 ? 1 : 0;
+    int      era      = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe      = static_cast<unsigned>(year - era * 400);
+    unsigned doy      = (153 * static_cast<unsigned>(month + (month > 2 ? -3 : 9)) + 2) / 5 + static_cast<unsigned>(day) - 1;
+    unsigned doe      = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t  days     = static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(doe) - 719468;
+    return static_cast<double>(days) * 86400.0 + hour * 3600.0 + minute * 60.0 + second;
+}
+
+std::optional<int64_t> parseInt64(const std::string& text) {
+    try {
+        size_t  used  = 0;
+        int64_t value = std::stoll(text, &used);
+        if (used != text.size()) return std::nullopt;
+        return value;
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+double percentile(const std::vector<float>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size()))) - 1;
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+WorkloadReplayer::WorkloadReplayer(
+    db::IDatabaseConnection& mainConn,
+    const Config&            config,
+    std::filesystem::path    directory,
+    ConnectionFactory        targetFactory
+)
+: mMainConn(mainConn),
+  mConfig(config),
+  mDirectory(std::move(directory)),
+  mTargetFactory(std::move(targetFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+WorkloadReplayer::~WorkloadReplayer() { stop(); }
+
+std::optional<std::filesystem::path> WorkloadReplayer::resolveFile(const std::string& fileName) const {
+    // 只允许导出目录下的文件名，避免通过命令读写任意路径
+    if (fileName.empty() || fileName.find_first_of("/\\:") != std::string::npos || fileName.find("..") != std::string::npos) {
+        return std::nullopt;
+    }
+    return mDirectory / fileName;
+}
+
+bool WorkloadReplayer::isRunning() const {
+    std::lock_guard lock(mMutex);
+    return mReport.running;
+}
+
+ReplayReport WorkloadReplayer::getReport() const {
+    std::lock_guard lock(mMutex);
+    ReplayReport report = mReport;
+    if (report.running) {
+        report.elapsedMs = millisecondsSince(mStartedAt);
+    }
+    return report;
+}
+
+void WorkloadReplayer::fail(const std::string& error) {
+    std::lock_guard lock(mMutex);
+    mLogger.error("流水{}失败: {}", mReport.mode == "export" ? "导出" : "回放", error);
+    mReport.error     = error;
+    mReport.running   = false;
+    mReport.elapsedMs = millisecondsSince(mStartedAt);
+}
+
+void WorkloadReplayer::stop() {
+    mCancelled = true;
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    // 导出在服务器线程上分块进行，调度器停止后不会再有下一块，在这里收尾
+    if (mExportStream.is_open()) {
+        finishExport("");
+    }
+}
+
+// --- 导出 ---
+
+bool WorkloadReplayer::startExport(const std::string& fileName) {
+    auto path = resolveFile(fileName);
+    if (!path) {
+        mLogger.error("无效的导出文件名: {}", fileName);
+        return false;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+    }
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(mDirectory, ec);
+    mExportPath = *path;
+    std::filesystem::path tmpPath = mExportPath;
+    tmpPath += ".tmp";
+    mExportStream.open(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!mExportStream) {
+        mLogger.error("无法写入导出文件: {}", tmpPath.string());
+        return false;
+    }
+    mExportStream << CSV_HEADER << '\n';
+    mExportCursor = 0;
+    mCancelled    = false;
+
+    std::lock_guard lock(mMutex);
+    mReport         = ReplayReport{};
+    mReport.mode    = "export";
+    mReport.file    = fileName;
+    mReport.running = true;
+    mStartedAt      = std::chrono::steady_clock::now();
+    mLogger.info("开始导出流水到 {}", mExportPath.string());
+    return true;
+}
+
+bool WorkloadReplayer::runNextExportChunk() {
+    if (!mExportStream.is_open()) {
+        return false;
+    }
+    if (mCancelled) {
+        finishExport("");
+        return false;
+    }
+
+    std::string dbType    = mMainConn.getDbType();
+    int         chunkSize = std::clamp(mConfig.replay.exportChunkSize, 1, 100000);
+    std::string sql = "SELECT id, timestamp, uuid, currency_type, change_amount, previous_amount, reason1, reason2, reason3 "
+                      "FROM economy_log WHERE id > "
+                    + std::string(dbType == "postgresql" ? "$1" : "?") + " ORDER BY id LIMIT " + std::to_string(chunkSize)
+                    + ";";
+    try {
+        // 按列读取，文本单元格直接从结果缓冲区写入文件
+        db::ColumnarResult rows = mMainConn.queryColumnar(sql, {mExportCursor});
+        if (!rows.empty() && rows.columnCount() != CSV_COLUMNS) {
+            finishExport("流水查询返回的列数不正确");
+            return false;
+        }
+        for (size_t row = 0; row < rows.rowCount(); ++row) {
+            mExportCursor = rows.getInt64(row, 0).value_or(mExportCursor);
+            mExportStream << mExportCursor;
+            for (size_t i = 1; i < CSV_COLUMNS; ++i) {
+                mExportStream << ',';
+                if (rows.kind(row, i) == db::ColumnKind::Text) {
+                    writeCsvField(mExportStream, rows.getText(row, i));
+                } else {
+                    writeCsvField(mExportStream, rows.getString(row, i));
+                }
+            }
+            mExportStream << '\n';
+        }
+        {
+            std::lock_guard lock(mMutex);
+            mReport.totalOps += rows.rowCount();
+        }
+        if (!mExportStream) {
+            finishExport("写入导出文件失败");
+            return false;
+        }
+        if (rows.rowCount() < static_cast<size_t>(chunkSize)) {
+            finishExport("");
+            return false;
+        }
+        return true;
+    } catch (const db::DatabaseException& e) {
+        finishExport(std::string("读取流水失败: ") + e.what());
+        return false;
+    } catch (const std::exception& e) {
+        finishExport(std::string("导出时发生意外错误: ") + e.what());
+        return false;
+    }
+}
+
+void WorkloadReplayer::finishExport(const std::string& error) {
+    mExportStream.close();
+    std::filesystem::path tmpPath = mExportPath;
+    tmpPath += ".tmp";
+    std::error_code ec;
+    if (error.empty() && !mCancelled) {
+        std::filesystem::rename(tmpPath, mExportPath, ec);
+        if (ec) {
+            fail("无法重命名导出文件: " + ec.message());
+            return;
+        }
+        std::lock_guard lock(mMutex);
+        mReport.running   = false;
+        mReport.elapsedMs = millisecondsSince(mStartedAt);
+        mLogger.info("流水导出完成: {} 行，耗时 {:.0f}ms", mReport.totalOps, mReport.elapsedMs);
+        return;
+    }
+    std::filesystem::remove(tmpPath, ec);
+    if (!error.empty()) {
+        fail(error);
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    mReport.running   = false;
+    mReport.cancelled = true;
+    mReport.elapsedMs = millisecondsSince(mStartedAt);
+    mLogger.info("流水导出已取消。");
+}
+
+// --- 回放 ---
+
+bool WorkloadReplayer::startReplay(const std::string& fileName, double speed, bool overwrite) {
+    auto path = resolveFile(fileName);
+    if (!path || !std::filesystem::exists(*path)) {
+        mLogger.error("回放文件不存在或文件名无效: {}", fileName);
+        return false;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        if (mReport.running) {
+            return false;
+        }
+        mReport         = ReplayReport{};
+        mReport.mode    = "replay";
+        mReport.file    = fileName;
+        mReport.speed   = std::max(0.0, speed);
+        mReport.running = true;
+        mStartedAt      = std::chrono::steady_clock::now();
+    }
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+    mCancelled = false;
+    mWorker    = std::thread([this, p = *path, s = std::max(0.0, speed), overwrite]() { replayWorker(p, s, overwrite); });
+    mLogger.info("开始回放流水文件 {} (倍速: {})", path->string(), speed > 0 ? std::to_string(speed) : "不等待");
+    return true;
+}
+
+bool WorkloadReplayer::loadOps(
+    const std::filesystem::path& path,
+    std::vector<ReplayOp>&       ops,
+    uint64_t&                    skipped,
+    std::string&                 error
+) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "无法读取回放文件: " + path.string();
+        return false;
+    }
+    std::vector<std::string> fields;
+    std::optional<double>    firstTime;
+    bool                     header = true;
+    while (readCsvRecord(in, fields)) {
+        if (header) {
+            header = false;
+            if (!fields.empty() && fields[0] == "id") continue;
+        }
+        if (fields.size() != CSV_COLUMNS) {
+            ++skipped;
+            continue;
+        }
+        // 旧版本批量调整写入的汇总流水无法还原到单个账户
+        if (fields[2] == BulkAdjustmentEngine::SUMMARY_LOG_UUID) {
+            ++skipped;
+            continue;
+        }
+        auto time     = parseTimestamp(fields[1]);
+        auto change   = parseInt64(fields[4]);
+        auto previous = parseInt64(fields[5]);
+        if (!time || !change || !previous || fields[2].empty() || fields[3].empty()) {
+            ++skipped;
+            continue;
+        }
+        if (!firstTime) {
+            firstTime = *time;
+        }
+        ops.push_back(
+            {std::max(0.0, *time - *firstTime),
+             std::move(fields[2]),
+             std::move(fields[3]),
+             *change,
+             *previous,
+             std::move(fields[6]),
+             std::move(fields[7]),
+             std::move(fields[8])}
+        );
+    }
+    return true;
+}
+
+void WorkloadReplayer::replayWorker(std::filesystem::path path, double speed, bool overwrite) {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<ReplayOp> ops;
+    uint64_t              skipped = 0;
+    std::string           error;
+    if (!loadOps(path, ops, skipped, error)) {
+        fail(error);
+        return;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        mReport.totalOps    = ops.size();
+        mReport.skippedRows = skipped;
+    }
+
+    std::unique_ptr<db::IDatabaseConnection> conn = mTargetFactory ? mTargetFactory() : nullptr;
+    if (!conn) {
+        fail("无法创建回放目标数据库连接 (请检查 replay 配置，目标不能与生产数据库相同)");
+        return;
+    }
+
+    try {
+        if (!conn->connect()) {
+            fail("无法连接回放目标数据库");
+            return;
+        }
+        std::string dbType = conn->getDbType();
+        {
+            std::lock_guard lock(mMutex);
+            mReport.targetType = dbType;
+        }
+
+        // 用 MoneyManager 建表，目标库的表结构和索引与生产一致
+        MoneyManager schema(*conn, mConfig);
+        if (!schema.initializeTable()) {
+            fail("无法在回放目标数据库中建立表结构");
+            return;
+        }
+        // 回放会清空目标库；已有数据时必须显式确认，避免误清空一个正在使用的数据库
+        if (!overwrite
+            && (!conn->query("SELECT 1 FROM player_balances LIMIT 1;").empty()
+                || !conn->query("SELECT 1 FROM economy_log LIMIT 1;").empty())) {
+            fail("回放目标数据库中已有余额或流水，如确认要清空请使用 overwrite 参数");
+            return;
+        }
+        conn->execute("DELETE FROM economy_log;");
+        conn->execute("DELETE FROM player_balances;");
+        // 理由全文索引在清空后的表上同步建立 (本线程不是服务器线程)
+        if (mConfig.db_reason_index) {
+            ReasonIndexBuilder::buildNow(*conn, schema);
+        }
+
+        auto p = [&](int index) { return placeholder(dbType, index); };
+        const std::string insertAccountSql =
+            "INSERT INTO player_balances (uuid, currency_type, amount) VALUES (" + p(1) + ", " + p(2) + ", " + p(3) + ");";
+        const std::string selectSql =
+            "SELECT amount FROM player_balances WHERE uuid = " + p(1) + " AND currency_type = " + p(2) + ";";
+        const std::string updateSql = "UPDATE player_balances SET amount = amount + " + p(1)
+                                    + ", last_updated = CURRENT_TIMESTAMP WHERE uuid = " + p(2) + " AND currency_type = " + p(3) + ";";
+        const std::string logSql =
+            "INSERT INTO economy_log (uuid, currency_type, change_amount, previous_amount, reason1, reason2, reason3) "
+            "VALUES ("
+            + p(1) + ", " + p(2) + ", " + p(3) + ", " + p(4) + ", " + p(5) + ", " + p(6) + ", " + p(7) + ");";
+
+        // 每个账户以首次出现时的余额建立；生产中的最终余额 = 最后一条流水的 previous_amount + change_amount
+        std::map<std::pair<std::string, std::string>, int64_t> expected;
+        auto                                                   seedStart = Clock::now();
+        {
+            db::ScopedTransaction transaction(*conn);
+            for (const auto& op : ops) {
+                auto [it, inserted] = expected.try_emplace({op.uuid, op.currencyType}, op.previous);
+                if (inserted) {
+                    conn->executePrepared(insertAccountSql, {op.uuid, op.currencyType, op.previous});
+                }
+            }
+            transaction.commit();
+        }
+        for (const auto& op : ops) {
+            expected[{op.uuid, op.currencyType}] = op.previous + op.change;
+        }
+        {
+            std::lock_guard lock(mMutex);
+            mReport.accounts = expected.size();
+            mReport.seedMs   = millisecondsSince(seedStart);
+        }
+
+        std::vector<float> latencies;
+        latencies.reserve(ops.size());
+        uint64_t previousMismatches = 0;
+        uint64_t failed             = 0;
+        double   maxLagMs           = 0;
+        auto     start              = Clock::now();
+        for (size_t i = 0; i < ops.size() && !mCancelled; ++i) {
+            const auto& op = ops[i];
+            if (speed > 0) {
+                auto due = start
+                         + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(op.time / speed));
+                // 分段等待，以便及时响应取消
+                while (!mCancelled && Clock::now() < due) {
+                    std::this_thread::sleep_until(std::min(due, Clock::now() + std::chrono::milliseconds(200)));
+                }
+                maxLagMs = std::max(maxLagMs, millisecondsSince(due));
+            }
+
+            auto opStart = Clock::now();
+            try {
+                db::ScopedTransaction transaction(*conn);
+                db::DbResult current = conn->queryPrepared(selectSql, {op.uuid, op.currencyType});
+                if (current.empty() || current[0].empty()
+                    || db::toInt64(current[0][0]).value_or(op.previous) != op.previous) {
+                    ++previousMismatches;
+                }
+                conn->executePrepared(updateSql, {op.change, op.uuid, op.currencyType});
+                conn->executePrepared(
+                    logSql,
+                    {op.uuid, op.currencyType, op.change, op.previous, op.reason1, op.reason2, op.reason3}
+                );
+                transaction.commit();
+            } catch (const std::exception& e) {
+                if (failed++ == 0) {
+                    mLogger.warn("回放第 {} 条操作失败: {}", i + 1, e.what());
+                }
+            }
+            latencies.push_back(static_cast<float>(millisecondsSince(opStart)));
+
+            if ((i + 1) % 1000 == 0) {
+                std::lock_guard lock(mMutex);
+                mReport.replayedOps = i + 1;
+                mReport.failedOps   = failed;
+            }
+        }
+        double elapsedMs = millisecondsSince(start);
+
+        // 逐账户比对最终余额
+        uint64_t     finalMismatches = 0;
+        db::DbResult balances        = conn->query("SELECT uuid, currency_type, amount FROM player_balances;");
+        for (const auto& row : balances) {
+            if (row.size() != 3) continue;
+            auto it = expected.find({db::toString(row[0]), db::toString(row[1])});
+            if (it != expected.end() && db::toInt64(row[2]).value_or(0) != it->second) {
+                ++finalMismatches;
+            }
+        }
+        if (balances.size() < expected.size()) {
+            finalMismatches += expected.size() - balances.size();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::lock_guard lock(mMutex);
+        mReport.running            = false;
+        mReport.cancelled          = mCancelled;
+        mReport.replayedOps        = latencies.size();
+        mReport.failedOps          = failed;
+        mReport.previousMismatches = previousMismatches;
+        mReport.finalMismatches    = finalMismatches;
+        mReport.elapsedMs          = elapsedMs;
+        mReport.opsPerSecond       = elapsedMs > 0 ? static_cast<double>(latencies.size()) * 1000.0 / elapsedMs : 0;
+        mReport.p50Ms              = percentile(latencies, 0.50);
+        mReport.p95Ms              = percentile(latencies, 0.95);
+        mReport.p99Ms              = percentile(latencies, 0.99);
+        mReport.maxMs              = latencies.empty() ? 0 : latencies.back();
+        mReport.maxLagMs           = maxLagMs;
+        mLogger.info(
+            "流水回放{} ({}): {} 条操作，{:.0f} ops/s，延迟 p50 {:.2f}ms / p95 {:.2f}ms / p99 {:.2f}ms / max {:.2f}ms，"
+            "失败 {}，余额不一致 {} 次，最终余额不一致账户 {} 个",
+            mReport.cancelled ? "已取消" : "完成",
+            dbType,
+            mReport.replayedOps,
+            mReport.opsPerSecond,
+            mReport.p50Ms,
+            mReport.p95Ms,
+            mReport.p99Ms,
+            mReport.maxMs,
+            failed,
+            previousMismatches,
+            finalMismatches
+        );
+    } catch (const db::DatabaseException& e) {
+        fail(std::string("回放目标数据库错误: ") + e.what());
+    } catch (const std::exception& e) {
+        fail(std::string("回放时发生意外错误: ") + e.what());
+    }
+    try {
+        conn->disconnect();
+    } catch (...) {}
+}
+
+} // namespace czmoney
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "ll/api/io/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace czmoney {
+
+// 导出或回放的进度与结果
+struct ReplayReport {
+    std::string mode;                    // "export" 或 "replay"
+    std::string file;
+    std::string targetType;              // 回放目标数据库类型
+    bool        running = false;
+    bool        cancelled = false;
+    std::string error;                   // 非空时表示任务失败
+    double      speed = 0;               // 回放倍速，0 表示不等待、尽快执行
+    uint64_t    totalOps = 0;            // 文件中可回放的操作数 (导出时为已写出的行数)
+    uint64_t    replayedOps = 0;
+    uint64_t    failedOps = 0;
+    uint64_t    skippedRows = 0;         // 批量调整汇总流水、格式错误的行
+    uint64_t    accounts = 0;
+    uint64_t    previousMismatches = 0;  // 执行时读到的余额与流水中的 previous_amount 不一致的次数
+    uint64_t    finalMismatches = 0;     // 回放结束后余额与流水推算的最终余额不一致的账户数
+    double      seedMs = 0;              // 建立初始账户的耗时 (不计入吞吐量)
+    double      elapsedMs = 0;
+    double      opsPerSecond = 0;
+    double      p50Ms = 0;
+    double      p95Ms = 0;
+    double      p99Ms = 0;
+    double      maxMs = 0;
+    double      maxLagMs = 0;            // 按原始节奏回放时，实际开始时间落后于计划时间的最大值
+};
+
+/**
+ * @brief 用生产流水做基准测试的导出 / 回放工具
+ *
+ * - 导出：按 id 顺序把 economy_log 分块写成 CSV (在后台任务调度器中使用主连接，每块一次主键范围查询)。
+ *   流水就是已提交操作的完整记录，因此导出文件同时也是操作轨迹。
+ * - 回放：在工作线程中连接单独的目标数据库 (配置 replay)，用 MoneyManager 建立与生产相同的表结构和索引，
+ *   先按每个账户首次出现时的 previous_amount 建立账户，再按原始节奏 (可加速) 或尽快逐条执行
+ *   "读余额 + 更新余额 + 写流水" 事务，统计吞吐量与延迟分位数，最后与流水推算的最终余额逐账户比对。
+ * 回放直接执行 SQL，不经过 MoneyManager 的公共方法，不会触发经济事件，也不会影响生产数据。
+ */
+class WorkloadReplayer {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (导出时在服务器线程上使用)
+     * @param config 配置对象
+     * @param directory 导出文件所在的目录
+     * @param targetFactory 创建回放目标数据库连接的工厂，目标与生产数据库相同时应返回 nullptr
+     */
+    WorkloadReplayer(
+        db::IDatabaseConnection& mainConn,
+        const Config&            config,
+        std::filesystem::path    directory,
+        ConnectionFactory        targetFactory
+    );
+    ~WorkloadReplayer();
+
+    WorkloadReplayer(const WorkloadReplayer&) = delete;
+    WorkloadReplayer& operator=(const WorkloadReplayer&) = delete;
+
+    /**
+     * @brief 开始导出 economy_log
+     * @param fileName 文件名 (位于导出目录下，不能包含路径)
+     * @return bool 是否成功开始 (已有任务在运行或无法创建文件时返回 false)
+     */
+    bool startExport(const std::string& fileName);
+
+    /**
+     * @brief 导出下一块流水
+     * @return bool 是否还有剩余分块需要处理
+     */
+    bool runNextExportChunk();
+
+    /**
+     * @brief 开始回放
+     * @param fileName 导出文件名
+     * @param speed 倍速，1 为原始节奏，0 表示不等待
+     * @param overwrite 目标库已有余额或流水时是否清空后回放 (为 false 时拒绝回放)
+     * @return bool 是否成功开始 (已有任务在运行时返回 false)
+     */
+    bool startReplay(const std::string& fileName, double speed, bool overwrite = false);
+
+    /**
+     * @brief 取消正在运行的导出或回放，并等待工作线程退出
+     */
+    void stop();
+
+    /**
+     * @brief 是否有任务在运行
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * @brief 获取当前 (或最近一次) 任务的进度与结果
+     */
+    [[nodiscard]] ReplayReport getReport() const;
+
+private:
+    struct ReplayOp {
+        double      time = 0; // 相对第一条流水的秒数
+        std::string uuid;
+        std::string currencyType;
+        int64_t     change = 0;
+        int64_t     previous = 0;
+        std::string reason1;
+        std::string reason2;
+        std::string reason3;
+    };
+
+    db::IDatabaseConnection& mMainConn;
+    const Config&            mConfig;
+    std::filesystem::path    mDirectory;
+    ConnectionFactory        mTargetFactory;
+    ll::io::Logger&          mLogger;
+
+    mutable std::mutex                    mMutex; // 保护 mReport
+    ReplayReport                          mReport;
+    std::atomic<bool>                     mCancelled{false};
+    std::thread                           mWorker;
+    std::chrono::steady_clock::time_point mStartedAt;
+
+    // 导出状态 (只在服务器线程上访问)
+    std::ofstream         mExportStream;
+    std::filesystem::path mExportPath;
+    int64_t               mExportCursor = 0;
+
+    std::optional<std::filesystem::path> resolveFile(const std::string& fileName) const;
+    void                                 finishExport(const std::string& error);
+    void                                 replayWorker(std::filesystem::path path, double speed, bool overwrite);
+    bool loadOps(const std::filesystem::path& path, std::vector<ReplayOp>& ops, uint64_t& skipped, std::string& error);
+    void fail(const std::string& error);
+};
+
+} // namespace czmoney
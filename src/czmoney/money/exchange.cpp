@@ -0,0 +1,303 @@
+#include "czmoney/database_interface.h"
+#include "czmoney/event/ExchangeMoneyEvent.h"
+#include "czmoney/money/Helpers.h"
+#include "czmoney/money/money.h"
+#include "ll/api/event/EventBus.h"
+#include <cmath>
+#include <fmt/format.h>
+#include <limits>
+#include <string>
+
+// 货币兑换相关的 MoneyManager 实现
+// 兑换不是"先扣款、再加款"两次独立的操作：两次余额更新和两条流水在同一个事务中提交，
+// 中途崩溃或任何一步失败都不会只扣不加。
+
+namespace czmoney {
+
+std::optional<double> MoneyManager::getExchangeRate(const std::string& fromCurrency, const std::string& toCurrency) const {
+    if (!mConfig.exchange.enabled) {
+        return std::nullopt;
+    }
+    auto fromIt = mConfig.exchange.rates.find(fromCurrency);
+    if (fromIt == mConfig.exchange.rates.end()) {
+        return std::nullopt;
+    }
+    auto toIt = fromIt->second.find(toCurrency);
+    if (toIt == fromIt->second.end() || !std::isfinite(toIt->second) || toIt->second <= 0.0) {
+        return std::nullopt;
+    }
+    return toIt->second;
+}
+
+api::MoneyApiResult MoneyManager::exchangeBalance(
+    const std::string& uuid,
+    const std::string& fromCurrency,
+    const std::string& toCurrency,
+    int64_t            amount,
+    int64_t*           amountReceived,
+    const std::string& reason1,
+    const std::string& reason2,
+    const std::string& reason3
+) {
+    // 0. 基础检查
+    if (!isCurrencyConfigured(fromCurrency) || !isCurrencyConfigured(toCurrency)) {
+        mLogger.error("兑换失败：货币类型 '{}' 或 '{}' 未在配置中定义。", fromCurrency, toCurrency);
+        return api::MoneyApiResult::ExchangeNotAllowed;
+    }
+    if (fromCurrency == toCurrency) {
+        mLogger.warn("尝试将货币 '{}' 兑换为自身 (UUID: {})", fromCurrency, uuid);
+        return api::MoneyApiResult::ExchangeNotAllowed;
+    }
+    std::optional<double> rate = getExchangeRate(fromCurrency, toCurrency);
+    if (!rate) {
+        mLogger.warn("兑换失败：未开启兑换或没有 '{}' -> '{}' 的汇率。", fromCurrency, toCurrency);
+        return api::MoneyApiResult::ExchangeNotAllowed;
+    }
+    if (amount <= 0) {
+        mLogger.warn("尝试兑换非正数金额 ({}) (UUID: {})", formatBalance(amount), uuid);
+        return api::MoneyApiResult::InvalidAmount;
+    }
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("兑换失败：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    // 1. 计算兑换所得，按分向下取整 (加一个远小于 1 分的偏移，避免 0.29 * 100 = 28.999... 这类误差被取整掉)
+    auto convert = [&](int64_t paid) -> std::optional<int64_t> {
+        long double converted = static_cast<long double>(paid) * static_cast<long double>(*rate);
+        if (converted >= static_cast<long double>(std::numeric_limits<int64_t>::max())) {
+            mLogger.warn("兑换所得溢出：{} {} 按汇率 {} 兑换为 {}", formatBalance(paid), fromCurrency, *rate, toCurrency);
+            return std::nullopt;
+        }
+        return static_cast<int64_t>(std::floor(converted + 1e-6L));
+    };
+    std::optional<int64_t> received = convert(amount);
+    if (!received) {
+        return api::MoneyApiResult::InvalidAmount;
+    }
+
+    // --- 事件准备 ---
+    std::string playerUuidForEvent     = uuid;
+    std::string fromCurrencyForEvent   = fromCurrency;
+    std::string toCurrencyForEvent     = toCurrency;
+    int64_t     amountPaidForEvent     = amount;
+    int64_t     amountReceivedForEvent = *received;
+    std::string reason1ForEvent        = reason1;
+    std::string reason2ForEvent        = reason2;
+    std::string reason3ForEvent        = reason3;
+
+    auto beforeEvent = event::ExchangeMoneyBeforeEvent(
+        playerUuidForEvent,
+        fromCurrencyForEvent,
+        toCurrencyForEvent,
+        amountPaidForEvent,
+        amountReceivedForEvent,
+        reason1ForEvent,
+        reason2ForEvent,
+        reason3ForEvent
+    );
+    ll::event::EventBus::getInstance().publish(beforeEvent);
+
+    if (beforeEvent.isCancelled()) {
+        mLogger.debug("玩家 '{}' 将 {} 兑换为 {} 的操作被事件监听器取消。", uuid, fromCurrency, toCurrency);
+        return api::MoneyApiResult::Cancelled;
+    }
+    // 监听器可能修改了支付金额，兑换所得始终按汇率重新计算 (货币类型和所得都不允许修改，以免绕过汇率表)
+    if (amountPaidForEvent != amount) {
+        if (amountPaidForEvent <= 0 || !(received = convert(amountPaidForEvent))) {
+            return api::MoneyApiResult::InvalidAmount;
+        }
+        amountReceivedForEvent = *received;
+    }
+    if (amountReceivedForEvent <= 0) {
+        mLogger.warn(
+            "兑换金额无效：支付 {} {}，获得 {} {} (汇率 {})",
+            formatBalance(amountPaidForEvent),
+            fromCurrency,
+            formatBalance(amountReceivedForEvent),
+            toCurrency,
+            *rate
+        );
+        return api::MoneyApiResult::InvalidAmount;
+    }
+    // --- 事件结束 ---
+
+    std::string dbType = mDbConnection.getDbType();
+    auto placeholder = [&](int index) { return czmoney::placeholder(dbType, index); };
+
+    // 锁定两个账户行 (SQLite 的写事务本身就是串行的，不支持 FOR UPDATE)
+    std::string selectSql = "SELECT currency_type, amount FROM player_balances WHERE uuid = " + placeholder(1)
+                          + " AND currency_type IN (" + placeholder(2) + ", " + placeholder(3) + ")"
+                          + (dbType == "sqlite" ? ";" : " FOR UPDATE;");
+    // 条件扣款：余额足够，且扣款后不低于最低余额与冻结总额之和
+    std::string debitSql = "UPDATE player_balances SET amount = amount - " + placeholder(1)
+                         + ", last_updated = CURRENT_TIMESTAMP WHERE uuid = " + placeholder(2) + " AND currency_type = "
+                         + placeholder(3) + " AND amount >= " + placeholder(4) + " AND (amount - " + placeholder(5)
+                         + ") >= " + placeholder(6) + ";";
+    std::string creditSql = "UPDATE player_balances SET amount = amount + " + placeholder(1)
+                          + ", last_updated = CURRENT_TIMESTAMP WHERE uuid = " + placeholder(2) + " AND currency_type = "
+                          + placeholder(3) + ";";
+    // 两条流水一次写入
+    std::string logSql = "INSERT INTO economy_log (uuid, currency_type, change_amount, previous_amount, reason1, reason2, reason3) VALUES (";
+    for (int i = 1; i <= 14; ++i) {
+        logSql += placeholder(i) + (i == 7 ? "), (" : i == 14 ? ");" : ", ");
+    }
+
+    try {
+        // 任何一步失败都会让事务在作用域结束时回滚
+        db::ScopedTransaction transaction(mDbConnection);
+
+        // 2. 目标货币账户不存在时先按初始余额创建 (与 addPlayerBalance 相同，包含在同一事务中)
+        getPlayerBalanceOrInit(uuid, toCurrency);
+
+        // 3. 读取 (并锁定) 两个账户的当前余额，作为流水的 previous_amount
+        std::optional<int64_t> fromBalance;
+        std::optional<int64_t> toBalance;
+        for (const auto& row : mDbConnection.queryPrepared(selectSql, {uuid, fromCurrency, toCurrency})) {
+            if (row.size() != 2) {
+                continue;
+            }
+            std::string currency = db::toString(row[0]);
+            if (currency == fromCurrency) {
+                fromBalance = db::toInt64(row[1]);
+            } else if (currency == toCurrency) {
+                toBalance = db::toInt64(row[1]);
+            }
+        }
+        if (!fromBalance || !toBalance) {
+            mLogger.warn("兑换失败：UUID: {} 的 {} 或 {} 账户不存在。", uuid, fromCurrency, toCurrency);
+            return api::MoneyApiResult::AccountNotFound;
+        }
+        if (*toBalance > std::numeric_limits<int64_t>::max() - amountReceivedForEvent) {
+            mLogger.error("兑换失败：UUID: {} 的 {} 余额加上 {} 后将溢出。", uuid, toCurrency, formatBalance(amountReceivedForEvent));
+            return api::MoneyApiResult::InvalidAmount;
+        }
+
+        // 4. 扣款
+        int64_t minBalance = getMinimumBalance(fromCurrency) + getHeldBalance(uuid, fromCurrency);
+        int     debited    = mDbConnection.executePrepared(
+            debitSql,
+            {amountPaidForEvent, uuid, fromCurrency, amountPaidForEvent, amountPaidForEvent, minBalance}
+        );
+        if (debited <= 0) {
+            mLogger.warn(
+                "兑换失败：UUID: {} 的 {} 余额不足 (当前: {}, 需要: {})",
+                uuid,
+                fromCurrency,
+                formatBalance(*fromBalance),
+                formatBalance(amountPaidForEvent)
+            );
+            return api::MoneyApiResult::InsufficientBalance;
+        }
+
+        // 5. 加款
+        if (mDbConnection.executePrepared(creditSql, {amountReceivedForEvent, uuid, toCurrency}) <= 0) {
+            mLogger.error("兑换失败：无法为 UUID: {} 增加 {} {}", uuid, formatBalance(amountReceivedForEvent), toCurrency);
+            return api::MoneyApiResult::DatabaseError;
+        }
+
+        // 6. 两条流水
+        std::string rateNote = fmt::format("Rate: {} {} -> {}", *rate, fromCurrency, toCurrency);
+        if (mDbConnection.executePrepared(
+                logSql,
+                {uuid,
+                 fromCurrency,
+                 -amountPaidForEvent,
+                 *fromBalance,
+                 reason1ForEvent,
+                 reason2ForEvent.empty() ? fmt::format("To: {}", toCurrency) : reason2ForEvent,
+                 reason3ForEvent.empty() ? rateNote : reason3ForEvent,
+                 uuid,
+                 toCurrency,
+                 amountReceivedForEvent,
+                 *toBalance,
+                 reason1ForEvent,
+                 reason2ForEvent.empty() ? fmt::format("From: {}", fromCurrency) : reason2ForEvent,
+                 reason3ForEvent.empty() ? rateNote : reason3ForEvent}
+            )
+            < 2) {
+            mLogger.error("兑换失败：流水写入不完整，已回滚。UUID: {}", uuid);
+            return api::MoneyApiResult::DatabaseError;
+        }
+        if (mLedgerChain.isEnabled()) {
+            // 两行属于不同的货币，各自是该货币最新的一行
+            mLedgerChain.sealLatest(mDbConnection, fromCurrency);
+            mLedgerChain.sealLatest(mDbConnection, toCurrency);
+        }
+
+        // <<< --- 发布 AfterEvent (外层事务真正提交后才发布) --- >>>
+        mDbConnection.afterCommit([playerUuidForEvent,
+                                   fromCurrencyForEvent,
+                                   toCurrencyForEvent,
+                                   amountPaidForEvent,
+                                   amountReceivedForEvent,
+                                   reason1ForEvent,
+                                   reason2ForEvent,
+                                   reason3ForEvent] {
+            auto afterEvent = event::ExchangeMoneyAfterEvent(
+                playerUuidForEvent,
+                fromCurrencyForEvent,
+                toCurrencyForEvent,
+                amountPaidForEvent,
+                amountReceivedForEvent,
+                reason1ForEvent,
+                reason2ForEvent,
+                reason3ForEvent
+            );
+            ll::event::EventBus::getInstance().publish(afterEvent);
+        });
+        // <<< --- AfterEvent 发布结束 --- >>>
+        if (mFlowCounters) {
+            mDbConnection.afterCommit([counters = mFlowCounters,
+                                       fromCurrency,
+                                       toCurrency,
+                                       reason1ForEvent,
+                                       reason2ForEvent,
+                                       amountPaidForEvent,
+                                       amountReceivedForEvent] {
+                counters->record(fromCurrency, reason1ForEvent, reason2ForEvent, -amountPaidForEvent);
+                counters->record(toCurrency, reason1ForEvent, reason2ForEvent, amountReceivedForEvent);
+            });
+        }
+        if (mActiveUsers) {
+            mDbConnection.afterCommit([tracker = mActiveUsers, uuid, fromCurrency, toCurrency, reason1ForEvent] {
+                tracker->record(uuid, fromCurrency, reason1ForEvent);
+                tracker->record(uuid, toCurrency, reason1ForEvent);
+            });
+        }
+        if (mExploitDetector) {
+            // 兑换所得是目标货币的入账，与加款一样接受检测
+            mDbConnection.afterCommit([detector = mExploitDetector,
+                                       uuid,
+                                       toCurrency,
+                                       amountReceivedForEvent,
+                                       reason1ForEvent,
+                                       reason2ForEvent] {
+                detector->observe(uuid, toCurrency, amountReceivedForEvent, reason1ForEvent, reason2ForEvent);
+            });
+        }
+        transaction.commit();
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("兑换过程中发生数据库错误: {}", e.what());
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("兑换过程中发生意外错误: {}", e.what());
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    if (amountReceived) {
+        *amountReceived = amountReceivedForEvent;
+    }
+    mLogger.info(
+        "UUID: {} 将 {} {} 兑换为 {} {} (汇率 {})",
+        uuid,
+        formatBalance(amountPaidForEvent),
+        fromCurrency,
+        formatBalance(amountReceivedForEvent),
+        toCurrency,
+        *rate
+    );
+    return api::MoneyApiResult::Success;
+}
+
+} // namespace czmoney
@@ -0,0 +1,387 @@
+#include "czmoney/database_interface.h"
+#include "czmoney/money/money.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// 冻结 (Hold / Escrow) 相关的 MoneyManager 实现
+// 冻结只影响"可用余额"：内存中维护每个账户的冻结总额，holds 表用于重启后恢复。
+// 解冻 (最常见的退款场景) 只删除 holds 表中的一行，不触碰 player_balances。
+
+namespace czmoney {
+
+std::string MoneyManager::holdKey(const std::string& uuid, const std::string& currencyType) {
+    return uuid + ":" + currencyType;
+}
+
+void MoneyManager::addHoldLocked(int64_t holdId, HoldRecord record) {
+    mHeldTotals[holdKey(record.uuid, record.currencyType)] += record.amount;
+    mHolds.emplace(holdId, std::move(record));
+    if (holdId >= mNextHoldId) {
+        mNextHoldId = holdId + 1;
+    }
+}
+
+void MoneyManager::removeHoldLocked(int64_t holdId) {
+    auto it = mHolds.find(holdId);
+    if (it == mHolds.end()) {
+        return;
+    }
+    auto totalIt = mHeldTotals.find(holdKey(it->second.uuid, it->second.currencyType));
+    if (totalIt != mHeldTotals.end()) {
+        totalIt->second -= it->second.amount;
+        if (totalIt->second <= 0) {
+            mHeldTotals.erase(totalIt);
+        }
+    }
+    mHolds.erase(it);
+}
+
+// 初始化冻结表并加载未结清的冻结
+bool MoneyManager::initializeHoldTable() {
+    std::string              dbType = mDbConnection.getDbType();
+    std::string              createHoldTableSQL;
+    std::vector<std::string> createIndexSQLs;
+
+    if (dbType == "mysql") {
+        createHoldTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS holds (
+                hold_id BIGINT PRIMARY KEY,
+                uuid VARCHAR(36) NOT NULL,
+                currency_type VARCHAR(50) NOT NULL,
+                amount BIGINT NOT NULL,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                reason1 VARCHAR(255) DEFAULT NULL,
+                reason2 VARCHAR(255) DEFAULT NULL,
+                reason3 VARCHAR(255) DEFAULT NULL,
+                INDEX idx_holds_account (uuid, currency_type)
+            ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+        )";
+    } else if (dbType == "sqlite") {
+        createHoldTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS holds (
+                hold_id INTEGER PRIMARY KEY,
+                uuid TEXT NOT NULL,
+                currency_type TEXT NOT NULL,
+                amount INTEGER NOT NULL,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                reason1 TEXT DEFAULT NULL,
+                reason2 TEXT DEFAULT NULL,
+                reason3 TEXT DEFAULT NULL
+            );
+        )";
+        createIndexSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_holds_account ON holds (uuid, currency_type);");
+    } else if (dbType == "postgresql") {
+        createHoldTableSQL = R"(
+            CREATE TABLE IF NOT EXISTS holds (
+                hold_id BIGINT PRIMARY KEY,
+                uuid VARCHAR(36) NOT NULL,
+                currency_type VARCHAR(50) NOT NULL,
+                amount BIGINT NOT NULL,
+                created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                reason1 VARCHAR(255) DEFAULT NULL,
+                reason2 VARCHAR(255) DEFAULT NULL,
+                reason3 VARCHAR(255) DEFAULT NULL
+            );
+        )";
+        createIndexSQLs.push_back("CREATE INDEX IF NOT EXISTS idx_holds_account ON holds (uuid, currency_type);");
+    } else {
+        mLogger.error("不支持的数据库类型 '{}'，无法创建 holds 表。", dbType);
+        return false;
+    }
+
+    try {
+        mDbConnection.execute(createHoldTableSQL);
+        for (const auto& sql : createIndexSQLs) {
+            mDbConnection.execute(sql);
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("创建 'holds' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("创建 'holds' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+    mLogger.info("'holds' 表初始化成功 (类型: {}).", dbType);
+    return reloadHolds();
+}
+
+bool MoneyManager::reloadHolds() {
+    try {
+        // 加载未结清的冻结
+        db::DbResult rows = mDbConnection.query("SELECT hold_id, uuid, currency_type, amount FROM holds;");
+
+        std::lock_guard lock(mHoldMutex);
+        mHolds.clear();
+        mHeldTotals.clear();
+        mNextHoldId = 1;
+        for (const auto& row : rows) {
+            if (row.size() != 4) {
+                continue;
+            }
+            auto holdId = db::toInt64(row[0]);
+            auto amount = db::toInt64(row[3]);
+            if (!holdId || !amount) {
+                mLogger.warn("跳过无法解析的冻结记录。");
+                continue;
+            }
+            addHoldLocked(*holdId, HoldRecord{db::toString(row[1]), db::toString(row[2]), *amount});
+        }
+        mLogger.info("已加载 {} 条未结清的冻结。", mHolds.size());
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("加载 'holds' 表失败: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.error("加载 'holds' 表时发生意外错误: {}", e.what());
+        return false;
+    }
+}
+
+int64_t MoneyManager::getHeldBalance(const std::string& uuid, const std::string& currencyType) const {
+    std::lock_guard lock(mHoldMutex);
+    auto            it = mHeldTotals.find(holdKey(uuid, currencyType));
+    return it != mHeldTotals.end() ? it->second : 0LL;
+}
+
+std::optional<int64_t> MoneyManager::getSpendableBalance(const std::string& uuid, const std::string& currencyType) {
+    std::optional<int64_t> balance = getPlayerBalance(uuid, currencyType);
+    if (!balance) {
+        return std::nullopt;
+    }
+    return *balance - getHeldBalance(uuid, currencyType);
+}
+
+api::MoneyApiResult MoneyManager::placeHold(
+    const std::string& uuid,
+    const std::string& currencyType,
+    int64_t            amount,
+    int64_t&           outHoldId,
+    const std::string& reason1,
+    const std::string& reason2,
+    const std::string& reason3
+) {
+    if (!isCurrencyConfigured(currencyType)) {
+        mLogger.error("无法冻结余额：货币类型 '{}' 未在配置中定义。", currencyType);
+        return api::MoneyApiResult::UnknownError;
+    }
+    if (amount <= 0) {
+        mLogger.warn("尝试为 UUID: {}, Currency: {} 冻结非正数金额 ({})", uuid, currencyType, formatBalance(amount));
+        return api::MoneyApiResult::InvalidAmount;
+    }
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法冻结余额：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    std::optional<int64_t> balance = getPlayerBalance(uuid, currencyType);
+    if (!balance) {
+        mLogger.warn("尝试为不存在的账户冻结余额。UUID: {}, Currency: {}", uuid, currencyType);
+        return api::MoneyApiResult::AccountNotFound;
+    }
+
+    // 持锁完成检查并先在内存中占用额度与单号，避免两次并发冻结同时通过可用余额检查；
+    // 数据库写入在锁外进行，不让其他线程的可用余额查询等待数据库 I/O
+    int64_t holdId = 0;
+    {
+        std::lock_guard lock(mHoldMutex);
+        auto            totalIt    = mHeldTotals.find(holdKey(uuid, currencyType));
+        int64_t         held       = totalIt != mHeldTotals.end() ? totalIt->second : 0LL;
+        int64_t         minBalance = getMinimumBalance(currencyType);
+        if (*balance - held - amount < minBalance) {
+            mLogger.warn("可用余额不足无法冻结。UUID: {}, Currency: {}, 余额: {}, 已冻结: {}, 请求: {}",
+                         uuid, currencyType, formatBalance(*balance), formatBalance(held), formatBalance(amount));
+            return api::MoneyApiResult::InsufficientBalance;
+        }
+        holdId = mNextHoldId;
+        addHoldLocked(holdId, HoldRecord{uuid, currencyType, amount});
+    }
+    auto undoReservation = [&]() {
+        std::lock_guard lock(mHoldMutex);
+        removeHoldLocked(holdId);
+    };
+
+    std::string sql;
+    if (mDbConnection.getDbType() == "postgresql") {
+        sql = "INSERT INTO holds (hold_id, uuid, currency_type, amount, reason1, reason2, reason3) VALUES ($1, $2, $3, $4, $5, $6, $7);";
+    } else {
+        sql = "INSERT INTO holds (hold_id, uuid, currency_type, amount, reason1, reason2, reason3) VALUES (?, ?, ?, ?, ?, ?, ?);";
+    }
+    db::DbParams params = {holdId, uuid, currencyType, amount, reason1, reason2, reason3};
+
+    try {
+        if (mDbConnection.executePrepared(sql, params) <= 0) {
+            mLogger.error("写入冻结记录失败 (INSERT 未影响任何行)。UUID: {}, Currency: {}", uuid, currencyType);
+            undoReservation();
+            return api::MoneyApiResult::DatabaseError;
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("写入冻结记录时发生数据库错误: {}", e.what());
+        undoReservation();
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("写入冻结记录时发生意外错误: {}", e.what());
+        undoReservation();
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    outHoldId = holdId;
+    mLogger.debug("已为 UUID: {}, Currency: {} 冻结 {} (单号 {})", uuid, currencyType, formatBalance(amount), holdId);
+    return api::MoneyApiResult::Success;
+}
+
+api::MoneyApiResult MoneyManager::releaseHold(int64_t holdId) {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法解冻：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    // 与兑现相同：先从内存中取出 (防止并发重复解冻)，数据库删除在锁外进行，失败时放回
+    HoldRecord record;
+    {
+        std::lock_guard lock(mHoldMutex);
+        auto            it = mHolds.find(holdId);
+        if (it == mHolds.end()) {
+            return api::MoneyApiResult::HoldNotFound;
+        }
+        record = it->second;
+        removeHoldLocked(holdId);
+    }
+    auto restoreHold = [&]() {
+        std::lock_guard lock(mHoldMutex);
+        addHoldLocked(holdId, record);
+    };
+
+    std::string sql = mDbConnection.getDbType() == "postgresql" ? "DELETE FROM holds WHERE hold_id = $1;"
+                                                                 : "DELETE FROM holds WHERE hold_id = ?;";
+    try {
+        mDbConnection.executePrepared(sql, {holdId});
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("删除冻结记录 {} 时发生数据库错误: {}", holdId, e.what());
+        restoreHold();
+        return api::MoneyApiResult::DatabaseError;
+    } catch (const std::exception& e) {
+        mLogger.error("删除冻结记录 {} 时发生意外错误: {}", holdId, e.what());
+        restoreHold();
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    mLogger.debug("冻结单 {} 已解冻。", holdId);
+    return api::MoneyApiResult::Success;
+}
+
+api::MoneyApiResult MoneyManager::captureHold(
+    int64_t                       holdId,
+    const std::string&            receiverUuid,
+    const std::optional<int64_t>& amount,
+    const std::string&            reason1,
+    const std::string&            reason2,
+    const std::string&            reason3
+) {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法兑现冻结：数据库未连接。");
+        return api::MoneyApiResult::DatabaseError;
+    }
+
+    // 1. 从内存中取出冻结记录。先移除再扣款，这样扣款时的可用余额检查不会把这笔冻结重复计算
+    HoldRecord record;
+    {
+        std::lock_guard lock(mHoldMutex);
+        auto            it = mHolds.find(holdId);
+        if (it == mHolds.end()) {
+            return api::MoneyApiResult::HoldNotFound;
+        }
+        record = it->second;
+        int64_t captureAmount = amount.value_or(record.amount);
+        if (captureAmount <= 0 || captureAmount > record.amount) {
+            mLogger.warn("兑现金额 {} 无效 (冻结单 {} 金额为 {})", formatBalance(captureAmount), holdId, formatBalance(record.amount));
+            return api::MoneyApiResult::InvalidAmount;
+        }
+        removeHoldLocked(holdId);
+    }
+    int64_t captureAmount = amount.value_or(record.amount);
+
+    auto restoreHold = [&]() {
+        std::lock_guard lock(mHoldMutex);
+        addHoldLocked(holdId, record);
+    };
+
+    // 2. 先检查可用余额 (本冻结单已从内存中移除，不会被重复计算)，以便把余额不足与其他失败区分开
+    auto checkSpendable = [&]() -> api::MoneyApiResult {
+        std::optional<int64_t> spendable = getSpendableBalance(record.uuid, record.currencyType);
+        if (!spendable) {
+            mLogger.error("兑现冻结失败：无法读取 {} 的余额 (冻结单 {})", record.uuid, holdId);
+            return api::MoneyApiResult::DatabaseError;
+        }
+        if (*spendable - captureAmount < getMinimumBalance(record.currencyType)) {
+            mLogger.warn("兑现冻结失败：{} 的可用余额 {} 不足以扣除 {} (冻结单 {})", record.uuid, formatBalance(*spendable), formatBalance(captureAmount), holdId);
+            return api::MoneyApiResult::InsufficientBalance;
+        }
+        return api::MoneyApiResult::Success;
+    };
+    if (api::MoneyApiResult checked = checkSpendable(); checked != api::MoneyApiResult::Success) {
+        restoreHold();
+        return checked;
+    }
+
+    std::string deleteSql = mDbConnection.getDbType() == "postgresql" ? "DELETE FROM holds WHERE hold_id = $1;"
+                                                                       : "DELETE FROM holds WHERE hold_id = ?;";
+
+    // 3. 删除冻结记录与扣款/加款在同一事务中完成 (已在外层事务中时使用保存点)
+    try {
+        db::ScopedTransaction transaction(mDbConnection, std::nothrow);
+        if (!transaction.ok()) {
+            logDbError(mLogger, "兑现冻结", transaction.error());
+            restoreHold();
+            return api::MoneyApiResult::DatabaseError;
+        }
+
+        db::DbExpected<int> deleted = mDbConnection.tryExecutePrepared(deleteSql, {holdId});
+        if (!deleted) {
+            logDbError(mLogger, fmt::format("删除冻结单 {} ", holdId), deleted.error());
+            restoreHold();
+            return api::MoneyApiResult::DatabaseError;
+        }
+        if (*deleted <= 0) {
+            mLogger.warn("兑现冻结失败：冻结单 {} 在数据库中不存在。", holdId);
+            return api::MoneyApiResult::HoldNotFound;
+        }
+
+        bool cancelled = false;
+        if (!subtractPlayerBalance(record.uuid, record.currencyType, captureAmount, reason1, reason2, reason3, nullptr, &cancelled)) {
+            restoreHold();
+            if (cancelled) {
+                return api::MoneyApiResult::Cancelled;
+            }
+            // 检查之后余额可能被并发扣款改变，重新检查一次以给出准确的结果
+            api::MoneyApiResult checked = checkSpendable();
+            if (checked == api::MoneyApiResult::Success) {
+                mLogger.error("兑现冻结失败：无法从 {} 扣除 {} (冻结单 {})", record.uuid, formatBalance(captureAmount), holdId);
+                return api::MoneyApiResult::DatabaseError;
+            }
+            return checked;
+        }
+
+        if (!receiverUuid.empty()
+            && !addPlayerBalance(receiverUuid, record.currencyType, captureAmount, reason1, reason2, reason3)) {
+            mLogger.error("兑现冻结失败：无法为接收方 {} 增加 {} (冻结单 {})", receiverUuid, formatBalance(captureAmount), holdId);
+            restoreHold();
+            return api::MoneyApiResult::DatabaseError;
+        }
+
+        if (auto committed = transaction.tryCommit(); !committed) {
+            logDbError(mLogger, fmt::format("提交兑现冻结单 {} ", holdId), committed.error());
+            restoreHold();
+            return api::MoneyApiResult::DatabaseError;
+        }
+    } catch (const std::exception& e) {
+        mLogger.error("兑现冻结单 {} 时发生意外错误: {}", holdId, e.what());
+        restoreHold();
+        return api::MoneyApiResult::UnknownError;
+    }
+
+    mLogger.debug("冻结单 {} 已兑现 {} (冻结金额 {})", holdId, formatBalance(captureAmount), formatBalance(record.amount));
+    return api::MoneyApiResult::Success;
+}
+
+} // namespace czmoney
@@ -1,6 +1,8 @@
 #include "czmoney/money/money.h"
 #include "czmoney/database_interface.h" // 包含数据库接口
+#include "czmoney/db/columnar.h" // 包含按列存储的查询结果
 // #include "czmoney/money/money_api.h"    // TransactionLogEntry 定义已移至 money.h
+#include "czmoney/event/AccountCreatedEvent.h"
 #include "czmoney/event/AddMoneyEvent.h"
 #include "czmoney/event/SetMoneyEvent.h"
 #include "czmoney/event/SubtractMoneyEvent.h"
@@ -14,6 +16,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <typeinfo> // For typeid in error logging
 #include <utility>  // For std::move
 #include <variant>  // 用于处理 DbValue
@@ -25,6 +28,16 @@ namespace czmoney {
 
 // 移除 MySQL 特定的 StatementGuard 和 BindGuard 类
 
+// 记录不抛异常的数据库操作返回的错误：繁忙、冲突、超时属于可预期的竞争结果，只记录警告
+void MoneyManager::logDbError(ll::io::Logger& logger, std::string_view context, const db::DbError& error) {
+    if (error.code == db::DbErrorCode::Busy || error.code == db::DbErrorCode::Conflict
+        || error.code == db::DbErrorCode::Timeout) {
+        logger.warn("{}时数据库返回 {}: {}", context, db::errorCodeName(error.code), error.message);
+    } else {
+        logger.error("{}时发生数据库错误 ({}): {}", context, db::errorCodeName(error.code), error.message);
+    }
+}
+
 // --- 私有辅助函数实现 ---
 
 // 新增：安全地将 double 金额转换为 int64_t (分)
@@ -83,7 +96,8 @@ int64_t MoneyManager::getMinimumBalance(const std::string& currencyType) const {
 MoneyManager::MoneyManager(db::IDatabaseConnection& dbConn, const Config& config) : // 使用接口引用
     mDbConnection(dbConn), // 初始化数据库连接接口引用成员
     mConfig(config),       // 初始化配置引用成员
-    mLogger(ll::mod::NativeMod::current()->getLogger()) // 初始化日志记录器引用成员
+    mLogger(ll::mod::NativeMod::current()->getLogger()), // 初始化日志记录器引用成员
+    mLedgerChain(config)   // 流水哈希链 (是否启用由配置决定)
 {
     // 构造时检查数据库连接状态
     if (!mDbConnection.isConnected()) {
@@ -91,6 +105,15 @@ MoneyManager::MoneyManager(db::IDatabaseConnection& dbConn, const Config& config
         // 根据实际需求，这里可以考虑抛出异常来阻止无效的 MoneyManager 实例创建
         // throw std::runtime_error("数据库未连接，无法初始化 MoneyManager");
     }
+
+    // 预先把各货币的初始余额转换为整数，创建账户时不再重复转换
+    for (const auto& [currencyType, currencyConfig] : mConfig.economy) {
+        std::optional<int64_t> initial =
+            convertDoubleToInt64(currencyConfig.initialBalance, "initialBalance for " + currencyType);
+        if (initial.has_value()) {
+            mInitialBalances[currencyType] = initial.value();
+        }
+    }
 }
 
 // 初始化数据库表的实现
@@ -151,6 +174,21 @@ bool MoneyManager::initializeTable() {
             return false;
         }
 
+        // 浏览索引失败时只影响管理员账户浏览的速度
+        initializeBalanceIndexes();
+
+        // 初始化冻结表
+        if (!initializeHoldTable()) {
+            mLogger.error("初始化 'holds' 表失败。");
+            return false;
+        }
+
+        // 启用哈希链时为流水表添加 chain_hash 列
+        if (mLedgerChain.isEnabled() && !mLedgerChain.initializeColumn(mDbConnection)) {
+            mLogger.error("初始化流水哈希链失败。");
+            return false;
+        }
+
         return true; // 全部成功
 
     } catch (const db::DatabaseException& e) {
@@ -247,6 +285,69 @@ bool MoneyManager::initializeLogTable() {
     // Removed extra closing brace here
 }
 
+bool MoneyManager::initializeBalanceIndexes() {
+    std::string dbType = mDbConnection.getDbType();
+    // 排序键之后带上 id，使 keyset 分页的 (排序键, id) 比较可以直接在索引上定位
+    const std::vector<std::pair<std::string, std::string>> indexes = {
+        {"idx_player_balances_amount", "(currency_type, amount, id)"},
+        {"idx_player_balances_updated", "(currency_type, last_updated, id)"}
+    };
+    try {
+        if (dbType == "sqlite") {
+            for (const auto& [name, columns] : indexes) {
+                mDbConnection.execute("CREATE INDEX IF NOT EXISTS " + name + " ON player_balances " + columns + ";");
+            }
+            // SQLite 没有 ON UPDATE CURRENT_TIMESTAMP；AFTER UPDATE 触发器会让每次改余额多写一遍同一行，
+            // 因此由各条 UPDATE 语句直接设置 last_updated，并删除旧版本创建的触发器
+            mDbConnection.execute("DROP TRIGGER IF EXISTS player_balances_touch;");
+        } else if (dbType == "postgresql") {
+            for (const auto& [name, columns] : indexes) {
+                mDbConnection.execute("CREATE INDEX IF NOT EXISTS " + name + " ON player_balances " + columns + ";");
+            }
+            mDbConnection.execute(R"(
+                CREATE OR REPLACE FUNCTION czmoney_touch_balance() RETURNS trigger AS $$
+                BEGIN
+                    NEW.last_updated := CURRENT_TIMESTAMP;
+                    RETURN NEW;
+                END;
+                $$ LANGUAGE plpgsql;
+            )");
+            db::DbResult existing = mDbConnection.query(
+                "SELECT 1 FROM pg_trigger WHERE tgname = 'player_balances_touch';"
+            );
+            if (existing.empty()) {
+                mDbConnection.execute(
+                    "CREATE TRIGGER player_balances_touch BEFORE UPDATE OF amount ON player_balances "
+                    "FOR EACH ROW EXECUTE PROCEDURE czmoney_touch_balance();"
+                );
+            }
+        } else if (dbType == "mysql") {
+            // last_updated 已经是 ON UPDATE CURRENT_TIMESTAMP；MySQL 不支持 CREATE INDEX IF NOT EXISTS
+            for (const auto& [name, columns] : indexes) {
+                db::DbResult exists = mDbConnection.queryPrepared(
+                    "SELECT COUNT(*) FROM information_schema.STATISTICS WHERE TABLE_SCHEMA = DATABASE() "
+                    "AND TABLE_NAME = 'player_balances' AND INDEX_NAME = ?;",
+                    {name}
+                );
+                if (!exists.empty() && !exists[0].empty() && db::toInt64(exists[0][0]).value_or(0) > 0) {
+                    continue;
+                }
+                mDbConnection.execute("CREATE INDEX " + name + " ON player_balances " + columns + ";");
+            }
+        } else {
+            return false;
+        }
+        mLogger.info("余额浏览索引已就绪 (类型: {}).", dbType);
+        return true;
+    } catch (const db::DatabaseException& e) {
+        mLogger.warn("创建余额浏览索引失败，按余额浏览账户将使用全表扫描: {}", e.what());
+        return false;
+    } catch (const std::exception& e) {
+        mLogger.warn("创建余额浏览索引时发生意外错误，按余额浏览账户将使用全表扫描: {}", e.what());
+        return false;
+    }
+}
+
 
 // 新增：记录经济交易流水的实现
 bool czmoney::MoneyManager::logTransaction(
@@ -297,18 +398,25 @@ bool czmoney::MoneyManager::logTransaction(
     mLogger.debug("Executing prepared SQL for logTransaction: {} with params: [{}, {}, {}, {}, {}, {}, {}]",
                   sql, uuid, currencyType, changeAmount, previousAmount, reason1, reason2, reason3);
 
+    db::DbExpected<int> affectedRows = mDbConnection.tryExecutePrepared(sql, params);
+    if (!affectedRows) {
+        logDbError(mLogger, "记录流水", affectedRows.error());
+        return false;
+    }
+    if (*affectedRows <= 0) {
+        mLogger.error("记录流水时 INSERT 操作影响了 {} 行 (预期 > 0)。", *affectedRows);
+        return false;
+    }
+
     try {
-        int affectedRows = mDbConnection.executePrepared(sql, params);
-        if (affectedRows > 0) {
-            mLogger.debug("成功记录流水：UUID={}, Currency={}, Change={}, Prev={}, R1={}, R2={}, R3={}",
-                          uuid, currencyType, formatBalance(changeAmount), formatBalance(previousAmount), reason1, reason2, reason3);
-            return true;
-        } else {
-            mLogger.error("记录流水时 INSERT 操作影响了 {} 行 (预期 > 0)。", affectedRows);
-            return false;
+        if (mLedgerChain.isEnabled()) {
+            mLedgerChain.sealLatest(mDbConnection, currencyType); // 与 INSERT 处于调用方的同一事务中
         }
+        mLogger.debug("成功记录流水：UUID={}, Currency={}, Change={}, Prev={}, R1={}, R2={}, R3={}",
+                      uuid, currencyType, formatBalance(changeAmount), formatBalance(previousAmount), reason1, reason2, reason3);
+        return true;
     } catch (const db::DatabaseException& e) {
-        mLogger.error("记录流水时发生数据库错误: {}", e.what());
+        mLogger.error("封存流水时发生数据库错误: {}", e.what());
         return false;
     } catch (const std::exception& e) {
         mLogger.error("记录流水时发生意外错误: {}", e.what());
@@ -340,74 +448,54 @@ std::optional<int64_t> czmoney::MoneyManager::getPlayerBalance(const std::string
     }
     db::DbParams params = {uuid, currencyType}; // 使用 std::string
 
-    mLogger.debug("Executing prepared SQL for getPlayerBalance: {} with params: [{}, {}]", sql, uuid, currencyType);
-
-    try {
-        db::DbResult result = mDbConnection.queryPrepared(sql, params);
+    // 过滤器判定一定不存在时不访问数据库 (例如 NPC 商店、假人等从未进服的 UUID)
+    if (mAccountFilter && !mAccountFilter->mightContain(uuid, currencyType)) {
+        mLogger.debug("账户过滤器判定 UUID: {}, Currency: {} 的账户不存在。", uuid, currencyType);
+        return std::nullopt;
+    }
 
-        if (result.empty()) {
-            // 没有找到记录，账户不存在
-            mLogger.debug("未找到 UUID: {}, Currency: {} 的余额记录。", uuid, currencyType);
-            return std::nullopt;
-        }
+    mLogger.debug("Executing prepared SQL for getPlayerBalance: {} with params: [{}, {}]", sql, uuid, currencyType);
 
-        if (result.size() > 1) {
-            // (uuid, currency_type) 应该是唯一的
-            mLogger.warn("为 UUID: {}, Currency: {} 找到多条余额记录，将使用第一条。", uuid, currencyType);
-        }
+    db::DbExpected<db::ColumnarResult> result = mDbConnection.tryQueryColumnar(sql, params);
+    if (!result) {
+        logDbError(mLogger, fmt::format("查询余额 (UUID: {}, Currency: {}) ", uuid, currencyType), result.error());
+        return std::nullopt;
+    }
 
-        const db::DbRow& row = result[0];
-        if (row.empty()) {
-            mLogger.error("查询余额返回了空行。UUID: {}, Currency: {}", uuid, currencyType);
-            return std::nullopt;
+    if (result->empty()) {
+        // 没有找到记录，账户不存在
+        if (mAccountFilter) {
+            mAccountFilter->recordFalsePositive();
         }
+        mLogger.debug("未找到 UUID: {}, Currency: {} 的余额记录。", uuid, currencyType);
+        return std::nullopt;
+    }
 
-        // 获取 amount 列 (索引 0)
-        const db::DbValue& amountValue = row[0];
-
-        // --- 提取 int64_t 值 (封装成辅助 lambda) ---
-        auto extractInt64 = [&](const db::DbValue& val) -> std::optional<int64_t> {
-            if (std::holds_alternative<int64_t>(val)) {
-                return std::get<int64_t>(val);
-            } else if (std::holds_alternative<std::string>(val)) {
-                const std::string& amountStr = std::get<std::string>(val);
-                try {
-                    return std::stoll(amountStr);
-                } catch (const std::invalid_argument&) {
-                    mLogger.error("无法将数据库余额字符串 '{}' 转换为整数 (invalid_argument)。UUID: {}, Currency: {}", amountStr, uuid, currencyType);
-                    return std::nullopt;
-                } catch (const std::out_of_range&) {
-                    mLogger.error("数据库余额字符串 '{}' 超出 int64_t 范围 (out_of_range)。UUID: {}, Currency: {}", amountStr, uuid, currencyType);
-                    return std::nullopt;
-                }
-            } else if (std::holds_alternative<std::nullptr_t>(val)) {
-                mLogger.warn("为 UUID: {}, Currency: {} 获取到 NULL 余额 (应为 0)", uuid, currencyType);
-                return 0LL; // 将 NULL 视为 0
-            } else {
-                mLogger.error("查询余额返回了非预期的类型。UUID: {}, Currency: {}", uuid, currencyType);
-                try {
-                    std::visit([this](auto&& arg){ mLogger.error(" - 实际类型: {}", typeid(arg).name()); }, val);
-                } catch(...) {}
-                return std::nullopt;
-            }
-        };
-        // --- 提取结束 ---
-
-        return extractInt64(amountValue);
+    if (result->rowCount() > 1) {
+        // (uuid, currency_type) 应该是唯一的
+        mLogger.warn("为 UUID: {}, Currency: {} 找到多条余额记录，将使用第一条。", uuid, currencyType);
+    }
 
-    } catch (const db::DatabaseException& e) {
-        mLogger.error("查询余额时发生数据库错误 (UUID: {}, Currency: {}): {}", uuid, currencyType, e.what());
-        return std::nullopt;
-    } catch (const std::exception& e) {
-        mLogger.error("查询余额时发生意外错误 (UUID: {}, Currency: {}): {}", uuid, currencyType, e.what());
+    if (result->columnCount() == 0) {
+        mLogger.error("查询余额返回了空行。UUID: {}, Currency: {}", uuid, currencyType);
         return std::nullopt;
     }
-}
 
+    // 获取 amount 列 (索引 0)
+    if (result->isNull(0, 0)) {
+        mLogger.warn("为 UUID: {}, Currency: {} 获取到 NULL 余额 (应为 0)", uuid, currencyType);
+        return 0LL; // 将 NULL 视为 0
+    }
+    std::optional<int64_t> amount = result->getInt64(0, 0);
+    if (!amount) {
+        mLogger.error("无法将数据库余额 '{}' 转换为整数。UUID: {}, Currency: {}", result->getString(0, 0), uuid, currencyType);
+    }
+    return amount;
+}
 
 
 
-// 更新：初始化账户的私有辅助函数实现 (从 double 转换)
+// 初始化账户的私有辅助函数实现 (使用构造时计算好的初始余额)
 std::optional<int64_t> czmoney::MoneyManager::initializeAccount(const std::string& uuid, const std::string& currencyType) {
     // 0. 检查货币类型是否已配置
     if (!isCurrencyConfigured(currencyType)) {
@@ -415,33 +503,132 @@ std::optional<int64_t> czmoney::MoneyManager::initializeAccount(const std::strin
         return std::nullopt;
     }
 
-    // 1. 从配置中获取初始余额 (double)
-    double initialAmountDouble = 0.0; // 默认初始值为 0.0
-    auto it = mConfig.economy.find(currencyType);
-    if (it != mConfig.economy.end()) {
-        initialAmountDouble = it->second.initialBalance;
-    } else {
-        mLogger.warn("未在配置的 'economy' 部分找到货币类型 '{}' 的设置，将使用默认初始余额 0.0。", currencyType);
+    // 1. 取出构造时转换好的初始余额
+    auto it = mInitialBalances.find(currencyType);
+    if (it == mInitialBalances.end()) {
+        mLogger.error("货币类型 '{}' 的 initialBalance 无效，初始化账户失败。", currencyType);
+        return std::nullopt;
+    }
+    bool writeOpeningLog = mConfig.economy.at(currencyType).logAccountCreation;
+
+    // 2. 不存在才插入，不经过 setPlayerBalance (不触发 SetMoney 事件，也不做 UPSERT)
+    std::optional<int64_t> balance = createAccount(uuid, currencyType, it->second, writeOpeningLog);
+    if (!balance.has_value()) {
+        mLogger.error("为 UUID: {}, Currency: {} 初始化账户失败。", uuid, currencyType);
     }
+    return balance;
+}
 
-    // 2. 转换初始余额为 int64_t
-    std::optional<int64_t> initialAmountIntOpt = convertDoubleToInt64(initialAmountDouble, "initialBalance for " + currencyType);
-    if (!initialAmountIntOpt.has_value()) {
-        mLogger.error("无法转换配置中货币类型 '{}' 的 initialBalance ({})，初始化账户失败。", currencyType, initialAmountDouble);
-        return std::nullopt; // 转换失败
+// 写操作限流：总是按调用方取令牌，能确定发起玩家时同时按玩家取令牌；每个桶一次耗尽期间只警告一次
+bool czmoney::MoneyManager::checkRateLimit(std::string_view playerUuid, std::string_view caller) {
+    if (!mRateLimiter) {
+        return true;
+    }
+    bool           firstRejection = false;
+    RateLimitScope rejectedScope  = RateLimitScope::Plugin;
+    std::string    pluginKey      = caller.empty() ? std::string("<unknown>") : std::string(caller);
+    std::string    playerKey(playerUuid);
+    bool           allowed = playerKey.empty()
+                               ? mRateLimiter->tryAcquire(RateLimitScope::Plugin, pluginKey, &firstRejection)
+                               : mRateLimiter->tryAcquireBoth(playerKey, pluginKey, &rejectedScope, &firstRejection);
+    if (allowed) {
+        return true;
+    }
+    if (firstRejection) {
+        if (rejectedScope == RateLimitScope::Player) {
+            mLogger.warn("玩家 {} 的写操作过于频繁，已被限流 (恢复前不再重复提示)", playerKey);
+        } else {
+            mLogger.warn("调用方 '{}' 的写操作过于频繁，已被限流 (恢复前不再重复提示)", pluginKey);
+        }
+    }
+    return false;
+}
+
+// 创建账户的实现：一条 "不存在才插入" 语句，可选地在同一事务中写入开户流水
+std::optional<int64_t> czmoney::MoneyManager::createAccount(
+    const std::string& uuid,
+    const std::string& currencyType,
+    int64_t            initialBalance,
+    bool               writeOpeningLog
+) {
+    if (!mDbConnection.isConnected()) {
+        mLogger.error("无法创建账户：数据库未连接。");
+        return std::nullopt;
     }
-    int64_t initialAmountInt = initialAmountIntOpt.value();
 
-    // 3. 使用 setPlayerBalance 插入新记录 (传入转换后的 int64_t 值)
-    mLogger.info("为 UUID: {}, Currency: {} 初始化账户，初始余额: {}", uuid, currencyType, formatBalance(initialAmountInt));
-    // 调用 setPlayerBalance 时，它内部会再次检查最低余额（现在 getMinimumBalance 会返回转换后的 int64_t）
-    // 注意：setPlayerBalance 也需要被重构以使用接口
-    if (setPlayerBalance(uuid, currencyType, initialAmountInt)) { // 传入 int64_t
-        return initialAmountInt; // 初始化成功，返回转换后的初始金额
+    std::string sql;
+    std::string dbType = mDbConnection.getDbType();
+    if (dbType == "sqlite") {
+        sql = "INSERT OR IGNORE INTO player_balances (uuid, currency_type, amount) VALUES (?, ?, ?);";
+    } else if (dbType == "mysql") {
+        // 不用 INSERT IGNORE：它会把数据截断、类型错误等降级为警告，只应忽略唯一键冲突
+        // 冲突时 id = id 不改变任何列，影响行数为 0
+        sql = "INSERT INTO player_balances (uuid, currency_type, amount) VALUES (?, ?, ?) "
+              "ON DUPLICATE KEY UPDATE id = id;";
+    } else if (dbType == "postgresql") {
+        sql = "INSERT INTO player_balances (uuid, currency_type, amount) VALUES ($1, $2, $3) "
+              "ON CONFLICT (uuid, currency_type) DO NOTHING;";
     } else {
-        mLogger.error("为 UUID: {}, Currency: {} 初始化账户失败 (setPlayerBalance 调用失败)。", uuid, currencyType);
-        return std::nullopt; // 初始化失败
+        mLogger.error("不支持的数据库类型 '{}'，无法创建账户。", dbType);
+        return std::nullopt;
+    }
+    db::DbParams params = {uuid, currencyType, initialBalance};
+
+    mLogger.debug("Executing prepared SQL for createAccount ({}): {} with params: [{}, {}, {}]",
+                  dbType, sql, uuid, currencyType, initialBalance);
+
+    // 先加入过滤器再写入数据库，其他线程不会在插入提交后仍被判定为不存在
+    if (mAccountFilter) {
+        mAccountFilter->add(uuid, currencyType);
+    }
+
+    bool created = false;
+    try {
+        db::ScopedTransaction transaction(mDbConnection, std::nothrow);
+        if (!transaction.ok()) {
+            logDbError(mLogger, "创建账户", transaction.error());
+            return std::nullopt;
+        }
+        db::DbExpected<int> inserted = mDbConnection.tryExecutePrepared(sql, params);
+        if (!inserted) {
+            logDbError(mLogger, fmt::format("创建账户 (UUID: {}, Currency: {}) ", uuid, currencyType), inserted.error());
+            return std::nullopt;
+        }
+        created = *inserted > 0;
+        if (created && writeOpeningLog && initialBalance != 0
+            && !logTransaction(uuid, currencyType, initialBalance, 0, "czmoney", "account_created", "")) {
+            mLogger.error("记录开户流水失败，已回滚本次创建账户。UUID: {}, Currency: {}", uuid, currencyType);
+            return std::nullopt;
+        }
+        if (created) {
+            // 开户事件与计数在外层事务真正提交后才生效 (例如在转账事务中为接收方开户)
+            if (writeOpeningLog && initialBalance != 0 && mFlowCounters) {
+                mDbConnection.afterCommit([counters = mFlowCounters, currencyType, initialBalance] {
+                    counters->record(currencyType, "czmoney", "account_created", initialBalance);
+                });
+            }
+            mDbConnection.afterCommit([playerUuidForEvent = uuid, currencyTypeForEvent = currencyType, initialBalance] {
+                auto createdEvent = event::AccountCreatedEvent(playerUuidForEvent, currencyTypeForEvent, initialBalance);
+                ll::event::EventBus::getInstance().publish(createdEvent);
+            });
+        }
+        if (auto committed = transaction.tryCommit(); !committed) {
+            logDbError(mLogger, "提交创建账户事务", committed.error());
+            return std::nullopt;
+        }
+    } catch (const std::exception& e) {
+        mLogger.error("创建账户时发生意外错误 (UUID: {}, Currency: {}): {}", uuid, currencyType, e.what());
+        return std::nullopt;
     }
+
+    if (!created) {
+        // 其他线程抢先创建了账户 (唯一键冲突被忽略)，以数据库中的余额为准
+        mLogger.debug("UUID: {}, Currency: {} 的账户已存在，返回现有余额。", uuid, currencyType);
+        return getPlayerBalance(uuid, currencyType);
+    }
+
+    mLogger.info("为 UUID: {}, Currency: {} 创建账户，初始余额: {}", uuid, currencyType, formatBalance(initialBalance));
+    return initialBalance;
 }
 
 // 新增：获取余额或初始化的实现
@@ -477,7 +664,8 @@ bool czmoney::MoneyManager::setPlayerBalance(
     int64_t            amount, // Correct parameter name
     const std::string& reason1,
     const std::string& reason2,
-    const std::string& reason3
+    const std::string& reason3,
+    int64_t*           newBalance
 ) {
     // --- 事件准备 ---
     std::string playerUuidForEvent   = uuid;
@@ -569,37 +757,79 @@ bool czmoney::MoneyManager::setPlayerBalance(
                   dbType, sql, uuid, currencyType, amount);
 
     try {
-        // 4. 执行数据库更新
-        int affectedRows = mDbConnection.executePrepared(sql, params);
-        // UPSERT 操作的 affectedRows 含义可能不同 (MySQL: 1=INSERT, 2=UPDATE, 0=No change)
-        // 这里我们假设 >= 0 表示操作本身成功
-        // --- 发布 AfterEvent ---
-        auto afterEvent = event::SetMoneyAfterEvent(
-            playerUuidForEvent,
-            currencyTypeForEvent,
-            amountForEvent,
-            reason1ForEvent,
-            reason2ForEvent,
-            reason3ForEvent
-        );
-        ll::event::EventBus::getInstance().publish(afterEvent);
+        // 4. 执行数据库更新，并在同一事务中记录流水
+        // UPSERT 可能创建账户，先加入过滤器
+        if (mAccountFilter && !previousBalanceOpt.has_value()) {
+            mAccountFilter->add(uuid, currencyType);
+        }
+        db::ScopedTransaction transaction(mDbConnection, std::nothrow);
+        if (!transaction.ok()) {
+            logDbError(mLogger, "设置余额", transaction.error());
+            return false;
+        }
+        // UPSERT 的影响行数含义因数据库而异 (MySQL: 1=INSERT, 2=UPDATE, 0=No change)，执行成功即视为成功
+        db::DbExpected<int> upserted = mDbConnection.tryExecutePrepared(sql, params);
+        if (!upserted) {
+            logDbError(mLogger, fmt::format("设置余额 (UUID: {}, Currency: {}) ", uuid, currencyType), upserted.error());
+            return false; // 事务在作用域结束时回滚
+        }
+
         // 5. 记录流水
         int64_t changeAmount = amount - previousBalance;
         if (changeAmount != 0) {
             if (!logTransaction(uuid, currencyType, changeAmount, previousBalance, reason1, reason2, reason3)) {
-                mLogger.error("数据库余额已更新，但记录流水失败！UUID: {}, Currency: {}", uuid, currencyType);
-                // 考虑是否需要回滚或采取其他措施，但目前 logTransaction 失败不影响 set 的结果
+                mLogger.error("记录流水失败，已回滚本次设置余额。UUID: {}, Currency: {}", uuid, currencyType);
+                return false;
             }
         } else {
             mLogger.debug("Set 操作未改变余额，不记录流水。UUID: {}, Currency: {}", uuid, currencyType);
         }
 
+        // --- 发布 AfterEvent (外层事务真正提交后才发布) ---
+        mDbConnection.afterCommit([playerUuidForEvent,
+                                   currencyTypeForEvent,
+                                   amountForEvent,
+                                   reason1ForEvent,
+                                   reason2ForEvent,
+                                   reason3ForEvent] {
+            auto afterEvent = event::SetMoneyAfterEvent(
+                playerUuidForEvent,
+                currencyTypeForEvent,
+                amountForEvent,
+                reason1ForEvent,
+                reason2ForEvent,
+                reason3ForEvent
+            );
+            ll::event::EventBus::getInstance().publish(afterEvent);
+        });
+        if (mFlowCounters && changeAmount != 0) {
+            // 计数同样只在外层事务提交后累加，回滚的操作不计入
+            mDbConnection.afterCommit([counters = mFlowCounters, currencyType, reason1, reason2, changeAmount] {
+                counters->record(currencyType, reason1, reason2, changeAmount);
+            });
+        }
+        if (mActiveUsers && changeAmount != 0) {
+            mDbConnection.afterCommit([tracker = mActiveUsers, uuid, currencyType, reason1] {
+                tracker->record(uuid, currencyType, reason1);
+            });
+        }
+        if (mExploitDetector && changeAmount > 0) {
+            // 直接设置余额带来的增加同样算作收入
+            mDbConnection.afterCommit([detector = mExploitDetector, uuid, currencyType, changeAmount, reason1, reason2] {
+                detector->observe(uuid, currencyType, changeAmount, reason1, reason2);
+            });
+        }
+        if (auto committed = transaction.tryCommit(); !committed) {
+            logDbError(mLogger, "提交设置余额事务", committed.error());
+            return false;
+        }
+
         mLogger.debug("成功设置/更新 UUID: {}, Currency: {} 的余额为: {}", uuid, currencyType, formatBalance(amount));
+        if (newBalance) {
+            *newBalance = amount;
+        }
         return true;
 
-    } catch (const db::DatabaseException& e) {
-        mLogger.error("设置余额时发生数据库错误: {}", e.what());
-        return false;
     } catch (const std::exception& e) {
         mLogger.error("设置余额时发生意外错误: {}", e.what());
         return false;
@@ -614,7 +844,8 @@ bool czmoney::MoneyManager::addPlayerBalance(
     int64_t            amountToAdd,
     const std::string& reason1,
     const std::string& reason2,
-    const std::string& reason3
+    const std::string& reason3,
+    int64_t*           newBalance
 ) {
     // 0. 检查货币类型和金额 (保持不变)
     if (!isCurrencyConfigured(currencyType)) {
@@ -667,6 +898,13 @@ bool czmoney::MoneyManager::addPlayerBalance(
     }
 
     try {
+        // 余额更新与流水写入在同一事务中提交 (账户初始化也包含在内)，避免崩溃后丢失流水
+        db::ScopedTransaction transaction(mDbConnection, std::nothrow);
+        if (!transaction.ok()) {
+            logDbError(mLogger, "增加余额", transaction.error());
+            return false;
+        }
+
         // 2. 获取当前余额，如果不存在则初始化
         // <<< 使用事件中可能已修改的数据 >>>
         int64_t currentBalance = getPlayerBalanceOrInit(playerUuidForEvent, currencyTypeForEvent);
@@ -681,13 +919,22 @@ bool czmoney::MoneyManager::addPlayerBalance(
         // 4. 准备 SQL 和参数 (原子更新)
         std::string sql;
         std::string dbType = mDbConnection.getDbType();
-        if (dbType == "postgresql") {
-            sql = "UPDATE player_balances SET amount = amount + $1 WHERE uuid = $2 AND currency_type = $3;";
+        // 启用哈希链时流水需要在写入后单独封存，不能使用合并语句
+        bool combinedLog = dbType == "postgresql" && !mLedgerChain.isEnabled();
+        db::DbParams params;
+        if (combinedLog) {
+            // PostgreSQL: 用数据修改 CTE 在一条语句中完成更新和记流水，previous_amount 取自 RETURNING
+            sql = "WITH updated AS (UPDATE player_balances SET amount = amount + $1, last_updated = CURRENT_TIMESTAMP WHERE uuid = $2 AND currency_type = $3 RETURNING amount) "
+                  "INSERT INTO economy_log (uuid, currency_type, change_amount, previous_amount, reason1, reason2, reason3) "
+                  "SELECT $2, $3, $1, amount - $1, $4, $5, $6 FROM updated;";
+            params = {amountToAddForEvent, playerUuidForEvent, currencyTypeForEvent, reason1ForEvent, reason2ForEvent, reason3ForEvent};
+        } else if (dbType == "postgresql") {
+            sql = "UPDATE player_balances SET amount = amount + $1, last_updated = CURRENT_TIMESTAMP WHERE uuid = $2 AND currency_type = $3;";
+            params = {amountToAddForEvent, playerUuidForEvent, currencyTypeForEvent};
         } else {
-            sql = "UPDATE player_balances SET amount = amount + ? WHERE uuid = ? AND currency_type = ?;";
+            sql = "UPDATE player_balances SET amount = amount + ?, last_updated = CURRENT_TIMESTAMP WHERE uuid = ? AND currency_type = ?;";
+            params = {amountToAddForEvent, playerUuidForEvent, currencyTypeForEvent};
         }
-        // <<< 使用事件中可能已修改的数据 >>>
-        db::DbParams params = {amountToAddForEvent, playerUuidForEvent, currencyTypeForEvent};
 
         mLogger.debug(
             "Executing prepared SQL for addPlayerBalance: {} with params: [{}, {}, {}]",
@@ -698,24 +945,26 @@ bool czmoney::MoneyManager::addPlayerBalance(
         );
 
         // 5. 执行更新
-        int affectedRows = mDbConnection.executePrepared(sql, params);
+        db::DbExpected<int> affectedRows = mDbConnection.tryExecutePrepared(sql, params);
+        if (!affectedRows) {
+            logDbError(mLogger, "增加余额", affectedRows.error());
+            return false; // 事务在作用域结束时回滚
+        }
 
-        if (affectedRows <= 0) {
+        if (*affectedRows <= 0) {
             mLogger.error(
                 "AddPlayerBalance UPDATE operation affected {} rows (expected 1). UUID: {}, Currency: {}",
-                affectedRows,
+                *affectedRows,
                 playerUuidForEvent,
                 currencyTypeForEvent
             );
-            if (!hasAccount(playerUuidForEvent, currencyTypeForEvent)) {
-                mLogger.error(" - Account seems to have disappeared during the add balance operation.");
-            }
-            return false; // 更新逻辑失败
+            return false; // 更新逻辑失败，事务在作用域结束时回滚
         }
 
-        // 6. 记录流水
+        // 6. 记录流水 (PostgreSQL 合并语句已在上面写入)
         // <<< 使用事件中可能已修改的数据 >>>
-        if (!logTransaction(
+        if (!combinedLog
+            && !logTransaction(
                 playerUuidForEvent,
                 currencyTypeForEvent,
                 amountToAddForEvent,
@@ -725,23 +974,58 @@ bool czmoney::MoneyManager::addPlayerBalance(
                 reason3ForEvent
             )) {
             mLogger.error(
-                "数据库余额已更新，但记录流水失败！(增加余额) UUID: {}, Currency: {}",
+                "记录流水失败，已回滚本次增加余额。UUID: {}, Currency: {}",
                 playerUuidForEvent,
                 currencyTypeForEvent
             );
+            return false;
         }
 
-        // <<< --- 发布 AfterEvent --- >>>
-        auto afterEvent = czmoney::event::AddMoneyAfterEvent(
-            playerUuidForEvent,
-            currencyTypeForEvent,
-            amountToAddForEvent,
-            reason1ForEvent,
-            reason2ForEvent,
-            reason3ForEvent
-        );
-        ll::event::EventBus::getInstance().publish(afterEvent);
+        // <<< --- 发布 AfterEvent (外层事务真正提交后才发布) --- >>>
+        mDbConnection.afterCommit([playerUuidForEvent,
+                                   currencyTypeForEvent,
+                                   amountToAddForEvent,
+                                   reason1ForEvent,
+                                   reason2ForEvent,
+                                   reason3ForEvent] {
+            auto afterEvent = czmoney::event::AddMoneyAfterEvent(
+                playerUuidForEvent,
+                currencyTypeForEvent,
+                amountToAddForEvent,
+                reason1ForEvent,
+                reason2ForEvent,
+                reason3ForEvent
+            );
+            ll::event::EventBus::getInstance().publish(afterEvent);
+        });
         // <<< --- AfterEvent 发布结束 --- >>>
+        if (mFlowCounters) {
+            mDbConnection.afterCommit(
+                [counters = mFlowCounters, currencyTypeForEvent, reason1ForEvent, reason2ForEvent, amountToAddForEvent] {
+                    counters->record(currencyTypeForEvent, reason1ForEvent, reason2ForEvent, amountToAddForEvent);
+                }
+            );
+        }
+
+        if (mActiveUsers) {
+            mDbConnection.afterCommit([tracker = mActiveUsers, playerUuidForEvent, currencyTypeForEvent, reason1ForEvent] {
+                tracker->record(playerUuidForEvent, currencyTypeForEvent, reason1ForEvent);
+            });
+        }
+        if (mExploitDetector) {
+            mDbConnection.afterCommit([detector = mExploitDetector,
+                                       playerUuidForEvent,
+                                       currencyTypeForEvent,
+                                       amountToAddForEvent,
+                                       reason1ForEvent,
+                                       reason2ForEvent] {
+                detector->observe(playerUuidForEvent, currencyTypeForEvent, amountToAddForEvent, reason1ForEvent, reason2ForEvent);
+            });
+        }
+        if (auto committed = transaction.tryCommit(); !committed) {
+            logDbError(mLogger, "提交增加余额事务", committed.error());
+            return false;
+        }
 
 
         mLogger.debug(
@@ -751,14 +1035,15 @@ bool czmoney::MoneyManager::addPlayerBalance(
             formatBalance(amountToAddForEvent),
             formatBalance(currentBalance + amountToAddForEvent)
         );
+        if (newBalance) {
+            // 余额在同一事务中读取并原子增加，无需再查询
+            *newBalance = currentBalance + amountToAddForEvent;
+        }
         return true;
 
     } catch (const std::runtime_error& e) { // Catch getPlayerBalanceOrInit exception
         mLogger.error("Runtime error during addPlayerBalance (likely from getPlayerBalanceOrInit): {}", e.what());
         return false;
-    } catch (const db::DatabaseException& e) { // 主要捕获 getPlayerBalanceOrInit 或 hasAccount 中的数据库错误
-        mLogger.error("Database error during addPlayerBalance (outside UPDATE execution): {}", e.what());
-        return false;
     } catch (const std::exception& e) { // 捕获其他未预料的异常
         mLogger.error("Unexpected standard error during addPlayerBalance: {}", e.what());
         return false;
@@ -772,7 +1057,9 @@ bool czmoney::MoneyManager::subtractPlayerBalance(
     int64_t            amountToSubtract,
     const std::string& reason1,
     const std::string& reason2,
-    const std::string& reason3
+    const std::string& reason3,
+    int64_t*           newBalance,
+    bool*              cancelled
 ) {
     // 0. 检查货币类型和金额
     if (!isCurrencyConfigured(currencyType)) {
@@ -809,13 +1096,22 @@ bool czmoney::MoneyManager::subtractPlayerBalance(
 
     if (beforeEvent.isCancelled()) {
         mLogger.debug("减少玩家 '{}' 余额的操作被事件取消。", playerUuidForEvent);
+        if (cancelled) {
+            *cancelled = true;
+        }
         return false;
     }
     // --- 事件结束 ---
-    // --- 事务考虑 ---
-    // 单个 UPDATE 通常是原子的
+    // --- 事务 ---
+    // 余额更新与流水写入在同一事务中提交，避免崩溃后丢失流水
 
     try {
+        db::ScopedTransaction transaction(mDbConnection, std::nothrow);
+        if (!transaction.ok()) {
+            logDbError(mLogger, "减少余额", transaction.error());
+            return false;
+        }
+
         // 2. 获取当前余额 (不初始化)
         std::optional<int64_t> currentBalanceOpt = getPlayerBalance(uuid, currencyType);
 
@@ -841,7 +1137,8 @@ bool czmoney::MoneyManager::subtractPlayerBalance(
         // int64_t newBalance = currentBalance - amountToSubtract; // 不再需要此行
 
         // 5. 检查扣款后是否低于最低余额 (在 SQL 中原子性检查)
-        int64_t minBalance = getMinimumBalance(currencyType);
+        // 被冻结 (hold) 的金额不可花费，因此扣款后的余额还需覆盖冻结总额
+        int64_t minBalance = getMinimumBalance(currencyType) + getHeldBalance(uuid, currencyType);
         // if (newBalance < minBalance) { // 此检查现在在 SQL 中完成
         //     mLogger.error("无法减少余额：操作将使 UUID: {} 的 Currency: {} 余额 ({}) 低于最低允许值 ({})",
         //                   uuid, currencyType, formatBalance(newBalance), formatBalance(minBalance));
@@ -851,12 +1148,18 @@ bool czmoney::MoneyManager::subtractPlayerBalance(
         // 6. 准备 SQL 和参数 (原子更新，包含余额和最低余额检查)
         std::string sql;
         std::string dbType = mDbConnection.getDbType();
-        if (dbType == "postgresql") {
-            // PostgreSQL: amount = amount - $1 WHERE uuid = $2 AND currency_type = $3 AND amount >= $4 AND (amount - $5) >= $6;
-            sql = "UPDATE player_balances SET amount = amount - $1 WHERE uuid = $2 AND currency_type = $3 AND amount >= $4 AND (amount - $5) >= $6;";
+        // 启用哈希链时流水需要在写入后单独封存，不能使用合并语句
+        bool combinedLog = dbType == "postgresql" && !mLedgerChain.isEnabled();
+        if (combinedLog) {
+            // PostgreSQL: 用数据修改 CTE 在一条语句中完成条件扣款和记流水，previous_amount 取自 RETURNING
+            sql = "WITH updated AS (UPDATE player_balances SET amount = amount - $1, last_updated = CURRENT_TIMESTAMP WHERE uuid = $2 AND currency_type = $3 AND amount >= $4 AND (amount - $5) >= $6 RETURNING amount) "
+                  "INSERT INTO economy_log (uuid, currency_type, change_amount, previous_amount, reason1, reason2, reason3) "
+                  "SELECT $2, $3, -$1, amount + $1, $7, $8, $9 FROM updated;";
+        } else if (dbType == "postgresql") {
+            sql = "UPDATE player_balances SET amount = amount - $1, last_updated = CURRENT_TIMESTAMP WHERE uuid = $2 AND currency_type = $3 AND amount >= $4 AND (amount - $5) >= $6;";
         } else {
             // SQLite/MySQL: amount = amount - ? WHERE uuid = ? AND currency_type = ? AND amount >= ? AND (amount - ?) >= ?;
-            sql = "UPDATE player_balances SET amount = amount - ? WHERE uuid = ? AND currency_type = ? AND amount >= ? AND (amount - ?) >= ?;";
+            sql = "UPDATE player_balances SET amount = amount - ?, last_updated = CURRENT_TIMESTAMP WHERE uuid = ? AND currency_type = ? AND amount >= ? AND (amount - ?) >= ?;";
         }
         db::DbParams params = {
             amountToSubtract, // $1 / ?
@@ -866,48 +1169,77 @@ bool czmoney::MoneyManager::subtractPlayerBalance(
             amountToSubtract, // $5 / ? (检查扣除后是否低于最低余额)
             minBalance        // $6 / ? (最低余额)
         };
+        if (combinedLog) {
+            params.insert(params.end(), {reason1, reason2, reason3}); // $7 ~ $9 (流水理由)
+        }
 
         mLogger.debug("Executing prepared SQL for subtractPlayerBalance: {} with params: [{}, {}, {}, {}, {}, {}]",
                       sql, amountToSubtract, uuid, currencyType, amountToSubtract, amountToSubtract, minBalance);
 
         // 7. 执行更新
-        int affectedRows = mDbConnection.executePrepared(sql, params);
+        db::DbExpected<int> affectedRows = mDbConnection.tryExecutePrepared(sql, params);
+        if (!affectedRows) {
+            logDbError(mLogger, "减少余额", affectedRows.error());
+            return false; // 事务在作用域结束时回滚
+        }
 
-        if (affectedRows <= 0) {
+        if (*affectedRows <= 0) {
              mLogger.warn("减少余额时 UPDATE 操作影响了 {} 行 (预期 1 行)。UUID: {}, Currency: {}",
-                          affectedRows, uuid, currencyType);
+                          *affectedRows, uuid, currencyType);
              // 如果没有行受影响，可能是余额不足或低于最低余额，或者账户不存在
              // 此时不需要额外检查 hasAccount，因为 SQL 已经处理了这些条件
              mLogger.warn(" - 扣款失败，可能原因：余额不足，或扣款后低于最低余额，或账户不存在。");
-             return false; // 更新失败
+             return false; // 更新失败，事务在作用域结束时回滚
         }
 
-        // 8. 记录流水 (注意 changeAmount 是负数)
-        // 此时 newBalance 无法直接从 C++ 计算，但我们可以通过 currentBalance - amountToSubtract 得到理论上的新余额
-        // 或者，如果需要精确的最终余额，可以再次查询数据库，但那会引入另一个读操作
-        // 为了保持原子性，我们假设更新成功，并使用操作前的余额和变动量来记录流水
-        if (!logTransaction(uuid, currencyType, -amountToSubtract, currentBalance, reason1, reason2, reason3)) {
-            mLogger.error("数据库余额已更新，但记录流水失败！(减少余额) UUID: {}, Currency: {}", uuid, currencyType);
-            // 考虑是否需要回滚或采取其他措施
+        // 8. 记录流水 (注意 changeAmount 是负数；PostgreSQL 合并语句已在上面写入)
+        // 与余额更新处于同一事务中，使用操作前的余额和变动量来记录流水
+        if (!combinedLog
+            && !logTransaction(uuid, currencyType, -amountToSubtract, currentBalance, reason1, reason2, reason3)) {
+            mLogger.error("记录流水失败，已回滚本次减少余额。UUID: {}, Currency: {}", uuid, currencyType);
+            return false;
         }
-        // --- 发布 AfterEvent ---
-        auto afterEvent = event::SubtractMoneyAfterEvent(
-            playerUuidForEvent,
-            currencyTypeForEvent,
-            amountToSubtractForEvent,
-            reason1ForEvent,
-            reason2ForEvent,
-            reason3ForEvent
-        );
-        ll::event::EventBus::getInstance().publish(afterEvent);
+
+        // --- 发布 AfterEvent (外层事务真正提交后才发布) ---
+        mDbConnection.afterCommit([playerUuidForEvent,
+                                   currencyTypeForEvent,
+                                   amountToSubtractForEvent,
+                                   reason1ForEvent,
+                                   reason2ForEvent,
+                                   reason3ForEvent] {
+            auto afterEvent = event::SubtractMoneyAfterEvent(
+                playerUuidForEvent,
+                currencyTypeForEvent,
+                amountToSubtractForEvent,
+                reason1ForEvent,
+                reason2ForEvent,
+                reason3ForEvent
+            );
+            ll::event::EventBus::getInstance().publish(afterEvent);
+        });
         // --- AfterEvent 结束 ---
+        if (mFlowCounters) {
+            mDbConnection.afterCommit([counters = mFlowCounters, currencyType, reason1, reason2, amountToSubtract] {
+                counters->record(currencyType, reason1, reason2, -amountToSubtract);
+            });
+        }
+
+        if (mActiveUsers) {
+            mDbConnection.afterCommit([tracker = mActiveUsers, uuid, currencyType, reason1] {
+                tracker->record(uuid, currencyType, reason1);
+            });
+        }
+        if (auto committed = transaction.tryCommit(); !committed) {
+            logDbError(mLogger, "提交减少余额事务", committed.error());
+            return false;
+        }
         mLogger.debug("成功为 UUID: {}, Currency: {} 减少余额 {}, 当前余额: {}", uuid, currencyType, formatBalance(amountToSubtract), formatBalance(currentBalance - amountToSubtract));
+        if (newBalance) {
+            *newBalance = currentBalance - amountToSubtract;
+        }
         return true;
 
-    } catch (const db::DatabaseException& e) {
-         mLogger.error("减少余额时发生数据库错误: {}", e.what());
-         return false;
-    } catch (const std::exception& e) {
+    } catch (const std::exception& e) { // 兜底：事件监听器等抛出的意外异常
         mLogger.error("减少余额时发生意外错误: {}", e.what());
         return false;
     }
@@ -1167,8 +1499,13 @@ bool czmoney::MoneyManager::transferBalance(
     // <<< --- 事件处理结束 --- >>>
 
     // --- 数据库事务 ---
+    // 已在外层事务中时使用保存点，失败只撤销本次转账
     try {
-        mDbConnection.beginTransaction(); // 开始事务
+        db::ScopedTransaction transaction(mDbConnection, std::nothrow);
+        if (!transaction.ok()) {
+            logDbError(mLogger, "开始转账事务", transaction.error());
+            return false;
+        }
 
         // 1. 尝试从发送方扣款 (使用事件中可能已修改的数据)
         std::string subtractReason1 = reason1ForEvent;
@@ -1177,8 +1514,7 @@ bool czmoney::MoneyManager::transferBalance(
 
         if (!subtractPlayerBalance(senderUuidForEvent, currencyTypeForEvent, amountToTransferForEvent, subtractReason1, subtractReason2, subtractReason3)) {
             mLogger.warn("转账失败：无法从发送方 {} 扣除 {} (可能是余额不足或账户问题)", senderUuidForEvent, formatBalance(amountToTransferForEvent));
-            mDbConnection.rollbackTransaction(); // 回滚事务
-            return false;
+            return false; // 事务在作用域结束时回滚
         }
 
         // 2. 尝试给接收方加款 (如果需要，使用事件中可能已修改的数据)
@@ -1190,51 +1526,50 @@ bool czmoney::MoneyManager::transferBalance(
             if (!addPlayerBalance(receiverUuidForEvent, currencyTypeForEvent, amountReceivedForEvent, addReason1, addReason2, addReason3)) {
                  mLogger.error("转账失败：已从发送方 {} 扣款 {}，但无法为接收方 {} 增加 {}",
                               senderUuidForEvent, formatBalance(amountToTransferForEvent), receiverUuidForEvent, formatBalance(amountReceivedForEvent));
-                 mDbConnection.rollbackTransaction(); // 回滚事务
-                 return false;
+                 return false; // 事务在作用域结束时回滚
             }
         } else {
              mLogger.info("转账税后接收金额为 0 (或更少)，接收方 {} 余额未增加。税费: {}", receiverUuidForEvent, formatBalance(taxAmountForEvent));
         }
 
-        // 3. 所有操作成功，提交事务
-        mDbConnection.commitTransaction(); // 提交事务
-
-        // <<< --- 发布 AfterEvent --- >>>
-        auto afterEvent = czmoney::event::TransferMoneyAfterEvent(
-            senderUuidForEvent,
-            receiverUuidForEvent,
-            currencyTypeForEvent,
-            amountToTransferForEvent,
-            taxAmountForEvent,
-            amountReceivedForEvent,
-            reason1ForEvent,
-            reason2ForEvent,
-            reason3ForEvent
-        );
-        ll::event::EventBus::getInstance().publish(afterEvent);
+        // <<< --- 发布 AfterEvent (与扣款/加款事件一起在提交后发布) --- >>>
+        mDbConnection.afterCommit([senderUuidForEvent,
+                                   receiverUuidForEvent,
+                                   currencyTypeForEvent,
+                                   amountToTransferForEvent,
+                                   taxAmountForEvent,
+                                   amountReceivedForEvent,
+                                   reason1ForEvent,
+                                   reason2ForEvent,
+                                   reason3ForEvent] {
+            auto afterEvent = czmoney::event::TransferMoneyAfterEvent(
+                senderUuidForEvent,
+                receiverUuidForEvent,
+                currencyTypeForEvent,
+                amountToTransferForEvent,
+                taxAmountForEvent,
+                amountReceivedForEvent,
+                reason1ForEvent,
+                reason2ForEvent,
+                reason3ForEvent
+            );
+            ll::event::EventBus::getInstance().publish(afterEvent);
+        });
         // <<< --- AfterEvent 发布结束 --- >>>
 
+        // 3. 所有操作成功，提交事务
+        if (auto committed = transaction.tryCommit(); !committed) {
+            logDbError(mLogger, "提交转账事务", committed.error());
+            return false;
+        }
+
         mLogger.info("成功转账 {} ({}) 从 {} 到 {} (实收: {}, 税: {})",
                      formatBalance(amountToTransferForEvent), currencyTypeForEvent, senderUuidForEvent, receiverUuidForEvent,
                      formatBalance(amountReceivedForEvent), formatBalance(taxAmountForEvent));
         return true;
 
-    } catch (const db::DatabaseException& e) {
-        mLogger.error("转账过程中发生数据库错误: {}", e.what());
-        try {
-            mDbConnection.rollbackTransaction(); // 尝试回滚
-        } catch (const db::DatabaseException& rbEx) {
-            mLogger.error("回滚转账事务时也发生错误: {}", rbEx.what());
-        }
-        return false;
-    } catch (const std::exception& e) { // 捕获其他潜在异常 (例如 fmt::format)
+    } catch (const std::exception& e) { // 捕获其他潜在异常 (例如 fmt::format)，事务已在析构时回滚
         mLogger.error("转账过程中发生意外错误: {}", e.what());
-         try {
-            mDbConnection.rollbackTransaction(); // 尝试回滚
-        } catch (const db::DatabaseException& rbEx) {
-            mLogger.error("回滚转账事务时也发生错误: {}", rbEx.what());
-        }
         return false;
     }
     // --- 事务结束 ---
@@ -1284,24 +1619,24 @@ std::vector<std::pair<std::string, int64_t>> czmoney::MoneyManager::getTopBalanc
     mLogger.debug("  Params: [CurrencyType={}, Limit={}, Offset={}]", currencyType, limit, offset);
 
     try {
-        db::DbResult queryResult = mDbConnection.queryPrepared(sql, params);
+        // 按列读取：整页结果只占用几块连续内存
+        db::ColumnarResult queryResult = mDbConnection.queryColumnar(sql, params);
+        if (queryResult.empty()) {
+            return results;
+        }
+        if (queryResult.columnCount() != 2) { // 期望 2 列: uuid, amount
+            mLogger.error("查询排行榜返回了列数不匹配的结果 (预期 2, 实际 {})", queryResult.columnCount());
+            return results;
+        }
 
-        results.reserve(queryResult.size());
-        for (const auto& row : queryResult) {
-            if (row.size() != 2) { // 期望 2 列: uuid, amount
-                mLogger.error("查询排行榜返回了列数不匹配的行 (预期 2, 实际 {})", row.size());
+        results.reserve(queryResult.rowCount());
+        for (size_t row = 0; row < queryResult.rowCount(); ++row) {
+            std::optional<int64_t> amount = queryResult.getInt64(row, 1); // 余额是 int64_t (分)
+            if (!amount.has_value()) {
+                mLogger.error("处理排行榜记录时无法读取第 {} 行的余额。", row);
                 continue;
             }
-
-            try {
-                std::string uuid = std::get<std::string>(row[0]);
-                int64_t amount = std::get<int64_t>(row[1]); // 余额是 int64_t (分)
-                results.emplace_back(uuid, amount);
-            } catch (const std::bad_variant_access& e) {
-                mLogger.error("处理排行榜记录时类型转换失败: {}", e.what());
-            } catch (const std::exception& e) {
-                mLogger.error("处理排行榜记录时发生意外错误: {}", e.what());
-            }
+            results.emplace_back(queryResult.getString(row, 0), amount.value());
         }
     } catch (const db::DatabaseException& e) {
         mLogger.error("查询排行榜时发生数据库错误: {}", e.what());
@@ -1372,9 +1707,39 @@ std::vector<czmoney::TransactionLogEntry> czmoney::MoneyManager::queryTransactio
     addCondition("currency_type", currencyTypeFilter);
     addTimeCondition("timestamp", startTimeFilter, ">=");
     addTimeCondition("timestamp", endTimeFilter, "<=");
-    addCondition("reason1", reason1Filter, true); // 使用 LIKE
-    addCondition("reason2", reason2Filter, true); // 使用 LIKE
-    addCondition("reason3", reason3Filter, true); // 使用 LIKE
+    // 理由过滤：全文索引可用时改写为走索引的条件，语义与 LIKE '%value%' 相同。
+    // 指定了 UUID 时 idx_uuid 已足够精确，直接在其结果上做 LIKE 更快。
+    // PostgreSQL 的 trigram 索引由规划器直接用于 LIKE，不需要改写。
+    bool useReasonIndex = mReasonIndexReady && (dbType == "sqlite" || dbType == "mysql")
+                       && !(uuidFilter.has_value() && !uuidFilter.value().empty());
+    auto addReasonCondition = [&](const std::string& column, const std::optional<std::string>& value) {
+        if (!value.has_value() || value.value().empty()) {
+            return;
+        }
+        const std::string& term = value.value();
+        size_t charCount = 0; // UTF-8 字符数
+        for (unsigned char c : term) {
+            if ((c & 0xC0) != 0x80) ++charCount;
+        }
+        if (useReasonIndex && dbType == "sqlite" && charCount >= 3) {
+            // FTS5 trigram 表上的 LIKE 由倒排索引计算 (至少需要 3 个字符)
+            whereConditions.push_back("id IN (SELECT rowid FROM economy_log_fts WHERE " + column + " LIKE " + getPlaceholder() + ")");
+            params.emplace_back("%" + term + "%");
+            return;
+        }
+        if (useReasonIndex && dbType == "mysql" && charCount >= mNgramTokenSize
+            && term.find_first_of(" \t\r\n\"%_") == std::string::npos) {
+            // ngram 短语匹配是 LIKE 结果的超集，用全文索引取候选行，再用 LIKE 精确复核；
+            // 含空白、引号或 LIKE 通配符的关键词无法保证这一点，仍使用 LIKE
+            whereConditions.push_back("MATCH(" + column + ") AGAINST(" + getPlaceholder() + " IN BOOLEAN MODE)");
+            params.emplace_back("\"" + term + "\"");
+        }
+        addCondition(column, value, true);
+    };
+
+    addReasonCondition("reason1", reason1Filter);
+    addReasonCondition("reason2", reason2Filter);
+    addReasonCondition("reason3", reason3Filter);
 
     if (!whereConditions.empty()) {
         sqlBuilder << " WHERE ";
@@ -1402,68 +1767,44 @@ std::vector<czmoney::TransactionLogEntry> czmoney::MoneyManager::queryTransactio
     // 可以添加更详细的参数日志记录，例如遍历 params 并转换为字符串
 
     try {
-        db::DbResult queryResult = mDbConnection.queryPrepared(finalSql, params);
-
-        results.reserve(queryResult.size());
+        // 按列读取：文本列共用一块缓冲区，不再为每个单元格单独分配
+        db::ColumnarResult queryResult = mDbConnection.queryColumnar(finalSql, params);
+        if (queryResult.empty()) {
+            return results;
+        }
+        if (queryResult.columnCount() != 9) { // 期望 9 列
+            mLogger.error("查询流水返回了列数不匹配的结果 (预期 9, 实际 {})", queryResult.columnCount());
+            return results;
+        }
 
-        for (const auto& row : queryResult) {
-            if (row.size() != 9) { // 期望 9 列
-                mLogger.error("查询流水返回了列数不匹配的行 (预期 9, 实际 {})", row.size());
-                 continue; // 跳过此行
+        // 读取数值列：文本会被解析，NULL 按 0 处理
+        auto getInt64Value = [&](size_t row, size_t col, const char* colName) -> int64_t {
+            if (queryResult.isNull(row, col)) {
+                mLogger.warn("流水列 '{}' 返回了 NULL 值 (预期为数值)。", colName);
+                return 0LL;
             }
+            std::optional<int64_t> value = queryResult.getInt64(row, col);
+            if (!value.has_value()) {
+                mLogger.error("无法将流水列 '{}' 的值 '{}' 转换为 int64_t。", colName, queryResult.getString(row, col));
+                return 0LL;
+            }
+            return value.value();
+        };
 
+        results.reserve(queryResult.rowCount());
+        for (size_t row = 0; row < queryResult.rowCount(); ++row) {
             czmoney::TransactionLogEntry entry;
-            try {
-                // Helper lambda to safely get int64_t from DbValue (handles string conversion)
-                auto getInt64Value = [&](const db::DbValue& val, const std::string& colName) -> int64_t {
-                    if (std::holds_alternative<int64_t>(val)) {
-                        return std::get<int64_t>(val);
-                    } else if (std::holds_alternative<std::string>(val)) {
-                        const std::string& strVal = std::get<std::string>(val);
-                        try {
-                            return std::stoll(strVal);
-                        } catch (...) {
-                            mLogger.error("无法将流水列 '{}' 的字符串值 '{}' 转换为 int64_t。", colName, strVal);
-                            return 0LL; // 返回默认值或抛出异常
-                        }
-                    } else if (std::holds_alternative<std::nullptr_t>(val)) {
-                         mLogger.warn("流水列 '{}' 返回了 NULL 值 (预期为数值)。", colName);
-                         return 0LL;
-                    } else {
-                        mLogger.error("流水列 '{}' 返回了非预期的类型。", colName);
-                        return 0LL;
-                    }
-                };
-
-                 // Helper lambda to safely get string from DbValue (handles nullptr)
-                auto getStringValue = [&](const db::DbValue& val, const std::string& colName) -> std::string {
-                    if (std::holds_alternative<std::string>(val)) {
-                        return std::get<std::string>(val);
-                    } else if (std::holds_alternative<std::nullptr_t>(val)) {
-                        return ""; // Treat NULL as empty string
-                    } else {
-                         mLogger.error("流水列 '{}' 返回了非预期的类型 (预期为字符串或 NULL)。", colName);
-                         return "";
-                    }
-                };
-
-
-                // 使用辅助函数提取数据
-                entry.id = getInt64Value(row[0], "id");
-                entry.timestamp = getStringValue(row[1], "timestamp"); // timestamp 通常是字符串
-                entry.uuid = getStringValue(row[2], "uuid");
-                entry.currencyType = getStringValue(row[3], "currency_type");
-                // 从数据库获取 int64_t (分)，然后转换为 double (元) 存储在结构体中
-                entry.changeAmount = static_cast<double>(getInt64Value(row[4], "change_amount")) / 100.0;
-                entry.previousAmount = static_cast<double>(getInt64Value(row[5], "previous_amount")) / 100.0;
-                entry.reason1 = getStringValue(row[6], "reason1");
-                entry.reason2 = getStringValue(row[7], "reason2");
-                entry.reason3 = getStringValue(row[8], "reason3");
-
-                results.push_back(std::move(entry));
-            } catch (const std::exception& e) { // Catch broader exceptions during processing
-                 mLogger.error("处理流水记录时发生错误: {}", e.what());
-            }
+            entry.id           = getInt64Value(row, 0, "id");
+            entry.timestamp    = queryResult.getString(row, 1); // timestamp 通常是字符串
+            entry.uuid         = queryResult.getString(row, 2);
+            entry.currencyType = queryResult.getString(row, 3);
+            // 从数据库获取 int64_t (分)，然后转换为 double (元) 存储在结构体中
+            entry.changeAmount   = static_cast<double>(getInt64Value(row, 4, "change_amount")) / 100.0;
+            entry.previousAmount = static_cast<double>(getInt64Value(row, 5, "previous_amount")) / 100.0;
+            entry.reason1        = queryResult.getString(row, 6); // NULL 视为空字符串
+            entry.reason2        = queryResult.getString(row, 7);
+            entry.reason3        = queryResult.getString(row, 8);
+            results.push_back(std::move(entry));
         }
 
     } catch (const db::DatabaseException& e) {
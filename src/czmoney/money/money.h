@@ -1,13 +1,22 @@
 #pragma once // 防止头文件被重复包含
 
 #include <string>      // 使用 std::string
+#include <string_view>
 #include <cstdint>     // 使用 int64_t 等固定宽度整数类型
 #include <optional>    // 使用 std::optional 表示可能不存在的值
 #include <vector>      // 用于返回流水列表
+#include <mutex>       // 保护冻结 (hold) 的内存状态
+#include <unordered_map>
 #include "ll/api/io/Logger.h" // 引入 LeviLamina 的日志记录器
 #include "czmoney/config.h" // 包含配置文件头文件
 #include "czmoney/database_interface.h" // 包含数据库接口
 #include "czmoney/money/money_api.h" // 包含 MoneyApiResult 枚举
+#include "czmoney/money/LedgerChain.h" // 包含流水哈希链
+#include "czmoney/money/FlowCounters.h" // 包含资金流向计数器
+#include "czmoney/money/ActiveUsers.h" // 包含活跃玩家统计
+#include "czmoney/money/AccountFilter.h" // 包含账户存在性过滤器
+#include "czmoney/money/ExploitDetector.h" // 包含异常收入检测
+#include "czmoney/money/RateLimiter.h" // 包含写操作限流器
 
 // 前向声明 (Forward declaration)
 namespace db {
@@ -51,6 +60,57 @@ public:
     MoneyManager(const MoneyManager&) = delete;
     MoneyManager& operator=(const MoneyManager&) = delete;
 
+    /**
+     * @brief 设置资金流向计数器，余额变动提交后在其中计数
+     * @param counters 计数器指针 (不持有所有权)，传入 nullptr 表示不计数
+     */
+    void setFlowCounters(FlowCounters* counters) { mFlowCounters = counters; }
+
+    /**
+     * @brief 设置活跃玩家统计，余额变动提交后把玩家计入当天的草图
+     * @param tracker 统计器指针 (不持有所有权)，传入 nullptr 表示不统计
+     */
+    void setActiveUserTracker(ActiveUserTracker* tracker) { mActiveUsers = tracker; }
+
+    /**
+     * @brief 设置账户存在性过滤器，查询过滤器判定为不存在的账户时不访问数据库
+     * @param filter 过滤器指针 (不持有所有权)，传入 nullptr 表示总是查询数据库
+     */
+    void setAccountFilter(AccountFilter* filter) { mAccountFilter = filter; }
+
+    /**
+     * @brief 设置异常收入检测，每笔入账在外层事务提交后交给检测器观察
+     * @param detector 检测器指针 (不持有所有权)，传入 nullptr 表示不检测
+     */
+    void setExploitDetector(ExploitDetector* detector) { mExploitDetector = detector; }
+
+    /**
+     * @brief 设置写操作限流器
+     * @param limiter 限流器指针 (不持有所有权)，传入 nullptr 表示不限流
+     */
+    void setRateLimiter(RateLimiter* limiter) { mRateLimiter = limiter; }
+
+    /**
+     * @brief 理由全文索引建立完成后由 ReasonIndexBuilder 调用，之后按理由查询流水改为走索引
+     * @param ngramTokenSize MySQL ngram 分词长度 (其他数据库忽略)
+     */
+    void enableReasonIndex(size_t ngramTokenSize) {
+        mNgramTokenSize   = ngramTokenSize;
+        mReasonIndexReady = true;
+    }
+
+    /**
+     * @brief 在访问数据库前为一次写操作消耗令牌
+     *
+     * 总是按调用方 (API 的 reason1，为空时归入 "<unknown>") 限流；能确定发起玩家时 (例如转账的付款方)
+     * 还要同时检查该玩家的令牌桶，两个桶都有令牌才放行，被拒绝时两个桶都不扣除。
+     * 同一个桶在一次耗尽期间只记录一条警告。未设置限流器时总是放行。
+     * @param playerUuid 发起操作的玩家 UUID，未知时为空
+     * @param caller 调用方 (API 的 reason1)
+     * @return bool 允许执行返回 true；应以 RateLimited 拒绝时返回 false
+     */
+    bool checkRateLimit(std::string_view playerUuid, std::string_view caller);
+
     /**
      * @brief 初始化数据库表
      *
@@ -89,6 +149,25 @@ public:
      */
     int64_t getPlayerBalanceOrInit(const std::string& uuid, const std::string& currencyType);
 
+    /**
+     * @brief 创建账户 (账户不存在时插入，已存在时不做任何修改)
+     *
+     * 只执行一条 "不存在才插入" 语句，不触发 SetMoney 事件；真正插入记录时发布 AccountCreatedEvent，
+     * 并按 writeOpeningLog 在同一事务中写入一条开户流水。
+     * 如果其他线程 (或服务器) 抢先创建了该账户，返回已有的余额。
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     * @param initialBalance 初始余额 (整数，实际金额乘以 100)
+     * @param writeOpeningLog 是否写入开户流水 (变动为 initialBalance，操作前金额为 0)
+     * @return std::optional<int64_t> 账户当前的余额；失败时返回 std::nullopt
+     */
+    std::optional<int64_t> createAccount(
+        const std::string& uuid,
+        const std::string& currencyType,
+        int64_t            initialBalance,
+        bool               writeOpeningLog = false
+    );
+
     /**
      * @brief 设置玩家指定货币类型的余额
      *
@@ -99,6 +178,7 @@ public:
      * @param reason1 可选的操作理由 1 (例如，插件名称)
      * @param reason2 可选的操作理由 2
      * @param reason3 可选的操作理由 3
+     * @param newBalance 成功时写入操作后的余额 (可为 nullptr)，调用方无需再查询一次
      * @return bool 操作是否成功
      */
     bool setPlayerBalance(
@@ -107,7 +187,8 @@ public:
         int64_t            amount,
         const std::string& reason1 = "",
         const std::string& reason2 = "",
-        const std::string& reason3 = ""
+        const std::string& reason3 = "",
+        int64_t*           newBalance = nullptr
     );
 
     /**
@@ -120,6 +201,7 @@ public:
      * @param reason1 可选的操作理由 1
      * @param reason2 可选的操作理由 2
      * @param reason3 可选的操作理由 3
+     * @param newBalance 成功时写入操作后的余额 (可为 nullptr)
      * @return bool 操作是否成功
      */
     bool addPlayerBalance(
@@ -128,7 +210,8 @@ public:
         int64_t            amountToAdd,
         const std::string& reason1 = "",
         const std::string& reason2 = "",
-        const std::string& reason3 = ""
+        const std::string& reason3 = "",
+        int64_t*           newBalance = nullptr
     );
 
     /**
@@ -141,6 +224,8 @@ public:
      * @param reason1 可选的操作理由 1
      * @param reason2 可选的操作理由 2
      * @param reason3 可选的操作理由 3
+     * @param newBalance 成功时写入操作后的余额 (可为 nullptr)
+     * @param cancelled 被事件监听器取消时写入 true (可为 nullptr)
      * @return bool 如果操作成功（账户存在且余额足够）则返回 true，否则返回 false
      */
     bool subtractPlayerBalance(
@@ -149,7 +234,9 @@ public:
         int64_t            amountToSubtract,
         const std::string& reason1 = "",
         const std::string& reason2 = "",
-        const std::string& reason3 = ""
+        const std::string& reason3 = "",
+        int64_t*           newBalance = nullptr,
+        bool*              cancelled  = nullptr
     );
 
     /**
@@ -224,6 +311,43 @@ public:
         const std::string& reason3 = ""
     );
 
+    // --- 货币兑换 ---
+
+    /**
+     * @brief 在同一玩家的两种货币之间兑换
+     *
+     * 按 exchange.rates 中的汇率计算兑换所得 (按分向下取整)。扣款、加款和两条流水在同一个事务中完成，
+     * 两条流水由一条 INSERT 语句写入；只发布一对 ExchangeMoney 事件，不再分别触发扣款/加款事件。
+     * 目标货币的账户不存在时按初始余额创建。
+     * @param uuid 玩家的 UUID
+     * @param fromCurrency 支付的货币类型
+     * @param toCurrency 获得的货币类型
+     * @param amount 支付金额 (整数，实际金额 * 100，必须为正数)
+     * @param amountReceived 成功时写入获得的目标货币金额 (可为 nullptr)
+     * @param reason1 可选的操作理由 1 (例如插件名称)
+     * @param reason2 可选的操作理由 2
+     * @param reason3 可选的操作理由 3
+     * @return api::MoneyApiResult 操作结果；未开启兑换 (默认关闭) 或未配置该方向的汇率时返回 ExchangeNotAllowed
+     */
+    api::MoneyApiResult exchangeBalance(
+        const std::string& uuid,
+        const std::string& fromCurrency,
+        const std::string& toCurrency,
+        int64_t            amount,
+        int64_t*           amountReceived = nullptr,
+        const std::string& reason1        = "Exchange",
+        const std::string& reason2        = "",
+        const std::string& reason3        = ""
+    );
+
+    /**
+     * @brief 获取兑换汇率 (每 1 单位源货币兑换得到的目标货币数量)
+     * @param fromCurrency 支付的货币类型
+     * @param toCurrency 获得的货币类型
+     * @return std::optional<double> 兑换已关闭或汇率表中没有该方向时返回 std::nullopt
+     */
+    std::optional<double> getExchangeRate(const std::string& fromCurrency, const std::string& toCurrency) const;
+
     /**
      * @brief 获取指定货币类型的金币排行榜数据
      *
@@ -239,7 +363,97 @@ public:
         size_t offset = 0
     );
 
+    // --- 冻结 (Hold / Escrow) ---
+
+    /**
+     * @brief 冻结玩家的一部分余额
+     *
+     * 冻结只减少可用余额 (内存 + holds 表)，不修改 player_balances，也不记录流水或发布事件。
+     * 之后通过 captureHold 转为真实扣款，或通过 releaseHold 解冻。
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     * @param amount 冻结金额 (整数，实际金额 * 100，必须为正数)
+     * @param[out] outHoldId 成功时写入冻结单号
+     * @param reason1 可选的理由 1 (例如插件名称)
+     * @param reason2 可选的理由 2
+     * @param reason3 可选的理由 3
+     * @return api::MoneyApiResult 操作结果 (可用余额不足时返回 InsufficientBalance)
+     */
+    api::MoneyApiResult placeHold(
+        const std::string& uuid,
+        const std::string& currencyType,
+        int64_t            amount,
+        int64_t&           outHoldId,
+        const std::string& reason1 = "",
+        const std::string& reason2 = "",
+        const std::string& reason3 = ""
+    );
+
+    /**
+     * @brief 兑现冻结：从冻结方扣款，并可选地转给接收方
+     *
+     * 删除冻结记录与扣款/加款在同一个事务中完成。兑现金额小于冻结金额时，剩余部分自动解冻。
+     * @param holdId 冻结单号
+     * @param receiverUuid 接收方 UUID，为空表示只扣款 (例如系统商店)
+     * @param amount 兑现金额，std::nullopt 表示兑现全部冻结金额
+     * @param reason1 可选的理由 1
+     * @param reason2 可选的理由 2
+     * @param reason3 可选的理由 3
+     * @return api::MoneyApiResult 操作结果 (可用余额不足时返回 InsufficientBalance，扣款被事件监听器取消时返回 Cancelled)
+     */
+    api::MoneyApiResult captureHold(
+        int64_t                       holdId,
+        const std::string&            receiverUuid = "",
+        const std::optional<int64_t>& amount       = std::nullopt,
+        const std::string&            reason1      = "",
+        const std::string&            reason2      = "",
+        const std::string&            reason3      = ""
+    );
+
+    /**
+     * @brief 解冻 (例如竞拍被超过时退款)
+     *
+     * 只删除 holds 表中的记录并更新内存，不访问 player_balances。
+     * @param holdId 冻结单号
+     * @return api::MoneyApiResult 操作结果 (单号不存在时返回 HoldNotFound)
+     */
+    api::MoneyApiResult releaseHold(int64_t holdId);
+
+    /**
+     * @brief 从 holds 表重新加载未结清的冻结 (恢复备份等直接改写 holds 表之后调用)
+     * @return bool 操作是否成功
+     */
+    bool reloadHolds();
+
+    /**
+     * @brief 获取玩家当前被冻结的总金额
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     * @return int64_t 冻结总额 (整数，实际金额 * 100)，无冻结时为 0
+     */
+    int64_t getHeldBalance(const std::string& uuid, const std::string& currencyType) const;
+
+    /**
+     * @brief 获取玩家的可用余额 (余额 - 冻结总额)
+     * @param uuid 玩家的 UUID
+     * @param currencyType 货币类型
+     * @return std::optional<int64_t> 账户存在时返回可用余额，否则返回 std::nullopt
+     */
+    std::optional<int64_t> getSpendableBalance(const std::string& uuid, const std::string& currencyType);
+
+    /**
+     * @brief 获取指定货币类型的最低余额
+     * @param currencyType 货币类型
+     * @return int64_t 最低余额 (整数，实际金额 * 100)。如果配置无效或转换失败，返回 0。
+     */
+    int64_t getMinimumBalance(const std::string& currencyType) const; // 返回类型不变，但内部实现会转换
+
 private:
+    /**
+     * @brief 记录不抛异常的数据库操作返回的错误 (繁忙、冲突、超时只记录警告)
+     */
+    static void logDbError(ll::io::Logger& logger, std::string_view context, const db::DbError& error);
+
     /**
      * @brief 安全地将 double 金额转换为 int64_t (分)
      *
@@ -254,6 +468,15 @@ private:
     db::IDatabaseConnection& mDbConnection; // 持有数据库连接接口的引用
     const Config& mConfig;             // 持有配置对象的引用
     ll::io::Logger& mLogger;           // 持有日志记录器的引用
+    LedgerChain mLedgerChain;          // 流水哈希链 (启用时封存每条新流水)
+    FlowCounters* mFlowCounters = nullptr; // 资金流向计数器 (由 MyMod 持有)
+    ActiveUserTracker* mActiveUsers = nullptr; // 活跃玩家统计 (由 MyMod 持有)
+    AccountFilter* mAccountFilter = nullptr; // 账户存在性过滤器 (由 MyMod 持有)
+    ExploitDetector* mExploitDetector = nullptr; // 异常收入检测 (由 MyMod 持有)
+    RateLimiter* mRateLimiter = nullptr; // 写操作限流器 (由 MyMod 持有)
+    std::unordered_map<std::string, int64_t> mInitialBalances; // 货币类型 -> 转换后的初始余额 (构造时计算)
+    bool mReasonIndexReady = false;    // 理由全文索引是否可用 (决定 queryTransactionLogs 的查询方式，由 ReasonIndexBuilder 设置)
+    size_t mNgramTokenSize = 2;        // MySQL ngram 分词长度，短于该长度的关键词无法使用全文索引
 
     /**
      * @brief 初始化经济流水日志表 (私有辅助函数)
@@ -261,6 +484,36 @@ private:
      */
     bool initializeLogTable();
 
+    /**
+     * @brief 为余额表创建按余额 / 按更新时间浏览的索引，并让 last_updated 随余额变化更新 (私有辅助函数)
+     *
+     * 失败不影响插件运行，只是账户浏览会变慢。
+     * @return bool 索引是否可用
+     */
+    bool initializeBalanceIndexes();
+
+    /**
+     * @brief 初始化冻结表并把未结清的冻结加载到内存 (私有辅助函数)
+     * @return bool 操作是否成功
+     */
+    bool initializeHoldTable();
+
+    // 单条冻结记录 (内存副本)
+    struct HoldRecord {
+        std::string uuid;
+        std::string currencyType;
+        int64_t     amount = 0;
+    };
+
+    mutable std::mutex                           mHoldMutex;   // 保护以下冻结状态
+    std::unordered_map<int64_t, HoldRecord>      mHolds;       // 冻结单号 -> 冻结记录
+    std::unordered_map<std::string, int64_t>     mHeldTotals;  // "uuid:currency" -> 冻结总额
+    int64_t                                      mNextHoldId = 1;
+
+    static std::string holdKey(const std::string& uuid, const std::string& currencyType);
+    void               addHoldLocked(int64_t holdId, HoldRecord record);
+    void               removeHoldLocked(int64_t holdId);
+
     /**
      * @brief 记录一笔经济交易流水 
      * @param uuid 玩家 UUID
@@ -290,13 +543,6 @@ private:
      */
     bool isCurrencyConfigured(const std::string& currencyType) const;
 
-    /**
-     * @brief 获取指定货币类型的最低余额
-     * @param currencyType 货币类型
-     * @return int64_t 最低余额 (整数，实际金额 * 100)。如果配置无效或转换失败，返回 0。
-     */
-    int64_t getMinimumBalance(const std::string& currencyType) const; // 返回类型不变，但内部实现会转换
-
     /**
      * @brief 初始化指定玩家和货币类型的账户 
      *
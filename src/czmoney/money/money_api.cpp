@@ -1,6 +1,10 @@
 #include "czmoney/money/money_api.h"
 #include "czmoney/MyMod.h"
 #include "czmoney/money/money.h"
+#include "czmoney/money/ScheduledPayment.h"
+#include "czmoney/money/FlowCounters.h"
+#include "czmoney/money/BulkAdjustment.h"
+#include "czmoney/money/BalanceSnapshot.h"
 #include "ll/api/io/Logger.h"
 #include <cmath>
 #include <limits>
@@ -22,6 +26,16 @@ inline czmoney::MoneyManager* getMoneyManagerInstance() {
     }
 }
 
+// 辅助函数：在访问数据库前检查令牌桶限流 (规则见 MoneyManager::checkRateLimit)
+// MoneyManager 不可用时放行，由后续的实例检查返回 MoneyManagerNotAvailable
+inline bool passRateLimit(std::string_view playerUuid, std::string_view caller) {
+    try {
+        return czmoney::MyMod::getInstance().getMoneyManager().checkRateLimit(playerUuid, caller);
+    } catch (const std::exception&) {
+        return true;
+    }
+}
+
 // 辅助函数：将 double 金额转换为 int64_t (分)，并进行校验 (截断)
 std::optional<int64_t> convertDoubleToInt64(double amount, bool requirePositive = false) {
     // 1. 检查 NaN 和 Infinity
@@ -143,6 +157,9 @@ czmoney::api::MoneyApiResult setPlayerBalance(
     int64_t amountInCents = amountInCentsOpt.value();
 
     if (auto* manager = getMoneyManagerInstance()) {
+        if (!passRateLimit({}, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
         // 注意：将 string_view 转换为 string
         bool success = manager->setPlayerBalance(
             std::string(uuid),
@@ -193,6 +210,9 @@ czmoney::api::MoneyApiResult addPlayerBalance(
 
 
         if (auto* manager = getMoneyManagerInstance()) {
+            if (!passRateLimit({}, reason1)) {
+                return czmoney::api::MoneyApiResult::RateLimited;
+            }
             // 注意：将 string_view 转换为 string
             bool success = manager->addPlayerBalance(
                 std::string(uuid),
@@ -252,6 +272,9 @@ czmoney::api::MoneyApiResult subtractPlayerBalance(
     int64_t amountToSubtractInCents = amountToSubtractInCentsOpt.value();
 
     if (auto* manager = getMoneyManagerInstance()) {
+        if (!passRateLimit({}, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
         // 注意：将 string_view 转换为 string
         bool success = manager->subtractPlayerBalance(
             std::string(uuid),
@@ -279,6 +302,62 @@ czmoney::api::MoneyApiResult subtractPlayerBalance(
     }
 }
 
+// adjustRawPlayerBalance 实现
+czmoney::api::MoneyApiResult adjustRawPlayerBalance(
+    std::string_view                uuid,
+    std::string_view                currencyType,
+    czmoney::api::BalanceAdjustment adjustment,
+    int64_t                         amount,
+    int64_t*                        newBalance,
+    std::string_view                reason1,
+    std::string_view                reason2,
+    std::string_view                reason3
+) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger(); // 获取 logger 实例
+    logger.debug("API::adjustRawPlayerBalance called for UUID: {}, Currency: {}, Adjustment: {}, Amount: {}, Reason1: {}",
+                 uuid, currencyType, static_cast<int>(adjustment), amount, reason1);
+
+    if (adjustment != czmoney::api::BalanceAdjustment::Set && amount <= 0) {
+        logger.error("API::adjustRawPlayerBalance failed for UUID: {}: amount must be positive, got {}", uuid, amount);
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+
+    auto* manager = getMoneyManagerInstance();
+    if (!manager) {
+        logger.error("API::adjustRawPlayerBalance failed: Could not get MoneyManager instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+    if (!passRateLimit({}, reason1)) {
+        return czmoney::api::MoneyApiResult::RateLimited;
+    }
+
+    std::string uuidStr(uuid), currencyStr(currencyType), r1(reason1), r2(reason2), r3(reason3);
+    bool        success = false;
+    try {
+        switch (adjustment) {
+        case czmoney::api::BalanceAdjustment::Set:
+            success = manager->setPlayerBalance(uuidStr, currencyStr, amount, r1, r2, r3, newBalance);
+            break;
+        case czmoney::api::BalanceAdjustment::Add:
+            success = manager->addPlayerBalance(uuidStr, currencyStr, amount, r1, r2, r3, newBalance);
+            break;
+        case czmoney::api::BalanceAdjustment::Subtract:
+            success = manager->subtractPlayerBalance(uuidStr, currencyStr, amount, r1, r2, r3, newBalance);
+            break;
+        }
+    } catch (const std::exception& e) {
+        logger.error("API::adjustRawPlayerBalance encountered exception: {}", e.what());
+        return czmoney::api::MoneyApiResult::UnknownError;
+    }
+    if (!success) {
+        // MoneyManager 内部已记录具体失败原因 (余额不足、低于最低余额、数据库错误等)
+        logger.error("API::adjustRawPlayerBalance failed for UUID: {}, Currency: {}.", uuid, currencyType);
+        return czmoney::api::MoneyApiResult::DatabaseError;
+    }
+    logger.debug("API::adjustRawPlayerBalance success for UUID: {}, Currency: {}", uuid, currencyType);
+    return czmoney::api::MoneyApiResult::Success;
+}
+
 bool hasAccount(std::string_view uuid, std::string_view currencyType) {
     auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger(); // 获取 logger 实例
     logger.debug("API::hasAccount called for UUID: {}, Currency: {}", uuid, currencyType);
@@ -300,6 +379,40 @@ std::string formatBalance(int64_t amount) {
     return czmoney::MoneyManager::formatBalance(amount);
 }
 
+std::string getResultMessage(czmoney::api::MoneyApiResult result) {
+    switch (result) {
+    case czmoney::api::MoneyApiResult::Success:
+        return "操作成功。";
+    case czmoney::api::MoneyApiResult::AccountNotFound:
+        return "账户不存在。";
+    case czmoney::api::MoneyApiResult::InvalidAmount:
+        return "无效金额。";
+    case czmoney::api::MoneyApiResult::InsufficientBalance:
+        return "余额不足。";
+    case czmoney::api::MoneyApiResult::DatabaseError:
+        return "数据库操作失败。";
+    case czmoney::api::MoneyApiResult::MoneyManagerNotAvailable:
+        return "经济系统不可用。";
+    case czmoney::api::MoneyApiResult::RateLimited:
+        return "操作过于频繁，请稍后再试。";
+    case czmoney::api::MoneyApiResult::HoldNotFound:
+        return "冻结单不存在。";
+    case czmoney::api::MoneyApiResult::ScheduleNotFound:
+        return "付款计划不存在或已结束。";
+    case czmoney::api::MoneyApiResult::JobInProgress:
+        return "已有批量任务在运行。";
+    case czmoney::api::MoneyApiResult::JobNotFound:
+        return "没有运行中的批量任务。";
+    case czmoney::api::MoneyApiResult::ExchangeNotAllowed:
+        return "不允许该货币兑换。";
+    case czmoney::api::MoneyApiResult::Cancelled:
+        return "操作已被取消。";
+    case czmoney::api::MoneyApiResult::UnknownError:
+    default:
+        return "未知错误。";
+    }
+}
+
 std::optional<int64_t> parseBalance(std::string_view formattedAmount) {
     // 这个函数是静态的，可以直接调用
     // 可以在 MoneyManager::parseBalance 内部添加日志（如果需要）
@@ -414,6 +527,9 @@ czmoney::api::MoneyApiResult transferBalance(
     }
 
     if (auto* manager = getMoneyManagerInstance()) {
+        if (!passRateLimit(senderUuid, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
         // 注意：将 string_view 转换为 string
         bool success = manager->transferBalance(
             std::string(senderUuid),
@@ -443,6 +559,63 @@ czmoney::api::MoneyApiResult transferBalance(
     }
 }
 
+czmoney::api::MoneyApiResult exchangeBalance(
+    std::string_view uuid,
+    std::string_view fromCurrency,
+    std::string_view toCurrency,
+    double           amount,
+    double*          amountReceived,
+    std::string_view reason1,
+    std::string_view reason2,
+    std::string_view reason3
+) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::exchangeBalance called for UUID: {}, From: {}, To: {}, Amount: {}, Reason1: {}",
+                 uuid, fromCurrency, toCurrency, amount, reason1);
+
+    std::optional<int64_t> amountInCentsOpt = convertDoubleToInt64(amount, true); // true: 要求正数
+    if (!amountInCentsOpt || amountInCentsOpt.value() <= 0) {
+        logger.error("API::exchangeBalance failed for UUID: {}: Invalid amount provided: {}", uuid, amount);
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+
+    if (auto* manager = getMoneyManagerInstance()) {
+        if (!passRateLimit(uuid, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
+        try {
+            int64_t received = 0;
+            czmoney::api::MoneyApiResult result = manager->exchangeBalance(
+                std::string(uuid),
+                std::string(fromCurrency),
+                std::string(toCurrency),
+                amountInCentsOpt.value(),
+                &received,
+                std::string(reason1),
+                std::string(reason2),
+                std::string(reason3)
+            );
+            if (result == czmoney::api::MoneyApiResult::Success && amountReceived) {
+                *amountReceived = static_cast<double>(received) / 100.0;
+            }
+            return result;
+        } catch (const std::exception& e) {
+            logger.error("API::exchangeBalance encountered exception: {}", e.what());
+            return czmoney::api::MoneyApiResult::UnknownError;
+        }
+    } else {
+        logger.error("API::exchangeBalance failed: Could not get MoneyManager instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+std::optional<double> getExchangeRate(std::string_view fromCurrency, std::string_view toCurrency) {
+    if (auto* manager = getMoneyManagerInstance()) {
+        return manager->getExchangeRate(std::string(fromCurrency), std::string(toCurrency));
+    }
+    return std::nullopt;
+}
+
 // 新增：原始余额 API 实现
 std::optional<int64_t> getRawPlayerBalance(std::string_view uuid, std::string_view currencyType) {
     auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
@@ -505,5 +678,350 @@ std::vector<std::pair<std::string, int64_t>> getTopBalances(
     }
 }
 
+// --- 冻结 (Hold) API 实现 ---
+
+czmoney::api::MoneyApiResult placeHold(
+    std::string_view uuid,
+    std::string_view currencyType,
+    double           amount,
+    int64_t&         outHoldId,
+    std::string_view reason1,
+    std::string_view reason2,
+    std::string_view reason3
+) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::placeHold called for UUID: {}, Currency: {}, Amount: {}, Reason1: {}", uuid, currencyType, amount, reason1);
+
+    std::optional<int64_t> amountInCentsOpt = convertDoubleToInt64(amount, true); // true: 要求正数
+    if (!amountInCentsOpt) {
+        logger.error("API::placeHold failed for UUID: {}: Invalid amount provided: {}", uuid, amount);
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+
+    if (auto* manager = getMoneyManagerInstance()) {
+        if (!passRateLimit({}, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
+        try {
+            return manager->placeHold(
+                std::string(uuid),
+                std::string(currencyType),
+                amountInCentsOpt.value(),
+                outHoldId,
+                std::string(reason1),
+                std::string(reason2),
+                std::string(reason3)
+            );
+        } catch (const std::exception& e) {
+            logger.error("API::placeHold encountered exception: {}", e.what());
+            return czmoney::api::MoneyApiResult::UnknownError;
+        }
+    } else {
+        logger.error("API::placeHold failed: Could not get MoneyManager instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+czmoney::api::MoneyApiResult captureHold(
+    int64_t          holdId,
+    std::string_view receiverUuid,
+    double           amount,
+    std::string_view reason1,
+    std::string_view reason2,
+    std::string_view reason3
+) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::captureHold called for HoldId: {}, Receiver: {}, Amount: {}, Reason1: {}", holdId, receiverUuid, amount, reason1);
+
+    // amount <= 0 表示兑现全部冻结金额
+    std::optional<int64_t> captureAmount;
+    if (amount > 0.0) {
+        captureAmount = convertDoubleToInt64(amount, true);
+        if (!captureAmount) {
+            logger.error("API::captureHold failed for HoldId: {}: Invalid amount provided: {}", holdId, amount);
+            return czmoney::api::MoneyApiResult::InvalidAmount;
+        }
+    } else if (std::isnan(amount)) {
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+
+    if (auto* manager = getMoneyManagerInstance()) {
+        if (!passRateLimit({}, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
+        try {
+            return manager->captureHold(
+                holdId,
+                std::string(receiverUuid),
+                captureAmount,
+                std::string(reason1),
+                std::string(reason2),
+                std::string(reason3)
+            );
+        } catch (const std::exception& e) {
+            logger.error("API::captureHold encountered exception: {}", e.what());
+            return czmoney::api::MoneyApiResult::UnknownError;
+        }
+    } else {
+        logger.error("API::captureHold failed: Could not get MoneyManager instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+czmoney::api::MoneyApiResult releaseHold(int64_t holdId) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::releaseHold called for HoldId: {}", holdId);
+
+    if (auto* manager = getMoneyManagerInstance()) {
+        try {
+            return manager->releaseHold(holdId);
+        } catch (const std::exception& e) {
+            logger.error("API::releaseHold encountered exception: {}", e.what());
+            return czmoney::api::MoneyApiResult::UnknownError;
+        }
+    } else {
+        logger.error("API::releaseHold failed: Could not get MoneyManager instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+double getHeldBalance(std::string_view uuid, std::string_view currencyType) {
+    if (auto* manager = getMoneyManagerInstance()) {
+        return static_cast<double>(manager->getHeldBalance(std::string(uuid), std::string(currencyType))) / 100.0;
+    }
+    return 0.0;
+}
+
+std::optional<double> getSpendableBalance(std::string_view uuid, std::string_view currencyType) {
+    if (auto* manager = getMoneyManagerInstance()) {
+        std::optional<int64_t> raw = manager->getSpendableBalance(std::string(uuid), std::string(currencyType));
+        if (raw) {
+            return static_cast<double>(raw.value()) / 100.0;
+        }
+    }
+    return std::nullopt;
+}
+
+// --- 定时/周期付款 API 实现 ---
+
+// 辅助函数，用于安全地获取 ScheduledPaymentEngine 实例
+inline czmoney::ScheduledPaymentEngine* getPaymentEngineInstance() {
+    try {
+        return &czmoney::MyMod::getInstance().getPaymentEngine();
+    } catch (const std::exception& e) {
+        try {
+            czmoney::MyMod::getInstance().getSelf().getLogger().error("无法获取 ScheduledPaymentEngine 实例: {}", e.what());
+        } catch (...) {
+        }
+        return nullptr;
+    }
+}
+
+czmoney::api::MoneyApiResult createScheduledPayment(
+    std::string_view payerUuid,
+    std::string_view payeeUuid,
+    std::string_view currencyType,
+    double           amount,
+    int64_t          intervalSeconds,
+    int64_t          firstRunDelaySeconds,
+    int64_t          totalRuns,
+    int64_t&         outScheduleId,
+    std::string_view reason1,
+    std::string_view reason2,
+    std::string_view reason3
+) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug(
+        "API::createScheduledPayment called for Payer: {}, Payee: {}, Currency: {}, Amount: {}, Interval: {}s",
+        payerUuid,
+        payeeUuid,
+        currencyType,
+        amount,
+        intervalSeconds
+    );
+
+    std::optional<int64_t> amountInCentsOpt = convertDoubleToInt64(amount, true); // true: 要求正数
+    if (!amountInCentsOpt || amountInCentsOpt.value() <= 0 || intervalSeconds < 0 || firstRunDelaySeconds < 0) {
+        logger.error("API::createScheduledPayment failed for Payer: {}: Invalid amount or interval", payerUuid);
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+
+    if (auto* engine = getPaymentEngineInstance()) {
+        if (!passRateLimit({}, reason1)) {
+            return czmoney::api::MoneyApiResult::RateLimited;
+        }
+        try {
+            czmoney::ScheduledPayment payment;
+            payment.payerUuid       = std::string(payerUuid);
+            payment.payeeUuid       = std::string(payeeUuid);
+            payment.currencyType    = std::string(currencyType);
+            payment.amount          = amountInCentsOpt.value();
+            payment.intervalSeconds = intervalSeconds;
+            payment.nextRun         = czmoney::ScheduledPaymentEngine::nowEpochSeconds() + firstRunDelaySeconds;
+            payment.remainingRuns   = intervalSeconds == 0 ? 1 : (totalRuns > 0 ? totalRuns : -1);
+            payment.reason1         = std::string(reason1);
+            payment.reason2         = std::string(reason2);
+            payment.reason3         = std::string(reason3);
+            return engine->createPayment(payment, outScheduleId);
+        } catch (const std::exception& e) {
+            logger.error("API::createScheduledPayment encountered exception: {}", e.what());
+            return czmoney::api::MoneyApiResult::UnknownError;
+        }
+    } else {
+        logger.error("API::createScheduledPayment failed: Could not get ScheduledPaymentEngine instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+czmoney::api::MoneyApiResult cancelScheduledPayment(int64_t scheduleId) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::cancelScheduledPayment called for ScheduleId: {}", scheduleId);
+
+    if (auto* engine = getPaymentEngineInstance()) {
+        try {
+            return engine->cancelPayment(scheduleId);
+        } catch (const std::exception& e) {
+            logger.error("API::cancelScheduledPayment encountered exception: {}", e.what());
+            return czmoney::api::MoneyApiResult::UnknownError;
+        }
+    } else {
+        logger.error("API::cancelScheduledPayment failed: Could not get ScheduledPaymentEngine instance.");
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+std::vector<czmoney::ScheduledPayment> getScheduledPayments(std::string_view uuid) {
+    if (auto* engine = getPaymentEngineInstance()) {
+        try {
+            return engine->listPayments(std::string(uuid));
+        } catch (const std::exception& e) {
+            czmoney::MyMod::getInstance().getSelf().getLogger().error(
+                "API::getScheduledPayments encountered exception: {}",
+                e.what()
+            );
+        }
+    }
+    return {};
+}
+
+// --- 批量利息/财富税 API 实现 ---
+
+czmoney::api::MoneyApiResult startBulkAdjustment(
+    std::string_view currencyType,
+    double           ratePercent,
+    double           threshold,
+    int64_t&         outJobId,
+    std::string_view reason1,
+    std::string_view reason2,
+    std::string_view reason3
+) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::startBulkAdjustment called for Currency: {}, Rate: {}%, Threshold: {}", currencyType, ratePercent, threshold);
+
+    if (std::isnan(ratePercent) || std::isinf(ratePercent) || ratePercent < -100.0 || ratePercent > 100.0) {
+        logger.error("API::startBulkAdjustment failed: Invalid rate provided: {}", ratePercent);
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+    // 百分比精确到 0.01 (即万分比)
+    int64_t                rateBasisPoints = std::llround(ratePercent * 100.0);
+    std::optional<int64_t> thresholdInCents = convertDoubleToInt64(threshold);
+    if (!thresholdInCents || thresholdInCents.value() < 0) {
+        logger.error("API::startBulkAdjustment failed: Invalid threshold provided: {}", threshold);
+        return czmoney::api::MoneyApiResult::InvalidAmount;
+    }
+
+    try {
+        auto& engine = czmoney::MyMod::getInstance().getBulkAdjustmentEngine();
+        auto  result = engine.startJob(
+            std::string(currencyType),
+            rateBasisPoints,
+            thresholdInCents.value(),
+            outJobId,
+            std::string(reason1),
+            std::string(reason2),
+            std::string(reason3)
+        );
+        if (result == czmoney::api::MoneyApiResult::Success) {
+            czmoney::MyMod::getInstance().scheduleBulkAdjustment();
+        }
+        return result;
+    } catch (const std::exception& e) {
+        logger.error("API::startBulkAdjustment encountered exception: {}", e.what());
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+czmoney::api::MoneyApiResult cancelBulkAdjustment() {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::cancelBulkAdjustment called");
+    try {
+        return czmoney::MyMod::getInstance().getBulkAdjustmentEngine().cancelJob();
+    } catch (const std::exception& e) {
+        logger.error("API::cancelBulkAdjustment encountered exception: {}", e.what());
+        return czmoney::api::MoneyApiResult::MoneyManagerNotAvailable;
+    }
+}
+
+std::optional<int64_t>
+getRawPlayerBalanceAt(std::string_view uuid, std::string_view currencyType, std::string_view timestamp) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::getRawPlayerBalanceAt called for UUID: {}, Currency: {}, Time: {}", uuid, currencyType, timestamp);
+    if (timestamp.empty()) {
+        return std::nullopt;
+    }
+    try {
+        auto balance = czmoney::MyMod::getInstance().getSnapshotEngine().getBalanceAt(
+            std::string(uuid),
+            std::string(currencyType),
+            std::string(timestamp)
+        );
+        if (!balance) {
+            return std::nullopt;
+        }
+        if (balance->approximate) {
+            logger.debug("API::getRawPlayerBalanceAt: result is approximate (bulk adjustment in range or account not yet created)");
+        }
+        return balance->amount;
+    } catch (const std::exception& e) {
+        logger.error("API::getRawPlayerBalanceAt encountered exception: {}", e.what());
+        return std::nullopt;
+    }
+}
+
+std::optional<double>
+getPlayerBalanceAt(std::string_view uuid, std::string_view currencyType, std::string_view timestamp) {
+    std::optional<int64_t> raw = getRawPlayerBalanceAt(uuid, currencyType, timestamp);
+    if (!raw) {
+        return std::nullopt;
+    }
+    return static_cast<double>(raw.value()) / 100.0;
+}
+
+std::optional<uint64_t>
+getActivePlayerCount(std::string_view currencyType, int days, std::optional<std::string_view> reason1) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::getActivePlayerCount called for Currency: {}, Days: {}", currencyType, days);
+    try {
+        return czmoney::MyMod::getInstance().getActiveUsers().countUnique(
+            std::string(currencyType),
+            days,
+            reason1 ? std::optional<std::string>(std::string(*reason1)) : std::nullopt
+        );
+    } catch (const std::exception& e) {
+        logger.error("API::getActivePlayerCount encountered exception: {}", e.what());
+        return std::nullopt;
+    }
+}
+
+std::vector<czmoney::FlowCounter> getFlowCounters(std::string_view currencyType, bool byReason) {
+    auto& logger = czmoney::MyMod::getInstance().getSelf().getLogger();
+    logger.debug("API::getFlowCounters called for Currency: {}, byReason: {}", currencyType, byReason);
+    try {
+        return czmoney::MyMod::getInstance().getFlowCounters().getCounters(std::string(currencyType), byReason);
+    } catch (const std::exception& e) {
+        logger.error("API::getFlowCounters encountered exception: {}", e.what());
+        return {};
+    }
+}
 
 } // namespace czmoney::api
@@ -29,6 +29,10 @@
 namespace czmoney {
 // 前向声明 TransactionLogEntry，其定义现在位于 money.h 中
 struct TransactionLogEntry;
+// 前向声明 ScheduledPayment，其定义位于 ScheduledPayment.h 中
+struct ScheduledPayment;
+// 前向声明 FlowCounter，其定义位于 FlowCounters.h 中
+struct FlowCounter;
 } // namespace czmoney
 
 namespace czmoney::api {
@@ -41,7 +45,21 @@ enum class MoneyApiResult {
     InsufficientBalance,        // 余额不足
     DatabaseError,              // 数据库操作失败
     MoneyManagerNotAvailable,   // MoneyManager 实例不可用 (插件未启用或初始化失败)
-    UnknownError                // 未知错误
+    UnknownError,               // 未知错误
+    RateLimited,                // 操作过于频繁，被限流拒绝 (未访问数据库)
+    HoldNotFound,               // 冻结单号不存在 (已兑现、已解冻或从未创建)
+    ScheduleNotFound,           // 付款计划不存在或已结束
+    JobInProgress,              // 已有批量任务在运行
+    JobNotFound,                // 没有运行中的批量任务
+    ExchangeNotAllowed,         // 兑换已关闭，或汇率表中没有该货币组合
+    Cancelled                   // 操作被事件监听器取消
+};
+
+// adjustRawPlayerBalance 的调整方式
+enum class BalanceAdjustment {
+    Set,      // 设置为指定余额
+    Add,      // 增加
+    Subtract  // 减少
 };
 
 /**
@@ -89,10 +107,10 @@ CZMONEY_API int64_t getRawPlayerBalanceOrInit(std::string_view uuid, std::string
  * @param uuid 玩家的 UUID
  * @param currencyType 货币类型
  * @param amount 要设置的余额 (浮点数，例如 123.45)
- * @param reason1 可选的操作理由 1 (例如，插件名称)
+ * @param reason1 可选的操作理由 1 (例如，插件名称)，同时作为按插件限流的键
  * @param reason2 可选的操作理由 2
  * @param reason3 可选的操作理由 3
- * @return MoneyApiResult 操作结果
+ * @return MoneyApiResult 操作结果；调用过于频繁时返回 RateLimited
  */
 CZMONEY_API MoneyApiResult setPlayerBalance(
     std::string_view uuid,
@@ -110,10 +128,10 @@ CZMONEY_API MoneyApiResult setPlayerBalance(
  * @param uuid 玩家的 UUID
  * @param currencyType 货币类型
  * @param amountToAdd 要增加的金额 (必须为正的浮点数，例如 10.50)
- * @param reason1 可选的操作理由 1
+ * @param reason1 可选的操作理由 1，同时作为按插件限流的键
  * @param reason2 可选的操作理由 2
  * @param reason3 可选的操作理由 3
- * @return MoneyApiResult 操作结果
+ * @return MoneyApiResult 操作结果；调用过于频繁时返回 RateLimited
  */
 CZMONEY_API MoneyApiResult addPlayerBalance(
     std::string_view uuid,
@@ -131,10 +149,10 @@ CZMONEY_API MoneyApiResult addPlayerBalance(
  * @param uuid 玩家的 UUID
  * @param currencyType 货币类型
  * @param amountToSubtract 要减少的金额 (必须为正的浮点数，例如 5.25)
- * @param reason1 可选的操作理由 1
+ * @param reason1 可选的操作理由 1，同时作为按插件限流的键
  * @param reason2 可选的操作理由 2
  * @param reason3 可选的操作理由 3
- * @return MoneyApiResult 操作结果
+ * @return MoneyApiResult 操作结果；调用过于频繁时返回 RateLimited
  */
 CZMONEY_API MoneyApiResult subtractPlayerBalance(
     std::string_view uuid,
@@ -145,6 +163,32 @@ CZMONEY_API MoneyApiResult subtractPlayerBalance(
     std::string_view reason3 = ""
 );
 
+/**
+ * @brief 以整数 (分) 设置 / 增加 / 减少玩家余额，并返回操作后的余额
+ *
+ * 与 set/add/subtractPlayerBalance 相同的校验、事件和流水，但金额不经过浮点数转换，
+ * 操作后的余额由写入过程直接给出，调用方 (例如管理界面) 不需要再查询一次。
+ * @param uuid 玩家的 UUID
+ * @param currencyType 货币类型
+ * @param adjustment 调整方式
+ * @param amount 金额 (整数，实际金额乘以 100)；增加 / 减少时必须为正数
+ * @param newBalance 成功时写入操作后的余额 (可为 nullptr)
+ * @param reason1 可选的操作理由 1，同时作为按插件限流的键
+ * @param reason2 可选的操作理由 2
+ * @param reason3 可选的操作理由 3
+ * @return MoneyApiResult 操作结果；调用过于频繁时返回 RateLimited
+ */
+CZMONEY_API MoneyApiResult adjustRawPlayerBalance(
+    std::string_view  uuid,
+    std::string_view  currencyType,
+    BalanceAdjustment adjustment,
+    int64_t           amount,
+    int64_t*          newBalance,
+    std::string_view  reason1 = "",
+    std::string_view  reason2 = "",
+    std::string_view  reason3 = ""
+);
+
 /**
  * @brief 检查玩家账户是否存在
  * @param uuid 玩家的 UUID
@@ -160,6 +204,13 @@ CZMONEY_API bool hasAccount(std::string_view uuid, std::string_view currencyType
  */
 CZMONEY_API std::string formatBalance(int64_t amount);
 
+/**
+ * @brief 获取操作结果对应的提示文本 (命令与表单共用，例如 "操作过于频繁，请稍后再试。")
+ * @param result 操作结果
+ * @return std::string 面向玩家的中文提示
+ */
+CZMONEY_API std::string getResultMessage(MoneyApiResult result);
+
 /**
  * @brief 将带小数的字符串金额解析为整数余额
  * @param formattedAmount 格式化的金额字符串
@@ -200,6 +251,7 @@ CZMONEY_API std::vector<czmoney::TransactionLogEntry> queryTransactionLogs(
  * @brief 从一个玩家向另一个玩家转账
  *
  * 原子性地执行扣款和加款操作。
+ * 在访问数据库前会同时检查转出方玩家和调用插件 (reason1) 的令牌桶。
  * @param senderUuid 转出方玩家 UUID
  * @param receiverUuid 接收方玩家 UUID
  * @param currencyType 货币类型
@@ -207,7 +259,7 @@ CZMONEY_API std::vector<czmoney::TransactionLogEntry> queryTransactionLogs(
  * @param reason1 可选的操作理由 1 (例如 "Transfer")
  * @param reason2 可选的操作理由 2 (例如 发起者名称)
  * @param reason3 可选的操作理由 3 (例如 接收者名称)
- * @return MoneyApiResult 操作结果
+ * @return MoneyApiResult 操作结果；调用过于频繁时返回 RateLimited
  */
 CZMONEY_API MoneyApiResult transferBalance(
     std::string_view senderUuid,
@@ -219,6 +271,42 @@ CZMONEY_API MoneyApiResult transferBalance(
     std::string_view reason3 = ""
 );
 
+/**
+ * @brief 在同一玩家的两种货币之间兑换 (例如 money -> points)
+ *
+ * 按配置 exchange.rates 中的汇率计算兑换所得 (按分向下取整)。
+ * 扣款、加款和两条流水在同一个事务中完成，不会出现只扣款未加款的情况；
+ * 只发布一对 ExchangeMoney 事件，不再分别触发扣款/加款事件。
+ * 在访问数据库前会同时检查该玩家和调用插件 (reason1) 的令牌桶。
+ * @param uuid 玩家的 UUID
+ * @param fromCurrency 支付的货币类型
+ * @param toCurrency 获得的货币类型
+ * @param amount 支付金额 (必须为正的浮点数，例如 10.50)
+ * @param[out] amountReceived 成功时写入获得的目标货币金额 (可为 nullptr)
+ * @param reason1 可选的操作理由 1 (例如插件名称)
+ * @param reason2 可选的操作理由 2
+ * @param reason3 可选的操作理由 3
+ * @return MoneyApiResult 操作结果；未开启兑换 (默认关闭) 或未配置该方向的汇率时返回 ExchangeNotAllowed
+ */
+CZMONEY_API MoneyApiResult exchangeBalance(
+    std::string_view uuid,
+    std::string_view fromCurrency,
+    std::string_view toCurrency,
+    double           amount,
+    double*          amountReceived = nullptr,
+    std::string_view reason1 = "Exchange",
+    std::string_view reason2 = "",
+    std::string_view reason3 = ""
+);
+
+/**
+ * @brief 获取兑换汇率
+ * @param fromCurrency 支付的货币类型
+ * @param toCurrency 获得的货币类型
+ * @return std::optional<double> 每 1 单位源货币兑换得到的目标货币数量；不能兑换时返回 std::nullopt
+ */
+CZMONEY_API std::optional<double> getExchangeRate(std::string_view fromCurrency, std::string_view toCurrency);
+
 /**
  * @brief 获取指定货币类型的金币排行榜数据
  *
@@ -234,5 +322,200 @@ CZMONEY_API std::vector<std::pair<std::string, int64_t>> getTopBalances(
     size_t offset = 0
 );
 
+/**
+ * @brief 冻结玩家的一部分余额 (托管/预扣)
+ *
+ * 适用于拍卖出价、商店下单等"先占用、后结算"的场景，用来替代"先扣款、失败再退款"。
+ * 冻结只减少可用余额，不修改余额本身，也不产生流水和事件。
+ * @param uuid 玩家的 UUID
+ * @param currencyType 货币类型
+ * @param amount 冻结金额 (必须为正的浮点数，例如 10.50)
+ * @param[out] outHoldId 成功时写入冻结单号，后续用于兑现或解冻
+ * @param reason1 可选的理由 1 (例如插件名称)，同时作为按插件限流的键
+ * @param reason2 可选的理由 2
+ * @param reason3 可选的理由 3
+ * @return MoneyApiResult 操作结果；可用余额不足时返回 InsufficientBalance
+ */
+CZMONEY_API MoneyApiResult placeHold(
+    std::string_view uuid,
+    std::string_view currencyType,
+    double           amount,
+    int64_t&         outHoldId,
+    std::string_view reason1 = "",
+    std::string_view reason2 = "",
+    std::string_view reason3 = ""
+);
+
+/**
+ * @brief 兑现冻结：从冻结方扣款，并可选地转给接收方
+ *
+ * 兑现会产生正常的扣款/加款流水和事件。兑现金额小于冻结金额时，剩余部分自动解冻。
+ * @param holdId 冻结单号
+ * @param receiverUuid 接收方 UUID，为空表示只扣款
+ * @param amount 兑现金额 (浮点数)，小于等于 0 表示兑现全部冻结金额
+ * @param reason1 可选的理由 1
+ * @param reason2 可选的理由 2
+ * @param reason3 可选的理由 3
+ * @return MoneyApiResult 操作结果；单号不存在时返回 HoldNotFound
+ */
+CZMONEY_API MoneyApiResult captureHold(
+    int64_t          holdId,
+    std::string_view receiverUuid = "",
+    double           amount = 0.0,
+    std::string_view reason1 = "",
+    std::string_view reason2 = "",
+    std::string_view reason3 = ""
+);
+
+/**
+ * @brief 解冻，将冻结金额退回可用余额
+ *
+ * 只删除冻结记录，不修改 player_balances。
+ * @param holdId 冻结单号
+ * @return MoneyApiResult 操作结果；单号不存在时返回 HoldNotFound
+ */
+CZMONEY_API MoneyApiResult releaseHold(int64_t holdId);
+
+/**
+ * @brief 获取玩家当前被冻结的总金额
+ * @param uuid 玩家的 UUID
+ * @param currencyType 货币类型
+ * @return double 冻结总额 (浮点数，实际金额)
+ */
+CZMONEY_API double getHeldBalance(std::string_view uuid, std::string_view currencyType);
+
+/**
+ * @brief 获取玩家的可用余额 (余额减去冻结总额)
+ * @param uuid 玩家的 UUID
+ * @param currencyType 货币类型
+ * @return std::optional<double> 账户存在时返回可用余额，否则返回 std::nullopt
+ */
+CZMONEY_API std::optional<double> getSpendableBalance(std::string_view uuid, std::string_view currencyType);
+
+/**
+ * @brief 创建定时/周期付款计划
+ *
+ * 到期时从付款方扣款并转给收款方 (为空时只扣款)，产生正常的流水和事件。
+ * 付款方余额不足时延迟重试，连续失败达到配置上限后计划被暂停。
+ * @param payerUuid 付款方 UUID
+ * @param payeeUuid 收款方 UUID，为空表示付给系统
+ * @param currencyType 货币类型
+ * @param amount 每次付款金额 (浮点数，必须为正数)
+ * @param intervalSeconds 付款周期 (秒)，0 表示一次性付款
+ * @param firstRunDelaySeconds 距第一次付款的延迟 (秒)
+ * @param totalRuns 总付款次数，小于等于 0 表示不限 (一次性付款忽略此参数)
+ * @param[out] outScheduleId 成功时写入计划编号
+ * @param reason1 可选的理由 1 (同时作为限流的插件标识)
+ * @param reason2 可选的理由 2
+ * @param reason3 可选的理由 3
+ * @return MoneyApiResult 操作结果；调用过于频繁时返回 RateLimited
+ */
+CZMONEY_API MoneyApiResult createScheduledPayment(
+    std::string_view payerUuid,
+    std::string_view payeeUuid,
+    std::string_view currencyType,
+    double           amount,
+    int64_t          intervalSeconds,
+    int64_t          firstRunDelaySeconds,
+    int64_t          totalRuns,
+    int64_t&         outScheduleId,
+    std::string_view reason1 = "",
+    std::string_view reason2 = "",
+    std::string_view reason3 = ""
+);
+
+/**
+ * @brief 取消付款计划
+ * @param scheduleId 计划编号
+ * @return MoneyApiResult 操作结果；计划不存在或已结束时返回 ScheduleNotFound
+ */
+CZMONEY_API MoneyApiResult cancelScheduledPayment(int64_t scheduleId);
+
+/**
+ * @brief 查询与玩家相关 (付款方或收款方) 的有效付款计划
+ * @param uuid 玩家的 UUID
+ * @return std::vector<ScheduledPayment> 计划列表，查询失败时返回空列表
+ */
+CZMONEY_API std::vector<czmoney::ScheduledPayment> getScheduledPayments(std::string_view uuid);
+
+/**
+ * @brief 开始批量利息/财富税任务
+ *
+ * 对指定货币所有余额高于 threshold 的账户，按 (余额 - threshold) * ratePercent% 调整余额。
+ * 任务在后台分块执行，每块一个事务，只写汇总流水，不触发单个账户的余额变动事件；
+ * 服务器中断后会从上次处理到的位置继续。
+ * @param currencyType 货币类型
+ * @param ratePercent 调整比例 (百分比，精确到 0.01)，正数为利息，负数为财富税，范围 [-100, 100]
+ * @param threshold 起息点/起征点 (浮点数，实际金额)，只调整高于该值的部分
+ * @param[out] outJobId 成功时写入任务编号
+ * @param reason1 汇总流水的理由 1
+ * @param reason2 汇总流水的理由 2
+ * @param reason3 汇总流水的理由 3
+ * @return MoneyApiResult 操作结果；已有任务在运行时返回 JobInProgress
+ */
+CZMONEY_API MoneyApiResult startBulkAdjustment(
+    std::string_view currencyType,
+    double           ratePercent,
+    double           threshold,
+    int64_t&         outJobId,
+    std::string_view reason1 = "",
+    std::string_view reason2 = "",
+    std::string_view reason3 = ""
+);
+
+/**
+ * @brief 取消正在运行的批量利息/财富税任务 (已处理的部分不会回滚)
+ * @return MoneyApiResult 操作结果；没有运行中的任务时返回 JobNotFound
+ */
+CZMONEY_API MoneyApiResult cancelBulkAdjustment();
+
+/**
+ * @brief 获取玩家在指定时间点的余额 (浮点数形式，实际金额)
+ *
+ * 从不晚于该时间点的最近一次余额快照开始，重放之后的少量流水得到结果。
+ * 区间内有批量调整 (只有汇总流水) 时结果只是近似值。
+ * @param uuid 玩家的 UUID
+ * @param currencyType 货币类型
+ * @param timestamp 时间点：服务器本地时间 (例如 "2025-01-01 12:00:00")，或距现在的时长 (例如 "3d"、"12h"、"30m")
+ * @return std::optional<double> 没有足够的快照或流水可供推算时返回 std::nullopt
+ */
+CZMONEY_API std::optional<double>
+getPlayerBalanceAt(std::string_view uuid, std::string_view currencyType, std::string_view timestamp);
+
+/**
+ * @brief 获取玩家在指定时间点的原始余额 (整数形式，实际金额 * 100)
+ * @param uuid 玩家的 UUID
+ * @param currencyType 货币类型
+ * @param timestamp 时间点：服务器本地时间 (例如 "2025-01-01 12:00:00")，或距现在的时长 (例如 "3d"、"12h"、"30m")
+ * @return std::optional<int64_t> 没有足够的快照或流水可供推算时返回 std::nullopt
+ */
+CZMONEY_API std::optional<int64_t>
+getRawPlayerBalanceAt(std::string_view uuid, std::string_view currencyType, std::string_view timestamp);
+
+/**
+ * @brief 获取资金流向计数 (按流入 + 流出总量降序)
+ *
+ * 计数按调用方插件 (reason1) 与理由 (reason1, reason2) 累计自启用以来所有已提交的余额变动，
+ * 读取只访问内存，不扫描流水表。
+ * @param currencyType 货币类型，为空时返回所有货币
+ * @param byReason true 按 (reason1, reason2) 返回，false 按 reason1 汇总
+ * @return std::vector<FlowCounter> 计数列表，计数器不可用时返回空列表
+ */
+CZMONEY_API std::vector<czmoney::FlowCounter> getFlowCounters(std::string_view currencyType, bool byReason = false);
+
+/**
+ * @brief 估计最近若干天 (含今天) 内参与经济活动 (余额发生变动) 的不同玩家数
+ *
+ * 基于每日的 HyperLogLog 草图合并估计，误差约 1.6%，不扫描流水表。日期按服务器本地时间划分。
+ * @param currencyType 货币类型，为空时合并所有货币
+ * @param days 天数，1 为今天，7 为最近一周 (最多 366)
+ * @param reason1 只统计该理由 (调用方插件)；std::nullopt 表示所有理由
+ * @return std::optional<uint64_t> 估计的玩家数，统计不可用或查询失败时返回 std::nullopt
+ */
+CZMONEY_API std::optional<uint64_t> getActivePlayerCount(
+    std::string_view                currencyType,
+    int                             days,
+    std::optional<std::string_view> reason1 = std::nullopt
+);
 
 } // namespace czmoney::api
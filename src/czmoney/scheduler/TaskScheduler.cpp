@@ -0,0 +1,255 @@
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/chrono/GameChrono.h"
+#include "ll/api/coro/CoroTask.h"
+#include "ll/api/mod/NativeMod.h"
+#include "ll/api/thread/ServerThreadExecutor.h"
+#include <algorithm>
+#include <exception>
+
+namespace czmoney::scheduler {
+
+namespace {
+double toMs(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+} // namespace
+
+TaskScheduler::TaskScheduler(const SchedulerConfig& config)
+: mConfig(config),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+TaskScheduler::~TaskScheduler() { stop(); }
+
+void TaskScheduler::start() {
+    if (isRunning()) {
+        return;
+    }
+    mRunning = std::make_shared<std::atomic<bool>>(true);
+    {
+        std::lock_guard lock(mMutex);
+        mLastTickAt.reset(); // 重新开始测量 tick 间隔
+    }
+
+    // 协程持有 running 标志的拷贝，即使调度器先被销毁也不会访问悬空的 this
+    ll::coro::keepThis([this, running = mRunning]() -> ll::coro::CoroTask<> {
+        using namespace ll::chrono_literals;
+        while (*running) {
+            co_await 1_tick;
+            if (!*running) {
+                break;
+            }
+            runTick();
+        }
+        co_return;
+    }).launch(ll::thread::ServerThreadExecutor::getDefault());
+
+    mLogger.info(
+        "后台任务调度器已启动 (每 tick 预算 {}ms，最低 {}ms)",
+        mConfig.tickBudgetMs,
+        mConfig.minTickBudgetMs
+    );
+}
+
+void TaskScheduler::stop() {
+    if (mRunning) {
+        *mRunning = false;
+        mRunning.reset();
+    }
+}
+
+void TaskScheduler::submit(std::string name, Task task, TaskPriority priority) {
+    if (!task) {
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    mQueues[static_cast<size_t>(priority)].push_back(
+        QueuedTask{std::move(name), std::move(task), Clock::now(), mTick}
+    );
+}
+
+void TaskScheduler::schedulePeriodic(
+    std::string               name,
+    std::chrono::milliseconds interval,
+    Task                      task,
+    TaskPriority              priority,
+    bool                      runImmediately
+) {
+    if (!task || interval.count() <= 0) {
+        return;
+    }
+    auto            now = Clock::now();
+    std::lock_guard lock(mMutex);
+    mPeriodicTasks.push_back(PeriodicTask{
+        std::move(name),
+        std::move(task),
+        priority,
+        interval,
+        runImmediately ? now : now + interval,
+        std::make_shared<std::atomic<bool>>(false)
+    });
+}
+
+void TaskScheduler::enqueueDuePeriodicLocked(Clock::time_point now) {
+    for (auto& periodic : mPeriodicTasks) {
+        if (now < periodic.nextRunAt || *periodic.pending) {
+            continue;
+        }
+        periodic.nextRunAt = now + periodic.interval;
+        *periodic.pending  = true;
+        mQueues[static_cast<size_t>(periodic.priority)].push_back(QueuedTask{
+            periodic.name,
+            [task = periodic.task, pending = periodic.pending]() {
+                // 无论成功与否都清除 pending 标志，以便下个周期继续入队
+                struct PendingReset {
+                    std::atomic<bool>& flag;
+                    ~PendingReset() { flag = false; }
+                } reset{*pending};
+                task();
+            },
+            now,
+            mTick
+        });
+    }
+}
+
+double TaskScheduler::computeBudgetMs(double tickIntervalMs, size_t backlog) const {
+    double budget = mConfig.tickBudgetMs;
+    // 积压超过阈值时放宽预算，尽快消化队列
+    if (mConfig.backlogThreshold > 0 && backlog > static_cast<size_t>(mConfig.backlogThreshold)) {
+        budget *= std::max(1.0, mConfig.burstBudgetMultiplier);
+    }
+    // 上一个 tick 超出 50ms 的部分视为服务器已无余量，按比例收缩预算
+    double overrun = std::max(0.0, tickIntervalMs - TARGET_TICK_MS);
+    double scale   = std::clamp(1.0 - overrun / TARGET_TICK_MS, 0.0, 1.0);
+    return std::max(mConfig.minTickBudgetMs, budget * scale);
+}
+
+void TaskScheduler::escalateLocked() {
+    if (mConfig.escalateAfterTicks <= 0) {
+        return;
+    }
+    const auto threshold = static_cast<uint64_t>(mConfig.escalateAfterTicks);
+    // 先处理 Normal -> High，再处理 Low -> Normal，避免同一任务在一个 tick 内连升两级
+    for (int level = static_cast<int>(TaskPriority::Normal); level >= static_cast<int>(TaskPriority::Low); --level) {
+        auto& from = mQueues[static_cast<size_t>(level)];
+        auto& to   = mQueues[static_cast<size_t>(level) + 1];
+        // 队列按入队顺序排列，队首等待最久
+        while (!from.empty() && mTick - from.front().enqueuedTick >= threshold) {
+            QueuedTask task   = std::move(from.front());
+            task.enqueuedTick = mTick;
+            from.pop_front();
+            to.push_back(std::move(task));
+            ++mStats.escalatedTotal;
+        }
+    }
+}
+
+bool TaskScheduler::popNextLocked(QueuedTask& out) {
+    for (size_t level = mQueues.size(); level-- > 0;) {
+        auto& queue = mQueues[level];
+        if (!queue.empty()) {
+            out = std::move(queue.front());
+            queue.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::execute(QueuedTask& task) {
+    try {
+        task.task();
+        std::lock_guard lock(mMutex);
+        ++mStats.executedTotal;
+    } catch (const std::exception& e) {
+        mLogger.error("后台任务 '{}' 执行失败: {}", task.name, e.what());
+        std::lock_guard lock(mMutex);
+        ++mStats.executedTotal;
+        ++mStats.failedTotal;
+    } catch (...) {
+        mLogger.error("后台任务 '{}' 执行失败: 未知异常", task.name);
+        std::lock_guard lock(mMutex);
+        ++mStats.executedTotal;
+        ++mStats.failedTotal;
+    }
+}
+
+void TaskScheduler::runTick() {
+    const auto tickStart = Clock::now();
+    double     budgetMs  = 0;
+    {
+        std::lock_guard lock(mMutex);
+        ++mTick;
+        ++mStats.ticksTotal;
+        double intervalMs = mLastTickAt ? toMs(tickStart - *mLastTickAt) : TARGET_TICK_MS;
+        mLastTickAt       = tickStart;
+
+        enqueueDuePeriodicLocked(tickStart);
+        escalateLocked();
+        size_t backlog = mQueues[0].size() + mQueues[1].size() + mQueues[2].size();
+        budgetMs       = computeBudgetMs(intervalMs, backlog);
+
+        mStats.lastTickIntervalMs = intervalMs;
+        mStats.lastBudgetMs       = budgetMs;
+    }
+
+    const auto deadline = tickStart + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double, std::milli>(budgetMs)
+                                      );
+    // 每个 tick 至少执行一个任务，保证在持续卡顿时队列也能推进
+    bool executedAny = false;
+    while (!executedAny || Clock::now() < deadline) {
+        QueuedTask task;
+        {
+            std::lock_guard lock(mMutex);
+            if (!popNextLocked(task)) {
+                break;
+            }
+        }
+        execute(task);
+        executedAny = true;
+    }
+
+    std::lock_guard lock(mMutex);
+    mStats.lastUsedMs = toMs(Clock::now() - tickStart);
+    if (!mQueues[0].empty() || !mQueues[1].empty() || !mQueues[2].empty()) {
+        ++mStats.ticksOverBudget;
+    }
+}
+
+size_t TaskScheduler::drain() {
+    size_t count = 0;
+    while (true) {
+        QueuedTask task;
+        {
+            std::lock_guard lock(mMutex);
+            if (!popNextLocked(task)) {
+                break;
+            }
+        }
+        execute(task);
+        ++count;
+    }
+    if (count > 0) {
+        mLogger.info("后台任务调度器已同步执行 {} 个积压任务", count);
+    }
+    return count;
+}
+
+SchedulerStats TaskScheduler::getStats() const {
+    std::lock_guard lock(mMutex);
+    SchedulerStats stats = mStats;
+    stats.queuedLow      = mQueues[static_cast<size_t>(TaskPriority::Low)].size();
+    stats.queuedNormal   = mQueues[static_cast<size_t>(TaskPriority::Normal)].size();
+    stats.queuedHigh     = mQueues[static_cast<size_t>(TaskPriority::High)].size();
+
+    auto now = Clock::now();
+    for (const auto& queue : mQueues) {
+        if (!queue.empty()) {
+            stats.oldestWaitMs = std::max(stats.oldestWaitMs, toMs(now - queue.front().enqueuedAt));
+        }
+    }
+    return stats;
+}
+
+} // namespace czmoney::scheduler
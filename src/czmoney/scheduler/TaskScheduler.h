@@ -0,0 +1,167 @@
+#pragma once
+
+#include "czmoney/config.h" // 包含 SchedulerConfig
+#include "ll/api/io/Logger.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace czmoney::scheduler {
+
+// 后台任务优先级，数值越大越优先
+enum class TaskPriority : int {
+    Low = 0,    // 例如：保留期清理、统计落盘
+    Normal = 1, // 例如：排行榜刷新、缓存回写
+    High = 2    // 例如：日志刷新等需要尽快完成的任务
+};
+
+// 调度器当前积压情况的快照，供管理命令展示
+struct SchedulerStats {
+    size_t   queuedLow = 0;          // 低优先级队列长度
+    size_t   queuedNormal = 0;       // 普通优先级队列长度
+    size_t   queuedHigh = 0;         // 高优先级队列长度
+    uint64_t executedTotal = 0;      // 累计执行的任务数
+    uint64_t failedTotal = 0;        // 累计抛出异常的任务数
+    uint64_t escalatedTotal = 0;     // 累计被提升优先级的任务数
+    uint64_t ticksTotal = 0;         // 调度器经历的 tick 数
+    uint64_t ticksOverBudget = 0;    // 因预算耗尽而留下积压的 tick 数
+    double   lastTickIntervalMs = 0; // 最近一次 tick 间隔 (毫秒)
+    double   lastBudgetMs = 0;       // 最近一次 tick 分配到的预算 (毫秒)
+    double   lastUsedMs = 0;         // 最近一次 tick 实际使用的时间 (毫秒)
+    double   oldestWaitMs = 0;       // 当前最老任务已等待的时间 (毫秒)
+};
+
+/**
+ * @brief 感知 tick 耗时的后台任务调度器
+ *
+ * 日志刷新、排行榜刷新、保留期清理等延迟任务都提交到这里，
+ * 由服务器线程在每个 tick 末尾按预算执行，避免与游戏逻辑争抢时间。
+ * - 每个 tick 的预算来自配置，并根据上一个 tick 的实际间隔动态收缩 (服务器卡顿时少跑)。
+ * - 任务等待过久会被逐级提升优先级；队列总长度超过阈值时启用突发预算。
+ * - submit 可在任意线程调用，任务本身始终在服务器线程执行。
+ */
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief 构造函数
+     * @param config 调度器配置的引用
+     */
+    explicit TaskScheduler(const SchedulerConfig& config);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * @brief 启动调度循环 (在服务器线程上每 tick 运行一次)
+     */
+    void start();
+
+    /**
+     * @brief 停止调度循环
+     *
+     * 停止后仍可调用 drain() 同步执行剩余任务。
+     */
+    void stop();
+
+    /**
+     * @brief 提交一个后台任务
+     * @param name 任务名称，用于日志
+     * @param task 要执行的任务
+     * @param priority 任务优先级
+     */
+    void submit(std::string name, Task task, TaskPriority priority = TaskPriority::Normal);
+
+    /**
+     * @brief 注册一个周期性任务
+     *
+     * 到期时按普通任务入队，同样受每 tick 预算约束。上一次提交的实例尚未执行完时不会重复入队，
+     * 因此服务器长时间卡顿也不会堆积同一个周期任务。
+     * @param name 任务名称，用于日志
+     * @param interval 执行间隔
+     * @param task 要执行的任务
+     * @param priority 任务优先级
+     * @param runImmediately 是否在下一个 tick 立即执行一次 (例如用于补跑停机期间错过的任务)
+     */
+    void schedulePeriodic(
+        std::string               name,
+        std::chrono::milliseconds interval,
+        Task                      task,
+        TaskPriority              priority       = TaskPriority::Low,
+        bool                      runImmediately = false
+    );
+
+    /**
+     * @brief 执行一次调度 (由调度循环在每个 tick 调用)
+     */
+    void runTick();
+
+    /**
+     * @brief 忽略预算，同步执行所有积压任务 (插件禁用前调用)
+     * @return size_t 执行的任务数量
+     */
+    size_t drain();
+
+    /**
+     * @brief 获取当前积压与运行统计
+     * @return SchedulerStats 统计快照
+     */
+    [[nodiscard]] SchedulerStats getStats() const;
+
+    /**
+     * @brief 调度循环是否正在运行
+     */
+    [[nodiscard]] bool isRunning() const { return mRunning && *mRunning; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedTask {
+        std::string       name;
+        Task              task;
+        Clock::time_point enqueuedAt;
+        uint64_t          enqueuedTick; // 入队 (或上次提升) 时的 tick 序号
+    };
+
+    struct PeriodicTask {
+        std::string                        name;
+        Task                               task;
+        TaskPriority                       priority;
+        Clock::duration                    interval;
+        Clock::time_point                  nextRunAt;
+        std::shared_ptr<std::atomic<bool>> pending; // 已入队但尚未执行
+    };
+
+    static constexpr double TARGET_TICK_MS = 50.0; // 20 TPS 下每个 tick 的目标时长
+
+    const SchedulerConfig& mConfig;
+    ll::io::Logger&        mLogger;
+
+    mutable std::mutex                 mMutex;
+    std::array<std::deque<QueuedTask>, 3> mQueues; // 按 TaskPriority 下标存放
+    std::vector<PeriodicTask>          mPeriodicTasks;
+    SchedulerStats                     mStats;
+    uint64_t                           mTick = 0;
+    std::optional<Clock::time_point>   mLastTickAt;
+
+    // 调度协程持有该标志的拷贝，stop() 置 false 后协程自行退出
+    std::shared_ptr<std::atomic<bool>> mRunning;
+
+    double computeBudgetMs(double tickIntervalMs, size_t backlog) const;
+    void   escalateLocked();
+    void   enqueueDuePeriodicLocked(Clock::time_point now);
+    bool   popNextLocked(QueuedTask& out);
+    void   execute(QueuedTask& task);
+};
+
+} // namespace czmoney::scheduler
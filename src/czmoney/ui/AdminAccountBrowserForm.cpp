@@ -0,0 +1,307 @@
+#include "czmoney/ui/AdminAccountBrowserForm.h"
+#include "czmoney/MyMod.h"
+#include "czmoney/logger.h"
+#include "czmoney/money/money_api.h"
+#include "czmoney/ui/AdminMoneyEditForm.h" // 选中账户后打开编辑表单
+#include "czmoney/ui/FormLoader.h"
+#include "ll/api/service/PlayerInfo.h"
+#include "mc/platform/UUID.h"
+#include "mc/world/actor/player/Player.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace czmoney::ui {
+
+namespace {
+// 输入框中的金额，空白表示不限
+std::string formatOptionalAmount(const std::optional<int64_t>& amount) {
+    return amount ? czmoney::api::formatBalance(*amount) : "";
+}
+
+std::string lookupPlayerName(const std::string& uuid) {
+    auto playerInfoOpt = ll::service::PlayerInfo::getInstance().fromUuid(mce::UUID::fromString(uuid));
+    if (playerInfoOpt.has_value()) {
+        return playerInfoOpt.value().name;
+    }
+    return "未知玩家";
+}
+} // namespace
+
+const std::vector<std::string>& AdminAccountBrowserForm::sortOrders() {
+    static const std::vector<std::string> orders = {"余额 从高到低", "余额 从低到高", "最近更新 从新到旧", "最近更新 从旧到新"};
+    return orders;
+}
+
+int AdminAccountBrowserForm::sortOrderIndex(const BalanceBrowseQuery& query) {
+    int index = query.sortKey == BalanceSortKey::Amount ? 0 : 2;
+    return query.descending ? index : index + 1;
+}
+
+void AdminAccountBrowserForm::applySortOrder(BalanceBrowseQuery& query, size_t index) {
+    query.sortKey    = index < 2 ? BalanceSortKey::Amount : BalanceSortKey::LastUpdated;
+    query.descending = index % 2 == 0;
+}
+
+AdminAccountBrowserForm::AdminAccountBrowserForm(
+    const AccountBrowserState& state,
+    const std::vector<BalanceBrowseRow>& rows,
+    uint64_t total,
+    size_t pageSize,
+    const std::vector<std::string>& availableCurrencies
+)
+    : ll::form::CustomForm("经济管理 - 账户浏览")
+{
+    const auto& query = state.query;
+    uint64_t totalPages = std::max<uint64_t>(1, (total + pageSize - 1) / pageSize);
+
+    // 1. 概要
+    appendLabel(fmt::format("§l{}§r 共 {} 个账户，第 {}/{} 页", query.currencyType, total, state.page + 1, totalPages));
+
+    // 2. 货币类型选择下拉列表
+    if (availableCurrencies.empty()) {
+        appendLabel("§c当前没有可用的经济类型。");
+    } else {
+        int defaultCurrencyIndex = 0;
+        for (size_t i = 0; i < availableCurrencies.size(); ++i) {
+            if (availableCurrencies[i] == query.currencyType) {
+                defaultCurrencyIndex = i;
+                break;
+            }
+        }
+        appendDropdown("currency_type", "选择经济类型", availableCurrencies, defaultCurrencyIndex);
+    }
+
+    // 3. 排序方式与筛选条件
+    appendDropdown("sort_order", "排序方式", sortOrders(), sortOrderIndex(query));
+    appendInput("min_amount", "最低余额 (留空不限)", "例如: 100.00", formatOptionalAmount(query.minAmount));
+    appendInput("max_amount", "最高余额 (留空不限)", "例如: 5000.00", formatOptionalAmount(query.maxAmount));
+    appendInput(
+        "updated_days",
+        "只看最近几天内有变动的账户 (留空不限)",
+        "例如: 7",
+        query.updatedWithinDays > 0 ? std::to_string(query.updatedWithinDays) : ""
+    );
+
+    // 4. 当前页的账户
+    if (rows.empty()) {
+        appendLabel("§c没有符合条件的账户");
+    } else {
+        for (const auto& row : rows) {
+            appendToggle(
+                row.uuid,
+                fmt::format(
+                    "{} ({}{}) §7{}",
+                    lookupPlayerName(row.uuid),
+                    czmoney::api::formatBalance(row.amount),
+                    query.currencyType,
+                    row.lastUpdated
+                ),
+                false
+            );
+        }
+    }
+
+    // 5. 翻页
+    appendToggle("prev_page", "上一页", false);
+    appendToggle("next_page", "下一页", false);
+    appendInput("page_input", fmt::format("跳转到页码 (1-{})", totalPages), "输入页码", std::to_string(state.page + 1));
+
+    // 6. 确认选择按钮
+    appendToggle("confirm_selection", "管理选中的账户", false);
+
+    // 7. 返回按钮
+    appendToggle("back_button", "返回", false);
+}
+
+void showAdminAccountBrowserForm(Player& player, AccountBrowserState state, AccountBrowserMove move) {
+    using ll::form::CustomFormResult;
+    using ll::form::FormCancelReason;
+    using ll::form::CustomFormElementResult;
+
+    // 获取所有可用的货币类型
+    std::vector<std::string> availableCurrencies;
+    const auto& config = czmoney::MyMod::getInstance().getConfig();
+    for (const auto& pair : config.economy) {
+        availableCurrencies.push_back(pair.first);
+    }
+    if (std::find(availableCurrencies.begin(), availableCurrencies.end(), state.query.currencyType)
+        == availableCurrencies.end()) {
+        state.query.currencyType = availableCurrencies.empty() ? "money" : availableCurrencies[0];
+    }
+    size_t pageSize = static_cast<size_t>(std::max(1, config.forms.accountsPerPage));
+
+    // 账户查询在表单加载线程上执行；表单需要读取 PlayerInfo，在服务器线程上构造
+    czmoney::MyMod::getInstance().getFormLoader().load(player, "admin-account-browser", [
+        state,
+        move,
+        pageSize,
+        availableCurrencies
+    ](db::IDatabaseConnection& conn) mutable -> FormLoader::Sender {
+    BalanceBrowser browser(conn);
+    uint64_t total = browser.count(state.query);
+    uint64_t lastPage = total == 0 ? 0 : (total - 1) / pageSize;
+
+    std::vector<BalanceBrowseRow> rows;
+    if (move == AccountBrowserMove::Next && state.last && state.page < lastPage) {
+        rows = browser.pageAfter(state.query, state.last, pageSize);
+        state.page++;
+    } else if (move == AccountBrowserMove::Previous && state.first && state.page > 0) {
+        rows = browser.pageBefore(state.query, *state.first, pageSize);
+        state.page--;
+    }
+    if (rows.empty()) {
+        // 跳页、刷新，或者翻页期间账户发生变化导致边界失效
+        state.page = std::min<uint64_t>(state.page, lastPage);
+        rows = browser.page(state.query, state.page, pageSize);
+    }
+    state.first = rows.empty() ? std::nullopt : std::optional<BalanceBrowseRow>(rows.front());
+    state.last  = rows.empty() ? std::nullopt : std::optional<BalanceBrowseRow>(rows.back());
+
+    return [state, rows, total, pageSize, availableCurrencies](Player& player) {
+    AdminAccountBrowserForm form(state, rows, total, pageSize, availableCurrencies);
+
+    std::vector<std::string> pageUuids;
+    for (const auto& row : rows) {
+        pageUuids.push_back(row.uuid);
+    }
+
+    form.sendTo(player, [
+        state,
+        pageUuids,
+        availableCurrencies
+    ](Player& player, CustomFormResult const& data, FormCancelReason reason) {
+        if (!data.has_value()) {
+            logger.debug("账户浏览表单被玩家 {} 关闭。", player.getRealName());
+            return;
+        }
+
+        const auto& formData = data.value();
+
+        auto getFormValue = [&](const std::string& key) -> CustomFormElementResult {
+            auto it = formData.find(key);
+            if (it != formData.end()) {
+                return it->second;
+            }
+            return std::monostate{};
+        };
+        auto getString = [&](const std::string& key) -> std::string {
+            auto result = getFormValue(key);
+            return std::holds_alternative<std::string>(result) ? std::get<std::string>(result) : "";
+        };
+        auto getToggle = [&](const std::string& key) -> bool {
+            auto result = getFormValue(key);
+            return std::holds_alternative<uint64>(result) && static_cast<bool>(std::get<uint64>(result));
+        };
+
+        // 读取新的浏览条件
+        BalanceBrowseQuery newQuery = state.query;
+        auto currencyTypeResult = getFormValue("currency_type");
+        if (std::holds_alternative<std::string>(currencyTypeResult)) {
+            newQuery.currencyType = std::get<std::string>(currencyTypeResult);
+        } else if (std::holds_alternative<uint64>(currencyTypeResult)) {
+            size_t selectedIndex = static_cast<size_t>(std::get<uint64>(currencyTypeResult));
+            if (selectedIndex < availableCurrencies.size()) {
+                newQuery.currencyType = availableCurrencies[selectedIndex];
+            }
+        }
+        auto sortOrderResult = getFormValue("sort_order");
+        if (std::holds_alternative<uint64>(sortOrderResult)) {
+            AdminAccountBrowserForm::applySortOrder(newQuery, static_cast<size_t>(std::get<uint64>(sortOrderResult)));
+        }
+
+        std::string minAmountStr = getString("min_amount");
+        std::string maxAmountStr = getString("max_amount");
+        std::string daysStr      = getString("updated_days");
+        newQuery.minAmount       = std::nullopt;
+        newQuery.maxAmount       = std::nullopt;
+        newQuery.updatedWithinDays = 0;
+        if (!minAmountStr.empty()) {
+            newQuery.minAmount = czmoney::api::parseBalance(minAmountStr);
+            if (!newQuery.minAmount) {
+                player.sendMessage("§c最低余额格式无效。");
+                showAdminAccountBrowserForm(player, state);
+                return;
+            }
+        }
+        if (!maxAmountStr.empty()) {
+            newQuery.maxAmount = czmoney::api::parseBalance(maxAmountStr);
+            if (!newQuery.maxAmount) {
+                player.sendMessage("§c最高余额格式无效。");
+                showAdminAccountBrowserForm(player, state);
+                return;
+            }
+        }
+        if (!daysStr.empty()) {
+            try {
+                newQuery.updatedWithinDays = std::max(0, std::stoi(daysStr));
+            } catch (const std::exception&) {
+                player.sendMessage("§c天数格式无效。");
+                showAdminAccountBrowserForm(player, state);
+                return;
+            }
+        }
+
+        // 检查是否点击了返回按钮
+        if (getToggle("back_button")) {
+            player.sendMessage("§a您退出了账户浏览界面。");
+            return;
+        }
+
+        // 条件发生变化时回到第一页
+        const auto& oldQuery = state.query;
+        if (newQuery.currencyType != oldQuery.currencyType || newQuery.sortKey != oldQuery.sortKey
+            || newQuery.descending != oldQuery.descending || newQuery.minAmount != oldQuery.minAmount
+            || newQuery.maxAmount != oldQuery.maxAmount || newQuery.updatedWithinDays != oldQuery.updatedWithinDays) {
+            AccountBrowserState newState;
+            newState.query = newQuery;
+            showAdminAccountBrowserForm(player, newState);
+            return;
+        }
+
+        if (getToggle("confirm_selection")) {
+            std::string selectedUuid;
+            int selectedCount = 0;
+            for (const auto& uuid : pageUuids) {
+                if (getToggle(uuid)) {
+                    selectedUuid = uuid;
+                    selectedCount++;
+                }
+            }
+            if (selectedCount != 1) {
+                player.sendMessage(selectedCount == 0 ? "§c请选择一个账户进行管理。" : "§c一次只能选择一个账户进行管理。");
+                showAdminAccountBrowserForm(player, state);
+                return;
+            }
+            showAdminMoneyEditForm(player, selectedUuid, state.query.currencyType);
+            return;
+        }
+
+        if (getToggle("next_page")) {
+            showAdminAccountBrowserForm(player, state, AccountBrowserMove::Next);
+            return;
+        }
+        if (getToggle("prev_page")) {
+            showAdminAccountBrowserForm(player, state, AccountBrowserMove::Previous);
+            return;
+        }
+
+        // 跳转到指定页码，其余情况刷新当前页
+        AccountBrowserState newState = state;
+        std::string pageStr = getString("page_input");
+        if (!pageStr.empty()) {
+            try {
+                newState.page = static_cast<size_t>(std::max(1, std::stoi(pageStr)) - 1);
+            } catch (const std::exception&) {
+                player.sendMessage("§c页码格式无效。");
+            }
+        }
+        showAdminAccountBrowserForm(player, newState);
+    });
+    };
+    });
+}
+
+} // namespace czmoney::ui
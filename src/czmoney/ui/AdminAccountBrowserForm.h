@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ll/api/form/CustomForm.h"
+#include "mc/world/actor/player/Player.h"
+#include "czmoney/money/BalanceBrowser.h"
+#include "czmoney/MyMod.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace czmoney::ui {
+
+// 账户浏览表单的状态 (在表单之间传递)
+struct AccountBrowserState {
+    BalanceBrowseQuery              query;
+    size_t                          page = 0;
+    std::optional<BalanceBrowseRow> first; // 当前页第一行 (上一页的边界)
+    std::optional<BalanceBrowseRow> last;  // 当前页最后一行 (下一页的边界)
+};
+
+// 打开账户浏览表单时的翻页方式
+enum class AccountBrowserMove {
+    Reload,   // 按页码重新读取 (跳页、刷新、条件变化)
+    Next,     // 从当前页最后一行继续
+    Previous, // 从当前页第一行往前
+};
+
+class AdminAccountBrowserForm : public ll::form::CustomForm {
+public:
+    // 构造函数，接收浏览状态、当前页的账户、账户总数、每页数量和可用货币类型
+    // 在服务器线程上构造 (需要读取 PlayerInfo 显示玩家名称)，数据库查询已经在表单加载线程上完成
+    AdminAccountBrowserForm(
+        const AccountBrowserState& state,
+        const std::vector<BalanceBrowseRow>& rows,
+        uint64_t total,
+        size_t pageSize,
+        const std::vector<std::string>& availableCurrencies
+    );
+
+    // 下拉列表中的排序方式 (索引与 sortOrderIndex 对应)
+    static const std::vector<std::string>& sortOrders();
+    // 浏览条件对应的排序方式索引
+    static int sortOrderIndex(const BalanceBrowseQuery& query);
+    // 把排序方式索引写回浏览条件
+    static void applySortOrder(BalanceBrowseQuery& query, size_t index);
+};
+
+// 辅助函数，用于创建和显示账户浏览表单 (管理员按余额 / 更新时间浏览某种货币的全部账户)
+void showAdminAccountBrowserForm(
+    Player& player,
+    AccountBrowserState state = {},
+    AccountBrowserMove move = AccountBrowserMove::Reload
+);
+
+} // namespace czmoney::ui
@@ -3,6 +3,7 @@
 #include "czmoney/logger.h"
 #include "czmoney/money/money_api.h"
 #include "czmoney/ui/AdminMoneyListForm.h" // 引入 AdminMoneyListForm
+#include "czmoney/ui/FormLoader.h"
 #include "ll/api/form/ModalForm.h"
 #include "ll/api/service/PlayerInfo.h"
 #include "mc/platform/UUID.h"
@@ -26,16 +27,16 @@ std::string AdminMoneyEditForm::getPlayerName(const std::string& uuid) {
 }
 
 AdminMoneyEditForm::AdminMoneyEditForm(
-    Player& player,
     const std::string& targetPlayerUuid,
+    const std::string& targetPlayerName,
+    const std::unordered_map<std::string, int64_t>& balances,
     const std::string& initialCurrency,
     const std::string& returnSearchFilter,
     int returnPage
 )
     : ll::form::CustomForm("经济管理 - 玩家编辑"),
-      mPlayer(player),
       mTargetPlayerUuid(targetPlayerUuid),
-      mTargetPlayerName(getPlayerName(targetPlayerUuid)),
+      mTargetPlayerName(targetPlayerName),
       mSelectedCurrency(initialCurrency),
       mReturnSearchFilter(returnSearchFilter),
       mReturnPage(returnPage)
@@ -62,10 +63,17 @@ AdminMoneyEditForm::AdminMoneyEditForm(
     // 1. 显示目标玩家信息
     appendLabel(fmt::format("§l目标玩家: §r{} (§7{})", mTargetPlayerName, mTargetPlayerUuid));
 
-    // 2. 货币类型选择下拉列表
-    if (mAvailableCurrencies.empty()) {
-        appendLabel("§c当前没有可用的经济类型。");
-    } else {
+    // 2. 显示所有货币的当前余额
+    std::string balanceLines;
+    for (const auto& currency : mAvailableCurrencies) {
+        auto it = balances.find(currency);
+        std::string balanceStr = it != balances.end() ? czmoney::api::formatBalance(it->second) : "N/A";
+        balanceLines += fmt::format("{}{}: §r{}", balanceLines.empty() ? "§l当前余额\n§7" : "\n§7", currency, balanceStr);
+    }
+    appendLabel(balanceLines.empty() ? "§c当前没有可用的经济类型。" : balanceLines);
+
+    // 3. 货币类型选择下拉列表 (要操作的货币)
+    if (!mAvailableCurrencies.empty()) {
         int defaultCurrencyIndex = 0;
         for (size_t i = 0; i < mAvailableCurrencies.size(); ++i) {
             if (mAvailableCurrencies[i] == mSelectedCurrency) {
@@ -76,11 +84,6 @@ AdminMoneyEditForm::AdminMoneyEditForm(
         appendDropdown("currency_type", "选择经济类型", mAvailableCurrencies, defaultCurrencyIndex);
     }
 
-    // 3. 显示当前余额
-    std::optional<double> currentBalanceOpt = czmoney::api::getPlayerBalance(mTargetPlayerUuid, mSelectedCurrency);
-    std::string currentBalanceStr = currentBalanceOpt.has_value() ? czmoney::api::formatBalance(static_cast<int64_t>(currentBalanceOpt.value() * 100)) : "N/A";
-    appendLabel(fmt::format("§l当前余额: §r{} {}", currentBalanceStr, mSelectedCurrency));
-
     // 4. 金额输入框
     appendInput("amount_input", "金额", "输入金额 (例如: 100.50)", "");
 
@@ -94,31 +97,30 @@ AdminMoneyEditForm::AdminMoneyEditForm(
     appendToggle("back_button", "返回列表", false);
 }
 
-void showAdminMoneyEditForm(
+namespace {
+
+// 发送编辑表单并处理提交
+// balances 为表单上显示的余额：操作成功后用返回的新余额更新，直接重新显示而不再查询
+void sendAdminMoneyEditForm(
     Player& player,
+    AdminMoneyEditForm& form,
     const std::string& targetPlayerUuid,
+    const std::string& targetPlayerName,
+    const std::unordered_map<std::string, int64_t>& balances,
     const std::string& initialCurrency,
     const std::string& returnSearchFilter,
-    int returnPage
+    int returnPage,
+    const std::vector<std::string>& availableCurrenciesForCallback
 ) {
     using ll::form::CustomFormResult;
     using ll::form::FormCancelReason;
     using ll::form::CustomFormElementResult;
 
-    auto form = std::make_unique<AdminMoneyEditForm>(player, targetPlayerUuid, initialCurrency, returnSearchFilter, returnPage);
-    std::string targetPlayerName = form->getTargetPlayerName(); // 获取目标玩家名称
-
-    // 获取所有可用的货币类型 (用于回调中重新构建表单)
-    std::vector<std::string> availableCurrenciesForCallback;
-    const auto& config = czmoney::MyMod::getInstance().getConfig();
-    for (const auto& pair : config.economy) {
-        availableCurrenciesForCallback.push_back(pair.first);
-    }
-
-    form->sendTo(player, [
+    form.sendTo(player, [
         playerUuid = player.getUuid().asString(),
         targetPlayerUuid,
         targetPlayerName,
+        balances,
         initialCurrency,
         returnSearchFilter,
         returnPage,
@@ -180,54 +182,65 @@ void showAdminMoneyEditForm(
             return;
         }
 
-        // 如果货币类型发生变化，重新显示表单以更新余额显示
-        if (newSelectedCurrency != initialCurrency) {
-            showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
-            return;
-        }
-
+        // 所有货币的余额已经显示在表单上，切换货币不需要重新查询，直接对选中的货币执行操作
         if (confirmAction) {
             std::optional<int64_t> rawAmountOpt = czmoney::api::parseBalance(amountStr);
             if (!rawAmountOpt.has_value()) {
                 player.sendMessage("§c请输入有效的金额。");
-                showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
+                showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage, balances);
                 return;
             }
-            double amount = static_cast<double>(rawAmountOpt.value()) / 100.0;
-
-            czmoney::api::MoneyApiResult result = czmoney::api::MoneyApiResult::UnknownError;
-            std::string reason1 = "AdminUI";
-            std::string reason2 = fmt::format("Admin: {}", player.getRealName());
-            std::string reason3 = fmt::format("Target: {}", targetPlayerName);
+            int64_t amount = rawAmountOpt.value();
 
+            czmoney::api::BalanceAdjustment adjustment;
             switch (actionType) {
                 case 0: // Set
-                    result = czmoney::api::setPlayerBalance(targetPlayerUuid, newSelectedCurrency, amount, reason1, reason2, reason3);
+                    adjustment = czmoney::api::BalanceAdjustment::Set;
                     break;
                 case 1: // Add
                     if (amount <= 0) {
                         player.sendMessage("§c增加金额必须为正数。");
-                        showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
+                        showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage, balances);
                         return;
                     }
-                    result = czmoney::api::addPlayerBalance(targetPlayerUuid, newSelectedCurrency, amount, reason1, reason2, reason3);
+                    adjustment = czmoney::api::BalanceAdjustment::Add;
                     break;
                 case 2: // Subtract
                     if (amount <= 0) {
                         player.sendMessage("§c减少金额必须为正数。");
-                        showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
+                        showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage, balances);
                         return;
                     }
-                    result = czmoney::api::subtractPlayerBalance(targetPlayerUuid, newSelectedCurrency, amount, reason1, reason2, reason3);
+                    adjustment = czmoney::api::BalanceAdjustment::Subtract;
                     break;
                 default:
                     player.sendMessage("§c无效的操作类型。");
-                    showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
+                    showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage, balances);
                     return;
             }
 
+            std::string reason1 = "AdminUI";
+            std::string reason2 = fmt::format("Admin: {}", player.getRealName());
+            std::string reason3 = fmt::format("Target: {}", targetPlayerName);
+
+            // 金额以分为单位直接写入，操作后的余额由写入过程返回
+            int64_t newBalance = 0;
+            czmoney::api::MoneyApiResult result = czmoney::api::adjustRawPlayerBalance(
+                targetPlayerUuid, newSelectedCurrency, adjustment, amount, &newBalance, reason1, reason2, reason3
+            );
+
             if (result == czmoney::api::MoneyApiResult::Success) {
-                player.sendMessage(fmt::format("§a成功对玩家 {} 的 {} 余额执行操作。", targetPlayerName, newSelectedCurrency));
+                player.sendMessage(fmt::format(
+                    "§a成功对玩家 {} 的 {} 余额执行操作，当前余额: {}。",
+                    targetPlayerName,
+                    newSelectedCurrency,
+                    czmoney::api::formatBalance(newBalance)
+                ));
+                // 用返回的新余额更新表单，无需再次查询
+                auto updatedBalances = balances;
+                updatedBalances[newSelectedCurrency] = newBalance;
+                showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage, updatedBalances);
+                return;
             } else {
                 std::string errorMessage;
                 switch (result) {
@@ -248,19 +261,63 @@ void showAdminMoneyEditForm(
                         break;
                     case czmoney::api::MoneyApiResult::UnknownError:
                     default:
-                        errorMessage = "未知错误。";
+                        errorMessage = czmoney::api::getResultMessage(result);
                         break;
                 }
                 player.sendMessage(fmt::format("§c操作失败！{}. 请检查日志。", errorMessage));
             }
-            // 操作完成后，重新显示表单以更新余额
+            // 操作失败时余额可能已被其他操作改变，重新查询后显示
             showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
             return;
         }
 
-        // 如果没有任何操作，重新显示表单 (例如，只是点击了空白区域)
+        // 如果没有任何操作，重新查询并显示表单 (例如，只是点击了空白区域，相当于刷新)
         showAdminMoneyEditForm(player, targetPlayerUuid, newSelectedCurrency, returnSearchFilter, returnPage);
     });
 }
 
+} // namespace
+
+void showAdminMoneyEditForm(
+    Player& player,
+    const std::string& targetPlayerUuid,
+    const std::string& initialCurrency,
+    const std::string& returnSearchFilter,
+    int returnPage,
+    std::optional<std::unordered_map<std::string, int64_t>> knownBalances
+) {
+    std::string targetPlayerName = AdminMoneyEditForm::getPlayerName(targetPlayerUuid); // 获取目标玩家名称
+
+    // 获取所有可用的货币类型 (用于回调中重新构建表单)
+    std::vector<std::string> availableCurrenciesForCallback;
+    const auto& config = czmoney::MyMod::getInstance().getConfig();
+    for (const auto& pair : config.economy) {
+        availableCurrenciesForCallback.push_back(pair.first);
+    }
+
+    // 已知余额 (刚执行完操作) 时直接构建，不访问数据库
+    if (knownBalances) {
+        AdminMoneyEditForm form(targetPlayerUuid, targetPlayerName, *knownBalances, initialCurrency, returnSearchFilter, returnPage);
+        sendAdminMoneyEditForm(player, form, targetPlayerUuid, targetPlayerName, *knownBalances, initialCurrency, returnSearchFilter, returnPage, availableCurrenciesForCallback);
+        return;
+    }
+
+    // 一次查询目标玩家所有货币的余额，查询和表单构建交给表单加载器
+    czmoney::MyMod::getInstance().getFormLoader().load(player, "admin-money-edit", [
+        targetPlayerUuid,
+        targetPlayerName,
+        initialCurrency,
+        returnSearchFilter,
+        returnPage,
+        availableCurrenciesForCallback
+    ](db::IDatabaseConnection& conn) -> FormLoader::Sender {
+        auto balances = queryAccountBalances(conn, targetPlayerUuid);
+        auto form = std::make_shared<AdminMoneyEditForm>(targetPlayerUuid, targetPlayerName, balances, initialCurrency, returnSearchFilter, returnPage);
+
+        return [form, balances, targetPlayerUuid, targetPlayerName, initialCurrency, returnSearchFilter, returnPage, availableCurrenciesForCallback](Player& player) {
+            sendAdminMoneyEditForm(player, *form, targetPlayerUuid, targetPlayerName, balances, initialCurrency, returnSearchFilter, returnPage, availableCurrenciesForCallback);
+        };
+    });
+}
+
 } // namespace czmoney::ui
@@ -6,7 +6,9 @@
 #include "mc/platform/UUID.h"
 #include "czmoney/money/money_api.h"
 #include "czmoney/MyMod.h"
+#include "czmoney/database_interface.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <optional>
@@ -17,17 +19,21 @@ namespace czmoney::ui {
 
 class AdminMoneyEditForm : public ll::form::CustomForm {
 public:
-    // 构造函数，接收当前玩家、目标玩家UUID、初始选定货币类型，以及返回列表表单时的状态
-    explicit AdminMoneyEditForm(
-        Player& player,
+    // 构造函数，接收目标玩家UUID和名称、该玩家所有货币的余额 (货币类型 -> 分，一次查询得到)、
+    // 初始选定货币类型，以及返回列表表单时的状态
+    AdminMoneyEditForm(
         const std::string& targetPlayerUuid,
+        const std::string& targetPlayerName,
+        const std::unordered_map<std::string, int64_t>& balances,
         const std::string& initialCurrency = "",
         const std::string& returnSearchFilter = "",
         int returnPage = 0
     );
 
+    // 辅助函数，获取玩家名称 (读取 PlayerInfo，只能在服务器线程调用)
+    static std::string getPlayerName(const std::string& uuid);
+
 private:
-    Player& mPlayer;
     std::string mTargetPlayerUuid;
     std::string mTargetPlayerName; // 缓存目标玩家名称
     std::string mSelectedCurrency;
@@ -37,9 +43,6 @@ private:
     std::string mReturnSearchFilter;
     int mReturnPage;
 
-    // 辅助函数，获取玩家名称
-    std::string getPlayerName(const std::string& uuid);
-
 public:
     // 获取目标玩家UUID
     const std::string& getTargetPlayerUuid() const { return mTargetPlayerUuid; }
@@ -48,12 +51,14 @@ public:
 };
 
 // 辅助函数，用于创建和显示玩家经济编辑表单
+// knownBalances 不为空时直接使用 (例如刚执行完操作)，否则通过表单加载器查询
 void showAdminMoneyEditForm(
     Player& player,
     const std::string& targetPlayerUuid,
     const std::string& initialCurrency = "",
     const std::string& returnSearchFilter = "",
-    int returnPage = 0
+    int returnPage = 0,
+    std::optional<std::unordered_map<std::string, int64_t>> knownBalances = std::nullopt
 );
 
 } // namespace czmoney::ui
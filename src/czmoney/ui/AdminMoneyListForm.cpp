@@ -3,6 +3,7 @@
 #include "czmoney/logger.h"
 #include "czmoney/money/money_api.h"
 #include "czmoney/ui/AdminMoneyEditForm.h" // 引入 AdminMoneyEditForm
+#include "czmoney/ui/FormLoader.h"
 #include "ll/api/form/ModalForm.h" // 用于显示提示信息
 #include "ll/api/service/PlayerInfo.h"
 #include "mc/platform/UUID.h"
@@ -19,12 +20,18 @@ namespace czmoney::ui {
 // 每页显示的玩家数量
 constexpr int PLAYERS_PER_PAGE = 8; // 与 TransferForm 保持一致
 
-AdminMoneyListForm::AdminMoneyListForm(Player& player, const std::string& searchFilter, int page, const std::string& selectedCurrency)
+AdminMoneyListForm::AdminMoneyListForm(
+    db::IDatabaseConnection& conn,
+    std::vector<ll::service::PlayerInfo::PlayerInfoEntry> allPlayers,
+    const std::string& searchFilter,
+    int page,
+    const std::string& selectedCurrency
+)
     : ll::form::CustomForm("经济管理 - 玩家列表"),
-      mPlayer(player),
       mSearchFilter(searchFilter),
       mCurrentPage(page),
-      mSelectedCurrency(selectedCurrency)
+      mSelectedCurrency(selectedCurrency),
+      mAllPlayers(std::move(allPlayers))
 {
     // 获取所有可用的货币类型
     const auto& config = czmoney::MyMod::getInstance().getConfig();
@@ -42,11 +49,6 @@ AdminMoneyListForm::AdminMoneyListForm(Player& player, const std::string& search
         }
     }
 
-    // 获取所有玩家信息
-    mAllPlayers.clear();
-    for (const auto& entry : ll::service::PlayerInfo::getInstance().entries()) {
-        mAllPlayers.push_back(entry);
-    }
     // 按照玩家名称排序
     std::sort(mAllPlayers.begin(), mAllPlayers.end(), [](const auto& a, const auto& b) {
         return a.name < b.name;
@@ -87,12 +89,20 @@ AdminMoneyListForm::AdminMoneyListForm(Player& player, const std::string& search
     } else {
         int startIndex = mCurrentPage * PLAYERS_PER_PAGE;
         int endIndex = std::min(startIndex + PLAYERS_PER_PAGE, (int)mFilteredPlayers.size());
+
+        // 一次查询当前页所有玩家选定货币的余额
+        std::vector<std::string> pageUuids;
+        for (int i = startIndex; i < endIndex; ++i) {
+            pageUuids.push_back(mFilteredPlayers[i].uuid.asString());
+        }
+        auto balances = queryBalances(conn, pageUuids, mSelectedCurrency);
+
         for (int i = startIndex; i < endIndex; ++i) {
             const auto& playerEntry = mFilteredPlayers[i];
-            // 获取玩家当前选定货币的余额
-            std::optional<double> balanceOpt = czmoney::api::getPlayerBalance(playerEntry.uuid.asString(), mSelectedCurrency);
-            std::string balanceStr = balanceOpt.has_value() ? czmoney::api::formatBalance(static_cast<int64_t>(balanceOpt.value() * 100)) : "N/A";
-            
+            auto it = balances.find(playerEntry.uuid.asString());
+            std::string balanceStr = it != balances.end() ? czmoney::api::formatBalance(it->second) : "N/A";
+
+
             // 按钮文本：玩家名称 (余额)
             appendToggle(playerEntry.uuid.asString(), fmt::format("{} ({}{})", playerEntry.name, balanceStr, mSelectedCurrency), false);
         }
@@ -143,9 +153,6 @@ void showAdminMoneyListForm(Player& player, const std::string& searchFilter, int
     using ll::form::CustomFormElementResult;
     using ll::service::PlayerInfo;
 
-    auto form = std::make_unique<AdminMoneyListForm>(player, searchFilter, page, selectedCurrency);
-    int totalPages = form->getTotalPages();
-
     // 获取所有可用的货币类型 (用于回调中重新构建表单)
     std::vector<std::string> availableCurrenciesForCallback;
     const auto& config = czmoney::MyMod::getInstance().getConfig();
@@ -153,6 +160,23 @@ void showAdminMoneyListForm(Player& player, const std::string& searchFilter, int
         availableCurrenciesForCallback.push_back(pair.first);
     }
 
+    // PlayerInfo 只能在服务器线程上读取，余额查询和表单构建交给表单加载器
+    std::vector<PlayerInfo::PlayerInfoEntry> allPlayers;
+    for (const auto& entry : PlayerInfo::getInstance().entries()) {
+        allPlayers.push_back(entry);
+    }
+
+    czmoney::MyMod::getInstance().getFormLoader().load(player, "admin-money-list", [
+        allPlayers = std::move(allPlayers),
+        searchFilter,
+        page,
+        selectedCurrency,
+        availableCurrenciesForCallback
+    ](db::IDatabaseConnection& conn) -> FormLoader::Sender {
+    auto form = std::make_shared<AdminMoneyListForm>(conn, allPlayers, searchFilter, page, selectedCurrency);
+    int totalPages = form->getTotalPages();
+
+    return [form, searchFilter, page, selectedCurrency, totalPages, availableCurrenciesForCallback](Player& player) {
     form->sendTo(player, [
         playerUuid = player.getUuid().asString(),
         initialSearchFilter = searchFilter,
@@ -344,6 +368,8 @@ void showAdminMoneyListForm(Player& player, const std::string& searchFilter, int
         // 否则，如果只是点击了空白区域或未触发任何操作，也重新显示表单
         showAdminMoneyListForm(player, newSearchFilter, newPage, newSelectedCurrency);
     });
+    };
+    });
 }
 
 } // namespace czmoney::ui
@@ -6,6 +6,7 @@
 #include "mc/platform/UUID.h"
 #include "czmoney/money/money_api.h"
 #include "czmoney/MyMod.h"
+#include "czmoney/database_interface.h"
 
 #include <string>
 #include <vector>
@@ -20,11 +21,17 @@ class AdminMoneyEditForm;
 
 class AdminMoneyListForm : public ll::form::CustomForm {
 public:
-    // 构造函数，接收 Player 引用，可选的搜索过滤器，当前页码和选定的货币类型
-    explicit AdminMoneyListForm(Player& player, const std::string& searchFilter = "", int page = 0, const std::string& selectedCurrency = "");
+    // 构造函数，接收数据库连接 (在表单加载线程上查询当前页的余额)，在服务器线程上取好的玩家列表，
+    // 可选的搜索过滤器，当前页码和选定的货币类型
+    AdminMoneyListForm(
+        db::IDatabaseConnection& conn,
+        std::vector<ll::service::PlayerInfo::PlayerInfoEntry> allPlayers,
+        const std::string& searchFilter = "",
+        int page = 0,
+        const std::string& selectedCurrency = ""
+    );
 
 private:
-    Player& mPlayer;
     std::string mSearchFilter;
     int mCurrentPage;
     std::string mSelectedCurrency;
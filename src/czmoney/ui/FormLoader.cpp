@@ -0,0 +1,263 @@
+#include "czmoney/ui/FormLoader.h"
+#include "czmoney/db/columnar.h"
+#include "czmoney/money/Helpers.h"
+#include "ll/api/chrono/GameChrono.h"
+#include "ll/api/coro/CoroTask.h"
+#include "ll/api/mod/NativeMod.h"
+#include "ll/api/service/Bedrock.h"
+#include "ll/api/thread/ServerThreadExecutor.h"
+#include "mc/platform/UUID.h"
+#include "mc/world/level/Level.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace czmoney::ui {
+
+FormLoader::FormLoader(
+    db::IDatabaseConnection&  mainConn,
+    scheduler::TaskScheduler& scheduler,
+    const Config&             config,
+    ConnectionFactory         connectionFactory
+)
+: mMainConn(mainConn),
+  mScheduler(scheduler),
+  mConfig(config),
+  mConnectionFactory(std::move(connectionFactory)),
+  mLogger(ll::mod::NativeMod::current()->getLogger()) {}
+
+FormLoader::~FormLoader() { stop(); }
+
+void FormLoader::start() {
+    if (!mConfig.forms.asyncLoading || mWorker.joinable()) {
+        return;
+    }
+    // SQLite：加载线程上的读事务会让服务器的写入失败，构建函数改由调度器在主连接上执行
+    if (mMainConn.getDbType() == "sqlite" || !mConnectionFactory) {
+        return;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        mRunning = true;
+    }
+    mWorker = std::thread([this]() { worker(); });
+}
+
+void FormLoader::stop() {
+    {
+        std::lock_guard lock(mMutex);
+        mRunning = false;
+        mQueue.clear();
+    }
+    mCondition.notify_all();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+}
+
+size_t FormLoader::pending() const {
+    std::lock_guard lock(mMutex);
+    return mQueue.size();
+}
+
+void FormLoader::load(Player& player, std::string name, Builder builder) {
+    Job job{player.getUuid().asString(), std::move(name), std::move(builder), std::make_shared<std::atomic<bool>>(false)};
+
+    bool queued = false;
+    {
+        std::lock_guard lock(mMutex);
+        if (mRunning) {
+            // 同一玩家还没开始构建的旧请求已经没有意义 (玩家只会看到最后一个表单)
+            std::erase_if(mQueue, [&](const Job& queuedJob) { return queuedJob.playerUuid == job.playerUuid; });
+            mQueue.push_back(job);
+            queued = true;
+        }
+    }
+    if (!queued) {
+        if (mConfig.forms.asyncLoading) {
+            // 没有加载线程 (SQLite)：在下一次调度时用主连接构建，命令处理不等待查询
+            mScheduler.submit(
+                "form-load-" + job.name,
+                [this, job]() mutable { runJob(job, mMainConn); },
+                scheduler::TaskPriority::High
+            );
+        } else {
+            runJob(job, mMainConn); // 同步执行：构建完成后同样经调度器发送
+        }
+        return;
+    }
+    mCondition.notify_one();
+
+    // 超过阈值仍未就绪时显示加载提示，避免玩家以为命令没有响应
+    int hintMs = mConfig.forms.loadingHintMs;
+    if (hintMs > 0) {
+        ll::coro::keepThis([uuid = job.playerUuid, ready = job.ready, hintMs]() -> ll::coro::CoroTask<> {
+            co_await std::chrono::milliseconds(hintMs);
+            if (!*ready) {
+                if (Player* player = findOnlinePlayer(uuid)) {
+                    player->sendMessage("§7正在加载数据，请稍候...");
+                }
+            }
+            co_return;
+        }).launch(ll::thread::ServerThreadExecutor::getDefault());
+    }
+}
+
+void FormLoader::worker() {
+    std::unique_ptr<db::IDatabaseConnection> conn;
+    try {
+        conn = mConnectionFactory ? mConnectionFactory() : nullptr;
+        if (!conn || !conn->connect()) {
+            conn.reset();
+        }
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("表单加载线程连接数据库失败: {}", e.what());
+        conn.reset();
+    } catch (const std::exception& e) {
+        mLogger.error("表单加载线程连接数据库时发生意外错误: {}", e.what());
+        conn.reset();
+    }
+    if (!conn) {
+        // 回退为同步加载：已排队的请求交给服务器线程使用主连接执行
+        mLogger.warn("表单加载线程无法连接数据库，表单将在服务器线程上同步加载。");
+        std::lock_guard lock(mMutex);
+        mRunning = false;
+        for (auto& job : mQueue) {
+            mScheduler.submit(
+                "form-load-" + job.name,
+                [this, job]() mutable { runJob(job, mMainConn); },
+                scheduler::TaskPriority::High
+            );
+        }
+        mQueue.clear();
+        return;
+    }
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this]() { return !mRunning || !mQueue.empty(); });
+            if (!mRunning) {
+                break;
+            }
+            job = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+        runJob(job, *conn);
+    }
+    conn->disconnect();
+}
+
+void FormLoader::runJob(Job& job, db::IDatabaseConnection& conn) {
+    auto   startedAt = std::chrono::steady_clock::now();
+    Sender sender;
+    try {
+        sender = job.builder(conn);
+    } catch (const db::DatabaseException& e) {
+        mLogger.error("加载表单 {} 的数据失败: {}", job.name, e.what());
+    } catch (const std::exception& e) {
+        mLogger.error("构建表单 {} 时发生意外错误: {}", job.name, e.what());
+    }
+    *job.ready = true;
+    mLogger.debug(
+        "Form {} built in {:.1f}ms",
+        job.name,
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt).count()
+    );
+    deliver(job, std::move(sender));
+}
+
+void FormLoader::deliver(const Job& job, Sender sender) {
+    mScheduler.submit(
+        "form-send-" + job.name,
+        [uuid = job.playerUuid, sender = std::move(sender)]() {
+            Player* player = findOnlinePlayer(uuid);
+            if (!player) {
+                return; // 玩家已离线
+            }
+            if (!sender) {
+                player->sendMessage("§c加载数据失败，请稍后再试。");
+                return;
+            }
+            sender(*player);
+        },
+        scheduler::TaskPriority::High
+    );
+}
+
+Player* findOnlinePlayer(const std::string& uuid) {
+    auto level = ll::service::getLevel();
+    if (!level) {
+        return nullptr;
+    }
+    return level->getPlayer(mce::UUID::fromString(uuid));
+}
+
+std::unordered_map<std::string, int64_t>
+queryBalances(db::IDatabaseConnection& conn, const std::vector<std::string>& uuids, const std::string& currencyType) {
+    std::unordered_map<std::string, int64_t> balances;
+    if (uuids.empty()) {
+        return balances;
+    }
+    std::string  dbType = conn.getDbType();
+    std::string  sql    = "SELECT uuid, amount FROM player_balances WHERE currency_type = " + placeholder(dbType, 1)
+                      + " AND uuid IN (";
+    db::DbParams params{currencyType};
+    for (size_t i = 0; i < uuids.size(); ++i) {
+        sql += (i > 0 ? ", " : "") + placeholder(dbType, static_cast<int>(i) + 2);
+        params.emplace_back(uuids[i]);
+    }
+    sql += ");";
+
+    db::ColumnarResult rows = conn.queryColumnar(sql, params);
+    for (size_t row = 0; row < rows.rowCount(); ++row) {
+        if (auto amount = rows.getInt64(row, 1)) {
+            balances.emplace(rows.getString(row, 0), *amount);
+        }
+    }
+    return balances;
+}
+
+std::optional<int64_t>
+queryBalance(db::IDatabaseConnection& conn, const std::string& uuid, const std::string& currencyType) {
+    auto balances = queryBalances(conn, {uuid}, currencyType);
+    auto it       = balances.find(uuid);
+    if (it == balances.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::unordered_map<std::string, int64_t> queryAccountBalances(db::IDatabaseConnection& conn, const std::string& uuid) {
+    std::string sql = "SELECT currency_type, amount FROM player_balances WHERE uuid = " + placeholder(conn.getDbType(), 1)
+                    + ";";
+    db::ColumnarResult rows = conn.queryColumnar(sql, {uuid});
+
+    std::unordered_map<std::string, int64_t> balances;
+    for (size_t row = 0; row < rows.rowCount(); ++row) {
+        if (auto amount = rows.getInt64(row, 1)) {
+            balances.emplace(rows.getString(row, 0), *amount);
+        }
+    }
+    return balances;
+}
+
+std::vector<std::pair<std::string, int64_t>>
+queryTopBalances(db::IDatabaseConnection& conn, const std::string& currencyType, size_t limit) {
+    std::string dbType = conn.getDbType();
+    std::string sql    = "SELECT uuid, amount FROM player_balances WHERE currency_type = " + placeholder(dbType, 1)
+                    + " ORDER BY amount DESC LIMIT " + placeholder(dbType, 2) + ";";
+    db::ColumnarResult rows = conn.queryColumnar(sql, {currencyType, static_cast<int64_t>(limit)});
+
+    std::vector<std::pair<std::string, int64_t>> results;
+    results.reserve(rows.rowCount());
+    for (size_t row = 0; row < rows.rowCount(); ++row) {
+        if (auto amount = rows.getInt64(row, 1)) {
+            results.emplace_back(rows.getString(row, 0), *amount);
+        }
+    }
+    return results;
+}
+
+} // namespace czmoney::ui
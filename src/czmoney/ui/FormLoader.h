@@ -0,0 +1,141 @@
+#pragma once
+
+#include "czmoney/config.h"
+#include "czmoney/database_interface.h"
+#include "czmoney/scheduler/TaskScheduler.h"
+#include "ll/api/io/Logger.h"
+#include "mc/world/actor/player/Player.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace czmoney::ui {
+
+/**
+ * @brief 异步构建表单
+ *
+ * 表单需要的数据库查询 (余额、排行榜) 不在服务器线程上执行：
+ * 1. 服务器线程提交一个构建函数 (只捕获已经在服务器线程上取好的内存数据，如 PlayerInfo)；
+ * 2. 加载线程用自己的只读连接执行构建函数：查询数据并构建表单，返回一个发送函数；
+ * 3. 发送函数通过后台任务调度器 (高优先级) 回到服务器线程，按 UUID 找到仍然在线的玩家后发送。
+ * 数据超过 loadingHintMs 仍未就绪时，先向玩家显示加载提示。
+ * 同一玩家排队中的旧请求会被新的请求替换 (例如连续翻页时只构建最后一页)。
+ * 数据库为 SQLite 时不启动加载线程 (其他连接的读事务会让服务器的写入失败)，构建函数由调度器在主连接上执行；
+ * 未启用异步加载或加载线程无法连接数据库时，构建函数同样在服务器线程上使用主连接执行。
+ */
+class FormLoader {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<db::IDatabaseConnection>()>;
+    using Sender            = std::function<void(Player&)>;                      // 在服务器线程上发送已构建的表单
+    using Builder           = std::function<Sender(db::IDatabaseConnection&)>; // 查询数据并构建表单
+
+    /**
+     * @brief 构造函数
+     * @param mainConn 主数据库连接 (同步回退时在服务器线程上使用)
+     * @param scheduler 后台任务调度器 (把构建好的表单交回服务器线程)
+     * @param config 配置对象
+     * @param connectionFactory 为加载线程创建独立连接的工厂
+     */
+    FormLoader(
+        db::IDatabaseConnection&  mainConn,
+        scheduler::TaskScheduler& scheduler,
+        const Config&             config,
+        ConnectionFactory         connectionFactory
+    );
+    ~FormLoader();
+
+    FormLoader(const FormLoader&) = delete;
+    FormLoader& operator=(const FormLoader&) = delete;
+
+    /**
+     * @brief 启动加载线程 (未启用异步加载或数据库为 SQLite 时不启动)
+     */
+    void start();
+
+    /**
+     * @brief 停止加载线程，排队中的请求被丢弃
+     */
+    void stop();
+
+    /**
+     * @brief 为玩家构建并发送一个表单 (在服务器线程调用)
+     * @param player 接收表单的玩家
+     * @param name 表单名称 (用于日志)
+     * @param builder 构建函数，在加载线程上执行，不能访问 Player 等游戏对象
+     */
+    void load(Player& player, std::string name, Builder builder);
+
+    /**
+     * @brief 当前排队中的请求数量
+     */
+    [[nodiscard]] size_t pending() const;
+
+private:
+    struct Job {
+        std::string                        playerUuid;
+        std::string                        name;
+        Builder                            builder;
+        std::shared_ptr<std::atomic<bool>> ready; // 已构建完成 (不再需要加载提示)
+    };
+
+    db::IDatabaseConnection&  mMainConn;
+    scheduler::TaskScheduler& mScheduler;
+    const Config&             mConfig;
+    ConnectionFactory         mConnectionFactory;
+    ll::io::Logger&           mLogger;
+
+    mutable std::mutex      mMutex; // 保护 mQueue 与 mRunning
+    std::condition_variable mCondition;
+    std::deque<Job>         mQueue;
+    bool                    mRunning = false; // 加载线程可以接收请求 (无法连接数据库时也为 false，改为同步执行)
+    std::thread             mWorker;
+
+    void worker();
+    void runJob(Job& job, db::IDatabaseConnection& conn);
+    void deliver(const Job& job, Sender sender);
+};
+
+/**
+ * @brief 按 UUID 查找在线玩家 (只能在服务器线程调用)
+ * @return Player* 玩家不在线时返回 nullptr
+ */
+Player* findOnlinePlayer(const std::string& uuid);
+
+/**
+ * @brief 查询多个账户在某种货币下的余额 (一次查询)
+ * @return std::unordered_map<std::string, int64_t> UUID -> 余额 (分)，没有账户的 UUID 不在结果中
+ */
+std::unordered_map<std::string, int64_t>
+queryBalances(db::IDatabaseConnection& conn, const std::vector<std::string>& uuids, const std::string& currencyType);
+
+/**
+ * @brief 查询单个账户的余额
+ * @return std::optional<int64_t> 余额 (分)，账户不存在时返回 std::nullopt
+ */
+std::optional<int64_t>
+queryBalance(db::IDatabaseConnection& conn, const std::string& uuid, const std::string& currencyType);
+
+/**
+ * @brief 查询一个玩家所有货币的余额 (一次查询)
+ * @return std::unordered_map<std::string, int64_t> 货币类型 -> 余额 (分)，没有账户的货币不在结果中
+ */
+std::unordered_map<std::string, int64_t> queryAccountBalances(db::IDatabaseConnection& conn, const std::string& uuid);
+
+/**
+ * @brief 查询余额排行 (与 MoneyManager::getTopBalances 相同的排序)
+ * @return std::vector<std::pair<std::string, int64_t>> (UUID, 余额) 列表
+ */
+std::vector<std::pair<std::string, int64_t>>
+queryTopBalances(db::IDatabaseConnection& conn, const std::string& currencyType, size_t limit);
+
+} // namespace czmoney::ui
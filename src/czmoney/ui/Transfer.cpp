@@ -2,6 +2,7 @@
 #include "czmoney/MyMod.h"
 #include "czmoney/logger.h" // 用于日志记录
 #include "czmoney/money/money_api.h"
+#include "czmoney/ui/FormLoader.h"
 #include "ll/api/form/CustomForm.h"
 #include "ll/api/form/ModalForm.h" // 用于显示转账结果
 #include "ll/api/service/PlayerInfo.h"
@@ -19,12 +20,20 @@ namespace czmoney::ui {
 // 每页显示的玩家数量
 constexpr int PLAYERS_PER_PAGE = 8; // 根据图片估算，大约8个玩家选项
 
-TransferForm::TransferForm(Player& player, const std::string& searchFilter, int page, const std::string& selectedCurrency)
+TransferForm::TransferForm(
+    db::IDatabaseConnection& conn,
+    const std::string& senderUuid,
+    std::vector<ll::service::PlayerInfo::PlayerInfoEntry> allPlayers,
+    const std::string& searchFilter,
+    int page,
+    const std::string& selectedCurrency
+)
     : ll::form::CustomForm("转账操作"),
-      mPlayer(player),
+      mSenderUuid(senderUuid),
       mSearchFilter(searchFilter),
       mCurrentPage(page),
-      mSelectedCurrency(selectedCurrency)
+      mSelectedCurrency(selectedCurrency),
+      mAllPlayers(std::move(allPlayers))
 {
     // 获取所有可用的货币类型
     const auto& config = czmoney::MyMod::getInstance().getConfig();
@@ -46,12 +55,6 @@ TransferForm::TransferForm(Player& player, const std::string& searchFilter, int
         }
     }
 
-
-    // 获取所有玩家信息
-    mAllPlayers.clear();
-    for (const auto& entry : ll::service::PlayerInfo::getInstance().entries()) {
-        mAllPlayers.push_back(entry);
-    }
     // 按照玩家名称排序
     std::sort(mAllPlayers.begin(), mAllPlayers.end(), [](const auto& a, const auto& b) {
         return a.name < b.name;
@@ -84,6 +87,11 @@ TransferForm::TransferForm(Player& player, const std::string& searchFilter, int
             }
         }
         appendDropdown("currency_type", "选择经济类型", mAvailableCurrencies, defaultCurrencyIndex);
+
+        // 显示发起者当前选定货币的余额
+        std::optional<int64_t> balanceOpt = queryBalance(conn, mSenderUuid, mSelectedCurrency);
+        std::string balanceStr = balanceOpt.has_value() ? czmoney::api::formatBalance(balanceOpt.value()) : "0.00";
+        appendLabel(fmt::format("§l当前余额: §r{} {}", balanceStr, mSelectedCurrency));
     }
 
     // 3. 玩家选择 Toggle 列表
@@ -118,16 +126,6 @@ int TransferForm::getTotalPages() const {
     return totalPages;
 }
 
-std::string TransferForm::getPlayerName(const std::string& uuid) {
-    using ll::service::PlayerInfo; // 引入命名空间
-    auto playerInfoOpt = PlayerInfo::getInstance().fromUuid(mce::UUID::fromString(uuid));
-    if (playerInfoOpt.has_value()) {
-        return playerInfoOpt.value().name;
-    }
-    logger.warn("无法获取 UUID {} 的玩家名称，将显示为 '未知玩家'。", uuid);
-    return "未知玩家";
-}
-
 void TransferForm::filterPlayers() {
     using ll::service::PlayerInfo; // 引入命名空间
     mFilteredPlayers.clear();
@@ -155,9 +153,6 @@ void showTransferForm(Player& player, const std::string& searchFilter, int page,
     using ll::form::CustomFormElementResult; // 引入命名空间
     using ll::service::PlayerInfo; // 引入命名空间
 
-    auto form = std::make_unique<TransferForm>(player, searchFilter, page, selectedCurrency);
-    int totalPages = form->getTotalPages(); // 使用公共方法获取总页数
-
     // 获取所有可用的货币类型 (用于回调中重新构建表单)
     std::vector<std::string> availableCurrenciesForCallback;
     const auto& config = czmoney::MyMod::getInstance().getConfig();
@@ -167,6 +162,25 @@ void showTransferForm(Player& player, const std::string& searchFilter, int page,
         }
     }
 
+    // PlayerInfo 只能在服务器线程上读取，余额查询和表单构建交给表单加载器
+    std::vector<PlayerInfo::PlayerInfoEntry> allPlayers;
+    for (const auto& entry : PlayerInfo::getInstance().entries()) {
+        allPlayers.push_back(entry);
+    }
+
+    czmoney::MyMod::getInstance().getFormLoader().load(player, "transfer", [
+        senderUuid = player.getUuid().asString(),
+        allPlayers = std::move(allPlayers),
+        searchFilter,
+        page,
+        selectedCurrency,
+        availableCurrenciesForCallback
+    ](db::IDatabaseConnection& conn) -> FormLoader::Sender {
+    auto form = std::make_shared<TransferForm>(conn, senderUuid, allPlayers, searchFilter, page, selectedCurrency);
+    int totalPages = form->getTotalPages(); // 使用公共方法获取总页数
+
+    return [form, searchFilter, page, selectedCurrency, totalPages, availableCurrenciesForCallback](Player& player) {
+
     form->sendTo(player, [
         playerUuid = player.getUuid().asString(),
         initialSearchFilter = searchFilter,
@@ -377,7 +391,7 @@ void showTransferForm(Player& player, const std::string& searchFilter, int page,
                         break;
                     case czmoney::api::MoneyApiResult::UnknownError:
                     default:
-                        errorMessage = "未知错误。";
+                        errorMessage = czmoney::api::getResultMessage(transferResult);
                         break;
                 }
                 player.sendMessage(fmt::format("§c转账失败！{}. 请检查您的余额或目标玩家账户。", errorMessage));
@@ -393,6 +407,8 @@ void showTransferForm(Player& player, const std::string& searchFilter, int page,
 
         player.sendMessage("§e请勾选 '确认转账' 以继续。");
     });
+    };
+    });
 }
 
 } // namespace czmoney::ui
@@ -6,6 +6,7 @@
 #include "mc/platform/UUID.h"             // 用于 UUID 转换
 #include "czmoney/money/money_api.h"      // 用于转账API
 #include "czmoney/MyMod.h"                // 用于获取日志和配置
+#include "czmoney/database_interface.h"   // 用于在表单加载线程上查询余额
 
 #include <string>
 #include <vector>
@@ -17,11 +18,19 @@ namespace czmoney::ui {
 
 class TransferForm : public ll::form::CustomForm {
 public:
-    // 构造函数，接收 Player 引用，可选的搜索过滤器，当前页码和选定的货币类型
-    explicit TransferForm(Player& player, const std::string& searchFilter = "", int page = 0, const std::string& selectedCurrency = "");
+    // 构造函数，接收数据库连接 (在表单加载线程上查询发起者余额)、发起转账的玩家 UUID、在服务器线程上取好的玩家列表，
+    // 可选的搜索过滤器，当前页码和选定的货币类型
+    TransferForm(
+        db::IDatabaseConnection& conn,
+        const std::string& senderUuid,
+        std::vector<ll::service::PlayerInfo::PlayerInfoEntry> allPlayers,
+        const std::string& searchFilter = "",
+        int page = 0,
+        const std::string& selectedCurrency = ""
+    );
 
 private:
-    Player& mPlayer; // 发起转账的玩家引用
+    std::string mSenderUuid; // 发起转账的玩家 UUID
     std::string mSearchFilter; // 当前搜索关键词
     int mCurrentPage;          // 当前页码
     std::string mSelectedCurrency; // 当前选定的货币类型
@@ -29,9 +38,6 @@ private:
     std::vector<ll::service::PlayerInfo::PlayerInfoEntry> mFilteredPlayers; // 筛选后的玩家信息
     std::vector<std::string> mAvailableCurrencies; // 所有可用的货币类型名称
 
-    // 获取玩家名称的辅助函数
-    std::string getPlayerName(const std::string& uuid);
-
     // 获取所有玩家信息并进行筛选的辅助函数
     void filterPlayers();
 
@@ -11,13 +11,14 @@
 #include <algorithm> // For std::sort (if needed, though DB handles sorting)
 #include "czmoney/logger.h" // 用于日志记录
 #include "czmoney/money/money_api.h" // 引入 money_api.h
+#include "czmoney/ui/FormLoader.h"
 
 // 将所有实现放在命名空间内
 namespace czmoney::ui {
 
-RankForm::RankForm(Player& player)
+RankForm::RankForm(db::IDatabaseConnection& conn, std::unordered_map<std::string, std::string> playerNames)
     : ll::form::SimpleForm("金币排行榜"), // 修正基类初始化
-          mPlayer(player)
+          mPlayerNames(std::move(playerNames))
     {
         // 移除 MoneyManager 实例的直接获取，改为直接调用 API
         // czmoney::MoneyManager* moneyManager = nullptr;
@@ -40,10 +41,9 @@ RankForm::RankForm(Player& player)
         logger.warn("配置中未找到任何货币类型，将使用默认 'money'。");
     }
 
-    // 获取排行榜数据，通过 API 调用
+    // 获取排行榜数据 (在表单加载线程上查询)
     // 假设我们总是显示前10名
-    std::vector<std::pair<std::string, int64_t>> topBalances =
-        czmoney::api::getTopBalances(defaultCurrencyType, 10, 0); // 调用 API
+    std::vector<std::pair<std::string, int64_t>> topBalances = queryTopBalances(conn, defaultCurrencyType, 10);
 
     // 构建表单内容
     std::string content = "";
@@ -85,27 +85,41 @@ RankForm::RankForm(Player& player)
 
     // 添加一个按钮 (图片中有一个“提交”按钮，虽然这里没有实际功能，但为了还原UI)
     appendButton("提交"); // 修正 addButton 为 appendButton
-
-    // 发送表单，并直接传入回调函数
-    sendTo(mPlayer, [this](Player& player, int selected, ll::form::FormCancelReason reason) { // 修正回调函数签名
-        if (selected == -1) { // 玩家关闭表单
-            logger.debug("排行榜表单被玩家 {} 关闭。", player.getRealName());
-        } else {
-            // 如果有多个按钮，这里可以根据按钮索引处理点击事件
-            logger.debug("排行榜表单被玩家 {} 提交，点击了按钮索引: {}", player.getRealName(), selected);
-        }
-    });
 }
 
 // getPlayerName 方法的定义应该在 RankForm 类外部，但仍在 czmoney::ui 命名空间内
 std::string RankForm::getPlayerName(const std::string& uuid) {
-    // 使用 mce::UUID::fromString 转换字符串 UUID
-    auto playerInfoOpt = ll::service::PlayerInfo::getInstance().fromUuid(mce::UUID::fromString(uuid)); // 修正命名空间
-    if (playerInfoOpt.has_value()) {
-        return playerInfoOpt.value().name; // 返回玩家名称
+    auto it = mPlayerNames.find(uuid);
+    if (it != mPlayerNames.end()) {
+        return it->second; // 返回玩家名称
     }
     logger.warn("无法获取 UUID {} 的玩家名称，将显示为 '未知玩家'。", uuid);
     return "未知玩家";
 }
 
+void showRankForm(Player& player) {
+    // PlayerInfo 只能在服务器线程上读取，排行榜查询和表单构建交给表单加载器
+    std::unordered_map<std::string, std::string> playerNames;
+    for (const auto& entry : ll::service::PlayerInfo::getInstance().entries()) {
+        playerNames.emplace(entry.uuid.asString(), entry.name);
+    }
+
+    czmoney::MyMod::getInstance().getFormLoader().load(player, "rank", [playerNames = std::move(playerNames)](
+        db::IDatabaseConnection& conn
+    ) -> FormLoader::Sender {
+        auto form = std::make_shared<RankForm>(conn, playerNames);
+        return [form](Player& player) {
+            // 发送表单，并直接传入回调函数
+            form->sendTo(player, [](Player& player, int selected, ll::form::FormCancelReason reason) { // 修正回调函数签名
+                if (selected == -1) { // 玩家关闭表单
+                    logger.debug("排行榜表单被玩家 {} 关闭。", player.getRealName());
+                } else {
+                    // 如果有多个按钮，这里可以根据按钮索引处理点击事件
+                    logger.debug("排行榜表单被玩家 {} 提交，点击了按钮索引: {}", player.getRealName(), selected);
+                }
+            });
+        };
+    });
+}
+
 } // namespace czmoney::ui
@@ -5,20 +5,25 @@
 #include "ll/api/service/PlayerInfo.h"    // 用于获取离线玩家信息
 #include "czmoney/money/money.h"
 #include "czmoney/MyMod.h" // 用于获取 MoneyManager 实例
+#include "czmoney/database_interface.h" // 用于在表单加载线程上查询排行榜
+#include <string>
+#include <unordered_map>
 
 namespace czmoney::ui {
 // RankForm 继承自 ll::form::SimpleForm
 class RankForm : public ll::form::SimpleForm { // 修正命名空间
 public:
-    // 构造函数，接收 Player 引用
-    explicit RankForm(Player& player);
-    
-private:
-    Player& mPlayer; // 玩家引用
+    // 构造函数，接收数据库连接 (在表单加载线程上查询排行榜) 和在服务器线程上取好的 UUID -> 玩家名称表
+    RankForm(db::IDatabaseConnection& conn, std::unordered_map<std::string, std::string> playerNames);
 
+private:
+    std::unordered_map<std::string, std::string> mPlayerNames; // UUID -> 玩家名称
 
     // 获取玩家名称的辅助函数
     std::string getPlayerName(const std::string& uuid);
 };
 
+// 辅助函数，用于创建和显示排行榜表单
+void showRankForm(Player& player);
+
 } // namespace czmoney::ui